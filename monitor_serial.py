@@ -8,6 +8,7 @@ ESP32串口监控脚本 - 增强版
 - 支持实时显示和文件保存
 - 支持过滤和高亮显示
 - 支持统计信息显示
+- 二进制帧（格式见 src/utils/SerialFrame.h）：PING、执行命令、高频遥测、SD卡文件下载
 """
 
 import serial
@@ -18,6 +19,8 @@ import glob
 from datetime import datetime
 import re
 import argparse
+import struct
+import csv
 
 class SerialMonitor:
     def __init__(self, port=None, baudrate=115200, output_dir='consoleout'):
@@ -260,6 +263,259 @@ class SerialMonitor:
         
         return True
 
+# ---------------- 二进制帧 ----------------
+
+FRAME_PING = 0x01
+FRAME_TEXT = 0x02
+FRAME_TELEMETRY_START = 0x10
+FRAME_TELEMETRY_STOP = 0x11
+FRAME_FILE_INFO = 0x20
+FRAME_FILE_READ = 0x21
+FRAME_REPLY = 0x80
+FRAME_TELEMETRY = 0x90
+FRAME_ERROR = 0xFF
+
+FRAME_ERRORS = {1: '未知命令', 2: '参数错误', 3: '未就绪', 4: '读写失败'}
+FILE_CHUNK = 508
+
+# 与 SerialTelemetry 一致（小端，无填充）
+TELEMETRY_FORMAT = '<BBHI3f3f3fddbbH'
+TELEMETRY_FIELDS = ['version', 'flags', 'battery_mv', 'uptime_ms',
+                    'accel_x', 'accel_y', 'accel_z', 'gyro_x', 'gyro_y', 'gyro_z',
+                    'roll', 'pitch', 'yaw', 'latitude', 'longitude',
+                    'satellites', 'battery_percent', 'heap_free_kb']
+assert struct.calcsize(TELEMETRY_FORMAT) == 64
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE"""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for b in data:
+        if b == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+    out[code_index] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frame_encode(frame_type, seq, payload=b''):
+    raw = bytes([frame_type, seq]) + payload
+    raw += struct.pack('<H', crc16(raw))
+    return b'\x00' + cobs_encode(raw) + b'\x00'
+
+
+class FrameDecoder:
+    """按固件相同的规则拆分文本行和帧"""
+
+    def __init__(self):
+        self.in_frame = False
+        self.buf = bytearray()
+        self.line = bytearray()
+        self.bad_frames = 0
+
+    def feed(self, data):
+        """返回事件列表：('line', str) 或 ('frame', 类型, 序号, 负载)"""
+        events = []
+        for b in data:
+            if self.in_frame:
+                if b != 0:
+                    self.buf.append(b)
+                    continue
+                self.in_frame = False
+                if not self.buf:
+                    continue
+                raw = cobs_decode(bytes(self.buf))
+                self.buf = bytearray()
+                if raw is None or len(raw) < 4 or crc16(raw[:-2]) != struct.unpack('<H', raw[-2:])[0]:
+                    self.bad_frames += 1
+                    continue
+                events.append(('frame', raw[0], raw[1], raw[2:-2]))
+            elif b == 0:
+                if self.line:
+                    events.append(('line', self.line.decode('utf-8', errors='ignore').rstrip()))
+                    self.line = bytearray()
+                self.in_frame = True
+                self.buf = bytearray()
+            elif b == 0x0A:
+                events.append(('line', self.line.decode('utf-8', errors='ignore').rstrip()))
+                self.line = bytearray()
+            else:
+                self.line.append(b)
+        return events
+
+
+def format_telemetry(payload):
+    return dict(zip(TELEMETRY_FIELDS, struct.unpack(TELEMETRY_FORMAT, payload[:64])))
+
+
+class FrameClient:
+    """帧请求/应答，等待期间收到的文本行照常打印"""
+
+    def __init__(self, ser):
+        self.ser = ser
+        self.decoder = FrameDecoder()
+        self.seq = 0
+        self.pending = []
+
+    def send(self, frame_type, payload=b''):
+        self.seq = (self.seq + 1) & 0xFF
+        self.ser.write(frame_encode(frame_type, self.seq, payload))
+        return self.seq
+
+    def read_events(self, timeout=0.1):
+        data = self.ser.read(max(1, self.ser.in_waiting))
+        events = self.decoder.feed(data)
+        for ev in events:
+            if ev[0] == 'line' and ev[1]:
+                print(ev[1])
+        return [ev for ev in events if ev[0] == 'frame']
+
+    def request(self, frame_type, payload=b'', timeout=2.0, retries=2):
+        """发送请求并等待同序号的应答，返回应答负载，出错时抛出 RuntimeError"""
+        for _ in range(retries + 1):
+            seq = self.send(frame_type, payload)
+            end_time = time.time() + timeout
+            while time.time() < end_time:
+                for _, rtype, rseq, rpayload in self.read_events():
+                    if rseq != seq:
+                        continue
+                    if rtype == FRAME_ERROR:
+                        raise RuntimeError(FRAME_ERRORS.get(rpayload[0], '错误 %d' % rpayload[0]))
+                    if rtype == frame_type | FRAME_REPLY:
+                        return rpayload
+        raise RuntimeError('等待应答超时')
+
+    def ping(self):
+        start = time.time()
+        reply = self.request(FRAME_PING)
+        uptime, = struct.unpack('<I', reply[:4])
+        print('PING 往返 %.1f ms，设备运行 %.1f 秒，固件 %s' %
+              ((time.time() - start) * 1000, uptime / 1000.0, reply[4:].decode('utf-8', errors='ignore')))
+
+    def command(self, text):
+        self.request(FRAME_TEXT, text.encode('utf-8'), timeout=10.0, retries=0)
+
+    def telemetry(self, interval_ms, output_dir, duration=None):
+        """接收遥测帧，保存为 CSV"""
+        os.makedirs(output_dir, exist_ok=True)
+        filename = os.path.join(output_dir, datetime.now().strftime('telemetry_%Y-%m-%d_%H%M%S.csv'))
+        self.request(FRAME_TELEMETRY_START, struct.pack('<H', interval_ms))
+        count = 0
+        start = time.time()
+        try:
+            with open(filename, 'w', newline='') as f:
+                writer = csv.writer(f)
+                writer.writerow(['host_time'] + TELEMETRY_FIELDS)
+                while duration is None or time.time() - start < duration:
+                    for _, rtype, _, payload in self.read_events():
+                        if rtype != FRAME_TELEMETRY or len(payload) < 64:
+                            continue
+                        t = format_telemetry(payload)
+                        writer.writerow(['%.3f' % time.time()] + [t[k] for k in TELEMETRY_FIELDS])
+                        count += 1
+                        if count % max(1, 1000 // max(interval_ms, 1)) == 0:
+                            print('[遥测] %d 帧 %.1f 帧/秒 电池 %dmV 加速度 %.2f %.2f %.2f 姿态 %.1f %.1f %.1f' %
+                                  (count, count / (time.time() - start), t['battery_mv'],
+                                   t['accel_x'], t['accel_y'], t['accel_z'], t['roll'], t['pitch'], t['yaw']))
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.request(FRAME_TELEMETRY_STOP)
+        print('遥测 %d 帧已保存到 %s（解析失败 %d 帧）' % (count, os.path.abspath(filename), self.decoder.bad_frames))
+
+    def download(self, path, local=None):
+        """分块下载SD卡文件，丢失的块按偏移重发"""
+        local = local or os.path.basename(path)
+        size, = struct.unpack('<I', self.request(FRAME_FILE_INFO, path.encode('utf-8')))
+        start = time.time()
+        offset = 0
+        with open(local, 'wb') as f:
+            while offset < size:
+                want = min(FILE_CHUNK, size - offset)
+                reply = self.request(FRAME_FILE_READ, struct.pack('<IH', offset, want) + path.encode('utf-8'))
+                got, = struct.unpack('<I', reply[:4])
+                data = reply[4:]
+                if got != offset or not data:
+                    raise RuntimeError('偏移不符或文件变短: %d' % offset)
+                f.write(data)
+                offset += len(data)
+                print('\r下载 %d/%d 字节' % (offset, size), end='', flush=True)
+        duration = max(time.time() - start, 1e-3)
+        print('\n已保存到 %s，%.1f KB/s' % (os.path.abspath(local), size / 1024.0 / duration))
+
+
+def decode_file(filename):
+    """离线解析抓取的串口原始数据（如 tools/serial_frame_sim.cpp 生成的样例）"""
+    decoder = FrameDecoder()
+    with open(filename, 'rb') as f:
+        events = decoder.feed(f.read())
+    for ev in events:
+        if ev[0] == 'line':
+            print('文本: %s' % ev[1])
+        elif ev[1] == FRAME_TELEMETRY:
+            print('遥测: %s' % format_telemetry(ev[3]))
+        else:
+            print('帧: 类型 0x%02X 序号 %d 负载 %d 字节' % (ev[1], ev[2], len(ev[3])))
+    print('错误帧: %d' % decoder.bad_frames)
+
+
+def run_frame_client(args):
+    port = args.port or SerialMonitor().find_serial_port()
+    if not port:
+        print('❌ 未找到串口设备')
+        return 1
+    with serial.Serial(port, args.baudrate, timeout=0.05) as ser:
+        client = FrameClient(ser)
+        try:
+            if args.ping:
+                client.ping()
+            if args.cmd:
+                client.command(args.cmd)
+            if args.download:
+                client.download(args.download, args.download_output)
+            if args.telemetry is not None:
+                client.telemetry(args.telemetry, args.output_dir, args.duration)
+        except RuntimeError as e:
+            print('❌ %s' % e)
+            return 1
+    return 0
+
+
 def main():
     """主函数"""
     parser = argparse.ArgumentParser(description='ESP32串口监控工具 - 增强版')
@@ -269,8 +525,22 @@ def main():
     parser.add_argument('-f', '--filter', help='过滤关键词')
     parser.add_argument('-o', '--output-dir', default='consoleout', help='输出目录 (默认: consoleout)')
     parser.add_argument('--list-ports', action='store_true', help='列出可用串口')
+    parser.add_argument('--ping', action='store_true', help='发送 PING 帧，显示往返时间和固件版本')
+    parser.add_argument('--cmd', help='以帧方式执行一条文本命令，等待执行完成')
+    parser.add_argument('--telemetry', type=int, nargs='?', const=100, metavar='MS',
+                        help='开启遥测（默认间隔 100ms），保存为 CSV，可配合 -d')
+    parser.add_argument('--download', metavar='PATH', help='下载SD卡文件，如 /data/log.txt')
+    parser.add_argument('-O', '--download-output', metavar='FILE', help='下载保存的本地文件名')
+    parser.add_argument('--decode', metavar='FILE', help='离线解析串口原始数据文件')
     
     args = parser.parse_args()
+
+    if args.decode:
+        decode_file(args.decode)
+        return
+
+    if args.ping or args.cmd or args.download or args.telemetry is not None:
+        sys.exit(run_frame_client(args))
     
     # 列出可用串口
     if args.list_ports:
@@ -1,6 +1,15 @@
 #include "SDManager.h"
+#include "audio/WavReader.h"
+#include "power/PowerLocks.h"
+#include "power/PowerAccounting.h"
+#include "power/WarmBoot.h"
+#include "utils/Log.h"
 
-SDManager::SDManager() : _initialized(false) {}
+#define CUSTOM_WELCOME_VOICE_PATH "/voice/welcome.wav"
+
+SDManager::SDManager() : _initialized(false), _gpsFileReady(false), _gpsFileSession(0) {
+    _gpsPath[0] = '\0';
+}
 
 SDManager::~SDManager() {
     if (_initialized) {
@@ -61,8 +70,6 @@ bool SDManager::begin() {
     
     debugPrint("✅ SD卡初始化成功");
     debugPrint("SD卡类型: " + cardTypeStr);
-    debugPrint("SD卡容量: " + String((unsigned long)getTotalSpaceMB()) + " MB");
-    debugPrint("可用空间: " + String((unsigned long)getFreeSpaceMB()) + " MB");
     
 #else
     // MMC模式初始化
@@ -81,20 +88,37 @@ bool SDManager::begin() {
     _initialized = true;
     
     debugPrint("✅ SD卡MMC模式初始化成功");
-    debugPrint("SD卡容量: " + String((unsigned long)getTotalSpaceMB()) + " MB");
-    debugPrint("可用空间: " + String((unsigned long)getFreeSpaceMB()) + " MB");
 #endif
 
+    uint32_t totalMB = (uint32_t)getTotalSpaceMB();
+    debugPrint("SD卡容量: " + String((unsigned long)totalMB) + " MB");
+
+    // 热启动且还是同一张卡：目录和设备信息在睡眠前已经写好，剩余空间沿用睡眠前的值
+    // （统计剩余空间要遍历FAT表，大容量卡上很慢，系统任务稍后会在后台刷新）
+    if (warmBoot.sdLayoutValid(totalMB)) {
+        debugPrint("热启动：跳过目录检查和设备信息写入");
+        debugPrint("可用空间: " + String((unsigned long)warmBoot.state().sdFreeMB) + " MB (睡眠前)");
+        return true;
+    }
+
+    uint32_t freeMB = (uint32_t)getFreeSpaceMB();
+    debugPrint("可用空间: " + String((unsigned long)freeMB) + " MB");
+
     // 创建必要的目录结构
-    if (!createDirectoryStructure()) {
+    bool layoutReady = createDirectoryStructure();
+    if (!layoutReady) {
         debugPrint("⚠️ 目录结构创建失败，但SD卡可用");
     }
     
     // 保存设备信息
-    if (!saveDeviceInfo()) {
+    bool infoSaved = saveDeviceInfo();
+    if (!infoSaved) {
         debugPrint("⚠️ 设备信息保存失败，但SD卡可用");
     }
 
+    // 都成功才算就绪，失败时下次唤醒重试
+    warmBoot.setSDLayout(totalMB, freeMB, layoutReady && infoSaved);
+
     return true;
 }
 
@@ -110,6 +134,7 @@ void SDManager::end() {
 #endif
 
     _initialized = false;
+    _gpsFileReady = false;
     debugPrint("SD卡已断开");
 }
 
@@ -117,6 +142,14 @@ bool SDManager::isInitialized() {
     return _initialized;
 }
 
+fs::FS& SDManager::getFileSystem() {
+#ifdef SD_MODE_SPI
+    return SD;
+#else
+    return SD_MMC;
+#endif
+}
+
 uint64_t SDManager::getTotalSpaceMB() {
     if (!_initialized) {
         debugPrint("⚠️ SD卡未初始化，无法获取容量信息");
@@ -162,10 +195,11 @@ bool SDManager::createDirectoryStructure() {
     const char* directories[] = {
         "/data",
         "/data/gps",
-        "/config"
+        "/config",
+        "/voice"
     };
 
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < 4; i++) {
         if (!createDirectory(directories[i])) {
             debugPrint("创建目录失败: " + String(directories[i]));
             return false;
@@ -227,6 +261,8 @@ bool SDManager::saveDeviceInfo() {
     if (!_initialized) {
         return false;
     }
+    PowerLockGuard sdLock(PM_CLIENT_SD);
+    PowerStateGuard sdState(PA_SD, PA_SD_WRITE);
 
     const char* filename = "/config/device_info.json";
     
@@ -257,56 +293,127 @@ bool SDManager::saveDeviceInfo() {
     return true;
 }
 
-bool SDManager::recordGPSData(gnss_data_t &gnss_data) {
+bool SDManager::appendLine(const char* path, const String& line) {
+    return appendLine(path, line.c_str());
+}
+
+bool SDManager::appendLine(const char* path, const char* line) {
     if (!_initialized) {
-        debugPrint("⚠️ SD卡未初始化，无法记录GPS数据");
         return false;
     }
+    PowerLockGuard sdLock(PM_CLIENT_SD);
+    PowerStateGuard sdState(PA_SD, PA_SD_WRITE);
 
-    // 生成当前会话的GPS文件名
-    String filename = generateGPSSessionFilename();
-    
-    // 确保GPS目录存在
-    if (!ensureGPSDirectoryExists()) {
-        debugPrint("❌ 无法创建GPS目录");
+    File file = getFileSystem().open(path, FILE_APPEND);
+    if (!file) {
+        debugPrint("无法打开日志文件: " + String(path));
         return false;
     }
-    
-    // 检查文件是否存在，如果不存在则创建GeoJSON头部
-    bool fileExists = false;
-    
-    try {
-#ifdef SD_MODE_SPI
-        File testFile = SD.open(filename.c_str(), FILE_READ);
-#else
-        File testFile = SD_MMC.open(filename.c_str(), FILE_READ);
-#endif
-        
-        if (testFile) {
-            fileExists = true;
-            testFile.close();
-            debugPrint("📄 使用现有GPS会话文件: " + filename);
-        }
-    } catch (...) {
-        debugPrint("⚠️ 检查GPS文件状态失败，可能SD卡已移除");
+    file.println(line);
+    file.close();
+    return true;
+}
+
+bool SDManager::writeFile(const char* dir, const char* name, const uint8_t* data, size_t len) {
+    if (!_initialized) {
+        return false;
+    }
+    PowerLockGuard sdLock(PM_CLIENT_SD);
+    PowerStateGuard sdState(PA_SD, PA_SD_WRITE);
+
+    if (!createDirectory(dir)) {
+        return false;
+    }
+    String path = String(dir) + "/" + name;
+    File file = getFileSystem().open(path.c_str(), FILE_WRITE);
+    if (!file) {
+        debugPrint("无法创建文件: " + path);
+        return false;
+    }
+    size_t written = file.write(data, len);
+    file.close();
+    return written == len;
+}
+
+int64_t SDManager::fileSize(const char* path) {
+    if (!_initialized) {
+        return -1;
+    }
+    PowerLockGuard sdLock(PM_CLIENT_SD);
+    File file = getFileSystem().open(path, FILE_READ);
+    if (!file) {
+        return -1;
+    }
+    int64_t size = file.isDirectory() ? -1 : (int64_t)file.size();
+    file.close();
+    return size;
+}
+
+int SDManager::readFile(const char* path, uint32_t offset, uint8_t* buf, size_t len) {
+    if (!_initialized) {
+        return -1;
+    }
+    PowerLockGuard sdLock(PM_CLIENT_SD);
+    File file = getFileSystem().open(path, FILE_READ);
+    if (!file || file.isDirectory()) {
+        return -1;
+    }
+    int n = -1;
+    if (offset <= file.size() && file.seek(offset)) {
+        n = (int)file.read(buf, len);
+    }
+    file.close();
+    return n;
+}
+
+bool SDManager::recordGPSData(gnss_data_t &gnss_data) {
+    if (!_initialized) {
+        debugPrint("⚠️ SD卡未初始化，无法记录GPS数据");
         return false;
     }
+    // 打开、追加、关闭文件是一次突发操作，期间升频并锁定SPI时钟
+    PowerLockGuard sdLock(PM_CLIENT_SD);
+    PowerStateGuard sdState(PA_SD, PA_SD_WRITE);
+
+    // 每秒调用一次，会话文件确认存在后只做一次追加
+    uint32_t session = warmBoot.sessionId();
+    bool fileExists = _gpsFileReady && _gpsFileSession == session;
+    if (!fileExists) {
+        formatGPSSessionPath(_gpsPath, sizeof(_gpsPath));
+
+        // 确保GPS目录存在
+        if (!ensureGPSDirectoryExists()) {
+            debugPrint("❌ 无法创建GPS目录");
+            return false;
+        }
+
+        // 检查文件是否存在，如果不存在则创建GeoJSON头部
+        try {
+            File testFile = getFileSystem().open(_gpsPath, FILE_READ);
+            if (testFile) {
+                fileExists = true;
+                testFile.close();
+                LOGI(SD, "📄 使用现有GPS会话文件: %s", _gpsPath);
+            }
+        } catch (...) {
+            debugPrint("⚠️ 检查GPS文件状态失败，可能SD卡已移除");
+            return false;
+        }
+    }
 
     // 打开文件进行写入
     File file;
     try {
-#ifdef SD_MODE_SPI
-        file = SD.open(filename.c_str(), FILE_APPEND);
-#else
-        file = SD_MMC.open(filename.c_str(), FILE_APPEND);
-#endif
+        file = getFileSystem().open(_gpsPath, FILE_APPEND);
     } catch (...) {
         debugPrint("⚠️ 打开GPS数据文件失败，可能SD卡已移除");
+        _gpsFileReady = false;
         return false;
     }
 
     if (!file) {
-        debugPrint("❌ 无法打开GPS数据文件: " + filename);
+        _gpsFileReady = false;
+        LOGE(SD, "❌ 无法打开GPS数据文件: %s", _gpsPath);
         debugPrint("可能的原因：");
         debugPrint("  1. SD卡空间不足");
         debugPrint("  2. SD卡已移除");
@@ -323,9 +430,9 @@ bool SDManager::recordGPSData(gnss_data_t &gnss_data) {
         return false;
     }
 
-    // 如果是新文件，写入GeoJSON头部和会话信息
+    // 如果是新文件，写入GeoJSON头部和会话信息（每个会话一次）
     if (!fileExists) {
-        debugPrint("📁 创建新的GPS会话文件: " + filename);
+        LOGI(SD, "📁 创建新的GPS会话文件: %s", _gpsPath);
         
         file.println("{");
         file.println("  \"type\": \"FeatureCollection\",");
@@ -333,41 +440,53 @@ bool SDManager::recordGPSData(gnss_data_t &gnss_data) {
         file.println("    \"device_id\": \"" + getDeviceID() + "\",");
         file.println("    \"session_start\": \"" + getCurrentTimestamp() + "\",");
         file.println("    \"boot_count\": " + String(getBootCount()) + ",");
+        file.println("    \"session_id\": " + String((unsigned long)warmBoot.sessionId()) + ",");
         file.println("    \"firmware_version\": \"" + String(FIRMWARE_VERSION) + "\"");
         file.println("  },");
         file.println("  \"features\": [");
-    } else {
-        // 如果文件已存在，需要在最后一个特征后添加逗号
-        file.print(",\n");
-    }
-
-    // 写入GPS数据点
-    String gpsFeature = "    {\n";
-    gpsFeature += "      \"type\": \"Feature\",\n";
-    gpsFeature += "      \"geometry\": {\n";
-    gpsFeature += "        \"type\": \"Point\",\n";
-    gpsFeature += "        \"coordinates\": [" + String(gnss_data.longitude, 6) + ", " + String(gnss_data.latitude, 6) + ", " + String(gnss_data.altitude, 2) + "]\n";
-    gpsFeature += "      },\n";
-    gpsFeature += "      \"properties\": {\n";
-    gpsFeature += "        \"timestamp\": \"" + getCurrentTimestamp() + "\",\n";
-    gpsFeature += "        \"runtime_ms\": " + String(millis()) + ",\n";
-    gpsFeature += "        \"speed_kmh\": " + String(gnss_data.speed, 2) + ",\n";
-    gpsFeature += "        \"satellites\": " + String(gnss_data.satellites) + ",\n";
-    gpsFeature += "        \"hdop\": 0.0\n";  // 可以后续添加HDOP数据
-    gpsFeature += "      }\n";
-    gpsFeature += "    }";
-
-    size_t bytesWritten = file.print(gpsFeature);
+    }
+
+    // 写入GPS数据点，已有数据点时先加逗号
+    unsigned long now = millis();
+    int len = snprintf(_gpsRecord, sizeof(_gpsRecord),
+                       "%s"
+                       "    {\n"
+                       "      \"type\": \"Feature\",\n"
+                       "      \"geometry\": {\n"
+                       "        \"type\": \"Point\",\n"
+                       "        \"coordinates\": [%.6f, %.6f, %.2f]\n"
+                       "      },\n"
+                       "      \"properties\": {\n"
+                       "        \"timestamp\": \"%lu\",\n"
+                       "        \"runtime_ms\": %lu,\n"
+                       "        \"speed_kmh\": %.2f,\n"
+                       "        \"satellites\": %d,\n"
+                       "        \"hdop\": 0.0\n"
+                       "      }\n"
+                       "    }",
+                       fileExists ? ",\n" : "", gnss_data.longitude, gnss_data.latitude, gnss_data.altitude, now, now,
+                       gnss_data.speed, (int)gnss_data.satellites);
+    if (len < 0 || len >= (int)sizeof(_gpsRecord)) {
+        file.close();
+        debugPrint("❌ GPS记录超出缓冲区");
+        return false;
+    }
+
+    size_t bytesWritten = file.write((const uint8_t*)_gpsRecord, len);
     file.flush(); // 确保数据写入
     file.close();
 
     if (bytesWritten == 0) {
+        _gpsFileReady = false;
         debugPrint("❌ GPS数据写入失败");
         debugPrint("可能SD卡空间不足或已移除");
         return false;
     }
+    _gpsFileReady = true;
+    _gpsFileSession = session;
 
-    debugPrint("📍 GPS数据已记录: " + String(gnss_data.latitude, 6) + "," + String(gnss_data.longitude, 6) + " (卫星:" + String(gnss_data.satellites) + ")");
+    LOGD(SD, "📍 GPS数据已记录: %.6f,%.6f (卫星:%d)", gnss_data.latitude, gnss_data.longitude,
+         (int)gnss_data.satellites);
     return true;
 }
 
@@ -391,45 +510,17 @@ String SDManager::getCurrentTimestamp() {
     return String(millis());
 }
 
-String SDManager::getCurrentDateString() {
-    // 简单的日期字符串，实际项目中应该使用真实日期
-    unsigned long days = millis() / (24 * 60 * 60 * 1000);
-    return String(days);
-}
-
-String SDManager::getCurrentTimeString() {
-    // 生成当前时间字符串 HHMMSS
-    unsigned long currentTime = millis();
-    unsigned long hours = (currentTime % (24 * 60 * 60 * 1000)) / (60 * 60 * 1000);
-    unsigned long minutes = (currentTime % (60 * 60 * 1000)) / (60 * 1000);
-    unsigned long seconds = (currentTime % (60 * 1000)) / 1000;
-    
-    String timeStr = "";
-    if (hours < 10) timeStr += "0";
-    timeStr += String(hours);
-    if (minutes < 10) timeStr += "0";
-    timeStr += String(minutes);
-    if (seconds < 10) timeStr += "0";
-    timeStr += String(seconds);
-    
-    return timeStr;
+String SDManager::generateGPSSessionFilename() {
+    char path[48];
+    formatGPSSessionPath(path, sizeof(path));
+    return String(path);
 }
 
-String SDManager::generateGPSSessionFilename() {
-    // 生成基于启动会话的GPS文件名
-    // 格式: gps_YYYYMMDD_HHMMSS_bootXXX.geojson
-    
-    // 获取当前日期时间（简化版）
-    String dateStr = getCurrentDateString();
-    String timeStr = getCurrentTimeString();
-    
-    // 格式化启动次数
-    String bootStr = String(getBootCount());
-    while (bootStr.length() < 3) {
-        bootStr = "0" + bootStr;
-    }
-    
-    return "/data/gps/gps_" + dateStr + "_" + timeStr + "_boot" + bootStr + ".geojson";
+void SDManager::formatGPSSessionPath(char* buf, size_t size) {
+    // 生成基于记录会话的GPS文件名
+    // 格式: gps_sessionXXXXX.geojson
+    // 会话号保存在RTC内存中，短暂停车后唤醒继续写同一个文件
+    snprintf(buf, size, "/data/gps/gps_session%05lu.geojson", (unsigned long)warmBoot.sessionId());
 }
 
 int SDManager::getBootCount() {
@@ -489,6 +580,7 @@ bool SDManager::finishGPSSession() {
     file.println("  ]");
     file.println("}");
     file.close();
+    _gpsFileReady = false;
 
     debugPrint("✅ GPS会话已结束: " + filename);
     return true;
@@ -547,8 +639,56 @@ bool SDManager::directoryExists(const char* path) {
     return isDir;
 }
 
+bool SDManager::hasCustomWelcomeVoice() {
+    if (!_initialized) {
+        return false;
+    }
+
+    File file = getFileSystem().open(CUSTOM_WELCOME_VOICE_PATH, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    bool isFile = !file.isDirectory();
+    file.close();
+    return isFile;
+}
+
+String SDManager::getCustomWelcomeVoicePath() {
+    return CUSTOM_WELCOME_VOICE_PATH;
+}
+
+bool SDManager::isValidWelcomeVoiceFile() {
+    if (!hasCustomWelcomeVoice()) {
+        return false;
+    }
+
+    File file = getFileSystem().open(CUSTOM_WELCOME_VOICE_PATH, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    WavFormat fmt;
+    bool valid = wavReadHeader(file, fmt) && fmt.dataSize > 0;
+    file.close();
+
+    if (valid) {
+        debugPrint("🔊 自定义欢迎语音: " + String(fmt.sampleRate) + "Hz, " +
+                   String(fmt.channels) + "声道, " + String(fmt.bitsPerSample) + "位, " +
+                   String((uint32_t)((uint64_t)(fmt.dataSize / fmt.blockAlign) * 1000 / fmt.sampleRate)) + "ms");
+    } else {
+        debugPrint("⚠️ 自定义欢迎语音格式不支持: " CUSTOM_WELCOME_VOICE_PATH);
+    }
+    return valid;
+}
+
 void SDManager::debugPrint(const String& message) {
-    Serial.println("[SDManager] " + message);
+    debugPrint(message.c_str());
+}
+
+void SDManager::debugPrint(const char* message) {
+    Serial.print("[SDManager] ");
+    Serial.println(message);
 }
 
 // 串口命令处理
@@ -644,6 +784,7 @@ bool SDManager::handleSerialCommand(const String& command) {
         Serial.println("/data 目录: " + String(directoryExists("/data") ? "存在" : "不存在"));
         Serial.println("/data/gps 目录: " + String(directoryExists("/data/gps") ? "存在" : "不存在"));
         Serial.println("/config 目录: " + String(directoryExists("/config") ? "存在" : "不存在"));
+        Serial.println("/voice 目录: " + String(directoryExists("/voice") ? "存在" : "不存在"));
         
         Serial.println("");
         Serial.println("正在确保GPS目录存在...");
@@ -19,6 +19,8 @@
 #include "Air780EG.h"
 #include "Air780EGGNSS.h"
 
+#define GPS_RECORD_BUFFER_SIZE 512  // 一条GeoJSON数据点约 330 字节
+
 class SDManager {
 public:
     SDManager();
@@ -29,6 +31,9 @@ public:
     void end();
     bool isInitialized();
 
+    // 当前使用的文件系统（SPI模式为SD，否则为SD_MMC）
+    fs::FS& getFileSystem();
+
     // 空间信息
     uint64_t getTotalSpaceMB();
     uint64_t getFreeSpaceMB();
@@ -38,6 +43,18 @@ public:
     bool recordGPSData(gnss_data_t &gnss_data);
     bool finishGPSSession();
 
+    // 向日志文件追加一行，文件不存在时创建
+    bool appendLine(const char* path, const String& line);
+    bool appendLine(const char* path, const char* line);
+
+    // 在目录 dir 下写入二进制文件（覆盖），目录不存在时创建
+    bool writeFile(const char* dir, const char* name, const uint8_t* data, size_t len);
+
+    // 文件大小，不存在或为目录时返回 -1
+    int64_t fileSize(const char* path);
+    // 从 offset 读取最多 len 字节，返回读到的字节数，失败返回 -1（串口分块下载）
+    int readFile(const char* path, uint32_t offset, uint8_t* buf, size_t len);
+
     // 串口命令处理
     bool handleSerialCommand(const String& command);
 
@@ -54,6 +71,7 @@ public:
     String getCustomWelcomeVoicePath();
     /**
      * @brief 检查语音文件是否有效（WAV格式）
+     * 解析RIFF块，要求为 8/16/24/32 位整数PCM，采样率和声道数不限（播放时转换）
      * @return 是否有效
      */
     bool isValidWelcomeVoiceFile();
@@ -61,6 +79,12 @@ public:
 private:
     bool _initialized;
 
+    // 已确认目录和文件头存在的GPS会话，之后的记录直接追加，不再检查目录和文件
+    bool _gpsFileReady;
+    uint32_t _gpsFileSession;
+    char _gpsPath[48];
+    char _gpsRecord[GPS_RECORD_BUFFER_SIZE];    // 单条GPS记录，避免每秒拼接 String
+
     // 内部方法
     bool createDirectoryStructure();
     bool createDirectory(const char* path);
@@ -70,11 +94,11 @@ private:
     // 工具方法
     String getDeviceID();
     String getCurrentTimestamp();
-    String getCurrentDateString();
-    String getCurrentTimeString();
     String generateGPSSessionFilename();
+    void formatGPSSessionPath(char* buf, size_t size);
     int getBootCount();
     void debugPrint(const String& message);
+    void debugPrint(const char* message);
 };
 
 #endif // SDMANAGER_H
@@ -0,0 +1,97 @@
+#ifndef ADPCM_CODEC_H
+#define ADPCM_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * IMA-ADPCM 解码器（单声道，Microsoft IMA ADPCM 块格式）
+ *
+ * 块结构（block_align 字节）：
+ *   [0..1] 第一个采样点 int16（小端）
+ *   [2]    步长索引 0..88
+ *   [3]    保留
+ *   [4..]  4bit 编码数据，低半字节在前
+ * 每块采样数 = (block_align - 4) * 2 + 1
+ *
+ * 与 tools/wav_to_header.py 中的编码器一一对应，解码结果逐位一致。
+ * 内置语音的解码精度见 tools/adpcm_decode_test.cpp。
+ */
+
+#define ADPCM_DEFAULT_BLOCK_ALIGN 256
+#define ADPCM_SAMPLES_PER_BLOCK(align) (((align) - 4) * 2 + 1)
+
+static const int16_t ADPCM_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t ADPCM_INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// 每块包含的采样数
+static inline size_t adpcmSamplesPerBlock(size_t blockAlign) {
+    return blockAlign > 4 ? (blockAlign - 4) * 2 + 1 : 0;
+}
+
+// 解码单个4bit码字，更新预测值和步长索引
+static inline int16_t adpcmDecodeNibble(uint8_t nibble, int32_t& predictor, int& index) {
+    int32_t step = ADPCM_STEP_TABLE[index];
+    int32_t diff = step >> 3;
+    if (nibble & 1) diff += step >> 2;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 4) diff += step;
+    if (nibble & 8) predictor -= diff;
+    else predictor += diff;
+
+    if (predictor > 32767) predictor = 32767;
+    else if (predictor < -32768) predictor = -32768;
+
+    index += ADPCM_INDEX_TABLE[nibble & 0x0F];
+    if (index < 0) index = 0;
+    else if (index > 88) index = 88;
+
+    return (int16_t)predictor;
+}
+
+/**
+ * @brief 解码一个 IMA-ADPCM 块
+ * @param block 块数据
+ * @param blockBytes 块实际字节数（最后一块可能不足 block_align）
+ * @param out 输出缓冲区
+ * @param maxSamples 输出缓冲区可容纳的采样数
+ * @return 实际解码的采样数
+ */
+static inline size_t adpcmDecodeBlock(const uint8_t* block, size_t blockBytes,
+                                      int16_t* out, size_t maxSamples) {
+    if (blockBytes < 4 || maxSamples == 0) {
+        return 0;
+    }
+
+    int32_t predictor = (int16_t)(block[0] | (block[1] << 8));
+    int index = block[2];
+    if (index > 88) index = 88;
+
+    size_t count = 0;
+    out[count++] = (int16_t)predictor;
+
+    for (size_t i = 4; i < blockBytes && count < maxSamples; i++) {
+        uint8_t byte = block[i];
+        out[count++] = adpcmDecodeNibble(byte & 0x0F, predictor, index);
+        if (count >= maxSamples) break;
+        out[count++] = adpcmDecodeNibble(byte >> 4, predictor, index);
+    }
+
+    return count;
+}
+
+#endif // ADPCM_CODEC_H
@@ -1,21 +1,32 @@
 #include "AudioManager.h"
-#include <math.h>
 #include "FS.h"
 #include "SPIFFS.h"
+#include "AudioMixer.h"
+#include "power/PowerLocks.h"
+#include "power/PowerAccounting.h"
+#include "utils/Trace.h"
+#include "utils/Log.h"
 #include "welcome_voice.h"  // 默认语音数据
 #include "dadada_daboluocheji.h"  // 新语音数据："大大大，大菠萝车机"
 
-static const char* TAG = "AudioManager";
 
 AudioManager audioManager;
 
 AudioManager::AudioManager() : 
     initialized(false), 
-    playing(false),
+    state(AUDIO_STATE_IDLE),
+    stopRequested(false),
     wsPin(IIS_S_WS_PIN),
     bclkPin(IIS_S_BCLK_PIN), 
     dataPin(IIS_S_DATA_PIN),
-    currentWelcomeVoice(WELCOME_VOICE_DADADA) {
+    currentWelcomeVoice(WELCOME_VOICE_DADADA),
+    customWelcomeFs(NULL),
+    audioTaskHandle(NULL),
+    pendingCount(0),
+    nextSeq(0),
+    masterGain(MIXER_GAIN_UNITY) {
+    vPortCPUInitializeMutex(&queueMux);
+    customWelcomePath[0] = '\0';
 }
 
 AudioManager::~AudioManager() {
@@ -24,7 +35,7 @@ AudioManager::~AudioManager() {
 
 bool AudioManager::begin(int ws_pin, int bclk_pin, int data_pin) {
     if (initialized) {
-        ESP_LOGW(TAG, "AudioManager already initialized");
+        LOGW(AUDIO, "AudioManager already initialized");
         return true;
     }
     
@@ -32,26 +43,43 @@ bool AudioManager::begin(int ws_pin, int bclk_pin, int data_pin) {
     bclkPin = bclk_pin;
     dataPin = data_pin;
     
-    ESP_LOGI(TAG, "Initializing AudioManager with pins: WS=%d, BCLK=%d, DATA=%d", 
+    LOGI(AUDIO, "Initializing AudioManager with pins: WS=%d, BCLK=%d, DATA=%d", 
              wsPin, bclkPin, dataPin);
     
     if (!initializeI2S()) {
-        ESP_LOGE(TAG, "Failed to initialize I2S");
+        LOGE(AUDIO, "Failed to initialize I2S");
         return false;
     }
     
     initialized = true;
-    ESP_LOGI(TAG, "AudioManager initialized successfully");
+    
+    // 音频任务：所有播放都在这里完成，调用方只负责入队
+    if (xTaskCreate(audioTask, "TaskAudio", AUDIO_TASK_STACK_SIZE, this,
+                    AUDIO_TASK_PRIORITY, &audioTaskHandle) != pdPASS) {
+        LOGE(AUDIO, "Failed to create audio task");
+        deinitializeI2S();
+        initialized = false;
+        return false;
+    }
+    
+    LOGI(AUDIO, "AudioManager initialized successfully");
     return true;
 }
 
 void AudioManager::end() {
     if (!initialized) return;
     
+    stop();
+    waitUntilIdle(500);
+    if (audioTaskHandle) {
+        vTaskDelete(audioTaskHandle);
+        audioTaskHandle = NULL;
+    }
+    
     deinitializeI2S();
     initialized = false;
-    playing = false;
-    ESP_LOGI(TAG, "AudioManager deinitialized");
+    state = AUDIO_STATE_IDLE;
+    LOGI(AUDIO, "AudioManager deinitialized");
 }
 
 bool AudioManager::initializeI2S() {
@@ -63,7 +91,7 @@ bool AudioManager::initializeI2S() {
         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,  // 单声道，只使用左声道
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 8,
+        .dma_buf_count = AUDIO_DMA_BUF_COUNT,
         .dma_buf_len = AUDIO_BUFFER_SIZE,
         .use_apll = false,
         .tx_desc_auto_clear = true,
@@ -81,14 +109,14 @@ bool AudioManager::initializeI2S() {
     // 安装I2S驱动
     esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, 0, NULL);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to install I2S driver: %s", esp_err_to_name(err));
+        LOGE(AUDIO, "Failed to install I2S driver: %s", esp_err_to_name(err));
         return false;
     }
     
     // 设置引脚
     err = i2s_set_pin(I2S_PORT, &pin_config);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set I2S pins: %s", esp_err_to_name(err));
+        LOGE(AUDIO, "Failed to set I2S pins: %s", esp_err_to_name(err));
         i2s_driver_uninstall(I2S_PORT);
         return false;
     }
@@ -96,7 +124,7 @@ bool AudioManager::initializeI2S() {
     // 启动I2S
     err = i2s_start(I2S_PORT);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start I2S: %s", esp_err_to_name(err));
+        LOGE(AUDIO, "Failed to start I2S: %s", esp_err_to_name(err));
         i2s_driver_uninstall(I2S_PORT);
         return false;
     }
@@ -109,73 +137,274 @@ void AudioManager::deinitializeI2S() {
     i2s_driver_uninstall(I2S_PORT);
 }
 
-bool AudioManager::playTone(float frequency, int duration_ms, float volume) {
-    if (!initialized) {
-        ESP_LOGE(TAG, "AudioManager not initialized");
-        return false;
+void AudioManager::audioTask(void* param) {
+    AudioManager* self = static_cast<AudioManager*>(param);
+    bool locked = false;  // 播放期间持有电源锁，保证I2S时钟稳定且不进入浅睡眠
+    trace.registerTask(TRACE_TASK_AUDIO);
+    
+    for (;;) {
+        if (self->stopRequested) {
+            self->stopAllVoices();
+            self->stopRequested = false;
+            // 丢弃DMA中已混好的数据，立即静音
+            i2s_zero_dma_buffer(I2S_PORT);
+        }
+        
+        uint8_t activeMask = self->startPendingVoices();
+        if (activeMask == 0) {
+            portENTER_CRITICAL(&self->queueMux);
+            if (self->pendingCount == 0 && !self->stopRequested) {
+                self->state = AUDIO_STATE_IDLE;
+            }
+            portEXIT_CRITICAL(&self->queueMux);
+            if (locked) {
+                powerLocks.release(PM_CLIENT_AUDIO);
+                powerAccounting.setState(PA_AUDIO, PA_AUDIO_OFF);
+                locked = false;
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        
+        if (!locked) {
+            powerLocks.acquire(PM_CLIENT_AUDIO);
+            powerAccounting.setState(PA_AUDIO, PA_AUDIO_PLAY);
+            locked = true;
+        }
+
+        if (!self->stopRequested) {
+            self->state = AUDIO_STATE_PLAYING;
+        }
+        self->mixBlock(activeMask);
     }
-    
-    if (playing) {
-        ESP_LOGW(TAG, "Audio already playing, skipping");
+}
+
+bool AudioManager::enqueue(AudioRequest& request) {
+    if (!initialized || !audioTaskHandle) {
+        LOGE(AUDIO, "AudioManager not initialized");
         return false;
     }
     
-    playing = true;
-    
-    // 计算样本数
-    int samples = (AUDIO_SAMPLE_RATE * duration_ms) / 1000;
-    int16_t* audio_buffer = (int16_t*)malloc(samples * sizeof(int16_t));
+    bool queued = true;
+    portENTER_CRITICAL(&queueMux);
+    request.seq = nextSeq++;
+    if (pendingCount < AUDIO_QUEUE_LENGTH) {
+        pendingRequests[pendingCount++] = request;
+    } else {
+        // 队列已满：替换优先级最低且最早入队的请求，新请求优先级不更高时丢弃
+        uint8_t victim = 0;
+        for (uint8_t i = 1; i < pendingCount; i++) {
+            if (pendingRequests[i].priority < pendingRequests[victim].priority ||
+                (pendingRequests[i].priority == pendingRequests[victim].priority &&
+                 pendingRequests[i].seq < pendingRequests[victim].seq)) {
+                victim = i;
+            }
+        }
+        if (request.priority > pendingRequests[victim].priority) {
+            pendingRequests[victim] = request;
+        } else {
+            queued = false;
+        }
+    }
+    portEXIT_CRITICAL(&queueMux);
     
-    if (!audio_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate audio buffer");
-        playing = false;
+    if (!queued) {
+        LOGW(AUDIO, "Audio queue full, dropping request (type: %d)", request.type);
         return false;
     }
     
-    // 生成正弦波
-    float amplitude = 32767.0 * volume; // 16位最大值的音量比例
-    for (int i = 0; i < samples; i++) {
-        float t = (float)i / AUDIO_SAMPLE_RATE;
-        audio_buffer[i] = (int16_t)(amplitude * sin(2.0 * M_PI * frequency * t));
+    xTaskNotifyGive(audioTaskHandle);
+    return true;
+}
+
+bool AudioManager::dequeue(AudioRequest& request, uint8_t busyPriorities) {
+    bool found = false;
+    portENTER_CRITICAL(&queueMux);
+    // 取没有正在播放的优先级中最高的请求，同优先级按入队顺序
+    int best = -1;
+    for (uint8_t i = 0; i < pendingCount; i++) {
+        if (busyPriorities & (1 << pendingRequests[i].priority)) {
+            continue;
+        }
+        if (best < 0 ||
+            pendingRequests[i].priority > pendingRequests[best].priority ||
+            (pendingRequests[i].priority == pendingRequests[best].priority &&
+             pendingRequests[i].seq < pendingRequests[best].seq)) {
+            best = i;
+        }
     }
+    if (best >= 0) {
+        request = pendingRequests[best];
+        pendingRequests[best] = pendingRequests[--pendingCount];
+        if (state == AUDIO_STATE_IDLE) {
+            state = AUDIO_STATE_PLAYING;  // 出队与声部启动之间不能出现空闲窗口
+        }
+        found = true;
+    }
+    portEXIT_CRITICAL(&queueMux);
+    return found;
+}
+
+void AudioManager::stop() {
+    portENTER_CRITICAL(&queueMux);
+    pendingCount = 0;
+    if (state == AUDIO_STATE_PLAYING) {
+        state = AUDIO_STATE_STOPPING;
+        stopRequested = true;
+    }
+    portEXIT_CRITICAL(&queueMux);
     
-    // 播放音频
-    size_t bytes_written = 0;
-    esp_err_t err = i2s_write(I2S_PORT, audio_buffer, samples * sizeof(int16_t), 
-                              &bytes_written, portMAX_DELAY);
+    if (audioTaskHandle) {
+        xTaskNotifyGive(audioTaskHandle);
+    }
+}
+
+bool AudioManager::isBusy() const {
+    // 出队和置为播放状态在同一临界区内完成，两者一起读才不会漏掉刚出队的请求
+    portENTER_CRITICAL(&queueMux);
+    bool busy = state != AUDIO_STATE_IDLE || pendingCount > 0;
+    portEXIT_CRITICAL(&queueMux);
+    return busy;
+}
+
+bool AudioManager::waitUntilIdle(uint32_t timeout_ms) {
+    unsigned long start = millis();
+    while (isBusy()) {
+        if (millis() - start >= timeout_ms) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+uint8_t AudioManager::startPendingVoices() {
+    uint8_t activeMask = 0;      // 正在播放的声部
+    uint8_t busyPriorities = 0;  // 已有声部在播放的优先级，同优先级依次播放
+    for (uint8_t i = 0; i < AUDIO_MAX_VOICES; i++) {
+        if (channels[i].voice.isActive()) {
+            activeMask |= 1 << i;
+            busyPriorities |= 1 << channels[i].priority;
+        }
+    }
     
-    free(audio_buffer);
-    playing = false;
+    // 文件打开等耗时操作在临界区外完成
+    AudioRequest request;
+    while (activeMask != (1 << AUDIO_MAX_VOICES) - 1 && dequeue(request, busyPriorities)) {
+        // 分配第一个空闲声部
+        uint8_t index = 0;
+        while (activeMask & (1 << index)) {
+            index++;
+        }
+        MixerChannel& channel = channels[index];
+        if (startRequest(channel, request)) {
+            activeMask |= 1 << index;
+            busyPriorities |= 1 << request.priority;
+            LOGI(AUDIO, "Voice started (type: %d, priority: %d, channel: %d)", request.type, request.priority, index);
+        } else {
+            LOGW(AUDIO, "Failed to start audio request (type: %d)", request.type);
+        }
+    }
+    return activeMask;
+}
+
+bool AudioManager::startRequest(MixerChannel& channel, const AudioRequest& request) {
+    AudioVoice& voice = channel.voice;
+    bool started = false;
     
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to write I2S data: %s", esp_err_to_name(err));
-        return false;
+    switch (request.type) {
+        case AUDIO_CLIP_EVENT:
+            started = startEvent(voice, request.event);
+            break;
+        case AUDIO_CLIP_TONE:
+            started = voice.startTones(&request.frequency, &request.duration, 1, 0.5);
+            break;
+        case AUDIO_CLIP_WELCOME_VOICE:
+            started = startWelcomeVoice(voice, request.voiceType);
+            break;
+        case AUDIO_CLIP_VOICE:
+            started = request.voice && voice.startVoice(*request.voice);
+            break;
+        case AUDIO_CLIP_FILE:
+            if (request.fs == &SPIFFS && !SPIFFS.begin(true)) {
+                LOGE(AUDIO, "SPIFFS Mount Failed");
+                break;
+            }
+            started = request.fs && voice.startWavFile(*request.fs, request.filename);
+            break;
+        case AUDIO_CLIP_TEST: {
+            // 测试序列：不同频率的音调
+            const float test_frequencies[] = {440.0, 880.0, 1320.0, 660.0};
+            const int test_durations[] = {300, 300, 300, 500};
+            started = voice.startTones(test_frequencies, test_durations, 4, 0.5);
+            break;
+        }
+        default:
+            break;
     }
     
-    ESP_LOGI(TAG, "Played tone: %.1fHz for %dms, wrote %d bytes", 
-             frequency, duration_ms, bytes_written);
-    return true;
+    if (started) {
+        channel.type = request.type;
+        channel.priority = request.priority;
+        channel.gain = mixerGainFromFloat(request.gain);
+        channel.appliedGain = channel.gain;
+    }
+    return started;
 }
 
-bool AudioManager::playBeepSequence(const float* frequencies, const int* durations, 
-                                   int count, float volume) {
-    if (!initialized) return false;
+void AudioManager::stopAllVoices() {
+    for (uint8_t i = 0; i < AUDIO_MAX_VOICES; i++) {
+        channels[i].voice.stop();
+    }
+}
+
+void AudioManager::mixBlock(uint8_t activeMask) {
+    static int32_t accumulator[AUDIO_BUFFER_SIZE];
+    static int16_t voiceBuffer[AUDIO_BUFFER_SIZE];
+    static int16_t outBuffer[AUDIO_BUFFER_SIZE];
+    
+    // 最高优先级之下的声部被压低
+    uint8_t topPriority = 0;
+    for (uint8_t i = 0; i < AUDIO_MAX_VOICES; i++) {
+        if ((activeMask & (1 << i)) && channels[i].priority > topPriority) {
+            topPriority = channels[i].priority;
+        }
+    }
+    const int32_t duckGain = mixerGainFromFloat(AUDIO_DUCK_GAIN);
     
-    for (int i = 0; i < count; i++) {
-        if (!playTone(frequencies[i], durations[i], volume)) {
-            return false;
+    memset(accumulator, 0, sizeof(accumulator));
+    for (uint8_t i = 0; i < AUDIO_MAX_VOICES; i++) {
+        if (!(activeMask & (1 << i))) {
+            continue;
+        }
+        MixerChannel& channel = channels[i];
+        int32_t target = channel.gain;
+        if (channel.priority < topPriority) {
+            target = (target * duckGain) >> 15;
+        }
+        
+        size_t samples = channel.voice.render(voiceBuffer, AUDIO_BUFFER_SIZE);
+        mixerAccumulate(accumulator, voiceBuffer, samples, channel.appliedGain, target);
+        channel.appliedGain = target;
+        
+        if (!channel.voice.isActive()) {
+            LOGI(AUDIO, "Voice finished (type: %d, priority: %d, channel: %d)", channel.type, channel.priority, i);
         }
-        // 短暂间隔
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
     
-    return true;
+    mixerSaturateBlock(accumulator, outBuffer, AUDIO_BUFFER_SIZE, masterGain);
+    
+    size_t bytesWritten = 0;
+    esp_err_t err = i2s_write(I2S_PORT, outBuffer, sizeof(outBuffer), &bytesWritten, portMAX_DELAY);
+    if (err != ESP_OK) {
+        LOGE(AUDIO, "I2S write failed: %s", esp_err_to_name(err));
+    }
 }
 
 bool AudioManager::canPlaySound(unsigned long& lastPlayTime) {
     unsigned long currentTime = millis();
     if (currentTime - lastPlayTime < PlaybackState::MIN_INTERVAL) {
-        ESP_LOGW(TAG, "音频播放间隔太短，跳过播放 (间隔: %lu ms)", currentTime - lastPlayTime);
+        LOGW(AUDIO, "音频播放间隔太短，跳过播放 (间隔: %lu ms)", currentTime - lastPlayTime);
         return false;
     }
     lastPlayTime = currentTime;
@@ -186,119 +415,136 @@ bool AudioManager::playBootSuccessSound() {
     if (!canPlaySound(playbackState.lastBootSound)) {
         return false;
     }
-    
-    ESP_LOGI(TAG, "Playing boot success sound with welcome voice");
-    
-    // 播放中文语音"大菠萝车机,扎西德勒"
-    return playWelcomeVoice();
+    return playAudioEvent(AUDIO_EVENT_BOOT_SUCCESS);
 }
 
 bool AudioManager::playWiFiConnectedSound() {
     if (!canPlaySound(playbackState.lastWiFiSound)) {
         return false;
     }
-    
-    ESP_LOGI(TAG, "Playing WiFi connected sound");
-    
-    // WiFi连接音：双音调
-    const float frequencies[] = {800.0, 1200.0};
-    const int durations[] = {150, 300};
-    
-    return playBeepSequence(frequencies, durations, 2, 0.5);
+    return playAudioEvent(AUDIO_EVENT_WIFI_CONNECTED);
 }
 
 bool AudioManager::playGPSFixedSound() {
     if (!canPlaySound(playbackState.lastGPSSound)) {
         return false;
     }
-    
-    ESP_LOGI(TAG, "Playing GPS fixed sound");
-    
-    // GPS定位音：三短音
-    const float frequencies[] = {1000.0, 1000.0, 1000.0};
-    const int durations[] = {100, 100, 100};
-    
-    return playBeepSequence(frequencies, durations, 3, 0.4);
+    return playAudioEvent(AUDIO_EVENT_GPS_FIXED);
 }
 
 bool AudioManager::playLowBatterySound() {
     if (!canPlaySound(playbackState.lastBatterySound)) {
         return false;
     }
-    
-    ESP_LOGI(TAG, "Playing low battery sound");
-    
-    // 低电量警告音：下降音调
-    const float frequencies[] = {1000.0, 800.0, 600.0};
-    const int durations[] = {300, 300, 500};
-    
-    return playBeepSequence(frequencies, durations, 3, 0.7);
+    return playAudioEvent(AUDIO_EVENT_LOW_BATTERY);
 }
 
 bool AudioManager::playSleepModeSound() {
     if (!canPlaySound(playbackState.lastSleepSound)) {
         return false;
     }
-    
-    ESP_LOGI(TAG, "Playing sleep mode sound");
-    
-    // 休眠模式音：渐弱音调
-    const float frequencies[] = {800.0, 600.0};
-    const int durations[] = {200, 400};
-    
-    return playBeepSequence(frequencies, durations, 2, 0.3);
+    return playAudioEvent(AUDIO_EVENT_SLEEP_MODE);
 }
 
 bool AudioManager::playCustomBeep(float frequency, int duration) {
-    ESP_LOGI(TAG, "Playing custom beep: %.1fHz for %dms", frequency, duration);
-    return playTone(frequency, duration, 0.5);
+    AudioRequest request = {};
+    request.type = AUDIO_CLIP_TONE;
+    request.priority = AUDIO_PRIORITY_NORMAL;
+    request.gain = 1.0;
+    request.frequency = frequency;
+    request.duration = duration;
+    return enqueue(request);
 }
 
 bool AudioManager::playAudioEvent(AudioEvent event) {
-    ESP_LOGI(TAG, "Playing audio event: %d", event);
+    if (event == AUDIO_EVENT_CUSTOM) {
+        return playCustomBeep();
+    }
+    
+    AudioRequest request = {};
+    request.type = AUDIO_CLIP_EVENT;
+    request.gain = 1.0;
+    request.event = event;
     switch (event) {
-        case AUDIO_EVENT_BOOT_SUCCESS:
-            return playBootSuccessSound();
-        case AUDIO_EVENT_WIFI_CONNECTED:
-            return playWiFiConnectedSound();
-        case AUDIO_EVENT_GPS_FIXED:
-            return playGPSFixedSound();
         case AUDIO_EVENT_LOW_BATTERY:
-            return playLowBatterySound();
         case AUDIO_EVENT_SLEEP_MODE:
-            return playSleepModeSound();
-        case AUDIO_EVENT_CUSTOM:
+            request.priority = AUDIO_PRIORITY_HIGH;
+            break;
+        case AUDIO_EVENT_WIFI_CONNECTED:
+        case AUDIO_EVENT_GPS_FIXED:
+            request.priority = AUDIO_PRIORITY_LOW;
+            break;
         default:
-            return playCustomBeep();
+            request.priority = AUDIO_PRIORITY_NORMAL;
+            break;
+    }
+    return enqueue(request);
+}
+
+bool AudioManager::startEvent(AudioVoice& voice, AudioEvent event) {
+    LOGI(AUDIO, "Playing audio event: %d", event);
+    switch (event) {
+        case AUDIO_EVENT_BOOT_SUCCESS:
+            // SD卡上的自定义语音优先，失败时回退到内置语音
+            if (customWelcomeFs && voice.startWavFile(*customWelcomeFs, customWelcomePath)) {
+                return true;
+            }
+            // 播放中文语音"大菠萝车机,扎西德勒"
+            return startWelcomeVoice(voice, currentWelcomeVoice);
+        case AUDIO_EVENT_WIFI_CONNECTED: {
+            // WiFi连接音：双音调
+            const float frequencies[] = {800.0, 1200.0};
+            const int durations[] = {150, 300};
+            return voice.startTones(frequencies, durations, 2, 0.5);
+        }
+        case AUDIO_EVENT_GPS_FIXED: {
+            // GPS定位音：三短音
+            const float frequencies[] = {1000.0, 1000.0, 1000.0};
+            const int durations[] = {100, 100, 100};
+            return voice.startTones(frequencies, durations, 3, 0.4);
+        }
+        case AUDIO_EVENT_LOW_BATTERY: {
+            // 低电量警告音：下降音调
+            const float frequencies[] = {1000.0, 800.0, 600.0};
+            const int durations[] = {300, 300, 500};
+            return voice.startTones(frequencies, durations, 3, 0.7);
+        }
+        case AUDIO_EVENT_SLEEP_MODE: {
+            // 休眠模式音：渐弱音调
+            const float frequencies[] = {800.0, 600.0};
+            const int durations[] = {200, 400};
+            return voice.startTones(frequencies, durations, 2, 0.3);
+        }
+        case AUDIO_EVENT_CUSTOM:
+        default: {
+            const float frequency = 1000.0;
+            const int duration = 200;
+            return voice.startTones(&frequency, &duration, 1, 0.5);
+        }
     }
 }
 
 bool AudioManager::setVolume(float volume) {
-    // NS4168是数字功放，音量主要通过数字信号幅度控制
-    // 这里记录音量设置，在播放时使用
+    // NS4168是数字功放，音量通过数字信号幅度控制，作用于混音输出
     if (volume < 0.0) volume = 0.0;
     if (volume > 1.0) volume = 1.0;
     
-    ESP_LOGI(TAG, "Volume set to %.2f", volume);
+    masterGain = mixerGainFromFloat(volume);
+    LOGI(AUDIO, "Volume set to %.2f", volume);
     return true;
 }
 
 bool AudioManager::testAudio() {
     if (!initialized) {
-        ESP_LOGE(TAG, "AudioManager not initialized for test");
+        LOGE(AUDIO, "AudioManager not initialized for test");
         return false;
     }
     
-    ESP_LOGI(TAG, "Starting audio test sequence");
-    
-    // 测试序列：不同频率的音调
-    const float test_frequencies[] = {440.0, 880.0, 1320.0, 660.0};
-    const int test_durations[] = {300, 300, 300, 500};
-    
-    bool result = playBeepSequence(test_frequencies, test_durations, 4, 0.5);
-    
-    ESP_LOGI(TAG, "Audio test %s", result ? "PASSED" : "FAILED");
-    return result;
+    AudioRequest request = {};
+    request.type = AUDIO_CLIP_TEST;
+    request.priority = AUDIO_PRIORITY_NORMAL;
+    request.gain = 1.0;
+    return enqueue(request);
 }
 
 bool AudioManager::playWelcomeVoice() {
@@ -306,112 +552,48 @@ bool AudioManager::playWelcomeVoice() {
 }
 
 bool AudioManager::playVoiceFromFile(const char* filename) {
-    if (!initialized) {
-        ESP_LOGE(TAG, "AudioManager not initialized");
-        return false;
-    }
-    
-    if (!SPIFFS.begin(true)) {
-        ESP_LOGE(TAG, "SPIFFS Mount Failed");
-        return false;
-    }
-    
-    File audioFile = SPIFFS.open(filename, "r");
-    if (!audioFile) {
-        ESP_LOGW(TAG, "Failed to open audio file: %s", filename);
-        return false;
-    }
-    
-    ESP_LOGI(TAG, "Playing audio file: %s (size: %d bytes)", filename, audioFile.size());
-    
-    // 简单的WAV文件播放（跳过44字节的WAV头）
-    audioFile.seek(44);
-    
-    const size_t bufferSize = 1024;
-    uint8_t* buffer = (uint8_t*)malloc(bufferSize);
-    if (!buffer) {
-        ESP_LOGE(TAG, "Failed to allocate audio buffer");
-        audioFile.close();
-        return false;
-    }
-    
-    playing = true;
-    size_t totalBytesRead = 0;
-    
-    while (audioFile.available() && playing) {
-        size_t bytesRead = audioFile.read(buffer, bufferSize);
-        if (bytesRead > 0) {
-            size_t bytesWritten = 0;
-            esp_err_t err = i2s_write(I2S_PORT, buffer, bytesRead, &bytesWritten, portMAX_DELAY);
-            if (err != ESP_OK) {
-                ESP_LOGE(TAG, "I2S write failed: %s", esp_err_to_name(err));
-                break;
-            }
-            totalBytesRead += bytesRead;
-        }
-        
-        // 允许其他任务运行
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
-    
-    free(buffer);
-    audioFile.close();
-    playing = false;
-    
-    ESP_LOGI(TAG, "Audio playback completed, played %d bytes", totalBytesRead);
-    return totalBytesRead > 0;
+    return playWavFile(SPIFFS, filename);
 }
 
-bool AudioManager::playVoiceFromArray(const uint8_t* audioData, size_t dataSize) {
-    if (!initialized || !audioData || dataSize == 0) {
-        ESP_LOGE(TAG, "Invalid parameters for voice playback");
+bool AudioManager::playWavFile(fs::FS& fs, const char* path, AudioPriority priority, float gain) {
+    if (!path || strlen(path) >= AUDIO_PATH_MAX) {
+        LOGE(AUDIO, "Invalid audio file path");
         return false;
     }
     
-    ESP_LOGI(TAG, "Playing voice from array (size: %d bytes)", dataSize);
-    
-    playing = true;
-    
-    // 跳过WAV头（如果存在）
-    const uint8_t* data = audioData;
-    size_t size = dataSize;
-    
-    // 检查是否是WAV文件（以"RIFF"开头）
-    if (size > 44 && memcmp(data, "RIFF", 4) == 0) {
-        data += 44;  // 跳过WAV头
-        size -= 44;
-    }
-    
-    const size_t chunkSize = 1024;
-    size_t offset = 0;
-    
-    while (offset < size && playing) {
-        size_t currentChunkSize = (size - offset > chunkSize) ? chunkSize : (size - offset);
-        
-        size_t bytesWritten = 0;
-        esp_err_t err = i2s_write(I2S_PORT, data + offset, currentChunkSize, &bytesWritten, portMAX_DELAY);
-        
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "I2S write failed: %s", esp_err_to_name(err));
-            playing = false;
-            return false;
-        }
-        
-        offset += currentChunkSize;
-        
-        // 允许其他任务运行
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
-    
-    playing = false;
-    ESP_LOGI(TAG, "Voice playback from array completed");
-    return true;
+    AudioRequest request = {};
+    request.type = AUDIO_CLIP_FILE;
+    request.priority = priority;
+    request.gain = gain;
+    request.fs = &fs;
+    strcpy(request.filename, path);
+    return enqueue(request);
+}
+
+bool AudioManager::playVoice(const VoiceInfo& voice, AudioPriority priority, float gain) {
+    AudioRequest request = {};
+    request.type = AUDIO_CLIP_VOICE;
+    request.priority = priority;
+    request.gain = gain;
+    request.voice = &voice;
+    return enqueue(request);
 }
 
 // 欢迎语音配置方法
 void AudioManager::setWelcomeVoiceType(WelcomeVoiceType voiceType) {
     currentWelcomeVoice = voiceType;
-    ESP_LOGI(TAG, "Welcome voice type set to: %s", getWelcomeVoiceDescription());
+    LOGI(AUDIO, "Welcome voice type set to: %s", getWelcomeVoiceDescription());
+}
+
+void AudioManager::setCustomWelcomeVoice(fs::FS* fs, const char* path) {
+    if (!fs || !path || strlen(path) >= AUDIO_PATH_MAX) {
+        customWelcomeFs = NULL;
+        customWelcomePath[0] = '\0';
+        return;
+    }
+    strcpy(customWelcomePath, path);
+    customWelcomeFs = fs;
+    LOGI(AUDIO, "Custom welcome voice set to: %s", customWelcomePath);
 }
 
 WelcomeVoiceType AudioManager::getWelcomeVoiceType() const {
@@ -430,6 +612,15 @@ const char* AudioManager::getWelcomeVoiceDescription() const {
 }
 
 bool AudioManager::playWelcomeVoice(WelcomeVoiceType voiceType) {
+    AudioRequest request = {};
+    request.type = AUDIO_CLIP_WELCOME_VOICE;
+    request.priority = AUDIO_PRIORITY_NORMAL;
+    request.gain = 1.0;
+    request.voiceType = voiceType;
+    return enqueue(request);
+}
+
+bool AudioManager::startWelcomeVoice(AudioVoice& voice, WelcomeVoiceType voiceType) {
     const VoiceInfo* voiceInfo = nullptr;
     
     switch (voiceType) {
@@ -440,27 +631,26 @@ bool AudioManager::playWelcomeVoice(WelcomeVoiceType voiceType) {
             voiceInfo = &DADADA_DABOLUOCHEJI_DATA_INFO;
             break;
         default:
-            ESP_LOGE(TAG, "Unknown welcome voice type: %d", voiceType);
+            LOGE(AUDIO, "Unknown welcome voice type: %d", voiceType);
             return false;
     }
     
-    ESP_LOGI(TAG, "Playing welcome voice: %s", voiceInfo->description);
+    LOGI(AUDIO, "Playing welcome voice: %s", voiceInfo->description);
     
     // 首先尝试播放内置的语音数据
-    if (playVoiceFromArray(voiceInfo->data, voiceInfo->size)) {
-        ESP_LOGI(TAG, "Successfully played embedded voice data: %s", voiceInfo->description);
+    if (voice.startVoice(*voiceInfo)) {
         return true;
     }
     
-    // 如果内置数据播放失败，尝试从文件播放
-    if (playVoiceFromFile("/spiffs/welcome.wav")) {
-        ESP_LOGI(TAG, "Successfully played voice from SPIFFS file");
+    // 如果内置数据无效，尝试从文件播放
+    if (SPIFFS.begin(true) && voice.startWavFile(SPIFFS, "/welcome.wav")) {
+        LOGI(AUDIO, "Playing voice from SPIFFS file");
         return true;
     }
     
     // 如果都失败，播放替代的音调序列
-    ESP_LOGW(TAG, "Voice playback failed, using tone sequence fallback");
+    LOGW(AUDIO, "Voice playback failed, using tone sequence fallback");
     const float frequencies[] = {1000.0, 1000.0, 1000.0};
     const int durations[] = {100, 100, 100};
-    return playBeepSequence(frequencies, durations, 10, 0.6);
+    return voice.startTones(frequencies, durations, 3, 0.6);
 }
@@ -3,13 +3,31 @@
 
 #include <Arduino.h>
 #include "driver/i2s.h"
+#include "FS.h"
 #include "esp_log.h"
+#include "AudioVoice.h"
+#include "VoiceInfo.h"
 
 // 音频配置常量
 #define AUDIO_SAMPLE_RATE       16000    // 采样率 16kHz
 #define AUDIO_BITS_PER_SAMPLE   16       // 16位采样
 #define AUDIO_CHANNELS          1        // 单声道
-#define AUDIO_BUFFER_SIZE       1024     // 缓冲区大小
+#define AUDIO_BUFFER_SIZE       256      // DMA缓冲区/混音块大小（采样数，16ms）
+#define AUDIO_DMA_BUF_COUNT     4        // DMA缓冲区个数，决定新声部最长约64ms的起播延迟
+
+// DMA环形缓冲共 4×256 采样（64ms），读文件时它就是双缓冲的另一半：混音块等待SD读取时
+// 剩余约48ms的已混数据继续输出。一次读取（AUDIO_FILE_READ_SIZE，1024字节）超过这个时间才会断音；
+// 加大缓冲能容忍更慢的卡，代价是起播、闪避和 stop() 的延迟同样变长
+
+// 音频任务配置
+#define AUDIO_QUEUE_LENGTH      8        // 待播放请求队列长度
+#define AUDIO_TASK_STACK_SIZE   4096     // 音频任务栈大小
+#define AUDIO_TASK_PRIORITY     4        // 高于业务任务，保证DMA及时填充
+
+// 混音配置
+#define AUDIO_MAX_VOICES        3        // 声部池大小（同时播放的片段数），同一优先级同时只播放一个
+#define AUDIO_DUCK_GAIN         0.2f     // 有更高优先级声部时，低优先级声部的增益（约-14dB）
+#define AUDIO_PATH_MAX          48       // 文件路径最大长度（含结束符）
 
 // I2S端口配置
 #define I2S_PORT                I2S_NUM_0
@@ -31,37 +49,97 @@ enum WelcomeVoiceType {
     WELCOME_VOICE_DADADA,       // 新语音："大大大，大菠萝车机"
 };
 
-// 语音文件信息结构
-struct VoiceInfo {
-    const char* name;
-    const char* description;
-    const uint8_t* data;
-    size_t size;
-    uint32_t sample_rate;
-    uint8_t channels;
-    uint8_t bits_per_sample;
+// 播放优先级（数值越大越优先）
+// 不同优先级的片段同时混音，低于当前最高优先级的声部被压低（闪避）；
+// 同一优先级的片段依次播放
+enum AudioPriority : uint8_t {
+    AUDIO_PRIORITY_LOW = 0,     // 提示音：WiFi连接、GPS定位
+    AUDIO_PRIORITY_NORMAL,      // 欢迎语音、自定义音、测试
+    AUDIO_PRIORITY_HIGH,        // 告警：低电量、进入休眠
+};
+
+// 音频引擎状态
+enum AudioState : uint8_t {
+    AUDIO_STATE_IDLE = 0,       // 空闲
+    AUDIO_STATE_PLAYING,        // 正在播放
+    AUDIO_STATE_STOPPING,       // 已请求stop()，所有声部将在下一个混音块停止
+};
+
+// 播放请求类型
+enum AudioClipType : uint8_t {
+    AUDIO_CLIP_EVENT,           // 预定义音频事件
+    AUDIO_CLIP_TONE,            // 单个自定义音调
+    AUDIO_CLIP_WELCOME_VOICE,   // 欢迎语音（含回退逻辑）
+    AUDIO_CLIP_VOICE,           // 内置语音数据
+    AUDIO_CLIP_FILE,            // 文件系统（SPIFFS/SD）中的WAV文件
+    AUDIO_CLIP_TEST,            // 测试音序列
+};
+
+// 播放请求，按值拷贝进队列，不持有动态内存
+struct AudioRequest {
+    AudioClipType type;
+    AudioPriority priority;
+    uint32_t seq;               // 入队序号，同优先级先进先出
+    AudioEvent event;
+    WelcomeVoiceType voiceType;
+    const VoiceInfo* voice;     // 必须指向静态存储的语音信息
+    float gain;                 // 声部增益 0.0 - 1.0
+    float frequency;
+    int duration;
+    fs::FS* fs;                 // 文件所在的文件系统
+    char filename[AUDIO_PATH_MAX];
 };
 
 class AudioManager {
 private:
     bool initialized;
-    bool playing;
+    volatile AudioState state;
+    volatile bool stopRequested;
     int wsPin;      // WS (Word Select) 引脚
     int bclkPin;    // BCLK (Bit Clock) 引脚  
     int dataPin;    // DATA 引脚
     
     // 欢迎语音配置
     WelcomeVoiceType currentWelcomeVoice;
+    fs::FS* customWelcomeFs;                 // 自定义欢迎语音（如SD卡），为空时使用内置语音
+    char customWelcomePath[AUDIO_PATH_MAX];
     
     // I2S配置结构体
     i2s_config_t i2s_config;
     i2s_pin_config_t pin_config;
     
+    // 音频任务与请求队列（由queueMux保护）
+    TaskHandle_t audioTaskHandle;
+    mutable portMUX_TYPE queueMux;
+    AudioRequest pendingRequests[AUDIO_QUEUE_LENGTH];
+    uint8_t pendingCount;
+    uint32_t nextSeq;
+    
+    // 混音声部池，启动请求时分配空闲声部并记录其优先级；以下状态只由音频任务访问
+    struct MixerChannel {
+        AudioVoice voice;
+        AudioClipType type;
+        AudioPriority priority;
+        int32_t gain;          // 请求指定的增益（Q15）
+        int32_t appliedGain;   // 上一块实际使用的增益，闪避时平滑过渡
+    };
+    MixerChannel channels[AUDIO_MAX_VOICES];
+    volatile int32_t masterGain;  // 主音量（Q15）
+    
     // 内部方法
     bool initializeI2S();
     void deinitializeI2S();
-    bool playTone(float frequency, int duration_ms, float volume = 0.5);
-    bool playBeepSequence(const float* frequencies, const int* durations, int count, float volume = 0.5);
+    static void audioTask(void* param);
+    bool enqueue(AudioRequest& request);
+    bool dequeue(AudioRequest& request, uint8_t busyPriorities);
+    
+    // 以下方法只在音频任务中运行
+    uint8_t startPendingVoices();
+    bool startRequest(MixerChannel& channel, const AudioRequest& request);
+    bool startEvent(AudioVoice& voice, AudioEvent event);
+    bool startWelcomeVoice(AudioVoice& voice, WelcomeVoiceType voiceType);
+    void stopAllVoices();
+    void mixBlock(uint8_t activeMask);
     
 public:
     AudioManager();
@@ -72,6 +150,8 @@ public:
     void end();
     
     // 音频播放控制
+    // 所有play*方法只把请求放入队列后立即返回，由音频任务异步播放；
+    // 返回false表示未初始化、被防重复间隔过滤或队列已满
     bool playBootSuccessSound();
     bool playWiFiConnectedSound();
     bool playGPSFixedSound();
@@ -82,22 +162,33 @@ public:
     // 语音播放功能
     bool playWelcomeVoice();  // 播放当前配置的欢迎语音
     bool playWelcomeVoice(WelcomeVoiceType voiceType);  // 播放指定类型的欢迎语音
-    bool playVoiceFromFile(const char* filename);
-    bool playVoiceFromArray(const uint8_t* audioData, size_t dataSize);
+    bool playVoice(const VoiceInfo& voice, AudioPriority priority = AUDIO_PRIORITY_NORMAL,
+                   float gain = 1.0);  // 按存储格式播放内置语音
+    bool playVoiceFromFile(const char* filename);  // SPIFFS中的WAV文件
+    bool playWavFile(fs::FS& fs, const char* path, AudioPriority priority = AUDIO_PRIORITY_NORMAL,
+                     float gain = 1.0);
     
     // 欢迎语音配置
     void setWelcomeVoiceType(WelcomeVoiceType voiceType);
     WelcomeVoiceType getWelcomeVoiceType() const;
     const char* getWelcomeVoiceDescription() const;
+    void setCustomWelcomeVoice(fs::FS* fs, const char* path);  // fs为空时取消自定义语音
     
     // 音频事件播放
     bool playAudioEvent(AudioEvent event);
     
     // 状态查询
     bool isInitialized() const { return initialized; }
-    bool isPlaying() const { return playing; }
+    bool isPlaying() const { return state != AUDIO_STATE_IDLE; }  // 不含队列中尚未开始的请求
+    bool isBusy() const;  // 正在播放或队列中有请求，睡眠判断用它
+    AudioState getState() const { return state; }
+    uint8_t getPendingCount() const { return pendingCount; }
+    
+    // 播放控制
+    void stop();  // 停止所有声部并清空队列
+    bool waitUntilIdle(uint32_t timeout_ms);  // 等待队列播放完毕，不可在音频任务内调用
     
-    // 音量控制（通过PWM模拟）
+    // 音量控制（混音输出的主音量）
     bool setVolume(float volume); // 0.0 - 1.0
     
     // 测试功能
@@ -0,0 +1,309 @@
+#include "AudioVoice.h"
+#include "AudioManager.h"
+#include "utils/Log.h"
+
+
+// 内置WAV数据的读取适配，供 wavReadHeader 解析文件头
+struct MemoryReader {
+    const uint8_t* data;
+    size_t length;
+    size_t pos;
+
+    size_t size() const { return length; }
+    bool seek(uint32_t offset) { pos = offset > length ? length : offset; return true; }
+    size_t read(uint8_t* buf, size_t n) {
+        if (n > length - pos) n = length - pos;
+        memcpy(buf, data + pos, n);
+        pos += n;
+        return n;
+    }
+};
+
+AudioVoice::AudioVoice() :
+    source(VOICE_SOURCE_NONE),
+    toneCount(0),
+    toneIndex(0),
+    toneVolume(0),
+    gapSamples(0),
+    resample(false),
+    monoPos(0),
+    monoLen(0),
+    data(NULL),
+    dataPos(0),
+    dataEnd(0),
+    adpcmBlockAlign(0),
+    adpcmSamplesLeft(0),
+    rawPos(0),
+    rawLen(0),
+    filePos(0),
+    fileRemaining(0) {
+}
+
+bool AudioVoice::startTones(const float* frequencies, const int* durations, uint8_t count, float volume) {
+    stop();
+    if (count == 0 || count > AUDIO_MAX_TONES) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        toneFrequencies[i] = frequencies[i];
+        toneDurations[i] = durations[i] > 0 ? durations[i] : 0;
+    }
+    toneCount = count;
+    toneIndex = 0;
+    toneVolume = volume;
+    gapSamples = 0;
+    toneInit(osc, toneFrequencies[0], AUDIO_SAMPLE_RATE, toneDurations[0], toneVolume);
+    source = VOICE_SOURCE_TONES;
+    return true;
+}
+
+void AudioVoice::beginSampleStream(uint32_t sampleRate) {
+    resample = sampleRate != AUDIO_SAMPLE_RATE;
+    wavResamplerInit(resampler, sampleRate, AUDIO_SAMPLE_RATE);
+    monoPos = 0;
+    monoLen = 0;
+}
+
+bool AudioVoice::startVoice(const VoiceInfo& voice) {
+    stop();
+    if (!voice.data || voice.size == 0) {
+        return false;
+    }
+
+    if (voice.format == VOICE_FORMAT_IMA_ADPCM) {
+        if (adpcmSamplesPerBlock(voice.block_align) == 0 ||
+            adpcmSamplesPerBlock(voice.block_align) > AUDIO_VOICE_MONO_SIZE) {
+            LOGE(AUDIO, "Unsupported ADPCM block size: %u", voice.block_align);
+            return false;
+        }
+        data = voice.data;
+        dataPos = 0;
+        dataEnd = voice.size;
+        adpcmBlockAlign = voice.block_align;
+        adpcmSamplesLeft = voice.sample_count;
+        beginSampleStream(voice.sample_rate ? voice.sample_rate : AUDIO_SAMPLE_RATE);
+        source = VOICE_SOURCE_ADPCM_MEMORY;
+        return true;
+    }
+
+    // 内置WAV：解析文件头获得真实格式，没有头时按16kHz单声道16位处理
+    MemoryReader reader = {voice.data, voice.size, 0};
+    if (wavReadHeader(reader, format)) {
+        dataPos = format.dataOffset;
+        dataEnd = format.dataOffset + format.dataSize;
+    } else if (memcmp(voice.data, "RIFF", 4) != 0) {
+        format.formatTag = WAV_FORMAT_PCM;
+        format.channels = 1;
+        format.sampleRate = AUDIO_SAMPLE_RATE;
+        format.bitsPerSample = 16;
+        format.blockAlign = 2;
+        dataPos = 0;
+        dataEnd = voice.size & ~1u;
+    } else {
+        LOGE(AUDIO, "Unsupported embedded WAV: %s", voice.name);
+        return false;
+    }
+    data = voice.data;
+    beginSampleStream(format.sampleRate);
+    source = VOICE_SOURCE_PCM_MEMORY;
+    return true;
+}
+
+bool AudioVoice::startWavFile(fs::FS& fs, const char* path) {
+    stop();
+    file = fs.open(path, FILE_READ);
+    if (!file || file.isDirectory()) {
+        LOGW(AUDIO, "Failed to open audio file: %s", path);
+        file = File();
+        return false;
+    }
+
+    if (!wavReadHeader(file, format)) {
+        LOGW(AUDIO, "Unsupported or invalid WAV file: %s", path);
+        file.close();
+        return false;
+    }
+
+    LOGI(AUDIO, "Streaming WAV file: %s (%u Hz, %u ch, %u bit, %u bytes)",
+             path, format.sampleRate, format.channels, format.bitsPerSample, format.dataSize);
+
+    filePos = format.dataOffset;
+    fileRemaining = format.dataSize;
+    rawPos = 0;
+    rawLen = 0;
+    file.seek(filePos);
+    beginSampleStream(format.sampleRate);
+    source = VOICE_SOURCE_PCM_FILE;
+    return true;
+}
+
+void AudioVoice::stop() {
+    if (source == VOICE_SOURCE_PCM_FILE) {
+        file.close();
+    }
+    source = VOICE_SOURCE_NONE;
+}
+
+size_t AudioVoice::render(int16_t* out, size_t count) {
+    size_t produced = 0;
+    switch (source) {
+        case VOICE_SOURCE_TONES:
+            produced = renderTones(out, count);
+            break;
+        case VOICE_SOURCE_PCM_MEMORY:
+        case VOICE_SOURCE_ADPCM_MEMORY:
+        case VOICE_SOURCE_PCM_FILE:
+            produced = renderSamples(out, count);
+            break;
+        default:
+            return 0;
+    }
+
+    if (produced < count) {
+        stop();
+    }
+    return produced;
+}
+
+size_t AudioVoice::renderTones(int16_t* out, size_t count) {
+    size_t produced = 0;
+    while (produced < count) {
+        if (gapSamples > 0) {
+            size_t n = count - produced;
+            if (n > gapSamples) n = gapSamples;
+            memset(out + produced, 0, n * sizeof(int16_t));
+            produced += n;
+            gapSamples -= n;
+            continue;
+        }
+
+        if (!toneFinished(osc)) {
+            produced += toneRender(osc, out + produced, count - produced);
+            continue;
+        }
+
+        // 当前音符结束，插入间隔后开始下一个
+        if (++toneIndex >= toneCount) {
+            break;
+        }
+        gapSamples = (AUDIO_SAMPLE_RATE * AUDIO_TONE_GAP_MS) / 1000;
+        toneInit(osc, toneFrequencies[toneIndex], AUDIO_SAMPLE_RATE, toneDurations[toneIndex], toneVolume);
+    }
+    return produced;
+}
+
+size_t AudioVoice::renderSamples(int16_t* out, size_t count) {
+    size_t produced = 0;
+    while (produced < count) {
+        if (monoPos >= monoLen && !fillMono()) {
+            break;
+        }
+
+        if (!resample) {
+            size_t n = monoLen - monoPos;
+            if (n > count - produced) n = count - produced;
+            memcpy(out + produced, mono + monoPos, n * sizeof(int16_t));
+            monoPos += n;
+            produced += n;
+            continue;
+        }
+
+        size_t got = 0;
+        monoPos += wavResample(resampler, mono + monoPos, monoLen - monoPos,
+                               out + produced, count - produced, got);
+        produced += got;
+    }
+    return produced;
+}
+
+bool AudioVoice::fillMono() {
+    monoPos = 0;
+    monoLen = 0;
+
+    switch (source) {
+        case VOICE_SOURCE_ADPCM_MEMORY: {
+            if (dataPos >= dataEnd || adpcmSamplesLeft == 0) {
+                return false;
+            }
+            size_t blockBytes = dataEnd - dataPos;
+            if (blockBytes > adpcmBlockAlign) blockBytes = adpcmBlockAlign;
+            size_t samples = adpcmDecodeBlock(data + dataPos, blockBytes, mono, AUDIO_VOICE_MONO_SIZE);
+            if (samples > adpcmSamplesLeft) {
+                samples = adpcmSamplesLeft;  // 最后一块的补齐部分不播放
+            }
+            dataPos += blockBytes;
+            adpcmSamplesLeft -= samples;
+            monoLen = samples;
+            return monoLen > 0;
+        }
+
+        case VOICE_SOURCE_PCM_MEMORY: {
+            size_t used = 0;
+            if (!fillMonoFromPcm(data + dataPos, dataEnd - dataPos, used)) {
+                return false;
+            }
+            dataPos += used;
+            return true;
+        }
+
+        case VOICE_SOURCE_PCM_FILE: {
+            if (rawLen - rawPos < format.blockAlign && !refillFileBuffer()) {
+                return false;
+            }
+            size_t used = 0;
+            if (!fillMonoFromPcm(readBuffer + rawPos, rawLen - rawPos, used)) {
+                return false;
+            }
+            rawPos += used;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool AudioVoice::fillMonoFromPcm(const uint8_t* raw, size_t rawBytes, size_t& usedBytes) {
+    size_t frames = rawBytes / format.blockAlign;
+    if (frames > AUDIO_VOICE_MONO_SIZE) {
+        frames = AUDIO_VOICE_MONO_SIZE;
+    }
+    if (frames == 0) {
+        return false;
+    }
+    wavFramesToMono16(raw, frames, format, mono);
+    monoLen = frames;
+    usedBytes = frames * format.blockAlign;
+    return true;
+}
+
+bool AudioVoice::refillFileBuffer() {
+    if (fileRemaining == 0) {
+        return false;
+    }
+
+    // 保留不足一帧的尾部字节，新数据接在后面；读取结束于扇区边界，
+    // 后续读取都是整扇区，FAT层可以直接传输到缓冲区
+    size_t carry = rawLen - rawPos;
+    memmove(readBuffer, readBuffer + rawPos, carry);
+    rawPos = 0;
+    rawLen = carry;
+
+    uint32_t end = (filePos + AUDIO_FILE_READ_SIZE - carry) & ~(uint32_t)(AUDIO_SD_SECTOR_SIZE - 1);
+    size_t want = end - filePos;
+    if (want > fileRemaining) {
+        want = fileRemaining;
+    }
+
+    size_t bytesRead = file.read(readBuffer + carry, want);
+    if (bytesRead == 0) {
+        LOGW(AUDIO, "WAV file read failed, %u bytes left", fileRemaining);
+        fileRemaining = 0;
+        return false;
+    }
+    filePos += bytesRead;
+    fileRemaining -= bytesRead;
+    rawLen += bytesRead;
+    return rawLen >= format.blockAlign;
+}
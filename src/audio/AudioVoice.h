@@ -0,0 +1,98 @@
+#ifndef AUDIOVOICE_H
+#define AUDIOVOICE_H
+
+#include <Arduino.h>
+#include "FS.h"
+#include "esp_attr.h"
+#include "AdpcmCodec.h"
+#include "ToneSynth.h"
+#include "WavReader.h"
+
+// 声部配置
+#define AUDIO_MAX_TONES         4        // 单个音调序列最多音符数
+#define AUDIO_TONE_GAP_MS       50       // 音符之间的间隔
+#define AUDIO_FILE_READ_SIZE    1024     // 每次从文件读取的字节数（2个扇区，16kHz单声道16位约32ms）
+#define AUDIO_SD_SECTOR_SIZE    512      // 读取按扇区边界结束，FAT层可直接DMA到缓冲区
+#define AUDIO_VOICE_MONO_SIZE   ADPCM_SAMPLES_PER_BLOCK(ADPCM_DEFAULT_BLOCK_ALIGN)
+
+struct VoiceInfo;
+
+// 声部音源类型
+enum AudioVoiceSource : uint8_t {
+    VOICE_SOURCE_NONE = 0,
+    VOICE_SOURCE_TONES,         // 音调序列
+    VOICE_SOURCE_PCM_MEMORY,    // 内置WAV数据
+    VOICE_SOURCE_ADPCM_MEMORY,  // 内置IMA-ADPCM数据
+    VOICE_SOURCE_PCM_FILE,      // 文件系统中的WAV文件
+};
+
+/**
+ * @brief 混音器的一个声部
+ *
+ * 每种音源都以拉取方式按块输出 AUDIO_SAMPLE_RATE 的16位单声道采样，
+ * 由音频任务在填充DMA时调用；所有缓冲区都在对象内部，不使用堆内存。
+ */
+class AudioVoice {
+public:
+    AudioVoice();
+
+    bool startTones(const float* frequencies, const int* durations, uint8_t count, float volume);
+    bool startVoice(const VoiceInfo& voice);
+    bool startWavFile(fs::FS& fs, const char* path);
+    void stop();
+
+    /**
+     * @brief 生成下一段采样
+     * @param out 输出缓冲区
+     * @param count 需要的采样数
+     * @return 实际生成的采样数，小于 count 表示音源已结束
+     */
+    size_t render(int16_t* out, size_t count);
+
+    bool isActive() const { return source != VOICE_SOURCE_NONE; }
+    AudioVoiceSource getSource() const { return source; }
+
+private:
+    AudioVoiceSource source;
+
+    // 音调序列
+    float toneFrequencies[AUDIO_MAX_TONES];
+    int toneDurations[AUDIO_MAX_TONES];
+    uint8_t toneCount;
+    uint8_t toneIndex;
+    float toneVolume;
+    uint32_t gapSamples;
+    ToneOscillator osc;
+
+    // 采样数据（内置或文件），先转换为单声道再按需重采样
+    WavFormat format;
+    bool resample;
+    WavResampler resampler;
+    int16_t mono[AUDIO_VOICE_MONO_SIZE];
+    size_t monoPos;
+    size_t monoLen;
+
+    // 内存数据源
+    const uint8_t* data;
+    uint32_t dataPos;
+    uint32_t dataEnd;
+    uint16_t adpcmBlockAlign;
+    uint32_t adpcmSamplesLeft;
+
+    // 文件数据源
+    File file;
+    WORD_ALIGNED_ATTR uint8_t readBuffer[AUDIO_FILE_READ_SIZE];
+    size_t rawPos;
+    size_t rawLen;
+    uint32_t filePos;
+    uint32_t fileRemaining;
+
+    void beginSampleStream(uint32_t sampleRate);
+    size_t renderTones(int16_t* out, size_t count);
+    size_t renderSamples(int16_t* out, size_t count);
+    bool fillMono();
+    bool fillMonoFromPcm(const uint8_t* raw, size_t rawBytes, size_t& usedBytes);
+    bool refillFileBuffer();
+};
+
+#endif // AUDIOVOICE_H
@@ -0,0 +1,142 @@
+#ifndef TONE_SYNTH_H
+#define TONE_SYNTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 查表式正弦音调合成器
+ *
+ * 32位相位累加器，高8位作为查表索引，次8位做线性插值，
+ * 每个采样只有整数运算，不调用 sin()，不使用堆内存。
+ * 可选线性起音/释音包络，消除音调首尾的爆音。
+ * 基准测试见 tools/bench_tone_synth.cpp。
+ */
+
+#define TONE_LUT_BITS 8
+#define TONE_LUT_SIZE (1 << TONE_LUT_BITS)
+#define TONE_DEFAULT_RAMP_MS 5
+
+// 一个周期的正弦表，多一个点方便插值时不用回绕
+static const int16_t TONE_SINE_LUT[TONE_LUT_SIZE + 1] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739,
+    9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+    32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+    32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+    28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+    15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179,
+    6393, 5602, 4808, 4011, 3212, 2410, 1608, 804, 0, -804, -1608, -2410,
+    -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+    -20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+    -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+    -31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+    -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+    -3212, -2410, -1608, -804, 0
+};
+
+// 振荡器状态
+struct ToneOscillator {
+    uint32_t phase;          // 当前相位，2^32 对应一个周期
+    uint32_t phaseStep;      // 每个采样的相位增量
+    int32_t amplitude;       // Q15 幅度（32767 = 满幅）
+    uint32_t totalSamples;   // 音调总采样数
+    uint32_t position;       // 已输出采样数
+    uint32_t attackSamples;  // 起音长度，0 表示不使用
+    uint32_t releaseSamples; // 释音长度，0 表示不使用
+    int32_t envelope;        // 当前增益，Q16（amplitude << 16 为满幅）
+    int32_t attackStep;      // 起音阶段每采样增益增量
+    int32_t releaseStep;     // 释音阶段每采样增益减量
+};
+
+/**
+ * @brief 初始化振荡器
+ * @param osc 振荡器
+ * @param frequency 频率（Hz）
+ * @param sampleRate 采样率（Hz）
+ * @param durationMs 时长（毫秒）
+ * @param volume 音量 0.0 - 1.0
+ * @param rampMs 起音/释音时长（毫秒），0 关闭包络
+ */
+static inline void toneInit(ToneOscillator& osc, float frequency, uint32_t sampleRate,
+                            uint32_t durationMs, float volume, uint32_t rampMs = TONE_DEFAULT_RAMP_MS) {
+    if (volume < 0.0f) volume = 0.0f;
+    if (volume > 1.0f) volume = 1.0f;
+    if (frequency < 0.0f) frequency = 0.0f;
+
+    osc.phase = 0;
+    osc.phaseStep = (uint32_t)((double)frequency * 4294967296.0 / sampleRate);
+    osc.amplitude = (int32_t)(volume * 32767.0f);
+    osc.totalSamples = (uint32_t)(((uint64_t)sampleRate * durationMs) / 1000);
+    osc.position = 0;
+
+    uint32_t ramp = (uint32_t)(((uint64_t)sampleRate * rampMs) / 1000);
+    if (ramp * 2 > osc.totalSamples) {
+        ramp = osc.totalSamples / 2;  // 短音调时包络不超过一半
+    }
+    osc.attackSamples = ramp;
+    osc.releaseSamples = ramp;
+
+    int32_t full = osc.amplitude << 16;
+    osc.attackStep = ramp ? full / (int32_t)ramp : 0;
+    osc.releaseStep = osc.attackStep;
+    osc.envelope = ramp ? 0 : full;
+}
+
+// 振荡器是否已输出完毕
+static inline bool toneFinished(const ToneOscillator& osc) {
+    return osc.position >= osc.totalSamples;
+}
+
+/**
+ * @brief 生成下一段采样
+ * @param osc 振荡器
+ * @param out 输出缓冲区
+ * @param maxSamples 缓冲区可容纳的采样数
+ * @return 实际生成的采样数，音调结束时为 0
+ */
+static inline size_t toneRender(ToneOscillator& osc, int16_t* out, size_t maxSamples) {
+    uint32_t left = osc.totalSamples - osc.position;
+    size_t count = maxSamples < left ? maxSamples : left;
+
+    uint32_t phase = osc.phase;
+    int32_t envelope = osc.envelope;
+    const uint32_t step = osc.phaseStep;
+    const int32_t full = osc.amplitude << 16;
+    const uint32_t releaseStart = osc.totalSamples - osc.releaseSamples;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t index = phase >> (32 - TONE_LUT_BITS);
+        int32_t frac = (phase >> (24 - TONE_LUT_BITS)) & 0xFF;
+        int32_t a = TONE_SINE_LUT[index];
+        int32_t b = TONE_SINE_LUT[index + 1];
+        int32_t sample = a + (((b - a) * frac) >> 8);
+
+        uint32_t pos = osc.position + i;
+        if (pos < osc.attackSamples) {
+            envelope += osc.attackStep;
+            if (envelope > full) envelope = full;
+        } else if (pos >= releaseStart && osc.releaseSamples > 0) {
+            envelope -= osc.releaseStep;
+            if (envelope < 0) envelope = 0;
+        }
+
+        out[i] = (int16_t)((sample * (envelope >> 16)) >> 15);
+        phase += step;
+    }
+
+    osc.phase = phase;
+    osc.envelope = envelope;
+    osc.position += count;
+    return count;
+}
+
+#endif // TONE_SYNTH_H
@@ -0,0 +1,30 @@
+#ifndef VOICEINFO_H
+#define VOICEINFO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 内置语音的描述，生成的语音头文件（tools/wav_to_header.py）只依赖这里的类型，
+// 主机端测试 tools/adpcm_decode_test.cpp 直接包含
+
+// 语音数据存储格式
+enum VoiceFormat {
+    VOICE_FORMAT_WAV_PCM16 = 0,  // 原始WAV文件字节（16位PCM）
+    VOICE_FORMAT_IMA_ADPCM,      // IMA-ADPCM块，播放时实时解码（4:1压缩）
+};
+
+// 语音文件信息结构
+struct VoiceInfo {
+    const char* name;
+    const char* description;
+    const uint8_t* data;
+    size_t size;
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint8_t bits_per_sample;
+    VoiceFormat format;      // 存储格式，旧头文件未填写时为 WAV_PCM16
+    uint16_t block_align;    // ADPCM块大小（字节）
+    uint32_t sample_count;   // 解码后的总采样数
+};
+
+#endif // VOICEINFO_H
@@ -0,0 +1,205 @@
+#ifndef WAV_READER_H
+#define WAV_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * WAV 文件解析与流式格式转换
+ *
+ * - 按 RIFF 块逐个解析，跳过 LIST/fact 等无关块，找到 fmt 和 data 块
+ * - 支持 8/16/24/32 位整数 PCM（含 WAVE_FORMAT_EXTENSIBLE），单声道或多声道
+ * - 多声道取平均混成单声道，线性插值重采样到 I2S 采样率
+ *
+ * 文件读取通过模板参数完成，只要求 read(uint8_t*, size_t)、seek(uint32_t)、
+ * size() 三个方法，fs::File 可直接使用。
+ */
+
+#define WAV_FORMAT_PCM          0x0001
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+#define WAV_MAX_CHUNKS          16       // 最多扫描的块数，防止损坏文件死循环
+
+struct WavFormat {
+    uint16_t formatTag;
+    uint16_t channels;
+    uint32_t sampleRate;
+    uint16_t bitsPerSample;
+    uint16_t blockAlign;     // 每帧字节数（所有声道）
+    uint32_t dataOffset;     // data 块数据起始位置
+    uint32_t dataSize;       // data 块字节数（已按文件实际大小截断）
+};
+
+static inline uint16_t wavReadLe16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t wavReadLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 是否是本播放器支持的格式
+static inline bool wavIsSupported(const WavFormat& fmt) {
+    if (fmt.formatTag != WAV_FORMAT_PCM && fmt.formatTag != WAV_FORMAT_EXTENSIBLE) return false;
+    if (fmt.channels == 0 || fmt.channels > 8) return false;
+    if (fmt.sampleRate < 4000 || fmt.sampleRate > 96000) return false;
+    if (fmt.bitsPerSample != 8 && fmt.bitsPerSample != 16 &&
+        fmt.bitsPerSample != 24 && fmt.bitsPerSample != 32) return false;
+    return fmt.blockAlign == fmt.channels * (fmt.bitsPerSample / 8);
+}
+
+/**
+ * @brief 解析 WAV 文件头
+ * @param file 已打开的文件，解析后读写位置不确定，播放前需 seek(dataOffset)
+ * @param fmt 输出格式信息
+ * @return 找到 fmt 和 data 块且格式受支持时返回 true
+ */
+template <typename Reader>
+static bool wavReadHeader(Reader& file, WavFormat& fmt) {
+    uint8_t header[12];
+    uint32_t fileSize = file.size();
+
+    memset(&fmt, 0, sizeof(fmt));
+    file.seek(0);
+    if (file.read(header, 12) != 12 ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool haveFmt = false;
+    uint32_t pos = 12;
+    for (int i = 0; i < WAV_MAX_CHUNKS && pos + 8 <= fileSize; i++) {
+        uint8_t chunk[8];
+        file.seek(pos);
+        if (file.read(chunk, 8) != 8) {
+            return false;
+        }
+        uint32_t chunkSize = wavReadLe32(chunk + 4);
+        pos += 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t body[16];
+            if (chunkSize < 16 || file.read(body, 16) != 16) {
+                return false;
+            }
+            fmt.formatTag = wavReadLe16(body);
+            fmt.channels = wavReadLe16(body + 2);
+            fmt.sampleRate = wavReadLe32(body + 4);
+            fmt.blockAlign = wavReadLe16(body + 12);
+            fmt.bitsPerSample = wavReadLe16(body + 14);
+            haveFmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFmt) {
+                return false;  // fmt 必须在 data 之前
+            }
+            fmt.dataOffset = pos;
+            fmt.dataSize = (chunkSize > fileSize - pos) ? (fileSize - pos) : chunkSize;
+            fmt.dataSize -= fmt.dataSize % (fmt.blockAlign ? fmt.blockAlign : 1);
+            return wavIsSupported(fmt);
+        }
+
+        // 块按偶数字节对齐
+        pos += chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+/**
+ * @brief 把一段 PCM 帧转换为 16 位单声道
+ * @param in 原始字节，必须是完整帧
+ * @param frames 帧数
+ * @param fmt 格式
+ * @param out 输出缓冲区，至少 frames 个采样
+ */
+static inline void wavFramesToMono16(const uint8_t* in, size_t frames, const WavFormat& fmt, int16_t* out) {
+    const uint16_t channels = fmt.channels;
+    const uint16_t bytes = fmt.bitsPerSample / 8;
+
+    if (channels == 1 && bytes == 2) {
+        for (size_t i = 0; i < frames; i++) {
+            out[i] = (int16_t)wavReadLe16(in + i * 2);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        int32_t sum = 0;
+        for (uint16_t c = 0; c < channels; c++) {
+            const uint8_t* p = in + (i * channels + c) * bytes;
+            switch (bytes) {
+                case 1: sum += ((int32_t)p[0] - 128) * 256; break;         // 8 位无符号
+                case 2: sum += (int16_t)wavReadLe16(p); break;
+                case 3: sum += (int16_t)(p[1] | (p[2] << 8)); break;      // 取高 16 位
+                default: sum += (int16_t)wavReadLe16(p + 2); break;
+            }
+        }
+        out[i] = (int16_t)(sum / channels);
+    }
+}
+
+// 线性插值重采样器，状态跨块保持，可以逐块喂入
+struct WavResampler {
+    uint32_t step;       // 每个输出采样前进的输入采样数，Q16
+    uint32_t position;   // 相对 previous 的位置，Q16
+    int16_t previous;    // 上一块的最后一个输入采样
+    bool primed;
+};
+
+static inline void wavResamplerInit(WavResampler& rs, uint32_t inRate, uint32_t outRate) {
+    rs.step = (uint32_t)(((uint64_t)inRate << 16) / outRate);
+    rs.position = 0;
+    rs.previous = 0;
+    rs.primed = false;
+}
+
+/**
+ * @brief 重采样一段输入
+ * @param rs 重采样器
+ * @param in 输入采样
+ * @param inCount 输入采样数
+ * @param out 输出缓冲区
+ * @param maxOut 输出缓冲区容量
+ * @param produced 实际输出的采样数
+ * @return 消耗的输入采样数；输出缓冲区写满时可能小于 inCount，剩余部分需再次调用
+ */
+static inline size_t wavResample(WavResampler& rs, const int16_t* in, size_t inCount,
+                                 int16_t* out, size_t maxOut, size_t& produced) {
+    size_t consumedBase = 0;
+    produced = 0;
+    if (inCount == 0) {
+        return 0;
+    }
+    if (!rs.primed) {
+        rs.previous = in[0];
+        rs.primed = true;
+        in++;
+        inCount--;
+        consumedBase = 1;
+    }
+
+    // 扩展序列 x[0] = previous, x[k] = in[k-1]
+    uint32_t pos = rs.position;
+    while (produced < maxOut) {
+        uint32_t index = pos >> 16;
+        if (index >= inCount) {
+            break;
+        }
+        int32_t a = index == 0 ? rs.previous : in[index - 1];
+        int32_t b = in[index];
+        int32_t frac = (pos & 0xFFFF) >> 1;  // 15 位小数，乘积不溢出 int32
+        out[produced++] = (int16_t)(a + (((b - a) * frac) >> 15));
+        pos += rs.step;
+    }
+
+    size_t consumed = pos >> 16;
+    if (consumed > inCount) {
+        consumed = inCount;
+    }
+    if (consumed > 0) {
+        rs.previous = in[consumed - 1];
+    }
+    rs.position = pos - (uint32_t)(consumed << 16);
+    return consumedBase + consumed;
+}
+
+#endif // WAV_READER_H
@@ -1,241 +1,184 @@
 #include "BAT.h"
 #include "config.h"
+#include "power/PowerLocks.h"
+#include "BatteryAdc.h"
+#include "utils/Log.h"
 
 BAT bat(BAT_PIN, CHARGING_STATUS_PIN);
 
+static const SocEstimatorConfig SOC_CONFIG = {
+    BAT_CAPACITY_MAH,
+    BAT_RESISTANCE_MOHM,
+    15.0f,  // ADC和OCV曲线的电压误差
+    0.05f,  // 模型漂移每小时 5%
+    {BAT_LOAD_BASE_MA, BAT_LOAD_MODEM_MA, BAT_LOAD_GNSS_MA, BAT_LOAD_AUDIO_MA, BAT_LOAD_BLE_MA,
+     BAT_CHARGE_CURRENT_MA},
+};
+
 BAT::BAT(int adc_pin, int charging_pin)
     : pin(adc_pin),
       charging_pin(charging_pin),
       _is_charging(false),
-      min_voltage(2800),
-      max_voltage(4200),
-      buffer_index(0),
+      _is_low(false),
       voltage(0),
-      ema_voltage(0),
-      last_output_voltage(0),
+      ema_voltage(),
       stable_voltage(0),
-      output_counter(0),
-      observed_max(0),
-      observed_min(5000),
-      last_calibration(0),
-      stable_count(0),
-      _debug(false)
+      last_publish(0),
+      soc(SOC_CONFIG),
+      _trace(false)
 {
-    loadCalibration();  // 加载已保存的校准数据
-}
-
-void BAT::debugPrint(const String& message) {
-    if (!_debug) return;
-    
-    unsigned long currentTime = millis();
-    Serial.print("[BAT] [debug] [");
-    Serial.print(currentTime);
-    Serial.print("ms] ");
-    Serial.println(message);
 }
 
 void BAT::begin()
 {
-    // setDebug(true);
-
     pinMode(pin, INPUT);
     pinMode(charging_pin, INPUT_PULLUP); // 初始化充电检测引脚
+    deviceState.set(DS_BATTERY, &device_state_t::battery_runtime_min, -1);
 
-    // 初始化缓冲区
-    memset(voltage_buffer, 0, sizeof(voltage_buffer));
+    // ADC由后台定时器采样，loop() 只取结果
+    batteryAdc.begin(pin);
     
-    String debug_msg = "初始化开始\n";
-    debug_msg += "配置 -> 引脚: " + String(pin) + ", ADC通道: " + String(analogGetChannel(pin)) + "\n";
-    debug_msg += "参数 -> 最小电压: " + String(min_voltage) + "mV, 最大电压: " + String(max_voltage) + "mV\n";
-    debug_msg += "滤波 -> 窗口大小: " + String(FILTER_WINDOW_SIZE) + ", EMA系数: " + String(EMA_ALPHA, 3) + "\n";
-    debug_msg += "校准 -> 间隔: " + String(CALIBRATION_INTERVAL) + "ms, 稳定阈值: " + String(STABLE_COUNT);
-    debugPrint(debug_msg);
+    LOGI(BAT, "初始化 -> 引脚: %d, ADC通道: %d", pin, analogGetChannel(pin));
+    LOGD(BAT, "模型 -> 容量: %dmAh, 内阻: %dmΩ", BAT_CAPACITY_MAH, BAT_RESISTANCE_MOHM);
+    LOGD(BAT, "采样 -> 发布周期: %dms, EMA系数: %.3f", BAT_PUBLISH_INTERVAL_MS, EMA_ALPHA);
 }   
 
-void BAT::loadCalibration()
-{
-    PreferencesUtils::loadBatteryRange(min_voltage, max_voltage);
-    observed_min = min_voltage;
-    observed_max = max_voltage;
-    debugPrint("加载校准数据 -> min: " + String(min_voltage) + "mV, max: " + String(max_voltage) + "mV");
-}
-
-void BAT::saveCalibration()
+void BAT::loop()
 {
-    PreferencesUtils::saveBatteryRange(observed_min, observed_max);
-    String debug_msg = "保存校准数据 -> min: " + String(observed_min) + "mV, max: " + String(observed_max) + "mV";
-    debug_msg += " [变化: " + String(observed_min - min_voltage) + "mV, " + String(observed_max - max_voltage) + "mV]";
-    debugPrint(debug_msg);
-}
+    // 更新充电状态
+    _is_charging = (digitalRead(charging_pin) == LOW);
+    deviceState.set(DS_BATTERY, &device_state_t::is_charging, _is_charging);
 
-void BAT::updateCalibration()
-{
-    if (stable_voltage < VOLTAGE_MIN_LIMIT || stable_voltage > VOLTAGE_MAX_LIMIT) {
-        debugPrint("电压超出校准范围: " + String(stable_voltage) + "mV [" + 
-                   String(VOLTAGE_MIN_LIMIT) + "-" + String(VOLTAGE_MAX_LIMIT) + "]");
+    // 按发布周期取走后台采样窗口的平均值，不等待ADC
+    unsigned long now = millis();
+    if (last_publish != 0 && now - last_publish < BAT_PUBLISH_INTERVAL_MS) {
+        return;
+    }
+    int adc_mv;
+    if (!batteryAdc.take(adc_mv)) {
         return;
     }
+    last_publish = now;
+    voltage = adc_mv * BAT_VOLTAGE_DIVIDER;
 
-    bool changed = false;
-    
-    // 更新观察到的最大/最小值
-    if (stable_voltage > observed_max) {
-        debugPrint("发现新的最大电压: " + String(stable_voltage) + "mV (原: " + String(observed_max) + "mV)");
-        observed_max = stable_voltage;
-        changed = true;
+    // 1. 指数移动平均滤波 (EMA)
+    if (ema_voltage.raw == 0)
+    {
+        ema_voltage = Q16::fromInt(voltage);
+        stable_voltage = voltage;
     }
-    if (stable_voltage < observed_min) {
-        debugPrint("发现新的最小电压: " + String(stable_voltage) + "mV (原: " + String(observed_min) + "mV)");
-        observed_min = stable_voltage;
-        changed = true;
+    else
+    {
+        static const Q16 alpha(EMA_ALPHA);
+        static const Q16 alphaJump(EMA_ALPHA * 0.5f);
+        int voltage_diff = abs(voltage - ema_voltage.toInt());
+        ema_voltage += (Q16::fromInt(voltage) - ema_voltage) * (voltage_diff > MAX_VOLTAGE_JUMP ? alphaJump : alpha);
     }
 
-    // 如果电压稳定且超过校准间隔，更新校准参数
-    unsigned long now = millis();
-    if (changed) {
-        stable_count = 0;  // 重置稳定计数
-    } else {
-        stable_count++;
-        if (stable_count >= STABLE_COUNT && 
-            (now - last_calibration) > CALIBRATION_INTERVAL) {
-            // 更新校准参数
-            if (abs(observed_max - max_voltage) > 50 || 
-                abs(observed_min - min_voltage) > 50) {
-                String debug_msg = "校准更新 -> 稳定计数: " + String(stable_count);
-                debug_msg += ", 间隔: " + String(now - last_calibration) + "ms";
-                debugPrint(debug_msg);
-                
-                min_voltage = observed_min;
-                max_voltage = observed_max;
-                saveCalibration();
-                last_calibration = now;
-            }
-        }
+    // 2. 输出迟滞 - 变化超过5mV才更新显示电压
+    int ema_mv = ema_voltage.toInt();
+    if (abs(ema_mv - stable_voltage) > 5)
+    {
+        stable_voltage = ema_mv;
     }
-}
 
-void BAT::loop()
-{
-    // 更新充电状态
-    _is_charging = (digitalRead(charging_pin) == LOW);
-    device_state.is_charging = _is_charging;
-
-    static constexpr float VOLTAGE_MULTIPLIER = 2.0f; // 电压倍数常量
-    static constexpr int ADC_MAX_VALUE = 4095;        // ADC最大值
-    static int last_percentage = -1;                  // 上一次显示的百分比
-
-    // 多次采样取平均，进一步抑制ADC抖动
-    int sum_analogVolts = 0;
-    const int ADC_SAMPLE_COUNT = 4;
-    for (int i = 0; i < ADC_SAMPLE_COUNT; ++i) {
-        sum_analogVolts += analogReadMilliVolts(this->pin);
-        delay(2); // 适当延时
+    // 低电量判定与深度睡眠监测使用同一阈值和迟滞
+    bool is_low = batteryLowUpdate(_is_low, stable_voltage, BAT_LOW_VOLTAGE_MV, BAT_LOW_HYSTERESIS_MV);
+    if (is_low != _is_low) {
+        _is_low = is_low;
+        deviceState.set(DS_BATTERY_LOW, &device_state_t::battery_low, is_low);
+        Serial.printf("[BAT] %s: %d mV\n", is_low ? "电池电量低" : "电池电量恢复", stable_voltage);
     }
-    int analogVolts = sum_analogVolts / ADC_SAMPLE_COUNT;
-    int current_voltage = analogVolts * VOLTAGE_MULTIPLIER;
 
-    // 1. 滑动窗口平均滤波 - 使用运行总和优化计算
-    static int running_sum = 0;
+    deviceState.set(DS_BATTERY, &device_state_t::battery_voltage, stable_voltage);
 
-    if (running_sum == 0 && voltage == 0)
-    {
-        for (int i = 0; i < FILTER_WINDOW_SIZE; i++)
-        {
-            voltage_buffer[i] = current_voltage;
-        }
-        running_sum = current_voltage * FILTER_WINDOW_SIZE;
-        voltage = current_voltage;
-        ema_voltage = current_voltage;
-        last_output_voltage = current_voltage;
-        stable_voltage = current_voltage;
-    }
-    else
-    {
-        running_sum -= voltage_buffer[buffer_index];
-        running_sum += current_voltage;
-        voltage_buffer[buffer_index] = current_voltage;
-        buffer_index = (buffer_index + 1) % FILTER_WINDOW_SIZE;
-        voltage = running_sum / FILTER_WINDOW_SIZE;
-    }
+    // 电量由模型估计，不随瞬时负载的压降跳变
+    updateSoc();
+}
 
-    // 2. 指数移动平均滤波 (EMA)
-    if (ema_voltage == 0)
-    {
-        ema_voltage = voltage;
+// 已知负载：4G在网、GNSS定位、音频播放、BLE连接
+uint8_t BAT::currentLoads()
+{
+    uint8_t loads = 0;
+    device_state_t state = deviceState.snapshot();
+    if (state.gsmReady) loads |= BAT_LOAD_MODEM;
+    if (state.gnssReady) loads |= BAT_LOAD_GNSS;
+    if (powerLocks.isHeld(PM_CLIENT_AUDIO)) loads |= BAT_LOAD_AUDIO;
+    if (state.bleConnected) loads |= BAT_LOAD_BLE;
+    return loads;
+}
+
+void BAT::updateSoc()
+{
+    static int last_percentage = -1;
+
+    uint8_t loads = currentLoads();
+    // 用过采样平均的端电压，EMA的延迟会让负载补偿对不上
+    soc.update(millis(), voltage, loads, _is_charging);
+    if (_trace) {
+        Serial.printf("bat,%lu,%d,%u,%d\n", millis(), voltage, loads, _is_charging ? 1 : 0);
     }
-    else
-    {
-        int voltage_diff = abs(voltage - ema_voltage);
-        float alpha = EMA_ALPHA;
-        if (voltage_diff > MAX_VOLTAGE_JUMP)
-        {
-            alpha = EMA_ALPHA * 0.5f;
-        }
-        ema_voltage = (int)(alpha * voltage + (1.0f - alpha) * ema_voltage);
+    if (!soc.isReady()) {
+        return;
     }
 
-    // 3. 输出分频 - 每N次计算才更新一次输出值
-    output_counter = (output_counter + 1) % OUTPUT_DIVIDER;
-    if (output_counter == 0)
+    int percentage = constrain(soc.percent(), 0, 100);
+    int sigma = soc.sigmaPercent();
+    int runtime = soc.runtimeMinutes();
+    // 只有当百分比变化超过1%才更新
+    bool publish = abs(percentage - last_percentage) >= 1 || last_percentage == -1;
     {
-        int output_diff = abs(ema_voltage - last_output_voltage);
-        if (output_diff > 5 || last_output_voltage == 0)
-        {
-            last_output_voltage = ema_voltage;
+        // 电量、不确定度和剩余时间一次写入，读取方看到的是同一次估计（写入期间处于临界区，不能打印）
+        DeviceStateBus::Writer state(deviceState);
+        state.set(DS_BATTERY, &device_state_t::battery_soc_error, sigma);
+        state.set(DS_BATTERY, &device_state_t::battery_runtime_min, runtime);
+        if (publish) {
+            state.set(DS_BATTERY, &device_state_t::battery_percentage, percentage);
         }
-        stable_voltage = last_output_voltage;
     }
 
-    // 更新校准
-    updateCalibration();
-
-    // 使用新的百分比计算方法
-    int percentage = calculatePercentage(stable_voltage);
-    percentage = constrain(percentage, 0, 100);
-
-    // 只有当百分比变化超过1%才更新
-    if (abs(percentage - last_percentage) >= 1 || last_percentage == -1) {
-        device_state.battery_voltage = stable_voltage;
-        device_state.battery_percentage = percentage;
+    if (publish) {
         last_percentage = percentage;
-        
-        String debug_msg = "状态更新 -> 充电: " + String(_is_charging ? "是" : "否");
-        debug_msg += ", 电压: " + String(stable_voltage) + "mV (" + String(percentage) + "%)";
-        debug_msg += ", 范围: " + String(min_voltage) + "-" + String(max_voltage) + "mV";
-        debug_msg += "\n滤波详情 -> 原始: " + String(current_voltage) + "mV";
-        debug_msg += ", 窗口: " + String(voltage) + "mV";
-        debug_msg += ", EMA: " + String(ema_voltage) + "mV";
-        debug_msg += ", 稳定: " + String(stable_voltage) + "mV";
-        debugPrint(debug_msg);
+
+        LOGD(BAT, "状态更新 -> 充电: %s, 电量: %d%% ±%d%%, 剩余: %dmin", _is_charging ? "是" : "否", percentage,
+             soc.sigmaPercent(), soc.runtimeMinutes());
+        LOGD(BAT, "电压详情 -> 采样: %dmV, OCV: %.0fmV, 负载: %.0fmA, 稳定: %dmV", voltage, soc.ocvMv(), soc.loadMa(),
+             stable_voltage);
     }
 }
 
-void BAT::print_voltage()
+void BAT::printSoc()
 {
-    String debug_msg = "电压报告 -> " + String(stable_voltage) + "mV";
-    debug_msg += " (" + String(device_state.battery_percentage) + "%)";
-    debug_msg += ", 充电: " + String(device_state.is_charging ? "是" : "否");
-    debugPrint(debug_msg);
+    Serial.println("=== 电池电量估计 ===");
+    if (!soc.isReady()) {
+        Serial.println("尚未完成初始化");
+        return;
+    }
+    Serial.printf("电量: %d%% ±%d%%\n", soc.percent(), soc.sigmaPercent());
+    if (soc.runtimeMinutes() >= 0) {
+        Serial.printf("剩余时间: %d 小时 %d 分钟 (平均电流 %.0f mA)\n", soc.runtimeMinutes() / 60,
+                      soc.runtimeMinutes() % 60, soc.averageLoadMa());
+    } else {
+        Serial.printf("剩余时间: %s\n", _is_charging ? "充电中" : "未知");
+    }
+    Serial.printf("端电压: %d mV, 开路电压: %.0f mV, 当前负载: %.0f mA (0x%02X)\n", voltage, soc.ocvMv(),
+                  soc.loadMa(), currentLoads());
+    Serial.printf("模型: %d mAh, %d mΩ, 剔除突发采样 %lu 次\n", BAT_CAPACITY_MAH, BAT_RESISTANCE_MOHM,
+                  (unsigned long)soc.rejectedCount());
+    Serial.printf("ADC: %s, 校准 %s, 累计采样 %lu 次\n", batteryAdc.isRunning() ? "后台定时采样" : "单次读取",
+                  batteryAdc.calibrationName(), (unsigned long)batteryAdc.totalSamples());
 }
 
-const int BAT::VOLTAGE_LEVELS[] = {4200, 4000, 3800, 3600, 3400, 3200, 3000, 2800};
-const int BAT::PERCENT_LEVELS[] = {100,   90,   80,   60,   45,   30,   15,    0};
-const int BAT::LEVEL_COUNT = 8;  // 数组大小固定为8
+void BAT::end()
+{
+    batteryAdc.stop();
+}
 
-int BAT::calculatePercentage(int voltage) {
-    if (voltage >= VOLTAGE_LEVELS[0]) return 100;
-    if (voltage <= VOLTAGE_LEVELS[LEVEL_COUNT-1]) return 0;
-    
-    // 查找电压所在区间
-    for (int i = 0; i < LEVEL_COUNT-1; i++) {
-        if (voltage <= VOLTAGE_LEVELS[i] && voltage > VOLTAGE_LEVELS[i+1]) {
-            // 线性插值计算百分比
-            return map(voltage, 
-                      VOLTAGE_LEVELS[i+1], VOLTAGE_LEVELS[i],
-                      PERCENT_LEVELS[i+1], PERCENT_LEVELS[i]);
-        }
-    }
-    return 0;
+void BAT::print_voltage()
+{
+    device_state_t state = deviceState.snapshot();
+    LOGD(BAT, "电压报告 -> %dmV (%d%%), 充电: %s", stable_voltage, state.battery_percentage,
+         state.is_charging ? "是" : "否");
 }
 
 // 新增实现
@@ -3,11 +3,11 @@
 
 #include <Arduino.h>
 #include "device.h"
-#include "utils/PreferencesUtils.h"
+#include "power/SleepMonitorLogic.h"
+#include "SocEstimator.h"
+#include "utils/FastMath.h"
 
-#define FILTER_WINDOW_SIZE 20 // 滤波窗口大小
 #define EMA_ALPHA 0.1f       // 指数平均滤波系数
-#define OUTPUT_DIVIDER 5     // 输出分频器
 #define MAX_VOLTAGE_JUMP 50  // 最大允许电压跳变值(mV)
 
 class BAT
@@ -16,55 +16,42 @@ public:
     BAT(int adc_pin, int charging_pin);
     void begin();
     void loop();
+    // 停止后台采样，进入深度睡眠前调用
+    void end();
     void print_voltage();
-    
-    // 添加调试控制
-    void setDebug(bool debug) { _debug = debug; }
 
     // 新增：获取充电状态
     bool isCharging();
 
+    // 低电量（BAT_LOW_VOLTAGE_MV，带迟滞），深度睡眠监测据此决定是否还需要低电量唤醒
+    bool isLow() const { return _is_low; }
+
+    // 电量估计状态，串口命令 bat.soc
+    void printSoc();
+
+    // 每次估计时输出一行 bat,<毫秒>,<mV>,<负载>,<充电>，供 tools/soc_estimator_sim.cpp 回放
+    void setTrace(bool trace) { _trace = trace; }
+    bool isTracing() const { return _trace; }
+
 private:
-    // 改为普通的静态常量数组声明
-    static const int VOLTAGE_LEVELS[];
-    static const int PERCENT_LEVELS[];
-    static const int LEVEL_COUNT;
-    
     const int pin;
     const int charging_pin; // 新增：充电状态引脚
     bool _is_charging;      // 新增：充电状态缓存
+    bool _is_low;           // 低电量状态
 
-    int min_voltage;
-    int max_voltage;
-    int voltage;        // 简单平均滤波后的电压
+    int voltage;        // 一个发布周期内过采样平均的电压
 
     // 滤波相关
-    int voltage_buffer[FILTER_WINDOW_SIZE];
-    int buffer_index;
-    int ema_voltage;         // 指数移动平均
-    int last_output_voltage; // 最后输出电压
-    int stable_voltage;      // 稳定电压
-    int output_counter;      // 输出分频计数器
+    Q16 ema_voltage;         // 指数移动平均（mV，定点保留小数，小幅变化不会被截断）
+    int stable_voltage;      // 稳定电压（变化超过5mV才更新）
+    unsigned long last_publish;
+
+    // 电量估计
+    SocEstimator soc;
+    bool _trace;
 
-    // 调试相关
-    bool _debug;
-    void debugPrint(const String& message);
-    
-    // 校准相关
-    static constexpr int VOLTAGE_MAX_LIMIT = 4500;
-    static constexpr int VOLTAGE_MIN_LIMIT = 2500;
-    static constexpr int CALIBRATION_INTERVAL = 60000;
-    static constexpr int STABLE_COUNT = 10;
-    
-    int observed_max;
-    int observed_min;
-    unsigned long last_calibration;
-    int stable_count;
-    
-    void updateCalibration();
-    void loadCalibration();
-    void saveCalibration();
-    int calculatePercentage(int voltage);
+    uint8_t currentLoads();
+    void updateSoc();
 };
 
 extern BAT bat;
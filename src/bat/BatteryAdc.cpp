@@ -0,0 +1,144 @@
+#include "BatteryAdc.h"
+#include "config.h"
+
+BatteryAdc batteryAdc;
+
+BatteryAdc::BatteryAdc()
+    : pin(-1),
+      channel(-1),
+      timer(NULL),
+      calType(ESP_ADC_CAL_VAL_DEFAULT_VREF),
+      calibrated(false),
+      mux(portMUX_INITIALIZER_UNLOCKED),
+      windowSum(0),
+      windowCount(0),
+      total(0)
+{
+}
+
+bool BatteryAdc::begin(int adcPin)
+{
+    pin = adcPin;
+    calibrate();
+
+    int ch = digitalPinToAnalogChannel(pin);
+    if (ch < 0 || ch >= ADC1_CHANNEL_MAX)
+    {
+        Serial.printf("[BAT] GPIO%d 不在ADC1上，改为取值时单次读取\n", pin);
+        channel = -1;
+        return false;
+    }
+    channel = ch;
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten((adc1_channel_t)channel, ADC_ATTEN_DB_11);
+
+    if (timer == NULL)
+    {
+        esp_timer_create_args_t args = {};
+        args.callback = onTimer;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "bat_adc";
+        if (esp_timer_create(&args, &timer) != ESP_OK)
+        {
+            timer = NULL;
+            Serial.println("[BAT] 采样定时器创建失败，改为取值时单次读取");
+            return false;
+        }
+    }
+    esp_timer_start_periodic(timer, (uint64_t)BAT_ADC_SAMPLE_PERIOD_MS * 1000);
+
+    Serial.printf("[BAT] 后台采样: ADC1_CH%d, 每 %d ms x%d, 校准: %s\n", channel, BAT_ADC_SAMPLE_PERIOD_MS,
+                  BAT_ADC_OVERSAMPLE, calibrationName());
+    return true;
+}
+
+void BatteryAdc::stop()
+{
+    if (timer != NULL)
+    {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+        timer = NULL;
+    }
+}
+
+bool BatteryAdc::take(int& adcMv)
+{
+    if (timer == NULL)
+    {
+        if (pin < 0)
+        {
+            return false;
+        }
+        adcMv = analogReadMilliVolts(pin);
+        return true;
+    }
+
+    portENTER_CRITICAL(&mux);
+    uint32_t sum = windowSum;
+    uint32_t count = windowCount;
+    windowSum = 0;
+    windowCount = 0;
+    portEXIT_CRITICAL(&mux);
+
+    if (count == 0)
+    {
+        return false;
+    }
+    // 先平均原始值再换算，保留过采样多出来的精度
+    adcMv = rawToMv((sum + count / 2) / count);
+    return true;
+}
+
+int BatteryAdc::rawToMv(uint32_t raw)
+{
+    if (!calibrated)
+    {
+        calibrate();
+    }
+    return (int)esp_adc_cal_raw_to_voltage(raw, &chars);
+}
+
+const char* BatteryAdc::calibrationName() const
+{
+    switch (calType)
+    {
+    case ESP_ADC_CAL_VAL_EFUSE_TP:
+        return "eFuse两点";
+    case ESP_ADC_CAL_VAL_EFUSE_VREF:
+        return "eFuse Vref";
+    default:
+        return "默认Vref";
+    }
+}
+
+void BatteryAdc::calibrate()
+{
+    calType = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &chars);
+    calibrated = true;
+}
+
+// esp_timer 任务中执行，每次连续读取若干次累加到当前窗口
+void BatteryAdc::onTimer(void* arg)
+{
+    BatteryAdc* self = (BatteryAdc*)arg;
+    uint32_t sum = 0;
+    for (int i = 0; i < BAT_ADC_OVERSAMPLE; i++)
+    {
+        sum += adc1_get_raw((adc1_channel_t)self->channel);
+    }
+
+    portENTER_CRITICAL(&self->mux);
+    // 长时间没有取值时丢弃旧窗口，避免累加溢出
+    if (self->windowCount >= 100000)
+    {
+        self->windowSum = 0;
+        self->windowCount = 0;
+    }
+    self->windowSum += sum;
+    self->windowCount += BAT_ADC_OVERSAMPLE;
+    portEXIT_CRITICAL(&self->mux);
+    self->total += BAT_ADC_OVERSAMPLE;
+}
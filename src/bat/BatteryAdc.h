@@ -0,0 +1,68 @@
+#ifndef BATTERY_ADC_H
+#define BATTERY_ADC_H
+
+#include <Arduino.h>
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+#include "esp_timer.h"
+
+/*
+ * 电池ADC后台采样
+ *
+ * 由 esp_timer 周期回调采样（每 BAT_ADC_SAMPLE_PERIOD_MS 连续读 BAT_ADC_OVERSAMPLE 次），
+ * 原始值在回调中累加，调用方按自己的节奏取走一个窗口的平均值，窗口内所有采样都参与平均，
+ * 等效于过采样。换算使用 eFuse 中的 Vref 或两点校准值（esp_adc_cal），没有时用默认 Vref。
+ * 取值不阻塞、不延时，系统任务可以在任意周期调用。
+ *
+ * ESP32 的连续（DMA）模式经过 I2S0，而 I2S0 已用于音频输出，所以用定时器采样代替。
+ * 电池引脚不在 ADC1 上时（ADC2 与 WiFi 冲突，不能后台采样）退回到取值时单次读取。
+ */
+
+class BatteryAdc {
+public:
+    BatteryAdc();
+
+    /**
+     * @brief 配置ADC并启动后台采样
+     * @param pin 电池分压采样引脚
+     * @return 后台采样已启动；false 时 take() 退回单次读取
+     */
+    bool begin(int pin);
+
+    // 停止后台采样（进入深度睡眠前，ADC交给ULP）
+    void stop();
+
+    /**
+     * @brief 取走当前窗口的平均电压并开始新窗口
+     * @param adcMv 输出ADC引脚电压（mV，未乘分压比）
+     * @return 窗口内有采样
+     */
+    bool take(int& adcMv);
+
+    // 原始值换算为ADC引脚电压（mV），ULP监测也用同一条校准曲线
+    int rawToMv(uint32_t raw);
+
+    const char* calibrationName() const;
+    uint32_t totalSamples() const { return total; }
+    bool isRunning() const { return timer != NULL; }
+
+private:
+    int pin;
+    int channel;                        // ADC1 通道，-1 表示不在 ADC1 上
+    esp_timer_handle_t timer;
+    esp_adc_cal_characteristics_t chars;
+    esp_adc_cal_value_t calType;
+    bool calibrated;
+    portMUX_TYPE mux;
+
+    uint32_t windowSum;
+    uint32_t windowCount;
+    volatile uint32_t total;
+
+    void calibrate();
+    static void onTimer(void* arg);
+};
+
+extern BatteryAdc batteryAdc;
+
+#endif // BATTERY_ADC_H
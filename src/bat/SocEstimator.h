@@ -0,0 +1,276 @@
+#ifndef SOC_ESTIMATOR_H
+#define SOC_ESTIMATOR_H
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+ * 电池剩余电量（SOC）估计
+ *
+ * 单状态扩展卡尔曼滤波：
+ * - 预测：按已知负载（4G模块、GNSS、音频、BLE）估算放电电流做库仑积分，
+ *   电流模型的误差计入过程噪声
+ * - 观测：端电压加上 电流 x 内阻 得到开路电压，与 LiPo 的 OCV-SOC 曲线比较；
+ *   曲线平坦段斜率小，同样的电压误差对应更大的 SOC 误差，滤波自动少信电压
+ * - 负载切换后的一段时间和新息超过 3σ 的采样（模型外的突发负载，如4G发射）
+ *   放大观测噪声，电量不随瞬时压降跳变
+ * 充电时端电压被充电器抬高，只按充电电流积分，停止充电后等电压回落再恢复观测。
+ *
+ * 输出 SOC、1σ 不确定度和按平均放电电流估计的剩余时间。
+ * 用录制的放电曲线回放验证，见 tools/soc_estimator_sim.cpp。
+ */
+
+// 已知负载，可组合
+#define BAT_LOAD_MODEM      0x01    // 4G模块在网
+#define BAT_LOAD_GNSS       0x02    // GNSS定位中
+#define BAT_LOAD_AUDIO      0x04    // 正在播放
+#define BAT_LOAD_BLE        0x08    // BLE已连接
+
+// 各负载的平均电流（mA）
+struct SocLoadModel {
+    float baseMa;       // 主控和传感器
+    float modemMa;
+    float gnssMa;
+    float audioMa;
+    float bleMa;
+    float chargeMa;     // 充电电流
+};
+
+struct SocEstimatorConfig {
+    float capacityMah;
+    float resistanceMohm;       // 电池内阻加线路电阻
+    float voltageNoiseMv;       // ADC和OCV曲线的电压误差（1σ）
+    float driftPerHour;         // 模型漂移（SOC/小时，1σ）
+    SocLoadModel load;
+};
+
+// LiPo 单体静置开路电压曲线（25℃，0.1C放电）
+static const int SOC_OCV_POINTS = 12;
+static const float SOC_OCV_SOC[SOC_OCV_POINTS] = {
+    0.00f, 0.05f, 0.10f, 0.20f, 0.30f, 0.40f, 0.50f, 0.60f, 0.70f, 0.80f, 0.90f, 1.00f};
+static const float SOC_OCV_MV[SOC_OCV_POINTS] = {
+    3270, 3610, 3690, 3740, 3770, 3790, 3820, 3870, 3920, 3980, 4060, 4180};
+
+static inline int socOcvSegment(float soc) {
+    int i = 0;
+    while (i < SOC_OCV_POINTS - 2 && soc > SOC_OCV_SOC[i + 1]) {
+        i++;
+    }
+    return i;
+}
+
+// SOC 对应的开路电压
+static inline float socOcvMv(float soc) {
+    if (soc <= 0.0f) return SOC_OCV_MV[0];
+    if (soc >= 1.0f) return SOC_OCV_MV[SOC_OCV_POINTS - 1];
+    int i = socOcvSegment(soc);
+    float t = (soc - SOC_OCV_SOC[i]) / (SOC_OCV_SOC[i + 1] - SOC_OCV_SOC[i]);
+    return SOC_OCV_MV[i] + t * (SOC_OCV_MV[i + 1] - SOC_OCV_MV[i]);
+}
+
+// 曲线斜率（mV / 单位SOC）
+static inline float socOcvSlope(float soc) {
+    int i = socOcvSegment(soc);
+    return (SOC_OCV_MV[i + 1] - SOC_OCV_MV[i]) / (SOC_OCV_SOC[i + 1] - SOC_OCV_SOC[i]);
+}
+
+// 开路电压对应的 SOC
+static inline float socFromOcv(float mv) {
+    if (mv <= SOC_OCV_MV[0]) return 0.0f;
+    if (mv >= SOC_OCV_MV[SOC_OCV_POINTS - 1]) return 1.0f;
+    int i = 0;
+    while (i < SOC_OCV_POINTS - 2 && mv > SOC_OCV_MV[i + 1]) {
+        i++;
+    }
+    float t = (mv - SOC_OCV_MV[i]) / (SOC_OCV_MV[i + 1] - SOC_OCV_MV[i]);
+    return SOC_OCV_SOC[i] + t * (SOC_OCV_SOC[i + 1] - SOC_OCV_SOC[i]);
+}
+
+static inline float socLoadCurrentMa(const SocLoadModel& m, uint8_t loads) {
+    float ma = m.baseMa;
+    if (loads & BAT_LOAD_MODEM) ma += m.modemMa;
+    if (loads & BAT_LOAD_GNSS) ma += m.gnssMa;
+    if (loads & BAT_LOAD_AUDIO) ma += m.audioMa;
+    if (loads & BAT_LOAD_BLE) ma += m.bleMa;
+    return ma;
+}
+
+class SocEstimator {
+public:
+    static const uint32_t LOAD_SETTLE_MS = 10000;       // 负载切换后电压回稳时间
+    static const uint32_t CHARGE_SETTLE_MS = 120000;    // 停止充电后表面电荷消散时间
+    static constexpr float SETTLE_NOISE_MV = 40.0f;
+    static constexpr float AVERAGE_TAU_SEC = 1800.0f;   // 剩余时间用的平均电流时间常数
+    static constexpr float CORRELATION_SEC = 60.0f;     // 电压误差（极化、未建模负载）的相关时间
+    static const uint8_t INIT_SAMPLES = 5;              // 初始化前采样次数
+    static constexpr float CONVERGED_SIGMA = 0.03f;     // 不确定度低于该值后电压修正计入平均电流
+
+    explicit SocEstimator(const SocEstimatorConfig& config)
+        : cfg(config) {
+        reset();
+    }
+
+    void reset() {
+        ready = false;
+        x = 0.0f;
+        p = 0.0f;
+        lastMs = 0;
+        settleUntilMs = 0;
+        settling = false;
+        lastLoads = 0;
+        wasCharging = false;
+        currentMa = 0.0f;
+        averageMa = 0.0f;
+        ocv = 0.0f;
+        initOcv = 0.0f;
+        initCount = 0;
+        rejected = 0;
+    }
+
+    /**
+     * @brief 输入一次端电压测量
+     * @param nowMs 单调时间
+     * @param terminalMv 电池端电压（已乘分压比）
+     * @param loads 当前负载 BAT_LOAD_*
+     * @param charging 充电中
+     */
+    void update(uint32_t nowMs, float terminalMv, uint8_t loads, bool charging) {
+        currentMa = socLoadCurrentMa(cfg.load, loads);
+        ocv = terminalMv + currentMa * cfg.resistanceMohm / 1000.0f;
+
+        if (!ready) {
+            // 按前几次采样中最高的开路电压初始化（突发负载只会拉低电压），
+            // 不确定度取曲线平坦段的典型误差；充电时端电压高出 充电电流 x 内阻
+            float mv = charging ? terminalMv - (cfg.load.chargeMa - currentMa) * cfg.resistanceMohm / 1000.0f : ocv;
+            if (initCount == 0 || mv > initOcv) {
+                initOcv = mv;
+            }
+            if (++initCount < INIT_SAMPLES) {
+                return;
+            }
+            x = socFromOcv(initOcv);
+            p = 0.10f * 0.10f;
+            averageMa = currentMa;
+            lastMs = nowMs;
+            lastLoads = loads;
+            wasCharging = charging;
+            ready = true;
+            return;
+        }
+
+        float dt = (float)(uint32_t)(nowMs - lastMs) / 1000.0f;
+        lastMs = nowMs;
+        float qRate = cfg.driftPerHour * cfg.driftPerHour / 3600.0f;
+
+        if (charging) {
+            // 充电：充电电流减去系统负载积分，电压不可用，充电电流按 50% 误差计入
+            float delta = (cfg.load.chargeMa - currentMa) * dt / 3600.0f / cfg.capacityMah;
+            x = clampSoc(x + delta);
+            p += qRate * dt + square(0.5f * delta);
+            wasCharging = true;
+            lastLoads = loads;
+            return;
+        }
+        if (wasCharging) {
+            wasCharging = false;
+            settle(nowMs, CHARGE_SETTLE_MS);
+        }
+        if (loads != lastLoads) {
+            lastLoads = loads;
+            settle(nowMs, LOAD_SETTLE_MS);
+        }
+        if (settling && (int32_t)(nowMs - settleUntilMs) >= 0) {
+            settling = false;
+        }
+
+        // 预测：库仑积分，负载电流按 30% 误差计入
+        float before = x;
+        bool converged = !settling && p < square(CONVERGED_SIGMA);
+        float delta = currentMa * dt / 3600.0f / cfg.capacityMah;
+        x = clampSoc(x - delta);
+        p += qRate * dt + square(0.3f * delta);
+
+        // 观测：开路电压
+        float h = socOcvSlope(x);
+        float y = ocv - socOcvMv(x);
+        float r = square(cfg.voltageNoiseMv) + square(0.3f * currentMa * cfg.resistanceMohm / 1000.0f);
+        if (settling) {
+            r += square(SETTLE_NOISE_MV);
+        }
+        // 新息超过 3σ 多半是模型外的突发负载，按超出比例放大观测噪声
+        float s = h * h * p + r;
+        if (y * y > 9.0f * s) {
+            r *= y * y / (9.0f * s);
+            rejected++;
+        }
+        // 相邻采样的误差高度相关，按相关时间折算，每个相关时间内的观测只相当于一次独立测量
+        if (dt > 0.0f && dt < CORRELATION_SEC) {
+            r *= CORRELATION_SEC / dt;
+        }
+        s = h * h * p + r;
+        float k = p * h / s;
+        x = clampSoc(x + k * y);
+        p = (1.0f - k * h) * p;
+        if (p < 1e-6f) {
+            p = 1e-6f;
+        }
+
+        // 剩余时间按实际消耗（积分加电压修正）的平均电流估计，包含模型外的负载；
+        // 收敛之前的修正是估计误差而不是消耗，只计模型电流
+        if (dt > 0.0f) {
+            float observedMa = converged ? (before - x) * cfg.capacityMah * 3600.0f / dt : currentMa;
+            float a = dt / (AVERAGE_TAU_SEC + dt);
+            averageMa += a * (observedMa - averageMa);
+        }
+    }
+
+    bool isReady() const { return ready; }
+    float soc() const { return x; }
+    float sigma() const { return sqrtf(p); }
+    int percent() const { return (int)(x * 100.0f + 0.5f); }
+    int sigmaPercent() const { return (int)(sqrtf(p) * 100.0f + 0.5f); }
+
+    // 剩余时间（分钟），充电中或未初始化返回 -1
+    int runtimeMinutes() const {
+        if (!ready || wasCharging || averageMa <= 0.0f) {
+            return -1;
+        }
+        return (int)(x * cfg.capacityMah / averageMa * 60.0f);
+    }
+
+    float loadMa() const { return currentMa; }
+    float averageLoadMa() const { return averageMa; }
+    float ocvMv() const { return ocv; }
+    uint32_t rejectedCount() const { return rejected; }
+    const SocEstimatorConfig& config() const { return cfg; }
+
+private:
+    SocEstimatorConfig cfg;
+    bool ready;
+    float x;                // SOC 0~1
+    float p;                // 方差
+    uint32_t lastMs;
+    uint32_t settleUntilMs;
+    bool settling;          // 电压回稳中，观测噪声加大
+    uint8_t lastLoads;
+    bool wasCharging;
+    float currentMa;
+    float averageMa;
+    float ocv;
+    float initOcv;
+    uint8_t initCount;
+    uint32_t rejected;
+
+    void settle(uint32_t nowMs, uint32_t durationMs) {
+        uint32_t until = nowMs + durationMs;
+        if (!settling || (int32_t)(until - settleUntilMs) > 0) {
+            settleUntilMs = until;
+        }
+        settling = true;
+    }
+
+    static float square(float v) { return v * v; }
+    static float clampSoc(float v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); }
+};
+
+#endif // SOC_ESTIMATOR_H
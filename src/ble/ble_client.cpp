@@ -1,4 +1,6 @@
 #include "ble_client.h"
+#include "power/PowerLocks.h"
+#include "power/PowerAccounting.h"
 
 void scanEndedCB(NimBLEScanResults results);
 
@@ -55,9 +57,9 @@ void notifyCB(NimBLERemoteCharacteristic *pRemoteCharacteristic, uint8_t *pData,
         if (length == sizeof(device_state_t))
         {
             // 使用安全的内存拷贝
-            device_state_t deviceState;
-            memcpy(&deviceState, pData, sizeof(device_state_t));
-            set_device_state(&deviceState);
+            device_state_t remote;
+            memcpy(&remote, pData, sizeof(device_state_t));
+            deviceState.store(remote, DS_ALL);
             print_device_info();
         }
     }
@@ -83,6 +85,8 @@ class ClientCallbacks : public NimBLEClientCallbacks
     {
         Serial.println("Connected");
         connected = true;
+        powerLocks.acquire(PM_CLIENT_BLE);
+        powerAccounting.setState(PA_BLE, PA_BLE_CONNECTED);
         doScan = false;
         /** After connection we should change the parameters if we don't need fast response times.
          *  These settings are 150ms interval, 0 latency, 450ms timout.
@@ -98,6 +102,8 @@ class ClientCallbacks : public NimBLEClientCallbacks
         Serial.print(pClient->getPeerAddress().toString().c_str());
         Serial.println(" Disconnected - Starting scan");
         connected = false;
+        powerLocks.release(PM_CLIENT_BLE);
+        powerAccounting.setState(PA_BLE, PA_BLE_SCAN);
         doScan = true;
     };
 
@@ -316,6 +322,7 @@ void BLEC::begin()
      *  Optional callback for when scanning stops.
      */
     pScan->start(scanTime, scanEndedCB);
+    powerAccounting.setState(PA_BLE, PA_BLE_SCAN);
     Serial.println("NimBLE Client started");
 }
 
@@ -332,11 +339,11 @@ void BLEC::loop()
             Serial.println("Success! we should now be getting notifications, scanning for more!");
             connected = true;
             doConnect = false;
-            device_state.bleConnected = true;
+            deviceState.set(DS_BLE, &device_state_t::bleConnected, true);
         }
         else
         {
-            device_state.bleConnected = false;
+            deviceState.set(DS_BLE, &device_state_t::bleConnected, false);
             Serial.println("Failed to connect, starting scan");
             doScan = true;
             connected = false;
@@ -389,6 +396,6 @@ void BLEC::loop()
         Serial.println("Starting scan");
         NimBLEDevice::getScan()->start(scanTime, scanEndedCB);
         doScan = false;
-        device_state.bleConnected = false;
+        deviceState.set(DS_BLE, &device_state_t::bleConnected, false);
     }
 }
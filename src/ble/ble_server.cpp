@@ -1,4 +1,5 @@
 #include "ble_server.h"
+#include "utils/DebugUtils.h"
 
 // 初始化静态成员
 TirePressureData BLES::lastTirePressureData = {0};
@@ -10,6 +11,9 @@ class ServerCallbacks : public NimBLEServerCallbacks
     void onConnect(NimBLEServer *pServer)
     {
         Serial.println("【BLE】客户端已连接");
+        // 连接期间保持高频，保证连接事件及时处理
+        powerLocks.acquire(PM_CLIENT_BLE);
+        powerAccounting.setState(PA_BLE, PA_BLE_CONNECTED);
         // 连接后停止扫描以节省资源
         NimBLEDevice::getScan()->stop();
     };
@@ -17,6 +21,8 @@ class ServerCallbacks : public NimBLEServerCallbacks
     void onDisconnect(NimBLEServer *pServer)
     {
         Serial.println("【BLE】客户端已断开连接 - 重新开始广播");
+        powerLocks.release(PM_CLIENT_BLE);
+        powerAccounting.setState(PA_BLE, PA_BLE_ADV);
         // 断开连接后恢复扫描
         NimBLEDevice::getScan()->start(0, nullptr, false);
     };
@@ -79,9 +85,19 @@ class DeviceCharacteristicCallbacks : public NimBLECharacteristicCallbacks
                 wifiManager.exitAPMode();
 #endif
                 break;
+            case 0x05:
+                // [0x05, 通道, 级别]，通道 0xFF 为全局级别，级别 0xFF 为恢复跟随全局
+                if (value.size() >= 3)
+                {
+                    uint8_t channel = (uint8_t)value[1];
+                    uint8_t level = (uint8_t)value[2];
+                    const char *name = channel == 0xFF ? "all" : DebugManager::channelName((LogChannel)channel);
+                    bool ok = DebugManager::setLevelByName(name, level);
+                    Serial.printf("【BLE】设置日志级别 通道=%u 级别=%u %s\n", channel, level, ok ? "成功" : "失败");
+                }
+                break;
             // case 0x04:
             //     Serial.println("收到 BLE 进入睡眠模式");
-            //     powerManager.requestLowPowerMode = true;
             //     powerManager.enterLowPowerMode();
             //     break;
             default:
@@ -106,6 +122,12 @@ void BLES::begin()
     pIMUCharacteristic = NULL;
     connected = false;
 
+    // 设备状态变化时通过设备特征通知客户端（长度为 sizeof(device_state_t)，与胎压数据区分）
+    stateSubscriber = deviceState.subscribe(DS_BIT(DS_BATTERY) | DS_BIT(DS_BATTERY_LOW) | DS_BIT(DS_EXTERNAL_POWER) |
+                                                DS_BIT(DS_SLEEP_ALARM) | DS_BIT(DS_GSM) | DS_BIT(DS_GNSS) |
+                                                DS_BIT(DS_SDCARD),
+                                            nullptr);
+
     // 初始化BLE设备
     NimBLEDevice::init(BLE_NAME);
 
@@ -154,6 +176,7 @@ void BLES::begin()
     pAdvertising->setMinInterval(32); // 20ms
     pAdvertising->setMaxInterval(64); // 40ms
     pAdvertising->start();
+    powerAccounting.setState(PA_BLE, PA_BLE_ADV);
 
     // 等待广播稳定
     delay(500);
@@ -358,6 +381,18 @@ void BLES::loop()
 
             pCharacteristic->setValue((uint8_t *)&lastTirePressureData, sizeof(TirePressureData));
             pCharacteristic->notify();
+
+            if (deviceState.take(stateSubscriber) != 0)
+            {
+                device_state_t state = deviceState.snapshot();
+                pCharacteristic->setValue((uint8_t *)&state, sizeof(state));
+                pCharacteristic->notify();
+            }
+        }
+        else
+        {
+            // 没有客户端时丢弃积累的变化，连接后从下一次变化开始通知
+            deviceState.take(stateSubscriber);
         }
         lastBlePublishTime = millis();
     }
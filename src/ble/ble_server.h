@@ -6,6 +6,8 @@
 #include "config.h"
 #include "imu/qmi8658.h"
 #include "power/PowerManager.h"
+#include "power/PowerLocks.h"
+#include "power/PowerAccounting.h"
 #include "wifi/server.h"
 #include "Air780EG.h"
 
@@ -37,6 +39,7 @@ private:
     bool connected;
 
     unsigned long lastBlePublishTime = 0;
+    int stateSubscriber = -1;
     
     static bool isValidTirePressureData(NimBLEAdvertisedDevice* advertisedDevice);
     static TirePressureData parseTirePressureData(uint8_t* data, size_t length);
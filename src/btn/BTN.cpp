@@ -1,4 +1,5 @@
 #include "BTN.h"
+#include "utils/Trace.h"
 #include <Arduino.h>
 
 #ifdef BTN_PIN
@@ -137,6 +138,7 @@ void BTN::handleButtonEvents() {
         Serial.println("[按钮] 单击 重启");
         int hz = gps.changeHz();
         Serial.printf("[GPS] 当前频率: %dHz\n", hz);
+        trace.instant(TRACE_ID_RESTART, TRACE_RESTART_BUTTON);
         esp_restart();
         break;
     }
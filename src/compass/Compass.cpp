@@ -1,8 +1,12 @@
 #include "compass/Compass.h"
+#include "power/WarmBoot.h"
+#include "utils/Log.h"
+#include "utils/FastMath.h"
+#include "utils/SensorHealth.h"
 
-// TAG
-static const char *TAG = "Compass";
-
+#define COMPASS_I2C_ADDR     0x0D   // QMC5883L
+#define COMPASS_REG_CHIP_ID  0x0D
+#define COMPASS_CHIP_ID      0xFF
 
 #ifdef ENABLE_COMPASS
 // 如果没有定义IMU引脚，使用GPS_COMPASS引脚作为备选
@@ -40,7 +44,7 @@ float normalizeHeading(float heading) {
 
 CompassDirection getDirection(float heading) {
     heading = normalizeHeading(heading);
-    int direction = (int)((heading + 22.5) / 45.0);
+    int direction = (int)((heading + 22.5f) / 45.0f);
     if (direction >= 8) direction = 0;
     return (CompassDirection)direction;
 }
@@ -62,19 +66,17 @@ const char* getDirectionCN(float heading) {
 
 void printCompassData() {
     if (!compass_data.isValid) {
-        ESP_LOGI(TAG, "数据无效");
+        LOGD(COMPASS, "数据无效");
         return;
     }
     
-    ESP_LOGI(TAG, "航向: %.2f° (%.3f rad), 方向: %s (%s, %s), 磁场: X=%.2f Y=%.2f Z=%.2f", 
-        compass_data.heading, 
+    LOGD(COMPASS, "航向: %.2f° (%.3f rad), 方向: %s (%s, %s)",
+        compass_data.heading,
         compass_data.headingRadians,
-        compass_data.directionStr, 
+        compass_data.directionStr,
         compass_data.directionName,
-        compass_data.directionCN,
-        compass_data.x, 
-        compass_data.y, 
-        compass_data.z);
+        compass_data.directionCN);
+    LOGD(COMPASS, "磁场: X=%.2f Y=%.2f Z=%.2f", compass_data.x, compass_data.y, compass_data.z);
 }
 
 /**
@@ -90,34 +92,107 @@ Compass::Compass(int sda, int scl) : _wire(Wire) {
 }
 
 bool Compass::begin() {
-    ESP_LOGI(TAG, "初始化: SDA=%d, SCL=%d, 磁偏角=%.2f°", _sda, _scl, _declination);
+    LOGI(COMPASS, "初始化: SDA=%d, SCL=%d, 磁偏角=%.2f°", _sda, _scl, _declination);
     
+    // 热启动时罗盘在深度睡眠期间一直供电，不需要等待上电稳定
+    bool warm = warmBoot.isWarm();
+
     // 先确保 Wire 是干净的
-    _wire.end();
-    delay(50);
-    
+    if (!warm) {
+        _wire.end();
+        delay(50);
+    }
+
+    // 启动时只做有限次重试，之后由健康监测按退避时间在后台恢复
+    bool ok = initChip(warm ? 0 : 100);
+    for (int i = 0; i < SENSOR_INIT_RETRIES && !ok; i++) {
+        delay(100);
+        ok = initChip(0);
+    }
+    sensorHealth.monitor(SENSOR_COMPASS).begin(millis(), ok);
+    _initialized = ok;
+    deviceState.set(DS_COMPASS, &device_state_t::compassReady, ok);
+    if (!ok) {
+        LOGE(COMPASS, "初始化失败，航向暂不可用，后台继续尝试恢复");
+        return false;
+    }
+    LOGI(COMPASS, "初始化完成");
+    return true;
+}
+
+bool Compass::probeChip() {
+    _wire.beginTransmission(COMPASS_I2C_ADDR);
+    _wire.write(COMPASS_REG_CHIP_ID);
+    if (_wire.endTransmission(false) != 0) {
+        return false;
+    }
+    if (_wire.requestFrom((uint8_t)COMPASS_I2C_ADDR, (uint8_t)1) != 1) {
+        return false;
+    }
+    return _wire.read() == COMPASS_CHIP_ID;
+}
+
+bool Compass::initChip(uint32_t settleMs) {
     // 初始化I2C
-    bool wireBeginSuccess = _wire.begin(_sda, _scl);
-    if (!wireBeginSuccess) {
-        ESP_LOGE(TAG, "Wire.begin() 失败!");
+    if (!_wire.begin(_sda, _scl)) {
+        LOGE(COMPASS, "Wire.begin() 失败!");
         return false;
     }
-    ESP_LOGI(TAG, "Wire.begin() 成功");
+    if (settleMs > 0) {
+        delay(settleMs);  // 给一些初始化时间
+    }
 
-    delay(100);  // 给一些初始化时间
-    
-    // 初始化QMC5883L
+    // QMC5883L 库的 init() 没有返回值，先确认芯片有应答，避免没有罗盘时也标记为就绪
+    if (!probeChip()) {
+        LOGE(COMPASS, "芯片没有应答或ID不符（地址 0x%02X）", COMPASS_I2C_ADDR);
+        return false;
+    }
+
+    // 初始化QMC5883L，睡眠前校准过则沿用校准参数
     qmc.init();
-    qmc.setCalibrationOffsets(0, 0, 0);
-    qmc.setCalibrationScales(1.0, 1.0, 1.0);
-    
-    _initialized = true;
-    device_state.compassReady = true;
-    
-    ESP_LOGI(TAG, "初始化完成");
+    const WarmBootState& rtc = warmBoot.state();
+    if (rtc.compassCalibrated) {
+        qmc.setCalibrationOffsets(rtc.compassOffset[0], rtc.compassOffset[1], rtc.compassOffset[2]);
+        qmc.setCalibrationScales(rtc.compassScale[0], rtc.compassScale[1], rtc.compassScale[2]);
+        LOGI(COMPASS, "已恢复睡眠前的校准参数");
+    } else {
+        qmc.setCalibrationOffsets(0, 0, 0);
+        qmc.setCalibrationScales(1.0, 1.0, 1.0);
+    }
     return true;
 }
 
+bool Compass::serviceHealth() {
+    SensorHealthMonitor& health = sensorHealth.monitor(SENSOR_COMPASS);
+    uint32_t now = millis();
+    switch (health.due(now)) {
+    case SENSOR_DO_CHECK:
+        if (health.check(now, probeChip())) {
+            sensorHealth.reportFailed(SENSOR_COMPASS);
+        }
+        break;
+    case SENSOR_DO_RECOVER: {
+        SensorRecoveryAction action = health.recoveryAction();
+        if (action == SENSOR_RECOVER_BUS_RESET) {
+            SensorHealth::recoverBus(_wire, _sda, _scl);
+        }
+        bool ok = initChip(0);
+        health.recovered(millis(), ok);
+        sensorHealth.reportRecovery(SENSOR_COMPASS, action, ok);
+        break;
+    }
+    default:
+        break;
+    }
+    bool usable = health.usable();
+    if (!usable) {
+        compass_data.isValid = false;
+    }
+    _initialized = usable;
+    deviceState.set(DS_COMPASS, &device_state_t::compassReady, usable);
+    return usable;
+}
+
 bool Compass::update() {
     if (!_initialized) {
         return false;
@@ -134,12 +209,14 @@ bool Compass::update() {
 }
 
 void Compass::loop() {
-    if (!_initialized) {
+    if (!serviceHealth()) {
         return;
     }
 
-    // 更新数据
+    // 更新数据，没有应答时读数不再变化，由健康监测按数据不变判定
     update();
+    int16_t raw[3] = {(int16_t)compass_data.x, (int16_t)compass_data.y, (int16_t)compass_data.z};
+    sensorHealth.monitor(SENSOR_COMPASS).onSample(sensorFingerprint(raw, sizeof(raw)));
 
     // 定期打印调试信息
     if (millis() - _lastDebugPrintTime > 2000) {
@@ -174,18 +251,27 @@ const char* Compass::getCurrentDirectionCN() {
 
 bool Compass::calibrate() {
     if (!_initialized) {
-        ESP_LOGE(TAG, "罗盘未初始化，无法校准");
+        LOGE(COMPASS, "罗盘未初始化，无法校准");
         return false;
     }
     
-    ESP_LOGI(TAG, "开始校准，请旋转模块...");
+    LOGI(COMPASS, "开始校准，请旋转模块...");
     qmc.calibrate();
-    ESP_LOGI(TAG, "校准完成，请将以下参数写入代码：");
+    LOGI(COMPASS, "校准完成，请将以下参数写入代码：");
     
     Serial.printf("qmc.setCalibrationOffsets(%d, %d, %d);\n",
         qmc.getCalibrationOffset(0), qmc.getCalibrationOffset(1), qmc.getCalibrationOffset(2));
     Serial.printf("qmc.setCalibrationScales(%.2f, %.2f, %.2f);\n",
         qmc.getCalibrationScale(0), qmc.getCalibrationScale(1), qmc.getCalibrationScale(2));
+
+    // 保存到RTC内存，深度睡眠唤醒后继续使用
+    int16_t offset[3];
+    float scale[3];
+    for (int i = 0; i < 3; i++) {
+        offset[i] = qmc.getCalibrationOffset(i);
+        scale[i] = qmc.getCalibrationScale(i);
+    }
+    warmBoot.setCompassCalibration(offset, scale);
     
     return true;
 }
@@ -193,7 +279,11 @@ bool Compass::calibrate() {
 void Compass::setCalibration(int xOffset, int yOffset, int zOffset, float xScale, float yScale, float zScale) {
     qmc.setCalibrationOffsets(xOffset, yOffset, zOffset);
     qmc.setCalibrationScales(xScale, yScale, zScale);
-    ESP_LOGI(TAG, "校准参数已设置");
+
+    int16_t offset[3] = {(int16_t)xOffset, (int16_t)yOffset, (int16_t)zOffset};
+    float scale[3] = {xScale, yScale, zScale};
+    warmBoot.setCompassCalibration(offset, scale);
+    LOGI(COMPASS, "校准参数已设置");
 }
 
 void Compass::getRawData(int16_t &x, int16_t &y, int16_t &z) {
@@ -204,7 +294,7 @@ void Compass::getRawData(int16_t &x, int16_t &y, int16_t &z) {
 
 void Compass::setDeclination(float declination) {
     _declination = declination;
-    ESP_LOGI(TAG, "磁偏角设置为: %.2f°", _declination);
+    LOGI(COMPASS, "磁偏角设置为: %.2f°", _declination);
 }
 
 float Compass::getDeclination() {
@@ -220,14 +310,17 @@ bool Compass::isDataValid() {
 }
 
 void Compass::reset() {
-    _initialized = false;
-    device_state.compassReady = false;
     compass_data.isValid = false;
-    ESP_LOGI(TAG, "罗盘已重置");
+    bool ok = initChip(0);
+    sensorHealth.monitor(SENSOR_COMPASS).begin(millis(), ok);
+    _initialized = ok;
+    deviceState.set(DS_COMPASS, &device_state_t::compassReady, ok);
+    LOGI(COMPASS, "罗盘已重置%s", ok ? "" : "，初始化失败，后台继续尝试恢复");
 }
 
 float Compass::calculateHeading(int16_t x, int16_t y) {
-    float heading = atan2(y, x) * 180.0 / PI;
+    typedef SensorMath<sensor_real_t> M;
+    float heading = M::toFloat(M::atan2Deg(M::from(y), M::from(x)));
     heading += _declination;  // 应用磁偏角校正
     return normalizeHeading(heading);
 }
@@ -237,7 +330,7 @@ void Compass::updateCompassData(int16_t x, int16_t y, int16_t z, float heading)
     compass_data.y = y;
     compass_data.z = z;
     compass_data.heading = heading;
-    compass_data.headingRadians = heading * PI / 180.0;
+    compass_data.headingRadians = heading * FAST_DEG_TO_RAD;
     compass_data.direction = getDirection(heading);
     compass_data.directionStr = DIRECTION_STRS[compass_data.direction];
     compass_data.directionName = DIRECTION_NAMES[compass_data.direction];
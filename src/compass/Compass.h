@@ -58,7 +58,8 @@ public:
     Compass(int sda, int scl);
 
     /**
-     * @brief 初始化罗盘
+     * @brief 初始化罗盘，确认芯片有应答后才标记为就绪；
+     * 失败时由健康监测（utils/SensorHealth.h）在 loop() 中按退避时间恢复
      * @return 是否初始化成功
      */
     bool begin();
@@ -152,7 +153,7 @@ public:
     bool isDataValid();
 
     /**
-     * @brief 重置罗盘
+     * @brief 重新初始化罗盘
      */
     void reset();
 
@@ -160,12 +161,19 @@ private:
     int _sda;
     int _scl;
     bool _initialized;
-    TwoWire& _wire;              // 使用 Wire1 作为 I2C 总线（与IMU共享）
+    TwoWire& _wire;              // 使用 Wire 作为 I2C 总线（IMU在 Wire1 上）
     float _declination;          // 磁偏角校正值
     QMC5883LCompass qmc;         // QMC5883L传感器对象
     unsigned long _lastReadTime; // 上次读取时间
     unsigned long _lastDebugPrintTime;
     
+    // 读芯片ID确认有应答
+    bool probeChip();
+    // 建立连接并配置芯片，begin() 和故障恢复共用
+    bool initChip(uint32_t settleMs);
+    // 健康检查和故障恢复，返回是否可以读取
+    bool serviceHealth();
+
     // 数据处理函数
     float calculateHeading(int16_t x, int16_t y);
     void updateCompassData(int16_t x, int16_t y, int16_t z, float heading);
@@ -62,6 +62,194 @@
 #define MQTT_KEEPALIVE               60
 #define MQTT_RECONNECT_INTERVAL      30000
 
+// 驻车浅睡眠配置（需要 ENABLE_SLEEP）
+// 静止超过休眠时间后先进入驻车模式：IMU切到WOM，芯片浅睡眠，定时唤醒上报位置，
+// 驻车超过 PARKED_DEEP_SLEEP_AFTER_SEC 后再走深度睡眠流程
+#ifndef PARKED_LIGHT_SLEEP_ENABLED
+#define PARKED_LIGHT_SLEEP_ENABLED   true
+#endif
+#define PARKED_CHECKIN_INTERVAL_SEC  300    // 位置上报间隔
+#define PARKED_CHECKIN_WINDOW_MS     5000   // 每次上报保持唤醒的时间
+#define PARKED_DEEP_SLEEP_AFTER_SEC  7200   // 驻车2小时后转入深度睡眠
+
+// 进入深度睡眠前的倒计时（秒），期间运动、电门开启或按钮按下取消
+#define SLEEP_COUNTDOWN_SEC          10
+
+// 热启动配置
+// 深度睡眠唤醒时沿用睡眠前已验证的初始化结果；睡眠时间短于该值时继续上一个GPS记录会话
+#define WARM_BOOT_SESSION_RESUME_SEC 1800
+
+// 电池电压阈值（醒着时 BAT 和深度睡眠时 ULP 共用）
+#define BAT_LOW_VOLTAGE_MV           3400   // 低电量
+#define BAT_LOW_HYSTERESIS_MV        100    // 回升到 低电量+迟滞 以上才解除
+#define BAT_TAMPER_VOLTAGE_MV        1500   // 低于该值视为电池或采样线被断开
+
+// 电池采样：后台定时器每个周期连续读 OVERSAMPLE 次，BAT 每个发布周期取一次平均并更新设备状态
+#define BAT_ADC_SAMPLE_PERIOD_MS     20
+#define BAT_ADC_OVERSAMPLE           8
+#ifndef BAT_PUBLISH_INTERVAL_MS
+#define BAT_PUBLISH_INTERVAL_MS      1000
+#endif
+
+// 电池模型（电量估计，见 bat/SocEstimator.h）
+#ifndef BAT_CAPACITY_MAH
+#define BAT_CAPACITY_MAH             3000
+#endif
+#ifndef BAT_RESISTANCE_MOHM
+#define BAT_RESISTANCE_MOHM          200    // 内阻、极化和线路电阻之和
+#endif
+#define BAT_CHARGE_CURRENT_MA        500
+// 已知负载的平均电流（mA），用于库仑积分和压降补偿
+#define BAT_LOAD_BASE_MA             45     // 主控和传感器
+#define BAT_LOAD_MODEM_MA            35     // 4G模块在网
+#define BAT_LOAD_GNSS_MA             25     // GNSS定位
+#define BAT_LOAD_AUDIO_MA            120    // 音频播放
+#define BAT_LOAD_BLE_MA              15     // BLE连接
+
+// 功耗统计：各子系统各状态的估计电流（mA，见 power/PowerAccounting.h），按实测值调整
+#ifndef PA_CPU_MAX_MA
+#define PA_CPU_SLEEP_MA              1.0f   // 驻车浅睡眠
+#define PA_CPU_MIN_MA                30.0f  // PM_MIN_CPU_FREQ_MHZ
+#define PA_CPU_APB_MA                30.0f  // 80MHz
+#define PA_CPU_MAX_MA                50.0f  // PM_MAX_CPU_FREQ_MHZ
+#endif
+#ifndef PA_GNSS_ACQUIRE_MA
+#define PA_GNSS_ACQUIRE_MA           30.0f  // 搜星
+#define PA_GNSS_FIX_MA               22.0f  // 跟踪
+#endif
+#ifndef PA_MODEM_TX_MA
+#define PA_MODEM_IDLE_MA             8.0f   // 在网空闲（DRX）
+#define PA_MODEM_TX_MA               120.0f // 连接态收发平均
+#endif
+#define PA_MODEM_TX_TAIL_MS          10000  // 每次上报后保持连接态的时间（网络不活动定时器）
+#ifndef PA_BLE_CONNECTED_MA
+#define PA_BLE_ADV_MA                8.0f   // 20-40ms 间隔广播
+#define PA_BLE_SCAN_MA               25.0f  // 持续扫描
+#define PA_BLE_CONNECTED_MA          12.0f
+#endif
+#ifndef PA_AUDIO_PLAY_MA
+#define PA_AUDIO_PLAY_MA             120.0f
+#endif
+#ifndef PA_SD_WRITE_MA
+#define PA_SD_IDLE_MA                0.5f
+#define PA_SD_WRITE_MA               60.0f
+#endif
+#ifndef PA_LED_ON_MA
+#define PA_LED_BLINK_MA              2.0f
+#define PA_LED_ON_MA                 4.0f   // 默认亮度
+#endif
+
+// 传感器计算的数值类型（见 utils/FastMath.h）：0 为 float，1 为 Q16.16 定点
+// 没有 FPU 的芯片上定点更快，有单精度 FPU 的 ESP32/ESP32-S3 用 float，各自耗时见 tools/bench_sensor_math.cpp
+#ifndef SENSOR_MATH_FIXED
+#define SENSOR_MATH_FIXED            0
+#endif
+
+// IMU运动唤醒过滤（见 imu/MotionWake.h）
+// 深度睡眠被 IMU 唤醒后先采样判定，误唤醒直接回到睡眠；误唤醒后提高 WOM 阈值，安静后降回基准值
+#ifndef IMU_WOM_BASE_MG
+#define IMU_WOM_BASE_MG              150    // 基准阈值，可用串口命令 imu.wom.base 按安装位置修改
+#endif
+#define IMU_WOM_MAX_MG               255    // WOM 阈值寄存器为 8 位
+#define IMU_WOM_STEP_MG              25
+#define IMU_WOM_DECAY_SEC            21600  // 6小时没有误唤醒降一档
+#define IMU_WOM_DEDUP_SEC            3      // 间隔不超过该值的误唤醒视为同一次冲击
+#define IMU_WOM_STORM_COUNT          6      // 窗口内误唤醒达到该次数视为唤醒风暴
+#define IMU_WOM_STORM_WINDOW_SEC     600
+#define IMU_WOM_STORM_HOLDOFF_SEC    1800   // 唤醒风暴后暂停 IMU 唤醒的时间
+#define IMU_WOM_TILT_DEG             5.0f   // 姿态变化超过该角度为真实运动
+#define IMU_WOM_SHAKE_MG             30.0f  // 晃动超过该值为真实运动
+#define IMU_WOM_SAMPLE_MS            80     // 唤醒后的采样时长
+
+// 振动分析（见 imu/Vibration.h）：加速度频谱估计发动机转速和振动健康度
+// 采样率 500Hz 时只能分析 250Hz 以下，一阶振动 250Hz 对应 15000 转；更高的谐波会混叠
+#ifndef VIB_ENABLED
+#define VIB_ENABLED                  false  // 默认关闭，串口命令 vib.on 临时开启
+#endif
+#define VIB_SAMPLE_RATE_HZ           500    // 与加速度计输出率一致
+#define VIB_SAMPLE_PERIOD_MS         (1000 / VIB_SAMPLE_RATE_HZ)
+#define VIB_FFT_SIZE                 256    // 每窗口采样数（2 的幂），500Hz 时约 0.5 秒，频率分辨率约 2Hz
+#define VIB_REQUIRE_IGNITION         true   // 只在电门打开时采样
+#define VIB_IDLE_POLL_MS             500    // 未采样时检查电门和开关的间隔
+#define VIB_BAND_LOW_HZ              20     // 低于该频率为路面、悬挂
+#define VIB_BAND_HIGH_HZ             120    // 高于该频率为高频段（支架松动、轴承）
+#define VIB_RPM_MIN                  1000
+#define VIB_RPM_MAX                  10000
+#define VIB_ENGINE_ORDER             1      // 每转振动次数，按发动机型式设置（单缸四冲程点火为 0.5）
+#define VIB_RPM_MIN_SNR              4.0f
+// 健康度阈值与车型和安装位置有关，需按车辆标定
+#define VIB_HIGH_GOOD_MG             40.0f  // 高频残余有效值不超过该值为 100 分
+#define VIB_HIGH_BAD_MG              200.0f // 达到该值为 0 分
+#define VIB_CREST_GOOD               4.5f   // 峰值因数不超过该值为 100 分
+#define VIB_CREST_BAD                9.0f
+#define VIB_HEALTH_SMOOTHING         0.05f  // 健康度每窗口的平滑系数，约 10 秒
+#define VIB_TASK_STACK_SIZE          3072
+#define VIB_TASK_PRIORITY            3      // 高于 TaskData，保证采样间隔均匀
+
+// 传感器健康监测（见 utils/SensorHealth.h）：故障时按退避时间恢复，不重启系统
+#define SENSOR_HEALTH_CHECK_MS       1000   // 芯片ID和数据检查周期
+#define SENSOR_HEALTH_FAULTS_TO_FAIL 2      // 连续异常次数达到该值判为故障
+#define SENSOR_HEALTH_READ_ERROR_LIMIT 20   // 检查周期内读取失败超过该次数为异常
+#define SENSOR_HEALTH_BACKOFF_MIN_MS 1000   // 恢复失败后的等待时间，每次加倍
+#define SENSOR_HEALTH_BACKOFF_MAX_MS 300000
+#define SENSOR_HEALTH_MQTT_INTERVAL_MS 300000 // MQTT diag/sensors 上报周期
+#define SENSOR_INIT_RETRIES          3      // 启动时初始化的重试次数，之后交给健康监测
+#define IMU_HEALTH_TIMEOUT_MS        500    // 加速度计 500Hz，持续查询超过该时间数据都未就绪为异常（任务阻塞不计入）
+#define IMU_HEALTH_STUCK_SAMPLES     50     // 连续相同的采样数（约 0.5 秒），有噪声的加速度计不会出现
+#define COMPASS_HEALTH_TIMEOUT_MS    1000
+#define COMPASS_HEALTH_STUCK_SAMPLES 100
+
+// 深度睡眠监测配置（ULP协处理器，仅ESP32，需要 BAT_PIN 为ADC1引脚、RTC_INT_PIN 为RTC GPIO）
+// 睡眠期间按周期采样电池和电门，只在低电量、电门变化、防拆时唤醒主CPU
+#ifndef SLEEP_MONITOR_ENABLED
+#define SLEEP_MONITOR_ENABLED        true
+#endif
+#define SLEEP_MONITOR_INTERVAL_MS    1000   // 采样周期
+#define SLEEP_MONITOR_DEBOUNCE       3      // 连续采样次数
+#define SLEEP_MONITOR_GLITCH_MAX     5      // 电门抖动达到该次数按防拆唤醒，0为不判定
+
+// 性能统计（见 utils/PerfMonitor.h）
+#define PERF_SAMPLE_INTERVAL_MS      10000  // 任务CPU占用和栈余量的采样周期
+#define PERF_LOG_INTERVAL_MS         60000  // 写入SD卡 /data/perf.log 的周期
+#define PERF_MQTT_INTERVAL_MS        60000  // MQTT diag/perf 上报周期
+
+// 事件跟踪（见 utils/Trace.h）
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY               128    // 事件数，每个 8 字节，占用RTC慢速内存
+#endif
+#define TRACE_SLOW_SLICE_US          50000  // 子系统循环超过该耗时才记入跟踪
+
+// 堆空间和分配统计（见 utils/HeapMonitor.h）
+#define HEAP_HISTORY_SIZE            60     // 保留的堆空间记录数，主循环每10秒一次
+#define ALLOC_SITE_DEPTH             3      // 分配调用点的调用栈层数
+#define ALLOC_SITE_SLOTS             64     // 分配调用点表大小（2 的幂）
+#define ALLOC_REPORT_TOP             16     // 串口 heap 显示的调用点数
+
+// 日志（见 utils/Log.h）
+#ifndef LOG_COMPILE_LEVEL
+#ifdef DEBUG
+#define LOG_COMPILE_LEVEL            4      // 编译进固件的最高级别，数值同 DebugLevel
+#else
+#define LOG_COMPILE_LEVEL            3
+#endif
+#endif
+#define LOG_RING_SIZE                32     // 待格式化的记录数，每条约 96 字节，满时丢弃
+#define LOG_LINE_SIZE                256    // 格式化后单行长度
+#define LOG_TASK_STACK_SIZE          3072
+#define LOG_TASK_PRIORITY            1      // 低于数据和网络任务
+#ifndef LOG_SD_ENABLED
+#define LOG_SD_ENABLED               false  // 同时追加到SD卡
+#endif
+#define LOG_SD_PATH                  "/data/log.txt"
+#define LOG_SD_BUFFER_SIZE           1024   // SD卡批量写入的缓冲区
+#define LOG_SD_FLUSH_MS              5000   // 缓冲区未满时的最长写入间隔
+
+// 串口二进制帧（见 utils/SerialLink.h）
+#define SERIAL_FRAME_MAX_PAYLOAD     512    // 单帧负载，文件分块读取每次最多 508 字节
+#define SERIAL_LINE_MAX              128    // 文本命令最大长度
+#define SERIAL_FRAME_TIMEOUT_MS      200    // 帧接收中途停顿超过该时间则丢弃，回到文本状态
+#define SERIAL_TELEMETRY_MIN_MS      10     // 遥测最小间隔（115200 波特率下约 180 帧/秒封顶）
+
 // GPS配置
 #define GPS_UPDATE_INTERVAL          1000
 #define GPS_TIMEOUT                  10000
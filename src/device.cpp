@@ -3,6 +3,13 @@
 #include "config.h"
 #include "tft/TFT.h"
 #include "imu/qmi8658.h"
+#include "power/WarmBoot.h"
+#include "power/SleepMonitorLogic.h"
+#include "power/PowerAccounting.h"
+#include "imu/MotionWake.h"
+#include "utils/PerfMonitor.h"
+#include "utils/Trace.h"
+#include "utils/SensorHealth.h"
 // GSM模块包含
 #ifdef USE_AIR780EG_GSM
 #include "Air780EG.h"
@@ -23,20 +30,17 @@ extern AudioManager audioManager;
 
 extern const VersionInfo &getVersionInfo();
 
-device_state_t device_state;
-state_changes_t state_changes;
+DeviceStateBus deviceState;
+device_info_t device_info;
+
 void print_device_info()
 {
-    // 如果休眠倒计时的时候不打印
-    if (powerManager.powerState == POWER_STATE_COUNTDOWN)
-    {
-        return;
-    }
+    device_state_t device_state = deviceState.snapshot();
     Serial.println("Device Info:");
-    Serial.printf("Device ID: %s\n", device_state.device_id.c_str());
+    Serial.printf("Device ID: %s\n", device_info.device_id.c_str());
     Serial.printf("Sleep Time: %d\n", device_state.sleep_time);
-    Serial.printf("Firmware Version: %s\n", device_state.device_firmware_version);
-    Serial.printf("Hardware Version: %s\n", device_state.device_hardware_version);
+    Serial.printf("Firmware Version: %s\n", device_info.device_firmware_version.c_str());
+    Serial.printf("Hardware Version: %s\n", device_info.device_hardware_version.c_str());
     Serial.printf("WiFi Connected: %d\n", device_state.wifiConnected);
     Serial.printf("BLE Connected: %d\n", device_state.bleConnected);
     Serial.printf("Battery Voltage: %d\n", device_state.battery_voltage);
@@ -66,47 +70,109 @@ String Device::get_device_id()
     return String(device_id);
 }
 
-device_state_t *get_device_state()
-{
-    return &device_state;
-}
-
-void set_device_state(device_state_t *state)
-{
-    device_state = *state;
-}
-
 // 生成精简版设备状态JSON
-// fw: 固件版本, hw: 硬件版本, wifi/ble/gps/imu/compass: 各模块状态, bat_v: 电池电压, bat_pct: 电池百分比, is_charging: 充电状态, ext_power: 外部电源状态, sd: SD卡状态
-String device_state_to_json(device_state_t *state)
+// fw: 固件版本, hw: 硬件版本, wifi/ble/gps/imu/compass: 各模块状态, bat_v: 电池电压, bat_pct: 电池百分比, bat_err: 电量不确定度, bat_rt: 剩余分钟, is_charging: 充电状态, ext_power: 外部电源状态, bat_low: 低电量, alarm: 深度睡眠监测唤醒原因, rpm/vib_health/vib_rms: 发动机转速、振动健康度、振动有效值(mg，振动分析有结果时), wom_thr: IMU唤醒阈值(mg), wom_false/wom_real/wom_storm: IMU误唤醒/真实唤醒/唤醒风暴次数, sd: SD卡状态
+String device_state_to_json(const device_state_t &state)
 {
-    StaticJsonDocument<256> doc; // 精简后更小即可
-    doc["fw"] = device_state.device_firmware_version;
-    doc["hw"] = device_state.device_hardware_version;
-    doc["wifi"] = device_state.wifiConnected;
-    doc["ble"] = device_state.bleConnected;
-    doc["gsm"] = device_state.gsmReady;
-    doc["gnss"] = device_state.gnssReady;
-    doc["imu"] = device_state.imuReady;
-    doc["compass"] = device_state.compassReady;
-    doc["bat_v"] = device_state.battery_voltage;
-    doc["bat_pct"] = device_state.battery_percentage;
-    doc["is_charging"] = device_state.is_charging;
-    doc["ext_power"] = device_state.external_power;
-    doc["sd"] = device_state.sdCardReady;
-    if (device_state.sdCardReady)
+    StaticJsonDocument<640> doc;   // 全部字段约 27 个
+    doc["fw"] = device_info.device_firmware_version;
+    doc["hw"] = device_info.device_hardware_version;
+    doc["wifi"] = state.wifiConnected;
+    doc["ble"] = state.bleConnected;
+    doc["gsm"] = state.gsmReady;
+    doc["gnss"] = state.gnssReady;
+    doc["imu"] = state.imuReady;
+    doc["compass"] = state.compassReady;
+    doc["bat_v"] = state.battery_voltage;
+    doc["bat_pct"] = state.battery_percentage;
+    doc["bat_err"] = state.battery_soc_error;
+    if (state.battery_runtime_min >= 0)
+    {
+        doc["bat_rt"] = state.battery_runtime_min;
+    }
+    doc["is_charging"] = state.is_charging;
+    doc["ext_power"] = state.external_power;
+    doc["bat_low"] = state.battery_low;
+    if (state.sleep_alarm)
+    {
+        doc["alarm"] = sleepWakeReasonName(state.sleep_alarm);
+    }
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    const MotionWakeState& wom = motionWake.state();
+    doc["wom_thr"] = wom.thresholdMg;
+    doc["wom_false"] = wom.falseWakes;
+    doc["wom_real"] = wom.realWakes;
+    doc["wom_storm"] = wom.storms;
+#endif
+    doc["sd"] = state.sdCardReady;
+    if (state.sdCardReady)
+    {
+        doc["sd_size"] = state.sdCardSizeMB;
+        doc["sd_free"] = state.sdCardFreeMB;
+    }
+    doc["audio"] = state.audioReady;
+    if (state.vibrationValid)
     {
-        doc["sd_size"] = device_state.sdCardSizeMB;
-        doc["sd_free"] = device_state.sdCardFreeMB;
+        doc["rpm"] = state.engine_rpm;
+        doc["vib_health"] = state.vibration_health;
+        doc["vib_rms"] = state.vibration_rms_mg;
     }
-    doc["audio"] = device_state.audioReady;
     return doc.as<String>();
 }
 
+bool operator==(const device_state_t &a, const device_state_t &b)
+{
+    return a.sleep_time == b.sleep_time &&
+           a.led_mode == b.led_mode &&
+           a.battery_voltage == b.battery_voltage &&
+           a.battery_percentage == b.battery_percentage &&
+           a.battery_soc_error == b.battery_soc_error &&
+           a.battery_runtime_min == b.battery_runtime_min &&
+           a.is_charging == b.is_charging &&
+           a.external_power == b.external_power &&
+           a.battery_low == b.battery_low &&
+           a.sleep_alarm == b.sleep_alarm &&
+           a.wifiConnected == b.wifiConnected &&
+           a.bleConnected == b.bleConnected &&
+           a.imuReady == b.imuReady &&
+           a.compassReady == b.compassReady &&
+           a.gsmReady == b.gsmReady &&
+           a.lbsReady == b.lbsReady &&
+           a.gnssReady == b.gnssReady &&
+           stateValueEqual(a.latitude, b.latitude) &&
+           stateValueEqual(a.longitude, b.longitude) &&
+           a.satellites == b.satellites &&
+           a.signalStrength == b.signalStrength &&
+           a.sdCardReady == b.sdCardReady &&
+           a.sdCardSizeMB == b.sdCardSizeMB &&
+           a.sdCardFreeMB == b.sdCardFreeMB &&
+           a.audioReady == b.audioReady &&
+           a.vibrationValid == b.vibrationValid &&
+           a.engine_rpm == b.engine_rpm &&
+           a.vibration_health == b.vibration_health &&
+           a.vibration_rms_mg == b.vibration_rms_mg;
+}
+
 // 添加包装函数
+// 上报负载生成函数只生成JSON，4G模块的连接态由 publishMqttReports() 在上报成功后计入功耗统计
 String getDeviceStatusJSON()
 {
-    return device_state_to_json(&device_state);
+    return device_state_to_json(deviceState.snapshot());
+}
+
+String getPowerJSON()
+{
+    return powerAccounting.toJson();
+}
+
+String getPerfJSON()
+{
+    return perfMonitor.toJson();
+}
+
+String getSensorHealthJSON()
+{
+    return sensorHealth.toJson();
 }
 
 String getLocationJSON()
@@ -123,6 +189,11 @@ String getLocationJSON()
                 air780eg.getGNSS().updateLBS();
         }
     }
+    else
+    {
+        // 第一次带有效定位的上报，用于统计唤醒到首次上报的耗时
+        warmBoot.markFirstFix();
+    }
     return air780eg.getGNSS().getLocationJSON();
 }
 
@@ -181,10 +252,22 @@ void mqttMessageCallback(const String &topic, const String &payload)
                 Serial.println("休眠时间不能小于0");
             }
         }
+        else if (strcmp(cmd, "set_log_level") == 0)
+        {
+            // {"cmd": "set_log_level", "channel": "IMU", "level": 4}，channel 为 "all" 时设置全局级别，
+            // level 为 -1 时恢复跟随全局
+            const char *channel = doc["channel"] | "all";
+            int level = doc["level"] | -2;
+            if (level < -1 || !DebugManager::setLevelByName(channel, level < 0 ? LOG_CH_FOLLOW_GLOBAL : (uint8_t)level))
+            {
+                Serial.println("日志级别参数无效");
+            }
+        }
         // reboot
         else if (strcmp(cmd, "reboot") == 0 || strcmp(cmd, "restart") == 0)
         {
             Serial.println("重启设备");
+            trace.instant(TRACE_ID_RESTART, TRACE_RESTART_MQTT);
             ESP.restart();
         }
 #ifdef ENABLE_SDCARD
@@ -208,14 +291,21 @@ void mqttMessageCallback(const String &topic, const String &payload)
 #endif
 }
 
+#if !defined(DISABLE_MQTT) && defined(USE_AIR780EG_GSM)
+static volatile bool mqttConnected = false;
+#endif
+
 void mqttConnectionCallback(bool connected)
 {
 #ifndef DISABLE_MQTT
     Serial.printf("MQTT连接状态: %s\n", connected ? "已连接" : "断开");
+#ifdef USE_AIR780EG_GSM
+    mqttConnected = connected;
+#endif
     if (connected)
     {
         // 订阅控制主题
-        air780eg.getMQTT().subscribe("vehicle/v1/" + device_state.device_id + "/ctrl/#", 1);
+        air780eg.getMQTT().subscribe("vehicle/v1/" + device_info.device_id + "/ctrl/#", 1);
     }
     else
     {
@@ -231,13 +321,23 @@ Device::Device()
 {
 }
 
+#ifdef ENABLE_COMPASS
+static bool compassInitJob()
+{
+    return compass.begin();
+}
+#endif
+
 void Device::begin()
 {
     // 从getVersionInfo()获取版本信息
     const VersionInfo &versionInfo = getVersionInfo();
-    device_state.device_id = get_device_id();
-    device_state.device_firmware_version = versionInfo.firmware_version;
-    device_state.device_hardware_version = versionInfo.hardware_version;
+    device_info.device_id = get_device_id();
+    device_info.device_firmware_version = versionInfo.firmware_version;
+    device_info.device_hardware_version = versionInfo.hardware_version;
+
+    // 订阅者在写入设备状态的模块初始化之前注册，启动过程中的状态变化由 taskSystem 统一输出
+    device_state_subscribe();
 
     // 检查是否从深度睡眠唤醒
     esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
@@ -255,12 +355,10 @@ void Device::begin()
     }
 
 #ifdef BAT_PIN
-    // bat.setDebug(true);
     bat.begin();
 #endif
 
 #ifdef RTC_INT_PIN
-    externalPower.setDebug(true);
     externalPower.begin();
 #endif
 
@@ -283,23 +381,25 @@ void Device::begin()
 #endif
 
 #ifdef ENABLE_COMPASS
-    compass.begin();
+    // 罗盘在 Wire 上，IMU 在 Wire1 上，两条总线互不影响，罗盘放到并行任务中初始化
+    static BootJob compassJob; // 超时后任务仍可能访问，不能放在栈上
+    compassJob.start("BootCompass", compassInitJob);
 #endif
 
 #ifdef ENABLE_IMU
     Serial.println("[IMU] 开始初始化IMU系统...");
     Serial.printf("[IMU] 引脚配置 - SDA:%d, SCL:%d, INT:%d\n", IMU_SDA_PIN, IMU_SCL_PIN, IMU_INT_PIN);
 
-    try
+    // 初始化失败不重启，IMU功能暂不可用，由 imu.loop() 中的健康监测在后台恢复
+    bool imuOk = imu.begin();
+    deviceState.set(DS_IMU, &device_state_t::imuReady, imuOk);
+    if (imuOk)
     {
-        imu.begin();
-        device_state.imuReady = true; // 设置IMU状态为就绪
         Serial.println("[IMU] ✅ IMU系统初始化成功，状态已设置为就绪");
     }
-    catch (...)
+    else
     {
-        device_state.imuReady = false;
-        Serial.println("[IMU] ❌ IMU系统初始化异常");
+        Serial.println("[IMU] ❌ IMU系统初始化失败，继续启动");
     }
 
     // 如果是从深度睡眠唤醒，检查唤醒原因
@@ -318,10 +418,19 @@ void Device::begin()
         }
     }
 #else
-    device_state.imuReady = false;
+    deviceState.set(DS_IMU, &device_state_t::imuReady, false);
     Serial.println("[IMU] IMU功能未启用 (ENABLE_IMU未定义)");
 #endif
 
+#ifdef ENABLE_COMPASS
+    if (!compassJob.join(2000))
+    {
+        Serial.println("[罗盘] 初始化失败");
+    }
+    Serial.printf("[罗盘] 初始化耗时 %lu ms（与IMU并行）\n", (unsigned long)compassJob.elapsedMs());
+#endif
+    warmBoot.markPhase("sensors");
+
 #ifdef ENABLE_GSM
 #ifdef USE_AIR780EG_GSM
     // Air780EG模块初始化已在main.cpp中完成
@@ -333,6 +442,7 @@ void Device::begin()
     ml307_at.begin(115200);
 #endif
     initializeGSM();
+    warmBoot.markPhase("gsm");
 #endif
     Serial.println("GPS初始化已延迟到任务中!");
 
@@ -343,21 +453,13 @@ void Device::begin()
 
     if (audioManager.begin())
     {
-        device_state.audioReady = true;
+        deviceState.set(DS_AUDIO, &device_state_t::audioReady, true);
         Serial.println("[音频] ✅ 音频系统初始化成功!");
-
-        // 播放开机成功音（只播放一次）
-        static bool bootSoundPlayed = false;
-        if (AUDIO_BOOT_SUCCESS_ENABLED && !bootSoundPlayed)
-        {
-            Serial.println("[音频] 播放开机成功音...");
-            audioManager.playBootSuccessSound();
-            bootSoundPlayed = true;
-        }
+        // 开机成功音在SD卡初始化之后由setup()播放，以便使用SD卡上的自定义语音
     }
     else
     {
-        device_state.audioReady = false;
+        deviceState.set(DS_AUDIO, &device_state_t::audioReady, false);
         Serial.println("[音频] ❌ 音频系统初始化失败!");
         Serial.println("[音频] 请检查:");
         Serial.println("[音频] 1. 音频引脚是否正确定义");
@@ -365,9 +467,10 @@ void Device::begin()
         Serial.println("[音频] 3. 引脚是否与其他功能冲突");
     }
 #else
-    device_state.audioReady = false;
+    deviceState.set(DS_AUDIO, &device_state_t::audioReady, false);
     Serial.println("[音频] 音频功能未启用 (ENABLE_AUDIO未定义)");
 #endif
+    warmBoot.markPhase("audio");
 }
 
 // 通知特定状态变化
@@ -376,139 +479,209 @@ void notify_state_change(const char *state_name, const char *old_value, const ch
     Serial.printf("[状态变化] %s: %s -> %s\n", state_name, old_value, new_value);
 }
 
-// 更新设备状态并检查变化
-void update_device_state()
+static const char *readyText(bool ready)
 {
-    static device_state_t last_state;
+    return ready ? "就绪" : "未就绪";
+}
 
-    // 检查电池状态变化
-    if (device_state.battery_percentage != last_state.battery_percentage)
-    {
-        notify_state_change("电池电量",
-                            String(last_state.battery_percentage).c_str(),
-                            String(device_state.battery_percentage).c_str());
-        state_changes.battery_changed = true;
+static const char *connectedText(bool connected)
+{
+    return connected ? "已连接" : "未连接";
+}
 
-        if (device_state.battery_percentage <= 20)
-        {
-            ledManager.setLEDState(LED_ON, LED_COLOR_RED, 5);
-        }
-        else
-        {
-            ledManager.setLEDState(LED_BREATH, LED_COLOR_GREEN, 5);
-        }
+// 日志订阅者：输出状态变化，只比较变化分组内的字段
+static void logStateChange(const device_state_t &state, uint32_t changed, void *ctx)
+{
+    static device_state_t last;
+    char before[16], after[16];
 
-#ifdef ENABLE_AUDIO
-        // 当电池电量降到20%以下时播放低电量警告音（避免频繁播放）
-        if (device_state.battery_percentage <= 20 &&
-            last_state.battery_percentage > 20)
-        {
-            if (device_state.audioReady){
-            Serial.println("[音频] 播放低电量警告音");
-            audioManager.playLowBatterySound();
-            }
-        }
-#endif
+    if ((changed & DS_BIT(DS_BATTERY)) && state.battery_percentage != last.battery_percentage)
+    {
+        snprintf(before, sizeof(before), "%d", last.battery_percentage);
+        snprintf(after, sizeof(after), "%d", state.battery_percentage);
+        notify_state_change("电池电量", before, after);
     }
-
-    // 检查外部电源状态变化
-    if (device_state.external_power != last_state.external_power)
+    if (changed & DS_BIT(DS_BATTERY_LOW))
     {
-        notify_state_change("外部电源",
-                            last_state.external_power ? "已连接" : "未连接",
-                            device_state.external_power ? "已连接" : "未连接");
-        state_changes.external_power_changed = true;
+        notify_state_change("低电量", last.battery_low ? "是" : "否", state.battery_low ? "是" : "否");
+    }
+    if (changed & DS_BIT(DS_EXTERNAL_POWER))
+    {
+        notify_state_change("外部电源", connectedText(last.external_power), connectedText(state.external_power));
+    }
+    if (changed & DS_BIT(DS_SLEEP_ALARM))
+    {
+        notify_state_change("睡眠监测唤醒", sleepWakeReasonName(last.sleep_alarm), sleepWakeReasonName(state.sleep_alarm));
     }
-
-    // 检查网络状态变化 - 根据模式区分
 #ifdef ENABLE_WIFI
-    if (device_state.wifiConnected != last_state.wifiConnected)
+    if (changed & DS_BIT(DS_WIFI))
     {
-        notify_state_change("WiFi连接",
-                            last_state.wifiConnected ? "已连接" : "未连接",
-                            device_state.wifiConnected ? "已连接" : "未连接");
-        state_changes.wifi_changed = true;
+        notify_state_change("WiFi连接", connectedText(last.wifiConnected), connectedText(state.wifiConnected));
     }
 #endif
-
-    // 检查BLE状态变化
-    if (device_state.bleConnected != last_state.bleConnected)
+    if (changed & DS_BIT(DS_BLE))
     {
-        notify_state_change("BLE连接",
-                            last_state.bleConnected ? "已连接" : "未连接",
-                            device_state.bleConnected ? "已连接" : "未连接");
-        state_changes.ble_changed = true;
+        notify_state_change("BLE连接", connectedText(last.bleConnected), connectedText(state.bleConnected));
     }
-
 #ifdef ENABLE_GSM
-    if (device_state.gsmReady != last_state.gsmReady)
+    if ((changed & DS_BIT(DS_GSM)) && state.gsmReady != last.gsmReady)
     {
-        notify_state_change("GNSS状态",
-                            last_state.gsmReady ? "就绪" : "未就绪",
-                            device_state.gsmReady ? "就绪" : "未就绪");
-        device_state.gsmReady = device_state.gsmReady;
+        notify_state_change("GSM状态", readyText(last.gsmReady), readyText(state.gsmReady));
     }
 #endif
-
-    // 检查IMU状态变化
-    if (device_state.imuReady != last_state.imuReady)
+    if (changed & DS_BIT(DS_IMU))
     {
-        notify_state_change("IMU状态",
-                            last_state.imuReady ? "就绪" : "未就绪",
-                            device_state.imuReady ? "就绪" : "未就绪");
-        state_changes.imu_changed = true;
+        notify_state_change("IMU状态", readyText(last.imuReady), readyText(state.imuReady));
     }
-
-    // 检查罗盘状态变化
-    if (device_state.compassReady != last_state.compassReady)
+    if (changed & DS_BIT(DS_COMPASS))
+    {
+        notify_state_change("罗盘状态", readyText(last.compassReady), readyText(state.compassReady));
+    }
+    if (changed & DS_BIT(DS_SLEEP_TIME))
+    {
+        snprintf(before, sizeof(before), "%d", last.sleep_time);
+        snprintf(after, sizeof(after), "%d", state.sleep_time);
+        notify_state_change("休眠时间", before, after);
+    }
+    if (changed & DS_BIT(DS_LED_MODE))
+    {
+        snprintf(before, sizeof(before), "%d", last.led_mode);
+        snprintf(after, sizeof(after), "%d", state.led_mode);
+        notify_state_change("LED模式", before, after);
+    }
+    if ((changed & DS_BIT(DS_SDCARD)) && state.sdCardReady != last.sdCardReady)
+    {
+        notify_state_change("SD卡状态", readyText(last.sdCardReady), readyText(state.sdCardReady));
+    }
+    if (changed & DS_BIT(DS_AUDIO))
     {
-        notify_state_change("罗盘状态",
-                            last_state.compassReady ? "就绪" : "未就绪",
-                            device_state.compassReady ? "就绪" : "未就绪");
-        state_changes.compass_changed = true;
+        notify_state_change("音频状态", readyText(last.audioReady), readyText(state.audioReady));
     }
+    last = state;
+}
 
-    // 检查休眠时间变化
-    if (device_state.sleep_time != last_state.sleep_time)
+#if defined(PWM_LED_PIN) || defined(LED_PIN)
+// LED订阅者：低电量常亮红灯，解除后恢复
+static void ledOnBatteryLow(const device_state_t &state, uint32_t changed, void *ctx)
+{
+    if (state.battery_low)
     {
-        notify_state_change("休眠时间",
-                            String(last_state.sleep_time).c_str(),
-                            String(device_state.sleep_time).c_str());
-        state_changes.sleep_time_changed = true;
+        ledManager.setLEDState(LED_ON, LED_COLOR_RED, 5);
     }
+    else
+    {
+        ledManager.setLEDState(LED_BREATH, LED_COLOR_GREEN, 5);
+    }
+}
+#endif
 
-    // 检查LED模式变化
-    if (device_state.led_mode != last_state.led_mode)
+#ifdef ENABLE_AUDIO
+// 音频订阅者：进入低电量时播放一次警告音（低电量带迟滞，不会反复播放）
+static void audioOnBatteryLow(const device_state_t &state, uint32_t changed, void *ctx)
+{
+    if (state.battery_low && state.audioReady)
     {
-        notify_state_change("LED模式",
-                            String(last_state.led_mode).c_str(),
-                            String(device_state.led_mode).c_str());
-        state_changes.led_mode_changed = true;
+        Serial.println("[音频] 播放低电量警告音");
+        audioManager.playLowBatterySound();
     }
+}
+#endif
 
-    // 检查SD卡状态变化
-    if (device_state.sdCardReady != last_state.sdCardReady)
+#if !defined(DISABLE_MQTT) && defined(USE_AIR780EG_GSM)
+// MQTT订阅者没有回调，由 publishMqttReports() 在模块串口所在的任务中取走变化
+static int mqttStateSubscriber = -1;
+#endif
+
+void device_state_subscribe()
+{
+    deviceState.subscribe(DS_ALL, logStateChange);
+#if defined(PWM_LED_PIN) || defined(LED_PIN)
+    deviceState.subscribe(DS_BIT(DS_BATTERY_LOW), ledOnBatteryLow);
+#endif
+#ifdef ENABLE_AUDIO
+    deviceState.subscribe(DS_BIT(DS_BATTERY_LOW), audioOnBatteryLow);
+#endif
+#if !defined(DISABLE_MQTT) && defined(USE_AIR780EG_GSM)
+    mqttStateSubscriber = deviceState.subscribe(
+        DS_BIT(DS_EXTERNAL_POWER) | DS_BIT(DS_BATTERY_LOW) | DS_BIT(DS_SLEEP_ALARM), nullptr);
+#endif
+}
+
+#if !defined(DISABLE_MQTT) && defined(USE_AIR780EG_GSM)
+// 定时上报，由 publishMqttReports() 在模块串口所在的任务中发布
+struct MqttReport
+{
+    const char *topic; // 设备主题下的子路径
+    String (*build)();
+    uint32_t intervalMs;
+    unsigned long last;
+    bool sent;
+};
+
+static MqttReport mqttReports[] = {
+    {"telemetry/device", getDeviceStatusJSON, 30000, 0, false},
+    {"telemetry/location", getLocationJSON, 1000, 0, false},
+    {"telemetry/power", getPowerJSON, 60000, 0, false},
+    {"diag/perf", getPerfJSON, PERF_MQTT_INTERVAL_MS, 0, false},
+    {"diag/sensors", getSensorHealthJSON, SENSOR_HEALTH_MQTT_INTERVAL_MS, 0, false},
+};
+
+static bool publishReport(MqttReport &report)
+{
+    report.last = millis();
+    report.sent = true;
+    return air780eg.getMQTT().publish("vehicle/v1/" + device_info.device_id + "/" + report.topic, report.build(), 0);
+}
+#endif
+
+void publishMqttReports()
+{
+#if !defined(DISABLE_MQTT) && defined(USE_AIR780EG_GSM)
+    // 电门、低电量、睡眠监测告警变化时立即上报设备状态，不等30秒的定时上报；
+    // 连续变化（电门抖动）最多每5秒上报一次，期间的变化合并到下一次
+    static uint32_t pending = 0;
+    static unsigned long lastStatePublish = 0;
+    pending |= deviceState.take(mqttStateSubscriber);
+    if (!mqttConnected)
     {
-        notify_state_change("SD卡状态",
-                            last_state.sdCardReady ? "就绪" : "未就绪",
-                            device_state.sdCardReady ? "就绪" : "未就绪");
-        state_changes.sdcard_changed = true;
+        return;
     }
 
-    // 检查音频状态变化
-    if (device_state.audioReady != last_state.audioReady)
+    bool published = false;
+    if (pending != 0 && millis() - lastStatePublish >= 5000)
     {
-        notify_state_change("音频状态",
-                            last_state.audioReady ? "就绪" : "未就绪",
-                            device_state.audioReady ? "就绪" : "未就绪");
-        state_changes.audio_changed = true;
+        lastStatePublish = millis();
+        pending = 0;
+        // 立即上报也算作一次设备状态定时上报
+        if (publishReport(mqttReports[0]))
+        {
+            published = true;
+        }
+        else
+        {
+            Serial.println("[状态变化] 设备状态上报失败，等待定时上报");
+        }
     }
 
-    // 更新上一次状态
-    last_state = device_state;
+    for (size_t i = 0; i < sizeof(mqttReports) / sizeof(mqttReports[0]); i++)
+    {
+        MqttReport &report = mqttReports[i];
+        if (report.sent && millis() - report.last < report.intervalMs)
+        {
+            continue;
+        }
+        if (publishReport(report))
+        {
+            published = true;
+        }
+    }
 
-    // 重置状态变化标志
-    state_changes = {0};
+    // 本轮有上报成功时4G模块进入连接态，计入功耗统计，一轮只计一次
+    if (published)
+    {
+        powerAccounting.hold(PA_MODEM, PA_MODEM_TX, PA_MODEM_TX_TAIL_MS);
+    }
+#endif
 }
 
 void device_loop()
@@ -527,12 +700,24 @@ void Device::initializeGSM()
     while (!air780eg.begin(&Serial1, 115200, GSM_RX_PIN, GSM_TX_PIN, GSM_EN))
     {
         Serial.println("[GSM] ❌ Air780EG基础初始化失败");
-        device_state.gsmReady = false;
+        deviceState.set(DS_GSM, &device_state_t::gsmReady, false);
         delay(1000);
     }
     Serial.println("[GSM] ✅ Air780EG基础初始化成功");
-    device_state.gsmReady = true;
+    deviceState.set(DS_GSM, &device_state_t::gsmReady, true);
+    powerAccounting.setState(PA_MODEM, PA_MODEM_IDLE);
     air780eg.getGNSS().enableGNSS();
+    powerAccounting.setState(PA_GNSS, PA_GNSS_ACQUIRE);
+
+    // 热启动时先用睡眠前的定位作为当前位置，重新定位之前的遥测不再是零坐标
+    double lastLat, lastLon;
+    if (warmBoot.lastFix(lastLat, lastLon))
+    {
+        DeviceStateBus::Writer state(deviceState);
+        state.set(DS_GNSS, &device_state_t::latitude, lastLat);
+        state.set(DS_GNSS, &device_state_t::longitude, lastLon);
+        Serial.printf("[GSM] 热启动，使用睡眠前的定位: %.6f, %.6f\n", lastLat, lastLon);
+    }
 
 #ifdef DISABLE_MQTT
     Serial.println("MQTT功能已禁用");
@@ -556,7 +741,7 @@ bool Device::initializeMQTT()
     Air780EGMQTTConfig config;
     config.server = MQTT_BROKER;
     config.port = MQTT_PORT;
-    config.client_id = MQTT_CLIENT_ID_PREFIX + device_state.device_hardware_version + "_" + device_state.device_id;
+    config.client_id = MQTT_CLIENT_ID_PREFIX + device_info.device_hardware_version + "_" + device_info.device_id;
     config.username = MQTT_USERNAME;
     config.password = MQTT_PASSWORD;
     config.keepalive = 60;
@@ -574,9 +759,7 @@ bool Device::initializeMQTT()
     // 设置连接状态回调
     air780eg.getMQTT().setConnectionCallback(mqttConnectionCallback);
 
-    // 添加定时任务
-    air780eg.getMQTT().addScheduledTask("device_status", "vehicle/v1/" + device_state.device_id + "/telemetry/device", getDeviceStatusJSON, 30000, 0, false);
-    air780eg.getMQTT().addScheduledTask("location", "vehicle/v1/" + device_state.device_id + "/telemetry/location", getLocationJSON, 1000, 0, false);
+    // 定时上报由 publishMqttReports() 发布，只有上报成功才计入4G模块的功耗
     // air780eg.getMQTT().addScheduledTask("system_stats", mqttTopics.getSystemStatusTopic(), getSystemStatsJSON, 60, 0, false);
 
     // // 连接到MQTT服务器
@@ -33,17 +33,29 @@
 
 
 
+#include "utils/StateBus.h"
+
+// 设备标识，启动时设置一次，之后只读
 typedef struct
 {
     String device_id; // 设备ID
     String device_firmware_version; // 固件版本
     String device_hardware_version; // 硬件版本
+} device_info_t;
+
+// 设备状态，多个任务和回调共同读写，只能通过 deviceState 访问（必须是 POD，快照按字节拷贝）
+typedef struct
+{
     int sleep_time; // 休眠时间 单位：秒
     int led_mode; // LED模式 0:关闭 1:常亮 2:单闪 3:双闪 4:慢闪 5:快闪 6:呼吸 7:5秒闪烁
     int battery_voltage;
     int battery_percentage;
+    int battery_soc_error;     // 电量估计不确定度（%，1σ）
+    int battery_runtime_min;   // 估计剩余时间（分钟），-1 为未知或充电中
     bool is_charging;          // 新增：充电状态
     bool external_power;       // 新增：外部电源接入状态（车辆电门）
+    bool battery_low;          // 低电量（带迟滞）
+    uint8_t sleep_alarm;       // 深度睡眠监测唤醒原因 SLEEP_WAKE_*，0 为无
     bool wifiConnected; // WiFi连接状态
     bool bleConnected; // BLE连接状态
     bool imuReady; // IMU准备状态
@@ -62,33 +74,69 @@ typedef struct
     uint64_t sdCardSizeMB; // SD卡大小(MB)
     uint64_t sdCardFreeMB; // SD卡剩余空间(MB)
     bool audioReady; // 音频系统准备状态
+
+    // 振动分析（见 imu/Vibration.h），vibrationValid 为 false 时其余字段为 0
+    bool vibrationValid;
+    int engine_rpm;             // 发动机转速（10转取整），0 为未检测到
+    uint8_t vibration_health;   // 振动健康度 0~100
+    int vibration_rms_mg;       // 振动总有效值（mg）
 } device_state_t;
 
-// 添加状态变化跟踪
-typedef struct {
-        bool battery_changed;      // 电池状态变化
-        bool external_power_changed; // 外部电源状态变化
-        bool wifi_changed;         // WiFi连接状态变化
-        bool ble_changed;          // BLE连接状态变化
-        bool gps_changed;          // GPS状态变化
-        bool imu_changed;          // IMU状态变化
-        bool compass_changed;      // 罗盘状态变化
-        bool gsm_changed;          // GSM状态变化
-        bool sleep_time_changed;   // 休眠时间变化
-        bool led_mode_changed;     // LED模式变化
-        bool sdcard_changed;       // SD卡状态变化
-        bool audio_changed;        // 音频状态变化
-} state_changes_t;
-
-void update_device_state();
-
-extern device_state_t device_state;
-extern state_changes_t state_changes;
-
-String device_state_to_json(device_state_t *state);
-
-device_state_t *get_device_state();
-void set_device_state(device_state_t *state);
+// 按字段比较，deviceState.store() 用它判断整体替换是否有变化
+bool operator==(const device_state_t &a, const device_state_t &b);
+
+// 状态字段分组，订阅和变化通知按分组进行
+enum DeviceStateField : uint8_t
+{
+    DS_BATTERY = 0,     // 电压、电量、不确定度、剩余时间、充电状态
+    DS_BATTERY_LOW,
+    DS_EXTERNAL_POWER,
+    DS_SLEEP_ALARM,
+    DS_WIFI,
+    DS_BLE,
+    DS_GSM,             // gsmReady、lbsReady、signalStrength
+    DS_GNSS,            // gnssReady、经纬度、卫星数
+    DS_IMU,
+    DS_COMPASS,
+    DS_SLEEP_TIME,
+    DS_LED_MODE,
+    DS_SDCARD,
+    DS_AUDIO,
+    DS_VIBRATION,       // vibrationValid、转速、健康度、有效值，每个分析窗口更新
+    DS_FIELD_COUNT
+};
+
+#define DS_BIT(field) (1UL << (field))
+#define DS_ALL ((1UL << DS_FIELD_COUNT) - 1)
+
+// 写入时关闭调度和中断，临界区内只做比较和拷贝
+struct DeviceStateLock
+{
+    portMUX_TYPE mux;
+    DeviceStateLock() : mux(portMUX_INITIALIZER_UNLOCKED) {}
+    void lock() { portENTER_CRITICAL(&mux); }
+    void unlock() { portEXIT_CRITICAL(&mux); }
+};
+
+typedef StateBus<device_state_t, DeviceStateLock> DeviceStateBus;
+
+/*
+ * 写入：deviceState.set(DS_BATTERY, &device_state_t::battery_voltage, mv);
+ *      同时变化的多个字段用 DeviceStateBus::Writer 一次写入
+ * 读取：deviceState.get(&device_state_t::audioReady) 或 deviceState.snapshot()
+ * 订阅：deviceState.subscribe(DS_BIT(DS_BATTERY_LOW), callback)，回调在 taskSystem 中执行
+ */
+extern DeviceStateBus deviceState;
+extern device_info_t device_info;
+
+// 注册设备状态的订阅者（日志、LED、音频），在任务创建前调用
+void device_state_subscribe();
+
+// MQTT 定时上报，以及取走订阅的状态变化立即上报，在调用 air780eg.loop() 的任务中调用
+void publishMqttReports();
+
+String device_state_to_json(const device_state_t &state);
+
 void print_device_info();
 
 
@@ -0,0 +1,46 @@
+#ifndef ATTITUDE_FILTER_H
+#define ATTITUDE_FILTER_H
+
+#include "utils/FastMath.h"
+
+/*
+ * 互补滤波姿态（横滚、俯仰），按数值类型 T（float 或 Q16）实例化
+ *
+ * 加速度计给出的倾角无漂移但受振动影响，陀螺仪积分平滑但会漂移：
+ *   angle = alpha * (angle + gyro * dt) + (1 - alpha) * angleAcc
+ * 每个采样两次 atan2、一次 sqrt，使用 FastMath.h 的近似，不经过 double。
+ * 输入输出都是 float（单位 g、°/s、度），内部状态为 T。
+ * 误差和耗时见 tools/bench_sensor_math.cpp。
+ */
+
+template <typename T>
+class AttitudeFilter {
+public:
+    typedef SensorMath<T> M;
+
+    AttitudeFilter(float alpha, float dtSec)
+        : alpha(M::from(alpha)), beta(M::from(1.0f - alpha)), dtSec(M::from(dtSec)),
+          rollState(M::from(0.0f)), pitchState(M::from(0.0f)) {}
+
+    void update(float ax, float ay, float az, float gx, float gy) {
+        T x = M::from(ax);
+        T y = M::from(ay);
+        T z = M::from(az);
+        T rollAcc = M::atan2Deg(y, z);
+        T pitchAcc = M::atan2Deg(-x, M::sqrt(y * y + z * z));
+        rollState = alpha * (rollState + M::from(gx) * dtSec) + beta * rollAcc;
+        pitchState = alpha * (pitchState + M::from(gy) * dtSec) + beta * pitchAcc;
+    }
+
+    float roll() const { return M::toFloat(rollState); }
+    float pitch() const { return M::toFloat(pitchState); }
+
+private:
+    T alpha;
+    T beta;
+    T dtSec;
+    T rollState;
+    T pitchState;
+};
+
+#endif // ATTITUDE_FILTER_H
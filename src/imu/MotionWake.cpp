@@ -0,0 +1,383 @@
+#include "MotionWake.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include <sys/time.h>
+#include "utils/PreferencesUtils.h"
+
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+#define MOTION_WAKE_HW 1
+#include <Wire.h>
+#include "SensorQMI8658.hpp"
+#include "driver/rtc_io.h"
+
+// QMI8658 寄存器（数据手册）
+#define QMI_REG_CTRL2       0x03    // bit6:4 加速度计量程
+#define QMI_REG_STATUS1     0x2F    // 读取后清除 WOM 中断
+#define QMI_REG_AX_L        0x35    // AX_L..AZ_H 共6字节
+#else
+#define MOTION_WAKE_HW 0
+#endif
+
+#define MOTION_WAKE_MAGIC       0x574F4D46   // "WOMF"
+#define MOTION_WAKE_MAX_SAMPLES 32
+#define MOTION_WAKE_MIN_SAMPLES 4
+#define MOTION_WAKE_SAMPLE_GAP_MS 8         // 与 WOM 的 128Hz 输出率一致
+#define MOTION_WAKE_REF_SAMPLES 8
+
+static const char* KEY_BASE = "womBaseMg";
+
+struct MotionWakeRtc {
+    uint32_t magic;
+    uint8_t baseMg;             // 最近一次从 NVS 读到的基准阈值，快速路径不读 NVS
+    uint8_t reserved[3];
+    uint32_t lastFilterMs;      // 最近一次误唤醒从应用启动到回到睡眠的耗时
+    int64_t timerDeadlineSec;   // 备用定时唤醒的时间
+    MotionWakeState state;
+};
+
+// 跨深度睡眠保留，上电时为零
+RTC_DATA_ATTR static MotionWakeRtc rtc;
+
+MotionWake motionWake;
+
+MotionWake::MotionWake() : baseLoaded(false), rearm(false), verdict(MOTION_WAKE_NONE)
+{
+    cfg.baseMg = IMU_WOM_BASE_MG;
+    cfg.maxMg = IMU_WOM_MAX_MG;
+    cfg.stepMg = IMU_WOM_STEP_MG;
+    cfg.stormCount = IMU_WOM_STORM_COUNT;
+    cfg.dedupSec = IMU_WOM_DEDUP_SEC;
+    cfg.decaySec = IMU_WOM_DECAY_SEC;
+    cfg.stormWindowSec = IMU_WOM_STORM_WINDOW_SEC;
+    cfg.stormHoldoffSec = IMU_WOM_STORM_HOLDOFF_SEC;
+    cfg.tiltDeg = IMU_WOM_TILT_DEG;
+    cfg.shakeMg = IMU_WOM_SHAKE_MG;
+}
+
+int64_t MotionWake::nowSec()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec;
+}
+
+static void ensureRtc(const MotionWakeConfig& cfg)
+{
+    if (rtc.magic == MOTION_WAKE_MAGIC)
+    {
+        return;
+    }
+    memset(&rtc, 0, sizeof(rtc));
+    rtc.magic = MOTION_WAKE_MAGIC;
+    rtc.baseMg = cfg.baseMg;
+    motionWakeReset(rtc.state, cfg);
+}
+
+void MotionWake::loadBase()
+{
+    if (baseLoaded)
+    {
+        return;
+    }
+    unsigned long mg = PreferencesUtils::loadULong(PreferencesUtils::NS_POWER, KEY_BASE, IMU_WOM_BASE_MG);
+    cfg.baseMg = (uint8_t)constrain(mg, 1UL, (unsigned long)cfg.maxMg);
+    baseLoaded = true;
+    ensureRtc(cfg);
+    rtc.baseMg = cfg.baseMg;
+}
+
+#if MOTION_WAKE_HW
+static bool readRegs(uint8_t reg, uint8_t* buf, size_t len)
+{
+    Wire1.beginTransmission(QMI8658_L_SLAVE_ADDRESS);
+    Wire1.write(reg);
+    if (Wire1.endTransmission(false) != 0)
+    {
+        return false;
+    }
+    if (Wire1.requestFrom((uint8_t)QMI8658_L_SLAVE_ADDRESS, (uint8_t)len) != len)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = Wire1.read();
+    }
+    return true;
+}
+
+// 按当前量程读一次加速度（mg）
+static bool readAccelMg(float mgPerLsb, int16_t out[3])
+{
+    uint8_t raw[6];
+    if (!readRegs(QMI_REG_AX_L, raw, sizeof(raw)))
+    {
+        return false;
+    }
+    for (int a = 0; a < 3; a++)
+    {
+        int16_t v = (int16_t)(raw[a * 2] | (raw[a * 2 + 1] << 8));
+        out[a] = (int16_t)(v * mgPerLsb);
+    }
+    return true;
+}
+
+static bool readScale(float* mgPerLsb)
+{
+    uint8_t ctrl2;
+    if (!readRegs(QMI_REG_CTRL2, &ctrl2, 1))
+    {
+        return false;
+    }
+    // aFS: 0=±2g 1=±4g 2=±8g 3=±16g
+    *mgPerLsb = (float)(2 << ((ctrl2 >> 4) & 0x03)) * 1000.0f / 32768.0f;
+    return true;
+}
+#endif
+
+MotionWakeVerdict MotionWake::classifyWakeup()
+{
+    verdict = MOTION_WAKE_NONE;
+    rearm = false;
+#if MOTION_WAKE_HW
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP || esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT0)
+    {
+        return verdict;
+    }
+    if (rtc.magic != MOTION_WAKE_MAGIC)
+    {
+        verdict = MOTION_WAKE_UNKNOWN;
+        return verdict;
+    }
+    MotionWakeState& s = rtc.state;
+    cfg.baseMg = rtc.baseMg;
+
+    // IMU 保持睡眠前的 WOM 配置，直接读寄存器，不复位
+    Wire1.begin(IMU_SDA_PIN, IMU_SCL_PIN, 400000);
+    int16_t samples[MOTION_WAKE_MAX_SAMPLES][3];
+    int count = 0;
+    float mgPerLsb = 0.0f;
+    uint8_t status1;
+    bool ok = readScale(&mgPerLsb) && readRegs(QMI_REG_STATUS1, &status1, 1);
+    uint32_t start = millis();
+    while (ok && count < MOTION_WAKE_MAX_SAMPLES && millis() - start < IMU_WOM_SAMPLE_MS)
+    {
+        ok = readAccelMg(mgPerLsb, samples[count]);
+        if (ok)
+        {
+            count++;
+        }
+        delay(MOTION_WAKE_SAMPLE_GAP_MS);
+    }
+    Wire1.end();
+
+    MotionWakeFeatures f = motionWakeFeatures(samples, count, s.ref);
+    if (!ok || count < MOTION_WAKE_MIN_SAMPLES)
+    {
+        verdict = MOTION_WAKE_UNKNOWN;
+    }
+    else
+    {
+        verdict = motionWakeClassify(f, s.refValid, cfg);
+    }
+    // 中断已清除但引脚仍为低，回到睡眠会立即再次唤醒
+    if (verdict == MOTION_WAKE_FALSE && rtc_gpio_get_level((gpio_num_t)IMU_INT_PIN) == 0)
+    {
+        verdict = MOTION_WAKE_UNKNOWN;
+    }
+    motionWakeRecord(s, verdict, f);
+    if (verdict == MOTION_WAKE_FALSE)
+    {
+        rearm = motionWakeOnFalse(s, cfg, nowSec());
+    }
+#endif
+    return verdict;
+}
+
+void MotionWake::reportWakeup()
+{
+    if (verdict == MOTION_WAKE_NONE)
+    {
+        return;
+    }
+    loadBase();
+    const MotionWakeState& s = rtc.state;
+    if (verdict != MOTION_WAKE_FALSE)
+    {
+        motionWakeOnReal(rtc.state);
+    }
+    Serial.printf("[IMU唤醒] 判定: %s（姿态变化 %.2f°，晃动 %u mg），阈值 %u mg，累计误唤醒 %lu 次，真实唤醒 %lu 次\n",
+                  motionWakeVerdictName(verdict), s.lastTiltCdeg / 100.0f, s.lastShakeMg, s.thresholdMg,
+                  (unsigned long)s.falseWakes, (unsigned long)s.realWakes);
+}
+
+bool MotionWake::holdoffEnded()
+{
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP || esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER ||
+        rtc.magic != MOTION_WAKE_MAGIC)
+    {
+        return false;
+    }
+    MotionWakeState& s = rtc.state;
+    int64_t now = nowSec();
+    if (s.holdoffUntilSec == 0 || now < s.holdoffUntilSec)
+    {
+        return false;
+    }
+    s.holdoffUntilSec = 0;
+    // 备用定时唤醒已到时按正常定时唤醒启动
+    return now + 2 < rtc.timerDeadlineSec;
+}
+
+uint8_t MotionWake::thresholdForSleep()
+{
+    loadBase();
+    return motionWakeThreshold(rtc.state, cfg, nowSec());
+}
+
+uint8_t MotionWake::threshold() const
+{
+    return rtc.magic == MOTION_WAKE_MAGIC ? rtc.state.thresholdMg : cfg.baseMg;
+}
+
+void MotionWake::captureReference()
+{
+    ensureRtc(cfg);
+    MotionWakeState& s = rtc.state;
+    s.refValid = 0;
+#if MOTION_WAKE_HW
+    // 在 configWakeOnMotion() 之后调用，Wire1 已由 IMU 初始化
+    float mgPerLsb;
+    if (!readScale(&mgPerLsb))
+    {
+        Serial.println("[IMU唤醒] 读取重力方向失败，下次IMU唤醒按真实运动处理");
+        return;
+    }
+    int32_t sum[3] = {0, 0, 0};
+    for (int i = 0; i < MOTION_WAKE_REF_SAMPLES; i++)
+    {
+        int16_t v[3];
+        if (!readAccelMg(mgPerLsb, v))
+        {
+            Serial.println("[IMU唤醒] 读取重力方向失败，下次IMU唤醒按真实运动处理");
+            return;
+        }
+        for (int a = 0; a < 3; a++)
+        {
+            sum[a] += v[a];
+        }
+        delay(MOTION_WAKE_SAMPLE_GAP_MS);
+    }
+    float norm2 = 0.0f;
+    for (int a = 0; a < 3; a++)
+    {
+        s.ref[a] = (int16_t)(sum[a] / MOTION_WAKE_REF_SAMPLES);
+        norm2 += (float)s.ref[a] * s.ref[a];
+    }
+    // 静止时应接近 1g，偏差太大说明正在运动或读数异常
+    float norm = sqrtf(norm2);
+    s.refValid = norm > 700.0f && norm < 1300.0f;
+    if (!s.refValid)
+    {
+        Serial.printf("[IMU唤醒] 重力方向异常 (%.0f mg)，下次IMU唤醒按真实运动处理\n", norm);
+    }
+#endif
+}
+
+bool MotionWake::suppressed()
+{
+    ensureRtc(cfg);
+    return motionWakeSuppressed(rtc.state, nowSec());
+}
+
+void MotionWake::setTimerDeadline(uint32_t seconds)
+{
+    ensureRtc(cfg);
+    rtc.timerDeadlineSec = nowSec() + seconds;
+}
+
+uint64_t MotionWake::sleepTimerUs()
+{
+    ensureRtc(cfg);
+    int64_t now = nowSec();
+    int64_t until = rtc.timerDeadlineSec;
+    if (motionWakeSuppressed(rtc.state, now) && rtc.state.holdoffUntilSec < until)
+    {
+        until = rtc.state.holdoffUntilSec;
+    }
+    int64_t remaining = until - now;
+    if (remaining < 1)
+    {
+        remaining = 1;
+    }
+    return (uint64_t)remaining * 1000000ULL;
+}
+
+void MotionWake::markResleep()
+{
+    rtc.lastFilterMs = (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void MotionWake::setBaseThreshold(uint8_t mg)
+{
+    mg = (uint8_t)constrain(mg, 1, cfg.maxMg);
+    PreferencesUtils::saveULong(PreferencesUtils::NS_POWER, KEY_BASE, mg);
+    cfg.baseMg = mg;
+    baseLoaded = true;
+    ensureRtc(cfg);
+    rtc.baseMg = mg;
+    // 从新的基准值重新开始自适应
+    rtc.state.thresholdMg = mg;
+    rtc.state.lastChangeSec = nowSec();
+}
+
+uint8_t MotionWake::baseThreshold()
+{
+    loadBase();
+    return cfg.baseMg;
+}
+
+void MotionWake::resetStats()
+{
+    ensureRtc(cfg);
+    MotionWakeState& s = rtc.state;
+    s.falseWakes = 0;
+    s.duplicates = 0;
+    s.realWakes = 0;
+    s.storms = 0;
+    s.recentFalse = 0;
+    s.holdoffUntilSec = 0;
+    rtc.lastFilterMs = 0;
+}
+
+void MotionWake::printStats()
+{
+    loadBase();
+    const MotionWakeState& s = rtc.state;
+    int64_t now = nowSec();
+    Serial.println("=== IMU运动唤醒 ===");
+    Serial.printf("基准阈值: %u mg，当前阈值: %u mg（上限 %u mg，误唤醒后 +%u mg，安静 %lu 小时降一档）\n",
+                  cfg.baseMg, s.thresholdMg, cfg.maxMg, cfg.stepMg, (unsigned long)(cfg.decaySec / 3600));
+    Serial.printf("判定: 姿态变化 > %.1f° 或晃动 > %.0f mg 为真实运动，采样 %d ms，重力方向%s\n",
+                  cfg.tiltDeg, cfg.shakeMg, IMU_WOM_SAMPLE_MS, s.refValid ? "已记录" : "未记录");
+    Serial.printf("误唤醒: %lu 次（%lu 秒内重复 %lu 次），真实唤醒: %lu 次，唤醒风暴: %lu 次\n",
+                  (unsigned long)s.falseWakes, (unsigned long)cfg.dedupSec, (unsigned long)s.duplicates,
+                  (unsigned long)s.realWakes, (unsigned long)s.storms);
+    Serial.printf("最近一次: %s（姿态变化 %.2f°，晃动 %u mg）\n", motionWakeVerdictName(s.lastVerdict),
+                  s.lastTiltCdeg / 100.0f, s.lastShakeMg);
+    if (rtc.lastFilterMs)
+    {
+        Serial.printf("最近一次误唤醒回到睡眠: 启动后 %lu ms\n", (unsigned long)rtc.lastFilterMs);
+    }
+    if (motionWakeSuppressed(s, now))
+    {
+        Serial.printf("唤醒风暴暂停中，剩余 %lld 秒\n", (long long)(s.holdoffUntilSec - now));
+    }
+}
+
+const MotionWakeState& MotionWake::state()
+{
+    ensureRtc(cfg);
+    return rtc.state;
+}
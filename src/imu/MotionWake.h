@@ -0,0 +1,74 @@
+#ifndef MOTION_WAKE_H
+#define MOTION_WAKE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "MotionWakeLogic.h"
+
+/*
+ * IMU运动唤醒过滤
+ *
+ * 进入睡眠前按自适应阈值配置 WOM 并记录重力方向；深度睡眠被 IMU 唤醒后，
+ * setup() 最前面直接读 QMI8658 寄存器采样约 IMU_WOM_SAMPLE_MS（不复位IMU，WOM 配置保持），
+ * 判定逻辑见 MotionWakeLogic.h。误唤醒由 PowerManager::filterMotionWakeup() 直接回到睡眠，
+ * 不走完整启动流程；真实运动照常启动。
+ *
+ * 状态和计数保存在 RTC 内存中，基准阈值按安装位置用串口命令修改，保存在 NVS。
+ */
+
+class MotionWake {
+public:
+    MotionWake();
+
+    /**
+     * @brief 深度睡眠被 IMU 唤醒后采样判定，在 setup() 最前面调用
+     * @return 判定结果；误唤醒已计入计数，其他结果在 reportWakeup() 中计入
+     */
+    MotionWakeVerdict classifyWakeup();
+
+    // 本次 IMU 唤醒的判定结果，完整启动时输出并计入真实唤醒
+    void reportWakeup();
+
+    // 误唤醒提高了阈值，回到睡眠前需要重新配置 WOM
+    bool rearmNeeded() const { return rearm; }
+
+    // 唤醒风暴暂停已到期且备用定时唤醒未到，可以恢复 IMU 唤醒继续睡眠
+    bool holdoffEnded();
+
+    // 进入睡眠时使用的 WOM 阈值（按安静时长降档）
+    uint8_t thresholdForSleep();
+    uint8_t threshold() const;
+
+    // WOM 配置完成后记录重力方向
+    void captureReference();
+
+    // 唤醒风暴暂停期间不使用 IMU 唤醒
+    bool suppressed();
+
+    // 备用定时唤醒：睡眠前记录，误唤醒回到睡眠时按剩余时间重新设置
+    void setTimerDeadline(uint32_t seconds);
+    uint64_t sleepTimerUs();
+
+    // 误唤醒回到睡眠前调用，记录从应用启动到回到睡眠的耗时
+    void markResleep();
+
+    void setBaseThreshold(uint8_t mg);
+    uint8_t baseThreshold();
+    void resetStats();
+    void printStats();
+
+    const MotionWakeState& state();
+
+private:
+    MotionWakeConfig cfg;
+    bool baseLoaded;
+    bool rearm;
+    MotionWakeVerdict verdict;
+
+    void loadBase();
+    static int64_t nowSec();
+};
+
+extern MotionWake motionWake;
+
+#endif // MOTION_WAKE_H
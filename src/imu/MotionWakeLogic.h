@@ -0,0 +1,202 @@
+#ifndef MOTION_WAKE_LOGIC_H
+#define MOTION_WAKE_LOGIC_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * IMU运动唤醒（WOM）的误唤醒判定和阈值自适应
+ *
+ * 深度睡眠被 WOM 中断唤醒后，启动最前面短暂采样加速度计，与睡眠前记录的重力方向比较：
+ * - 姿态变化超过 tiltDeg：车被推动、推倒或抬起
+ * - 采样偏离平均值的均方根超过 shakeMg：仍在持续晃动（有人在操作车辆）
+ * 都不满足时判为误唤醒（路过的重车、风、附近坑洼的冲击已经结束），直接回到睡眠。
+ *
+ * 误唤醒后阈值提高一档，dedupSec 内的连续误唤醒视为同一次冲击，只提高一次；
+ * 超过 decaySec 没有误唤醒时逐档降回基准阈值。stormWindowSec 内误唤醒达到 stormCount 次
+ * 视为唤醒风暴，暂停 IMU 唤醒 stormHoldoffSec，期间只靠电门、ULP 监测和定时器唤醒。
+ *
+ * 状态保存在 RTC 内存中，计数随状态上报，用于按安装位置调整基准阈值。
+ * 误唤醒判定的仿真见 tools/motion_wake_sim.cpp。
+ */
+
+struct MotionWakeConfig {
+    uint8_t baseMg;             // 基准阈值
+    uint8_t maxMg;              // 自适应上限（WOM 阈值寄存器为 8 位，最大 255mg）
+    uint8_t stepMg;
+    uint8_t stormCount;
+    uint32_t dedupSec;
+    uint32_t decaySec;
+    uint32_t stormWindowSec;
+    uint32_t stormHoldoffSec;
+    float tiltDeg;
+    float shakeMg;
+};
+
+enum MotionWakeVerdict : uint8_t {
+    MOTION_WAKE_NONE = 0,       // 不是 IMU 唤醒
+    MOTION_WAKE_FALSE,          // 误唤醒
+    MOTION_WAKE_TILT,           // 姿态变化
+    MOTION_WAKE_SHAKE,          // 持续晃动
+    MOTION_WAKE_UNKNOWN,        // 无法判定（没有参考方向、读取失败、中断未解除），按真实运动处理
+};
+
+struct MotionWakeState {
+    uint8_t thresholdMg;        // 当前 WOM 阈值
+    uint8_t recentFalse;        // 风暴窗口内的误唤醒次数
+    uint8_t refValid;
+    uint8_t lastVerdict;
+    int16_t ref[3];             // 睡眠前的重力方向（传感器坐标，mg）
+    uint16_t lastTiltCdeg;      // 最近一次判定的姿态变化（0.01°）
+    uint16_t lastShakeMg;       // 最近一次判定的晃动
+    uint16_t reserved;
+    uint32_t falseWakes;
+    uint32_t duplicates;        // 其中与上一次误唤醒间隔不超过 dedupSec 的次数
+    uint32_t realWakes;
+    uint32_t storms;
+    int64_t windowStartSec;
+    int64_t lastFalseSec;
+    int64_t lastChangeSec;      // 上次误唤醒或降档的时间，降档从这里开始计时
+    int64_t holdoffUntilSec;    // 暂停 IMU 唤醒到该时间，0 表示没有暂停
+};
+
+struct MotionWakeFeatures {
+    float tiltDeg;
+    float shakeMg;
+    float meanMg[3];
+};
+
+static inline const char* motionWakeVerdictName(uint8_t verdict) {
+    switch (verdict) {
+    case MOTION_WAKE_FALSE: return "误唤醒";
+    case MOTION_WAKE_TILT: return "姿态变化";
+    case MOTION_WAKE_SHAKE: return "持续晃动";
+    case MOTION_WAKE_UNKNOWN: return "无法判定";
+    default: return "无";
+    }
+}
+
+static inline void motionWakeReset(MotionWakeState& s, const MotionWakeConfig& cfg) {
+    memset(&s, 0, sizeof(s));
+    s.thresholdMg = cfg.baseMg;
+}
+
+// 采样的平均方向与参考方向的夹角，和各采样偏离平均值的均方根（任意方向的晃动）
+static inline MotionWakeFeatures motionWakeFeatures(const int16_t samples[][3], int count, const int16_t ref[3]) {
+    MotionWakeFeatures f;
+    memset(&f, 0, sizeof(f));
+    if (count <= 0) {
+        return f;
+    }
+    for (int i = 0; i < count; i++) {
+        for (int a = 0; a < 3; a++) {
+            f.meanMg[a] += samples[i][a];
+        }
+    }
+    for (int a = 0; a < 3; a++) {
+        f.meanMg[a] /= count;
+    }
+    float sum2 = 0.0f;
+    for (int i = 0; i < count; i++) {
+        for (int a = 0; a < 3; a++) {
+            float d = samples[i][a] - f.meanMg[a];
+            sum2 += d * d;
+        }
+    }
+    f.shakeMg = sqrtf(sum2 / count);
+
+    float dot = f.meanMg[0] * ref[0] + f.meanMg[1] * ref[1] + f.meanMg[2] * ref[2];
+    float n1 = sqrtf(f.meanMg[0] * f.meanMg[0] + f.meanMg[1] * f.meanMg[1] + f.meanMg[2] * f.meanMg[2]);
+    float n2 = sqrtf((float)ref[0] * ref[0] + (float)ref[1] * ref[1] + (float)ref[2] * ref[2]);
+    if (n1 > 0.0f && n2 > 0.0f) {
+        float c = dot / (n1 * n2);
+        c = c > 1.0f ? 1.0f : (c < -1.0f ? -1.0f : c);
+        f.tiltDeg = acosf(c) * 180.0f / (float)M_PI;
+    }
+    return f;
+}
+
+static inline MotionWakeVerdict motionWakeClassify(const MotionWakeFeatures& f, bool refValid,
+                                                   const MotionWakeConfig& cfg) {
+    if (!refValid) {
+        return MOTION_WAKE_UNKNOWN;
+    }
+    if (f.tiltDeg > cfg.tiltDeg) {
+        return MOTION_WAKE_TILT;
+    }
+    if (f.shakeMg > cfg.shakeMg) {
+        return MOTION_WAKE_SHAKE;
+    }
+    return MOTION_WAKE_FALSE;
+}
+
+static inline void motionWakeRecord(MotionWakeState& s, MotionWakeVerdict verdict, const MotionWakeFeatures& f) {
+    s.lastVerdict = verdict;
+    float tilt = f.tiltDeg * 100.0f;
+    s.lastTiltCdeg = tilt > 65535.0f ? 65535 : (uint16_t)tilt;
+    s.lastShakeMg = f.shakeMg > 65535.0f ? 65535 : (uint16_t)f.shakeMg;
+}
+
+/**
+ * @brief 记录一次误唤醒
+ * @return 阈值已提高，需要重新配置 WOM
+ */
+static inline bool motionWakeOnFalse(MotionWakeState& s, const MotionWakeConfig& cfg, int64_t nowSec) {
+    s.falseWakes++;
+    bool duplicate = s.lastFalseSec != 0 && nowSec - s.lastFalseSec <= (int64_t)cfg.dedupSec;
+    s.lastFalseSec = nowSec;
+    s.lastChangeSec = nowSec;
+
+    if (nowSec - s.windowStartSec > (int64_t)cfg.stormWindowSec) {
+        s.windowStartSec = nowSec;
+        s.recentFalse = 0;
+    }
+    if (s.recentFalse < 255) {
+        s.recentFalse++;
+    }
+    if (cfg.stormCount > 0 && s.recentFalse >= cfg.stormCount) {
+        s.storms++;
+        s.holdoffUntilSec = nowSec + cfg.stormHoldoffSec;
+        s.recentFalse = 0;
+        s.windowStartSec = nowSec;
+    }
+
+    if (duplicate) {
+        s.duplicates++;
+        return false;
+    }
+    if (s.thresholdMg >= cfg.maxMg) {
+        return false;
+    }
+    int next = s.thresholdMg + cfg.stepMg;
+    s.thresholdMg = next > cfg.maxMg ? cfg.maxMg : (uint8_t)next;
+    return true;
+}
+
+static inline void motionWakeOnReal(MotionWakeState& s) {
+    s.realWakes++;
+}
+
+// 按安静时长逐档降回基准值，返回进入睡眠时使用的阈值
+static inline uint8_t motionWakeThreshold(MotionWakeState& s, const MotionWakeConfig& cfg, int64_t nowSec) {
+    if (s.thresholdMg < cfg.baseMg) {
+        s.thresholdMg = cfg.baseMg;
+    }
+    if (s.thresholdMg > cfg.maxMg) {
+        s.thresholdMg = cfg.maxMg;
+    }
+    while (s.thresholdMg > cfg.baseMg && cfg.decaySec > 0 && nowSec - s.lastChangeSec >= (int64_t)cfg.decaySec) {
+        int next = s.thresholdMg - cfg.stepMg;
+        s.thresholdMg = next < cfg.baseMg ? cfg.baseMg : (uint8_t)next;
+        s.lastChangeSec += cfg.decaySec;
+    }
+    return s.thresholdMg;
+}
+
+// 唤醒风暴暂停期间不使用 IMU 唤醒
+static inline bool motionWakeSuppressed(const MotionWakeState& s, int64_t nowSec) {
+    return s.holdoffUntilSec != 0 && nowSec < s.holdoffUntilSec;
+}
+
+#endif // MOTION_WAKE_LOGIC_H
@@ -0,0 +1,176 @@
+#include "Vibration.h"
+#include "esp_timer.h"
+#include "device.h"
+#include "utils/Log.h"
+
+#ifdef ENABLE_IMU
+#include "qmi8658.h"
+
+Vibration vibration;
+
+Vibration::Vibration()
+    : analyzer(makeConfig()),
+      enabled(VIB_ENABLED),
+      usingDsp(false),
+      task(NULL),
+      lastAnalyzeUs(0),
+      maxAnalyzeUs(0),
+      readErrors(0),
+      overruns(0)
+{
+}
+
+VibrationConfig Vibration::makeConfig()
+{
+    VibrationConfig c;
+    c.sampleRateHz = VIB_SAMPLE_RATE_HZ;
+    c.bandLowHz = VIB_BAND_LOW_HZ;
+    c.bandHighHz = VIB_BAND_HIGH_HZ;
+    c.rpmMin = VIB_RPM_MIN;
+    c.rpmMax = VIB_RPM_MAX;
+    c.engineOrder = VIB_ENGINE_ORDER;
+    c.rpmMinSnr = VIB_RPM_MIN_SNR;
+    c.highGoodMg = VIB_HIGH_GOOD_MG;
+    c.highBadMg = VIB_HIGH_BAD_MG;
+    c.crestGood = VIB_CREST_GOOD;
+    c.crestBad = VIB_CREST_BAD;
+    c.healthSmoothing = VIB_HEALTH_SMOOTHING;
+    return c;
+}
+
+void Vibration::begin()
+{
+    if (task != NULL)
+    {
+        return;
+    }
+    usingDsp = analyzer.begin();
+    if (xTaskCreate(taskMain, "TaskVibration", VIB_TASK_STACK_SIZE, this, VIB_TASK_PRIORITY, &task) != pdPASS)
+    {
+        Serial.println("[振动] 采样任务创建失败");
+        task = NULL;
+        return;
+    }
+    Serial.printf("[振动] 初始化完成，%d 点 FFT（%s），%s\n", VibrationAnalyzer::N,
+                  usingDsp ? "ESP-DSP" : "可移植实现", enabled ? "已启用" : "未启用（vib.on 开启）");
+}
+
+void Vibration::setEnabled(bool on)
+{
+    enabled = on;
+}
+
+void Vibration::taskMain(void* arg)
+{
+    static_cast<Vibration*>(arg)->run();
+}
+
+void Vibration::run()
+{
+    const TickType_t period = pdMS_TO_TICKS(VIB_SAMPLE_PERIOD_MS) > 0 ? pdMS_TO_TICKS(VIB_SAMPLE_PERIOD_MS) : 1;
+    bool sampling = false;
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true)
+    {
+        device_state_t state = deviceState.snapshot();
+        bool active = enabled && state.imuReady;
+#if VIB_REQUIRE_IGNITION
+        active = active && state.external_power;
+#endif
+        if (!active)
+        {
+            if (sampling)
+            {
+                sampling = false;
+                analyzer.reset();
+                publish(false);
+                LOGI(IMU, "振动分析暂停");
+            }
+            vTaskDelay(pdMS_TO_TICKS(VIB_IDLE_POLL_MS));
+            continue;
+        }
+        if (!sampling)
+        {
+            sampling = true;
+            lastWake = xTaskGetTickCount();
+            LOGI(IMU, "振动分析开始");
+        }
+
+        // 每个窗口检查一次状态，窗口内只采样
+        for (int i = 0; i < VibrationAnalyzer::N; i++)
+        {
+            // 错过的周期不补采，窗口内的采样间隔保持一致比凑满点数重要
+            if (xTaskGetTickCount() - lastWake > period)
+            {
+                overruns++;
+                lastWake = xTaskGetTickCount();
+            }
+            vTaskDelayUntil(&lastWake, period);
+
+            float ax, ay, az;
+            if (!imu.readAccel(ax, ay, az))
+            {
+                readErrors++;
+                continue;
+            }
+            int64_t start = esp_timer_get_time();
+            if (analyzer.addSample(ax, ay, az))
+            {
+                // 窗口满的这次 addSample 包含整个窗口的分析
+                lastAnalyzeUs = (uint32_t)(esp_timer_get_time() - start);
+                if (lastAnalyzeUs > maxAnalyzeUs)
+                {
+                    maxAnalyzeUs = lastAnalyzeUs;
+                }
+                publish(true);
+            }
+        }
+    }
+}
+
+void Vibration::publish(bool valid)
+{
+    const VibrationResult& r = analyzer.result();
+    valid = valid && r.valid;
+    DeviceStateBus::Writer state(deviceState);
+    state.set(DS_VIBRATION, &device_state_t::vibrationValid, valid);
+    state.set(DS_VIBRATION, &device_state_t::engine_rpm, valid ? (int)(r.rpm / 10.0f + 0.5f) * 10 : 0);
+    state.set(DS_VIBRATION, &device_state_t::vibration_health, valid ? r.health : 0);
+    state.set(DS_VIBRATION, &device_state_t::vibration_rms_mg, valid ? (int)(r.rmsMg + 0.5f) : 0);
+}
+
+void Vibration::printStatus()
+{
+    // 采样任务可能正在写入，串口诊断用，不加锁
+    VibrationResult r = analyzer.result();
+    Serial.println("=== 振动分析 ===");
+    Serial.printf("状态: %s，%d 点 FFT（%s），采样 %d Hz，窗口 %.2f 秒，频率分辨率 %.2f Hz（%.0f 转）\n",
+                  enabled ? "已启用" : "未启用", VibrationAnalyzer::N, usingDsp ? "ESP-DSP" : "可移植实现",
+                  VIB_SAMPLE_RATE_HZ, VibrationAnalyzer::N / (float)VIB_SAMPLE_RATE_HZ, analyzer.binHz(),
+                  analyzer.binHz() * 60.0f / VIB_ENGINE_ORDER);
+    Serial.printf("转速范围: %d ~ %d 转（每转 %.1f 次振动），%s\n", VIB_RPM_MIN, VIB_RPM_MAX, (float)VIB_ENGINE_ORDER,
+                  VIB_REQUIRE_IGNITION ? "仅电门打开时采样" : "始终采样");
+    Serial.printf("分析耗时: 最近 %lu us，最长 %lu us；读取失败 %lu 次，错过采样周期 %lu 次\n",
+                  (unsigned long)lastAnalyzeUs, (unsigned long)maxAnalyzeUs, (unsigned long)readErrors,
+                  (unsigned long)overruns);
+    if (!r.valid)
+    {
+        Serial.println("暂无结果");
+        return;
+    }
+    Serial.printf("窗口数: %lu，总有效值 %.0f mg，峰值因数 %.1f\n", (unsigned long)r.windows, r.rmsMg, r.crest);
+    Serial.printf("频带: 路面 %.0f mg，发动机 %.0f mg，高频 %.0f mg（去掉发动机谐波 %.0f mg）\n",
+                  r.bandMg[VIB_BAND_ROAD], r.bandMg[VIB_BAND_ENGINE], r.bandMg[VIB_BAND_HIGH], r.residualMg);
+    Serial.printf("最强峰: %.1f Hz，%.0f mg\n", r.peakHz, r.peakMg);
+    if (r.rpm > 0)
+    {
+        Serial.printf("发动机转速: %.0f 转/分\n", r.rpm);
+    }
+    else
+    {
+        Serial.println("发动机转速: 未检测到");
+    }
+    Serial.printf("健康度: %u（本窗口 %u）\n", r.health, r.healthNow);
+}
+
+#endif // ENABLE_IMU
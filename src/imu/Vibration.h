@@ -0,0 +1,51 @@
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "VibrationLogic.h"
+
+/*
+ * 振动分析任务：发动机转速和振动健康度
+ *
+ * 独立任务按 VIB_SAMPLE_RATE_HZ 读取加速度计（与加速度计输出率一致，IMU::loop 的 100Hz 不够），
+ * 每 VIB_FFT_SIZE 个采样分析一次（算法见 VibrationLogic.h），结果写入设备状态 DS_VIBRATION 分组，
+ * 随设备状态 JSON 上报。只在电门打开时采样（VIB_REQUIRE_IGNITION），电门关闭或 IMU 未就绪时清除结果。
+ * 与 IMU::loop 共用 I2C 总线，每个采样一次 6 字节读取。
+ * 默认关闭（VIB_ENABLED），可用串口命令 vib.on / vib.off 临时开关。
+ */
+
+class Vibration {
+public:
+    Vibration();
+
+    // 初始化 FFT 并创建采样任务，在 IMU 初始化之后调用
+    void begin();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    void printStatus();
+
+private:
+    VibrationAnalyzer analyzer;
+    volatile bool enabled;
+    bool usingDsp;
+    TaskHandle_t task;
+
+    uint32_t lastAnalyzeUs;     // 最近一次窗口分析耗时
+    uint32_t maxAnalyzeUs;
+    uint32_t readErrors;        // 加速度计读取失败次数
+    uint32_t overruns;          // 采样周期被错过的次数（任务被抢占或 I2C 等待）
+
+    static VibrationConfig makeConfig();
+    static void taskMain(void* arg);
+    void run();
+    void publish(bool valid);
+};
+
+#ifdef ENABLE_IMU
+extern Vibration vibration;
+#endif
+
+#endif // VIBRATION_H
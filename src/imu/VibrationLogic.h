@@ -0,0 +1,389 @@
+#ifndef VIBRATION_LOGIC_H
+#define VIBRATION_LOGIC_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * 振动频谱分析：发动机转速估计和振动健康度
+ *
+ * 每 VIB_FFT_SIZE 个加速度采样（三轴，单位 g）为一个窗口，不重叠：
+ * - 各轴去均值（去掉重力和静态倾斜）、加 Hann 窗
+ * - x、y 两轴合成一个复数序列做一次 FFT，z 轴再做一次，按 |X|²+|Y|² = (|Z[k]|²+|Z[N-k]|²)/2 分离，
+ *   三轴功率相加得到单边功率谱。功率和与传感器安装方向无关
+ * - 频带能量（路面/悬挂、发动机、高频）和最强峰（抛物线插值）
+ * - 转速：在设定转速范围内做谐波求和（基频和 2、3 次谐波的幅值，权重递减，避免选中基频的几分之一），
+ *   最强候选明显高于平均谱幅时转速 = 基频 * 60 / engineOrder，否则为 0（熄火或被路面振动淹没）
+ * - 健康度 0~100：高频段去掉发动机谐波后的有效值（减震胶老化、支架松动时的宽带振动）和
+ *   时域峰值因数（松动部件的撞击）分别按 good/bad 阈值线性打分，取较低者，再按窗口做指数平滑
+ *
+ * FFT 为基 2 复数 FFT：ESP32 上有 ESP-DSP 时用 dsps_fft2r_fc32（S3 为 SIMD 版本，ESP32 为汇编优化版本），
+ * 否则用可移植实现。转速估计和耗时见 tools/bench_vibration.cpp。
+ */
+
+#ifndef VIB_FFT_SIZE
+#define VIB_FFT_SIZE 256
+#endif
+
+#if (VIB_FFT_SIZE & (VIB_FFT_SIZE - 1)) != 0
+#error "VIB_FFT_SIZE 必须是 2 的幂"
+#endif
+
+#ifndef VIBRATION_USE_ESP_DSP
+#if defined(ESP_PLATFORM) && defined(__has_include)
+#if __has_include("esp_dsp.h")
+#define VIBRATION_USE_ESP_DSP 1
+#endif
+#endif
+#endif
+
+#if VIBRATION_USE_ESP_DSP
+#include "esp_dsp.h"
+#endif
+
+#define VIB_BAND_COUNT 3
+
+enum VibrationBand : uint8_t {
+    VIB_BAND_ROAD = 0,      // 低于 bandLowHz：路面、悬挂
+    VIB_BAND_ENGINE,        // bandLowHz ~ bandHighHz：发动机及其谐波
+    VIB_BAND_HIGH,          // 高于 bandHighHz：支架松动、轴承、链条
+};
+
+struct VibrationConfig {
+    float sampleRateHz;
+    float bandLowHz;
+    float bandHighHz;
+    float rpmMin;
+    float rpmMax;
+    float engineOrder;      // 每转振动次数：1 为一阶不平衡，单缸四冲程点火频率为 0.5，直列四缸二阶为 2
+    float rpmMinSnr;        // 谐波求和幅值 / 平均谱幅值低于该值不输出转速
+    float highGoodMg;       // 高频段残余有效值，不超过该值为 100 分
+    float highBadMg;        // 达到该值为 0 分
+    float crestGood;        // 峰值因数（峰值 / 有效值），正弦约 1.4，随机振动约 3~4
+    float crestBad;
+    float healthSmoothing;  // 健康度指数平滑系数（每窗口）
+};
+
+struct VibrationResult {
+    bool valid;
+    float rmsMg;                    // 去掉直流后的总有效值
+    float bandMg[VIB_BAND_COUNT];   // 各频带有效值
+    float residualMg;               // 高频段去掉发动机谐波（检测到转速时）后的有效值
+    float peakHz;                   // 最强峰
+    float peakMg;
+    float rpm;                      // 0 为未检测到
+    float crest;
+    uint8_t healthNow;              // 本窗口
+    uint8_t health;                 // 平滑后
+    uint32_t windows;
+};
+
+class VibrationAnalyzer {
+public:
+    static const int N = VIB_FFT_SIZE;
+
+    explicit VibrationAnalyzer(const VibrationConfig& config)
+        : cfg(config), count(0), healthAvg(-1), useDsp(false) {
+        memset(&res, 0, sizeof(res));
+        float sum = 0;
+        for (int i = 0; i < N; i++) {
+            window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / N);
+            sum += window[i] * window[i];
+        }
+        windowPower = sum / N;
+        portableTwiddle();
+    }
+
+    // 初始化 ESP-DSP 的旋转因子表（表放在本对象内），失败时使用可移植实现；返回是否使用 ESP-DSP
+    bool begin() {
+#if VIBRATION_USE_ESP_DSP
+        useDsp = dsps_fft2r_init_fc32(twiddle, N) == ESP_OK;
+        if (!useDsp) {
+            portableTwiddle();
+        }
+#endif
+        return useDsp;
+    }
+
+    // 加入一个采样（g），窗口满时分析并返回 true，结果见 result()
+    bool addSample(float ax, float ay, float az) {
+        samples[0][count] = ax;
+        samples[1][count] = ay;
+        samples[2][count] = az;
+        if (++count < N) {
+            return false;
+        }
+        count = 0;
+        analyze();
+        return true;
+    }
+
+    // 丢弃未满的窗口和平滑状态（采样中断后重新开始）
+    void reset() {
+        count = 0;
+        healthAvg = -1;
+        res.valid = false;
+    }
+
+    const VibrationResult& result() const { return res; }
+    const float* spectrum() const { return power; }     // 单边功率谱，g²，下标为频点
+    float binHz() const { return cfg.sampleRateHz / N; }
+
+    // 可移植的基 2 复数 FFT（原地，交错的实部、虚部），tw 为 N/2 个 e^(-j2πk/N)
+    static void fftPortable(float* data, int n, const float* tw) {
+        for (int i = 1, j = 0; i < n; i++) {
+            int bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                float tr = data[2 * i];
+                float ti = data[2 * i + 1];
+                data[2 * i] = data[2 * j];
+                data[2 * i + 1] = data[2 * j + 1];
+                data[2 * j] = tr;
+                data[2 * j + 1] = ti;
+            }
+        }
+        for (int len = 2; len <= n; len <<= 1) {
+            int half = len >> 1;
+            int step = n / len;
+            for (int start = 0; start < n; start += len) {
+                for (int k = 0; k < half; k++) {
+                    float wr = tw[2 * k * step];
+                    float wi = tw[2 * k * step + 1];
+                    float* a = data + 2 * (start + k);
+                    float* b = data + 2 * (start + k + half);
+                    float br = b[0] * wr - b[1] * wi;
+                    float bi = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - br;
+                    b[1] = a[1] - bi;
+                    a[0] += br;
+                    a[1] += bi;
+                }
+            }
+        }
+    }
+
+private:
+    void portableTwiddle() {
+        for (int i = 0; i < N / 2; i++) {
+            twiddle[2 * i] = cosf(2.0f * (float)M_PI * i / N);
+            twiddle[2 * i + 1] = -sinf(2.0f * (float)M_PI * i / N);
+        }
+    }
+
+    void fft(float* data) {
+#if VIBRATION_USE_ESP_DSP
+        if (useDsp) {
+            dsps_fft2r_fc32(data, N);
+            dsps_bit_rev_fc32(data, N);
+            return;
+        }
+#endif
+        fftPortable(data, N, twiddle);
+    }
+
+    void analyze() {
+        // 去均值，时域峰值因数用去均值后的三轴矢量长度
+        float mean[3];
+        for (int a = 0; a < 3; a++) {
+            float sum = 0;
+            for (int i = 0; i < N; i++) {
+                sum += samples[a][i];
+            }
+            mean[a] = sum / N;
+        }
+        float peak2 = 0;
+        float sum2 = 0;
+        for (int i = 0; i < N; i++) {
+            float x = samples[0][i] - mean[0];
+            float y = samples[1][i] - mean[1];
+            float z = samples[2][i] - mean[2];
+            float m2 = x * x + y * y + z * z;
+            sum2 += m2;
+            if (m2 > peak2) {
+                peak2 = m2;
+            }
+            bufXY[2 * i] = x * window[i];
+            bufXY[2 * i + 1] = y * window[i];
+            bufZ[2 * i] = z * window[i];
+            bufZ[2 * i + 1] = 0;
+        }
+        fft(bufXY);
+        fft(bufZ);
+
+        // 单边功率谱，按窗函数功率归一化，各频点之和等于时域方差
+        const float scale = 2.0f / ((float)N * N * windowPower);
+        float total = 0;
+        for (int k = 1; k < N / 2; k++) {
+            int m = N - k;
+            float xy = 0.5f * (bufXY[2 * k] * bufXY[2 * k] + bufXY[2 * k + 1] * bufXY[2 * k + 1] +
+                               bufXY[2 * m] * bufXY[2 * m] + bufXY[2 * m + 1] * bufXY[2 * m + 1]);
+            float z = bufZ[2 * k] * bufZ[2 * k] + bufZ[2 * k + 1] * bufZ[2 * k + 1];
+            power[k] = (xy + z) * scale;
+            total += power[k];
+        }
+        power[0] = 0;
+
+        const float hz = binHz();
+        float band[VIB_BAND_COUNT] = {0, 0, 0};
+        int peakBin = 1;
+        for (int k = 1; k < N / 2; k++) {
+            float f = k * hz;
+            band[f < cfg.bandLowHz ? VIB_BAND_ROAD : f < cfg.bandHighHz ? VIB_BAND_ENGINE : VIB_BAND_HIGH] += power[k];
+            if (power[k] > power[peakBin]) {
+                peakBin = k;
+            }
+        }
+
+        res.rmsMg = sqrtf(total) * 1000.0f;
+        for (int b = 0; b < VIB_BAND_COUNT; b++) {
+            res.bandMg[b] = sqrtf(band[b]) * 1000.0f;
+        }
+        res.peakHz = interpolate(peakBin) * hz;
+        res.peakMg = sqrtf(power[peakBin]) * 1000.0f;
+        res.rpm = estimateRpm();
+        res.residualMg = sqrtf(highResidual(res.rpm)) * 1000.0f;
+        float rms = sqrtf(sum2 / N);
+        res.crest = rms > 0 ? sqrtf(peak2) / rms : 0;
+
+        float highScore = score(res.residualMg, cfg.highGoodMg, cfg.highBadMg);
+        float crestScore = score(res.crest, cfg.crestGood, cfg.crestBad);
+        float now = highScore < crestScore ? highScore : crestScore;
+        healthAvg = healthAvg < 0 ? now : healthAvg + cfg.healthSmoothing * (now - healthAvg);
+        res.healthNow = (uint8_t)(now + 0.5f);
+        res.health = (uint8_t)(healthAvg + 0.5f);
+        res.windows++;
+        res.valid = true;
+    }
+
+    // 谐波求和：基频候选 k 的得分为 k、2k、3k 处的幅值之和
+    float estimateRpm() {
+        const float hz = binHz();
+        int lo = (int)(cfg.rpmMin * cfg.engineOrder / 60.0f / hz);
+        int hi = (int)(cfg.rpmMax * cfg.engineOrder / 60.0f / hz + 1);
+        if (lo < 1) {
+            lo = 1;
+        }
+        if (hi > N / 2 - 2) {
+            hi = N / 2 - 2;
+        }
+        float meanMag = 0;
+        for (int k = 1; k < N / 2; k++) {
+            mag[k] = sqrtf(power[k]);
+            meanMag += mag[k];
+        }
+        meanMag /= (N / 2 - 1);
+        if (lo > hi || meanMag <= 0) {
+            return 0;
+        }
+        int best = 0;
+        float bestScore = 0;
+        for (int k = lo; k <= hi; k++) {
+            // 频点之间的峰会分到相邻两个频点，取三点中的最大值
+            static const float WEIGHT[3] = {1.0f, 0.7f, 0.5f};
+            float s = 0;
+            for (int h = 1; h <= 3 && h * k + 1 < N / 2; h++) {
+                s += localMax(h * k) * WEIGHT[h - 1];
+            }
+            if (s > bestScore) {
+                bestScore = s;
+                best = k;
+            }
+        }
+        if (best == 0 || bestScore < cfg.rpmMinSnr * meanMag) {
+            return 0;
+        }
+        // 基频处几乎没有能量、得分来自 2、3 倍处的峰（混叠的高次谐波也会落在那里）时，改用该峰
+        for (int m = 2; m <= 3; m++) {
+            int c = m * best;
+            if (c + 1 > hi) {
+                break;
+            }
+            int peak = mag[c - 1] > mag[c] ? c - 1 : c;
+            peak = mag[c + 1] > mag[peak] ? c + 1 : peak;
+            if (localMax(best) < 0.5f * mag[peak]) {
+                best = peak;
+                break;
+            }
+        }
+        // 基频频点附近最强的一点插值
+        if (best > 1 && power[best - 1] > power[best]) {
+            best--;
+        } else if (power[best + 1] > power[best]) {
+            best++;
+        }
+        return interpolate(best) * hz * 60.0f / cfg.engineOrder;
+    }
+
+    float localMax(int k) const {
+        float m = mag[k];
+        m = mag[k - 1] > m ? mag[k - 1] : m;
+        return mag[k + 1] > m ? mag[k + 1] : m;
+    }
+
+    // 高频段功率，检测到转速时去掉各次谐波附近 ±2 个频点
+    float highResidual(float rpm) const {
+        const float hz = binHz();
+        float f0 = rpm * cfg.engineOrder / 60.0f;
+        float sum = 0;
+        for (int k = 1; k < N / 2; k++) {
+            float f = k * hz;
+            if (f < cfg.bandHighHz) {
+                continue;
+            }
+            if (f0 > 0) {
+                float h = floorf(f / f0 + 0.5f);
+                if (h >= 1 && fabsf(f - h * f0) <= 2 * hz) {
+                    continue;
+                }
+            }
+            sum += power[k];
+        }
+        return sum;
+    }
+
+    // 对数功率的抛物线插值，Hann 窗下峰值频率误差约 0.1 个频点以内
+    float interpolate(int k) const {
+        if (k <= 1 || k >= N / 2 - 1 || power[k] <= 0) {
+            return (float)k;
+        }
+        float a = logf(power[k - 1] + 1e-20f);
+        float b = logf(power[k] + 1e-20f);
+        float c = logf(power[k + 1] + 1e-20f);
+        float d = a - 2 * b + c;
+        if (d >= 0) {
+            return (float)k;
+        }
+        return k + 0.5f * (a - c) / d;
+    }
+
+    static float score(float value, float good, float bad) {
+        if (value <= good) {
+            return 100.0f;
+        }
+        if (value >= bad) {
+            return 0.0f;
+        }
+        return 100.0f * (bad - value) / (bad - good);
+    }
+
+    VibrationConfig cfg;
+    VibrationResult res;
+    int count;
+    float healthAvg;
+    bool useDsp;
+    float windowPower;
+    float samples[3][N];
+    float window[N];
+    float twiddle[N];
+    float bufXY[2 * N] __attribute__((aligned(16)));
+    float bufZ[2 * N] __attribute__((aligned(16)));
+    float power[N / 2];
+    float mag[N / 2];
+};
+
+#endif // VIBRATION_LOGIC_H
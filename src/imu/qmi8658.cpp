@@ -1,4 +1,9 @@
 #include "qmi8658.h"
+#include "MotionWake.h"
+#include "utils/Trace.h"
+#include "utils/Log.h"
+#include "utils/SensorHealth.h"
+#include "power/WarmBoot.h"
 
 #define USE_WIRE
 
@@ -12,6 +17,17 @@ IMU imu(IMU_SDA_PIN, IMU_SCL_PIN);
 
 imu_data_t imu_data;
 
+// 持有 IMU 的总线互斥量直到离开作用域
+class ImuBusLock
+{
+public:
+    explicit ImuBusLock(IMU &imu) : mutex(imu.busMutex) { xSemaphoreTakeRecursive(mutex, portMAX_DELAY); }
+    ~ImuBusLock() { xSemaphoreGiveRecursive(mutex); }
+
+private:
+    SemaphoreHandle_t mutex;
+};
+
 volatile bool IMU::motionInterruptFlag = false;
 void IRAM_ATTR IMU::motionISR()
 {
@@ -21,7 +37,6 @@ void IRAM_ATTR IMU::motionISR()
 IMU::IMU(int sda, int scl, int motionIntPin)
     : _wire(Wire1),
     motionIntPin(motionIntPin),
-    _debug(false),
     _lastDebugPrintTime(0)
 {
     this->sda = sda;
@@ -30,69 +45,74 @@ IMU::IMU(int sda, int scl, int motionIntPin)
     motionThreshold = MOTION_DETECTION_THRESHOLD_DEFAULT;
     motionDetectionEnabled = false;
     sampleWindow = MOTION_DETECTION_WINDOW_DEFAULT;
+    // 全局对象构造时堆已可用，begin() 之前的调用也能持锁
+    busMutex = xSemaphoreCreateRecursiveMutex();
 }
 
 void IMU::debugPrint(const String &message)
 {
-    if (_debug)
+    if (logEnabled(LOG_CH_IMU, (uint8_t)DebugLevel::DEBUG))
     {
         Serial.println("[IMU] [debug] " + message);
     }
 }
 
-void IMU::begin()
+bool IMU::begin()
 {
-    Serial.println("[IMU] 初始化完成");
 #ifdef USE_WIRE
     Serial.printf("[IMU] SDA: %d, SCL: %d\n", sda, scl);
-    if (!qmi.begin(_wire, QMI8658_L_SLAVE_ADDRESS, sda, scl))
+#endif
+    // 深度睡眠唤醒后按睡眠前的配置工作
+    if (warmBoot.isWarm() && loadConfig())
     {
-        Serial.println("[IMU] 初始化失败");
-        for (int i = 0; i < 3; i++)
-        {
-            delay(1000);
-            Serial.println("[IMU] 重试初始化...");
-            if (qmi.begin(_wire, QMI8658_L_SLAVE_ADDRESS, sda, scl))
-            {
-                Serial.println("[IMU] 重试成功");
-                break;
-            }
-            if (i == 2)
-            {
-                Serial.println("[IMU] 多次重试失败，系统将重启");
-                delay(1000);
-                esp_restart();
-            }
-        }
+        Serial.println("[IMU] 使用睡眠前的配置");
+    }
+
+    ImuBusLock lock(*this);
+    // 启动时只做有限次重试，之后由健康监测按退避时间在后台恢复，不重启系统
+    bool ok = initChip();
+    for (int i = 0; i < SENSOR_INIT_RETRIES && !ok; i++)
+    {
+        delay(100);
+        Serial.println("[IMU] 重试初始化...");
+        ok = initChip();
     }
+    sensorHealth.monitor(SENSOR_IMU).begin(millis(), ok);
+
+    // 配置中断引脚（初始化失败时也配置，后台恢复后直接可用）
+    if (motionIntPin >= 0)
+    {
+        pinMode(motionIntPin, INPUT_PULLUP);
+        attachInterrupt(motionIntPin, IMU::motionISR, CHANGE);
+        Serial.printf("[IMU] 运动检测中断已绑定: GPIO%d\n", motionIntPin);
+    }
+    if (!ok)
+    {
+        Serial.println("[IMU] 初始化失败，IMU功能暂不可用，后台继续尝试恢复");
+        trace.error(TRACE_ID_IMU_INIT, SENSOR_INIT_RETRIES);
+        return false;
+    }
+    restoreConfig();
+    Serial.println("[IMU] 初始化完成");
+    return true;
+}
+
+bool IMU::initChip()
+{
+#ifdef USE_WIRE
+    if (!qmi.begin(_wire, QMI8658_L_SLAVE_ADDRESS, sda, scl))
 #else
     if (!qmi.begin(IMU_CS))
+#endif
     {
         Serial.println("[IMU] 初始化失败 - 请检查接线!");
-        for (int i = 0; i < 3; i++)
-        {
-            delay(1000);
-            Serial.println("[IMU] 重试初始化...");
-            if (qmi.begin(IMU_CS))
-            {
-                Serial.println("[IMU] 重试成功");
-                break;
-            }
-            if (i == 2)
-            {
-                Serial.println("[IMU] 多次重试失败，系统将重启");
-                delay(1000);
-                esp_restart();
-            }
-        }
+        return false;
     }
-#endif
 
-    Serial.print("[IMU] 设备ID: 0x");
-    Serial.println(qmi.getChipID(), HEX);
+    Serial.printf("[IMU] 设备ID: 0x%02X\n", qmi.getChipID());
 
-    // 推荐检测采样率
-    qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_500Hz);
+    // 推荐检测采样率（热启动时为睡眠前的配置）
+    qmi.configAccelerometer((SensorQMI8658::AccelRange)accelRange, (SensorQMI8658::AccelODR)accelOdr);
     qmi.enableAccelerometer();
 
     // 配置三轴任意运动检测
@@ -107,14 +127,102 @@ void IMU::begin()
                      AnyMotionXThr, AnyMotionYThr, AnyMotionZThr, AnyMotionWindow,
                      0, 0, 0, 0, 0, 0);
     qmi.enableMotionDetect(SensorQMI8658::INTERRUPT_PIN_1);
-    // 配置中断引脚
-    if (motionIntPin >= 0)
+    return true;
+}
+
+bool IMU::serviceHealth()
+{
+    // 检查和恢复（含总线复位、重新初始化和恢复配置）整体持锁
+    ImuBusLock lock(*this);
+    SensorHealthMonitor &health = sensorHealth.monitor(SENSOR_IMU);
+    uint32_t now = millis();
+    switch (health.due(now))
     {
-        pinMode(motionIntPin, INPUT_PULLUP);
-        attachInterrupt(motionIntPin, IMU::motionISR, CHANGE);
-        Serial.printf("[IMU] 运动检测中断已绑定: GPIO%d\n", motionIntPin);
+    case SENSOR_DO_CHECK:
+        if (health.check(now, qmi.getChipID() == IMU_CHIP_ID))
+        {
+            sensorHealth.reportFailed(SENSOR_IMU);
+        }
+        break;
+    case SENSOR_DO_RECOVER:
+    {
+        // 先置为不可用，振动分析任务停止读取
+        deviceState.set(DS_IMU, &device_state_t::imuReady, false);
+        SensorRecoveryAction action = health.recoveryAction();
+#ifdef USE_WIRE
+        if (action == SENSOR_RECOVER_BUS_RESET)
+        {
+            SensorHealth::recoverBus(_wire, sda, scl);
+        }
+#endif
+        bool ok = initChip() && restoreConfig();
+        health.recovered(millis(), ok);
+        sensorHealth.reportRecovery(SENSOR_IMU, action, ok);
+        break;
+    }
+    default:
+        break;
     }
-    Serial.println("[IMU] 运动检测初始化完成");
+    bool usable = health.usable();
+    deviceState.set(DS_IMU, &device_state_t::imuReady, usable);
+    return usable;
+}
+
+bool IMU::restoreConfig()
+{
+    ImuBusLock lock(*this);
+    // 驻车时 initChip() 的正常模式配置会覆盖 WOM，电源管理仍按 INT1 等待运动唤醒
+    if (womActive)
+    {
+        int result = qmi.configWakeOnMotion(womThresholdMg, SensorQMI8658::ACC_ODR_LOWPOWER_128Hz,
+                                            SensorQMI8658::INTERRUPT_PIN_1, 1, 0x30);
+        return result == DEV_WIRE_NONE;
+    }
+    applyNormalConfig();
+    return true;
+}
+
+void IMU::applyNormalConfig()
+{
+    qmi.configAccelerometer((SensorQMI8658::AccelRange)accelRange, (SensorQMI8658::AccelODR)accelOdr);
+    qmi.enableAccelerometer();
+    if (gyroEnabled)
+    {
+        setGyroEnabled(true);
+    }
+    if (motionDetectionEnabled)
+    {
+        configureMotionDetection(motionThreshold);
+    }
+}
+
+void IMU::saveConfig()
+{
+    WarmBootImuConfig config;
+    memset(&config, 0, sizeof(config));
+    config.accelRange = accelRange;
+    config.accelOdr = accelOdr;
+    config.womThresholdMg = womThresholdMg;
+    config.gyroEnabled = gyroEnabled ? 1 : 0;
+    config.motionDetect = motionDetectionEnabled ? 1 : 0;
+    config.motionThreshold = motionThreshold;
+    warmBoot.setImuConfig(config);
+}
+
+bool IMU::loadConfig()
+{
+    const WarmBootImuConfig& config = warmBoot.state().imu;
+    if (!config.valid)
+    {
+        return false;
+    }
+    accelRange = config.accelRange;
+    accelOdr = config.accelOdr;
+    womThresholdMg = config.womThresholdMg;
+    gyroEnabled = config.gyroEnabled != 0;
+    motionDetectionEnabled = config.motionDetect != 0;
+    motionThreshold = config.motionThreshold;
+    return true;
 }
 
 void IMU::configureMotionDetection(float threshold)
@@ -137,6 +245,7 @@ void IMU::configureMotionDetection(float threshold)
 
 void IMU::disableMotionDetection()
 {
+    ImuBusLock lock(*this);
     if (!motionDetectionEnabled)
         return;
 
@@ -152,6 +261,7 @@ void IMU::disableMotionDetection()
 
 bool IMU::configureForDeepSleep()
 {
+    ImuBusLock lock(*this);
     // 禁用当前的运动检测中断
     if (motionIntPin >= 0)
     {
@@ -159,9 +269,10 @@ bool IMU::configureForDeepSleep()
     }
 
     // 使用官方的WakeOnMotion配置，专门用于深度睡眠唤醒
-    // 参数：255mg阈值（uint8_t最大值），低功耗128Hz，使用中断引脚1，默认引脚值1，抑制时间0x30
+    // 阈值按误唤醒情况自适应（基准值~255mg，见 MotionWake.h），低功耗128Hz，使用中断引脚1，默认引脚值1，抑制时间0x30
+    uint8_t threshold = motionWake.thresholdForSleep();
     int result = qmi.configWakeOnMotion(
-        255,                                   // 255mg阈值，uint8_t最大值，比默认200mg更保守
+        threshold,
         SensorQMI8658::ACC_ODR_LOWPOWER_128Hz, // 低功耗模式
         SensorQMI8658::INTERRUPT_PIN_1,        // 使用中断引脚1
         1,                                     // 默认引脚值为1
@@ -174,6 +285,13 @@ bool IMU::configureForDeepSleep()
         return false;
     }
 
+    womActive = true;
+    womThresholdMg = threshold;
+    saveConfig();
+
+    // 记录睡眠前的重力方向，唤醒后用于判定误唤醒
+    motionWake.captureReference();
+
     // 重新配置中断引脚为CHANGE触发（官方例子的方式）
     if (motionIntPin >= 0)
     {
@@ -181,18 +299,36 @@ bool IMU::configureForDeepSleep()
         attachInterrupt(motionIntPin, IMU::motionISR, CHANGE); // 使用CHANGE而非特定边沿
     }
 
-    Serial.println("[IMU] 已配置为WakeOnMotion深度睡眠模式 (阈值=255mg, 低功耗128Hz)");
+    Serial.printf("[IMU] 已配置为WakeOnMotion深度睡眠模式 (阈值=%umg, 低功耗128Hz)\n", threshold);
     return true;
 }
 
-bool IMU::restoreFromDeepSleep()
+bool IMU::rearmWakeOnMotion(uint8_t thresholdMg)
 {
-    // 唤醒后适当延时，确保I2C/IMU电源和时钟ready
-    delay(500); // 增加到500ms，确保电源稳定
+    ImuBusLock lock(*this);
+    // 误唤醒快速路径：只建立I2C连接后重新配置WOM，不做 begin() 里的重试和正常模式配置
+    if (!qmi.begin(_wire, QMI8658_L_SLAVE_ADDRESS, sda, scl))
+    {
+        return false;
+    }
+    int result = qmi.configWakeOnMotion(thresholdMg, SensorQMI8658::ACC_ODR_LOWPOWER_128Hz,
+                                        SensorQMI8658::INTERRUPT_PIN_1, 1, 0x30);
+    if (result != DEV_WIRE_NONE)
+    {
+        return false;
+    }
+    womActive = true;
+    womThresholdMg = thresholdMg;
+    saveConfig();
+    return true;
+}
 
-    // 重新初始化I2C总线
+bool IMU::restoreFromDeepSleep()
+{
+    ImuBusLock lock(*this);
+    // WOM 模式下IMU一直供电，I2C寄存器写入是同步完成的，只有软复位需要等待
     _wire.begin(sda, scl);
-    delay(50); // 等待I2C总线稳定
+    womActive = false;
 
     // 重置设备
     if (!qmi.reset())
@@ -202,21 +338,9 @@ bool IMU::restoreFromDeepSleep()
     }
     delay(50); // 等待重置完成
 
-    // 重新配置正常的加速度计
-    qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_500Hz);
-    qmi.enableAccelerometer();
-    delay(50); // 等待配置生效
-
-    // 重新启用陀螺仪
-    setGyroEnabled(true);
-    delay(50); // 等待陀螺仪稳定
-
-    // 恢复正常的运动检测配置（如果之前启用了的话）
-    if (motionDetectionEnabled)
-    {
-        configureMotionDetection(motionThreshold);
-        delay(50); // 等待运动检测配置生效
-    }
+    // 按进入 WOM 时保存的配置恢复加速度计、陀螺仪和运动检测
+    loadConfig();
+    applyNormalConfig();
 
     Serial.println("[IMU] 已从WakeOnMotion模式恢复到正常模式");
     return true;
@@ -224,6 +348,7 @@ bool IMU::restoreFromDeepSleep()
 
 bool IMU::checkWakeOnMotionEvent()
 {
+    ImuBusLock lock(*this);
     // 使用官方例子的方式检查状态
     uint8_t status = qmi.getStatusRegister();
 
@@ -244,6 +369,7 @@ bool IMU::isMotionDetected()
     if (motionInterruptFlag)
     {
         motionInterruptFlag = false;
+        ImuBusLock lock(*this);
         uint8_t status = qmi.getStatusRegister();
         return (status & SensorQMI8658::EVENT_ANY_MOTION) != 0;
     }
@@ -257,22 +383,29 @@ void IMU::setAccelPowerMode(uint8_t mode)
     switch (mode)
     {
     case 0: // 低功耗
-        qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_125Hz);
+        accelOdr = SensorQMI8658::ACC_ODR_125Hz;
         Serial.println("[IMU] 加速度计设置为低功耗模式");
         break;
     case 1: // 正常
-        qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_500Hz);
+        accelOdr = SensorQMI8658::ACC_ODR_500Hz;
         Serial.println("[IMU] 加速度计设置为正常模式");
         break;
     case 2: // 高性能
-        qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_1000Hz);
+        accelOdr = SensorQMI8658::ACC_ODR_1000Hz;
         Serial.println("[IMU] 加速度计设置为高性能模式");
         break;
+    default:
+        return;
     }
+    // 记录当前配置，故障恢复和睡眠唤醒后按它重新配置
+    ImuBusLock lock(*this);
+    qmi.configAccelerometer((SensorQMI8658::AccelRange)accelRange, (SensorQMI8658::AccelODR)accelOdr);
 }
 
 void IMU::setGyroEnabled(bool enabled)
 {
+    ImuBusLock lock(*this);
+    gyroEnabled = enabled;
     if (enabled)
     {
         qmi.configGyroscope(
@@ -290,12 +423,42 @@ void IMU::setGyroEnabled(bool enabled)
     }
 }
 
+bool IMU::readAccel(float &ax, float &ay, float &az)
+{
+    // 故障和恢复期间不访问芯片，恢复在 TaskData 中持锁进行，可用性检查和读取在同一次持锁内
+    ImuBusLock lock(*this);
+    if (!sensorHealth.monitor(SENSOR_IMU).usable() || !qmi.getAccelerometer(ax, ay, az))
+    {
+        return false;
+    }
+#if defined(IMU_ROTATION)
+    float temp = ax;
+    ax = ay;
+    ay = -temp;
+#endif
+    return true;
+}
+
 void IMU::loop()
 {
-    if (qmi.getDataReady())
+    ImuBusLock lock(*this);
+    if (!serviceHealth())
+    {
+        return;
+    }
+    if (!qmi.getDataReady())
     {
-        get_device_state()->imuReady = true;
-        qmi.getAccelerometer(imu_data.accel_x, imu_data.accel_y, imu_data.accel_z);
+        sensorHealth.monitor(SENSOR_IMU).onNoData(millis());
+    }
+    else
+    {
+        if (!qmi.getAccelerometer(imu_data.accel_x, imu_data.accel_y, imu_data.accel_z))
+        {
+            sensorHealth.monitor(SENSOR_IMU).onReadError();
+            return;
+        }
+        float raw[3] = {imu_data.accel_x, imu_data.accel_y, imu_data.accel_z};
+        sensorHealth.monitor(SENSOR_IMU).onSample(sensorFingerprint(raw, sizeof(raw)));
 
         // 应用传感器旋转（如果定义了）
 #if defined(IMU_ROTATION)
@@ -307,13 +470,10 @@ void IMU::loop()
 
         qmi.getGyroscope(imu_data.gyro_x, imu_data.gyro_y, imu_data.gyro_z);
 
-        // 使用加速度计计算姿态角
-        float roll_acc = atan2(imu_data.accel_y, imu_data.accel_z) * 180 / M_PI;
-        float pitch_acc = atan2(-imu_data.accel_x, sqrt(imu_data.accel_y * imu_data.accel_y + imu_data.accel_z * imu_data.accel_z)) * 180 / M_PI;
-
-        // 使用陀螺仪数据和互补滤波更新姿态角
-        imu_data.roll = ALPHA * (imu_data.roll + imu_data.gyro_x * dt) + (1.0 - ALPHA) * roll_acc;
-        imu_data.pitch = ALPHA * (imu_data.pitch + imu_data.gyro_y * dt) + (1.0 - ALPHA) * pitch_acc;
+        // 加速度计倾角和陀螺仪积分互补滤波
+        attitude.update(imu_data.accel_x, imu_data.accel_y, imu_data.accel_z, imu_data.gyro_x, imu_data.gyro_y);
+        imu_data.roll = attitude.roll();
+        imu_data.pitch = attitude.pitch();
 
         imu_data.temperature = qmi.getTemperature_C();
 
@@ -332,7 +492,7 @@ void IMU::loop()
     if (millis() - _lastDebugPrintTime > 500)
     {
         _lastDebugPrintTime = millis();
-        debugPrint("IMU Heading: " + String(imu_data.roll) + ", " + String(imu_data.pitch) + ", " + String(imu_data.yaw));
+        LOGD(IMU, "Heading: %.2f, %.2f, %.2f", imu_data.roll, imu_data.pitch, imu_data.yaw);
     }
 }
 
@@ -342,11 +502,11 @@ void IMU::loop()
  */
 bool IMU::detectMotion()
 {
-    float accelMagnitude = sqrt(
+    float accelMagnitude = fastSqrt(
         imu_data.accel_x * imu_data.accel_x +
         imu_data.accel_y * imu_data.accel_y +
         imu_data.accel_z * imu_data.accel_z);
-    float delta = fabs(accelMagnitude - lastAccelMagnitude);
+    float delta = fabsf(accelMagnitude - lastAccelMagnitude);
     lastAccelMagnitude = accelMagnitude;
     accumulatedDelta += delta;
     sampleIndex++;
@@ -354,7 +514,7 @@ bool IMU::detectMotion()
     {
         float averageDelta = accumulatedDelta / sampleWindow;
         Serial.printf("[IMU] 运动检测阈值: %f, 平均加速度变化: %f\n", motionThreshold, averageDelta);
-        bool motionDetected = averageDelta > (motionThreshold * 0.8);
+        bool motionDetected = averageDelta > (motionThreshold * 0.8f);
         accumulatedDelta = 0;
         sampleIndex = 0;
         return motionDetected;
@@ -371,7 +531,7 @@ void IMU::printImuData()
 }
 
 // 生成精简版IMU数据JSON
-String imu_data_to_json(imu_data_t &imu_data)
+size_t imu_data_to_json(const imu_data_t &imu_data, char *buf, size_t size)
 {
     StaticJsonDocument<256> doc;
     doc["ax"] = imu_data.accel_x; // X轴加速度
@@ -387,5 +547,9 @@ String imu_data_to_json(imu_data_t &imu_data)
     doc["pitch"] = imu_data.pitch;      // 俯仰角
     doc["yaw"] = imu_data.yaw;          // 航向角
     doc["temp"] = imu_data.temperature; // 温度
-    return doc.as<String>();
+    if (measureJson(doc) >= size)
+    {
+        return 0;
+    }
+    return serializeJson(doc, buf, size);
 }
\ No newline at end of file
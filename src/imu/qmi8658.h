@@ -5,12 +5,16 @@
 #include <Wire.h>
 #include <SPI.h>
 #include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "SensorQMI8658.hpp"
 #include "device.h"
 #include "config.h"
+#include "AttitudeFilter.h"
 
-#define ALPHA 0.98 // 互补滤波的系数，范围在0到1之间
-#define dt 0.01    // 时间间隔，单位是秒（假设采样率为100Hz）
+#define IMU_FILTER_ALPHA 0.98f   // 互补滤波的系数，范围在0到1之间
+#define IMU_SAMPLE_DT_SEC 0.01f  // 时间间隔，单位是秒（假设采样率为100Hz）
+#define IMU_CHIP_ID 0x05         // QMI8658 WHO_AM_I
 
 // 运动检测相关参数
 #define MOTION_DETECTION_THRESHOLD_DEFAULT 0.0035   // 0.05 适合震动检测，, 静止的量级0.001~0.003
@@ -40,13 +44,19 @@ typedef struct
 
 extern imu_data_t imu_data;
 
-String imu_data_to_json(imu_data_t& imu_data);
+// 精简版IMU数据JSON写入 buf，返回长度（不含结尾的 0），缓冲区不够时返回 0
+size_t imu_data_to_json(const imu_data_t& imu_data, char* buf, size_t size);
 
 class IMU
 {
 public:
     IMU(int sda, int scl, int motionIntPin = -1);
-    void begin();
+
+    /**
+     * @brief 初始化IMU，失败时不重启，由健康监测（utils/SensorHealth.h）在 loop() 中按退避时间恢复
+     * @return 是否初始化成功
+     */
+    bool begin();
     void loop();
     
     // 运动检测中断标志和ISR
@@ -56,6 +66,7 @@ public:
     // 低功耗相关方法
     void disableMotionDetection();
     bool configureForDeepSleep();
+    bool rearmWakeOnMotion(uint8_t thresholdMg);  // 误唤醒后提高阈值，不做完整初始化
     bool restoreFromDeepSleep();
     bool isMotionDetected();
     bool checkWakeOnMotionEvent();  // 新增：检查WakeOnMotion事件
@@ -81,6 +92,12 @@ public:
     float getAccelX() const { return imu_data.accel_x; }
     float getAccelY() const { return imu_data.accel_y; }
     float getAccelZ() const { return imu_data.accel_z; }
+
+    /**
+     * @brief 直接读取一次加速度计（单位 g，已按 IMU_ROTATION 旋转），不更新 imu_data
+     * 振动分析任务按加速度计输出率采样时使用
+     */
+    bool readAccel(float& ax, float& ay, float& az);
     
     /**
      * @brief 获取陀螺仪数据
@@ -101,28 +118,54 @@ public:
      */
     float getTemperature() const { return imu_data.temperature; }
 
-    void setDebug(bool debug) { _debug = debug; }
-
 private:
     int sda;
     int scl;
-    bool _debug;
     int motionIntPin;           // 运动检测中断引脚
     float motionThreshold;      // 运动检测阈值
     bool motionDetectionEnabled;// 运动检测是否启用
     TwoWire& _wire; // 使用 Wire1 作为 I2C 总线
     SensorQMI8658 qmi;
+
+    // Wire1 和芯片访问的互斥量（递归），TaskData 的读取和故障恢复、振动任务的 readAccel、
+    // 电源管理的睡眠配置都在持有时进行，恢复中途不会被其他任务的读取打断
+    SemaphoreHandle_t busMutex;
+    friend class ImuBusLock;
     
     // 配置运动检测参数
     void configureMotionDetection(float threshold);
 
+    // 建立连接并配置芯片，begin() 和故障恢复共用
+    bool initChip();
+
+    // 健康检查和故障恢复，返回是否可以读取
+    bool serviceHealth();
+
+    // 故障恢复后按故障前的工作模式重新配置（WOM，或正常模式配置）
+    bool restoreConfig();
+    bool womActive = false;     // 处于 WakeOnMotion 模式（驻车），浅睡眠依赖 INT1 唤醒
+    uint8_t womThresholdMg = 0; // 当前 WOM 阈值，恢复时重新写入
+    bool gyroEnabled = false;
+    uint8_t accelRange = SensorQMI8658::ACC_RANGE_4G;
+    uint8_t accelOdr = SensorQMI8658::ACC_ODR_500Hz;
+
+    // 正常模式配置（加速度计量程和输出率、陀螺仪、运动检测）写入芯片
+    void applyNormalConfig();
+
+    // 睡眠前把当前配置存入热启动状态，唤醒后从中读回
+    void saveConfig();
+    bool loadConfig();
+
     // 运动检测相关变量
     float lastAccelMagnitude = 0;
     float accumulatedDelta = 0;
     int sampleIndex = 0;
     int sampleWindow = MOTION_DETECTION_WINDOW_DEFAULT;
 
-    void debugPrint(const String& message);
+    // 姿态解算，数值类型由 SENSOR_MATH_FIXED 选择
+    AttitudeFilter<sensor_real_t> attitude{IMU_FILTER_ALPHA, IMU_SAMPLE_DT_SEC};
+
+    void debugPrint(const String& message);     // IMU 通道为调试级别时输出
     unsigned long _lastDebugPrintTime;
 
 };
@@ -2,6 +2,7 @@
 #include "device.h"
 #include "led/LED.h"
 #include "led/PWMLED.h"
+#include "power/PowerAccounting.h"
 
 #if defined(LED_PIN) || defined(PWM_LED_PIN)
 LEDManager::LEDManager() : _mode(LED_OFF), _color(LED_COLOR_GREEN), _brightness(10) {}
@@ -26,6 +27,7 @@ void LEDManager::begin() {
     // 普通 LED 设置为常亮
     led.setMode(LED_ON);
 #endif
+    powerAccounting.setState(PA_LED, PA_LED_ON);
 }
 
 
@@ -33,7 +35,8 @@ void LEDManager::setLEDState(LEDMode mode, LEDColor color, uint8_t brightness) {
     _mode = mode;
     _color = color;
     _brightness = brightness;
-    device_state.led_mode = mode;
+    deviceState.set(DS_LED_MODE, &device_state_t::led_mode, mode);
+    powerAccounting.setState(PA_LED, mode == LED_OFF ? PA_LED_OFF : (mode == LED_ON ? PA_LED_ON : PA_LED_BLINK));
     updateLED();
 }
 
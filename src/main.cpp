@@ -14,10 +14,17 @@
 #include "Arduino.h"
 #include "config.h"
 #include "power/PowerManager.h"
+#include "power/WarmBoot.h"
+#include "power/PowerAccounting.h"
 #include "led/LEDManager.h"
 #include "device.h"
 #include "Air780EG.h"
 #include "utils/serialCommand.h"
+#include "utils/PerfMonitor.h"
+#include "utils/Trace.h"
+#include "utils/HeapMonitor.h"
+#include "utils/Log.h"
+#include "utils/SerialLink.h"
 
 #ifdef BAT_PIN
 #include "bat/BAT.h"
@@ -51,6 +58,7 @@ extern Ml307AtModem ml307_at;
 
 #ifdef ENABLE_IMU
 #include "imu/qmi8658.h"
+#include "imu/Vibration.h"
 #endif
 
 #ifdef ENABLE_SDCARD
@@ -95,9 +103,12 @@ void taskSystem(void *parameter)
 {
   // 添加任务启动提示
   Serial.println("[系统] 系统监控任务启动");
+  trace.registerTask(TRACE_TASK_SYSTEM);
 
   while (true)
   {
+    int64_t loopStartUs = esp_timer_get_time();
+
     // LED状态更新
 #ifdef PWM_LED_PIN
     pwmLed.loop();
@@ -112,11 +123,8 @@ void taskSystem(void *parameter)
     bat.loop();
 #endif
 
-    // 串口命令处理
-    if (Serial.available())
-    {
-      handleSerialCommand();
-    }
+    // 串口命令和二进制帧，只读取已到达的字节
+    serialLink.poll();
 
     // 外部电源检测
 #ifdef RTC_INT_PIN
@@ -133,7 +141,9 @@ void taskSystem(void *parameter)
       lastSDCheckTime = currentTime;
       if (sdManager.isInitialized())
       {
-        device_state.sdCardFreeMB = sdManager.getFreeSpaceMB();
+        uint64_t freeMB = sdManager.getFreeSpaceMB();
+        deviceState.set(DS_SDCARD, &device_state_t::sdCardFreeMB, freeMB);
+        warmBoot.setSDFreeMB((uint32_t)freeMB);
       }
     }
 #endif
@@ -145,11 +155,18 @@ void taskSystem(void *parameter)
 #endif
 
     // 电源管理 - 始终保持处理
-    powerManager.loop();
+    {
+      PerfScope scope(PERF_POWER);
+      powerManager.loop();
+    }
+
+    // 通知设备状态订阅者（日志、LED、音频）
+    deviceState.dispatch();
 
     // LED状态更新
     ledManager.loop();
 
+    perfMonitor.record(PERF_TASK_SYSTEM, (uint32_t)(esp_timer_get_time() - loopStartUs));
     delay(5);
   }
 }
@@ -161,6 +178,7 @@ void taskSystem(void *parameter)
 void taskDataProcessing(void *parameter)
 {
   Serial.println("[系统] 数据处理任务启动");
+  trace.registerTask(TRACE_TASK_DATA);
 
   // 数据记录相关变量
   unsigned long lastGNSSRecordTime = 0;
@@ -168,16 +186,39 @@ void taskDataProcessing(void *parameter)
 
   for (;;)
   {
+    int64_t loopStartUs = esp_timer_get_time();
+
     // Air780EG库处理 - 必须在主循环中调用
 #ifdef USE_AIR780EG_GSM
     // 调用新库的主循环（处理URC、网络状态更新、GNSS数据更新等）
-    air780eg.loop();
+    // 串口收发期间锁定APB时钟，保证波特率准确
+    powerLocks.acquire(PM_CLIENT_MODEM);
+    {
+      PerfScope scope(PERF_AIR780EG);
+      air780eg.loop();
+    }
+    publishMqttReports();
+    powerLocks.release(PM_CLIENT_MODEM);
+    // GNSS开启后区分搜星和已定位，计入功耗统计
+    if (powerAccounting.state(PA_GNSS) != PA_GNSS_OFF)
+    {
+      powerAccounting.setState(PA_GNSS, air780eg.getGNSS().isDataValid() ? PA_GNSS_FIX : PA_GNSS_ACQUIRE);
+    }
+    // 有效定位覆盖热启动时的睡眠前位置
+    if (air780eg.getGNSS().isDataValid())
+    {
+      DeviceStateBus::Writer state(deviceState);
+      state.set(DS_GNSS, &device_state_t::latitude, air780eg.getGNSS().gnss_data.latitude);
+      state.set(DS_GNSS, &device_state_t::longitude, air780eg.getGNSS().gnss_data.longitude);
+    }
 #endif
 
     // IMU数据处理
 #ifdef ENABLE_IMU
-    imu.setDebug(false);
-    imu.loop();
+    {
+      PerfScope scope(PERF_IMU);
+      imu.loop();
+    }
 #endif
 
 #ifdef ENABLE_SDCARD
@@ -185,7 +226,7 @@ void taskDataProcessing(void *parameter)
     unsigned long currentTime = millis();
 
     // 记录GPS数据
-    if (device_state.gnssReady && device_state.sdCardReady &&
+    if (deviceState.get(&device_state_t::gnssReady) && deviceState.get(&device_state_t::sdCardReady) &&
         currentTime - lastGNSSRecordTime >= 1000)
     {
       lastGNSSRecordTime = currentTime;
@@ -202,7 +243,10 @@ void taskDataProcessing(void *parameter)
 #endif
 
 #ifdef BLE_SERVER
-    bs.loop();
+    {
+      PerfScope scope(PERF_BLE);
+      bs.loop();
+    }
 #endif
 
 #ifdef ENABLE_TFT
@@ -212,9 +256,17 @@ void taskDataProcessing(void *parameter)
 
 #ifdef ENABLE_COMPASS
     // 罗盘数据处理
-    compass.loop();
+    {
+      PerfScope scope(PERF_COMPASS);
+      compass.loop();
+    }
 #endif
 
+    perfMonitor.record(PERF_TASK_DATA, (uint32_t)(esp_timer_get_time() - loopStartUs));
+
+    // 任务CPU占用和栈余量采样，定期写SD卡日志（与GPS记录在同一任务，不并发访问SD卡）
+    perfMonitor.loop();
+
     delay(10); // 增加延时，减少CPU占用
   } // for循环结束
 }
@@ -224,6 +276,7 @@ void taskDataProcessing(void *parameter)
 void taskWiFi(void *parameter)
 {
   Serial.println("[系统] WiFi任务启动");
+  trace.registerTask(TRACE_TASK_WIFI);
   while (true)
   {
     if (wifiManager.getConfigMode())
@@ -235,12 +288,37 @@ void taskWiFi(void *parameter)
 }
 #endif
 
+#ifdef ENABLE_SDCARD
+// SD卡在SPI总线上，与 Device::begin() 中的I2C、UART、I2S外设并行初始化
+static bool sdInitJob()
+{
+  return sdManager.begin();
+}
+#endif
+
 void setup()
 {
+  // IMU误唤醒在任何初始化之前判定，直接回到深度睡眠
+  powerManager.filterMotionWakeup();
+
   Serial.begin(115200);
-  delay(1000);
+
+  // 异常复位前的事件仍在RTC内存中，记录启动事件；在串口初始化之后，待写入SD卡的提示才能输出
+  trace.begin();
+  logBegin();
 
   PreferencesUtils::init();
+  DebugManager::begin();
+
+  // 深度睡眠唤醒且RTC状态有效时走热启动，跳过重复的初始化
+  warmBoot.begin();
+  powerAccounting.begin(warmBoot.isWarm(), warmBoot.sleptSeconds());
+  if (!warmBoot.isWarm())
+  {
+    // 冷启动等待串口监视器连接
+    delay(1000);
+  }
+  warmBoot.markPhase("serial");
 
   Serial.println("step 1");
   bootCount++;
@@ -254,6 +332,12 @@ void setup()
 
   Serial.println("step 4");
   powerManager.checkWakeupCause();
+  warmBoot.markPhase("power");
+
+#ifdef ENABLE_SDCARD
+  static BootJob sdJob; // 超时后任务仍可能访问，不能放在栈上
+  sdJob.start("BootSD", sdInitJob, 6144);
+#endif
 
   Serial.println("step 5");
   device.begin();
@@ -261,44 +345,70 @@ void setup()
   //================ SD卡初始化开始 ================
 #ifdef ENABLE_SDCARD
   Serial.println("step 6");
-  if (sdManager.begin())
+  if (sdJob.join(5000))
   {
-    Serial.println("[SD] SD卡初始化成功");
-
-    // 更新设备状态
-    device_state.sdCardReady = true;
-    device_state.sdCardSizeMB = sdManager.getTotalSpaceMB();
-    device_state.sdCardFreeMB = sdManager.getFreeSpaceMB();
+    Serial.printf("[SD] SD卡初始化成功，耗时 %lu ms（与外设并行）\n", (unsigned long)sdJob.elapsedMs());
 
-    // 保存设备信息
-    sdManager.saveDeviceInfo();
+    // 更新设备状态，容量和剩余空间由 SDManager::begin() 记录（热启动时为睡眠前的值）
+    {
+      DeviceStateBus::Writer state(deviceState);
+      state.set(DS_SDCARD, &device_state_t::sdCardReady, true);
+      state.set(DS_SDCARD, &device_state_t::sdCardSizeMB, warmBoot.state().sdCardSizeMB);
+      state.set(DS_SDCARD, &device_state_t::sdCardFreeMB, warmBoot.state().sdFreeMB);
+    }
 
-    Serial.println("[SD] 设备信息已保存到SD卡");
+#ifdef ENABLE_AUDIO
+    // SD卡上的 /voice/welcome.wav 优先作为开机语音
+    if (deviceState.get(&device_state_t::audioReady) && sdManager.isValidWelcomeVoiceFile())
+    {
+      audioManager.setCustomWelcomeVoice(&sdManager.getFileSystem(),
+                                         sdManager.getCustomWelcomeVoicePath().c_str());
+      Serial.println("[SD] 使用SD卡自定义欢迎语音");
+    }
+#endif
   }
   else
   {
     Serial.println("[SD] SD卡初始化失败");
-    device_state.sdCardReady = false;
+    deviceState.set(DS_SDCARD, &device_state_t::sdCardReady, false);
   }
+
+  // 上次异常复位时保存复位前的事件
+  if (trace.dumpPending())
+  {
+    trace.dumpToSD();
+  }
+  warmBoot.markPhase("sd");
 #endif
   //================ SD卡初始化结束 ================
 
   // 创建任务
+  perfMonitor.begin();
   xTaskCreate(taskSystem, "TaskSystem", 1024 * 15, NULL, 1, NULL);
   xTaskCreate(taskDataProcessing, "TaskData", 1024 * 15, NULL, 2, NULL);
 #ifdef ENABLE_WIFI
   xTaskCreate(taskWiFi, "TaskWiFi", 1024 * 15, NULL, 3, NULL);
 #endif
+#ifdef ENABLE_IMU
+  vibration.begin();
+#endif
 
 #ifdef ENABLE_AUDIO
   Serial.println("音频功能: ✅ 编译时已启用");
-  if (device_state.audioReady)
+  if (deviceState.get(&device_state_t::audioReady) && AUDIO_BOOT_SUCCESS_ENABLED)
   {
     audioManager.playBootSuccessSound();
   }
 #else
   Serial.println("音频功能: ❌ 编译时未启用");
 #endif
+  // 初始化期间保持全速，完成后按电源锁动态调频
+  powerLocks.begin();
+
+  // 记录唤醒到就绪耗时，电源状态机进入 ACTIVE
+  powerManager.markSystemReady();
+  warmBoot.markPhase("ready");
+  warmBoot.printBootTiming();
   Serial.println("=== 系统初始化完成 ===");
 }
 
@@ -314,6 +424,8 @@ void loop()
     uint32_t freeHeap = ESP.getFreeHeap();
     uint32_t minFreeHeap = ESP.getMinFreeHeap();
     Serial.printf("[主循环] 运行正常，循环计数: %lu, 空闲内存: %d 字节\n", loopCount, freeHeap);
+    trace.counter(TRACE_ID_HEAP, (uint16_t)(freeHeap / 1024));
+    heapMonitor.sample();
     if (freeHeap < 50000)
     {
       Serial.printf("[警告] 内存不足: %d 字节，最小值: %d 字节\n", freeHeap, minFreeHeap);
@@ -321,6 +433,8 @@ void loop()
     if (freeHeap < 20000)
     {
       Serial.println("[严重] 内存严重不足，即将重启系统...");
+      trace.error(TRACE_ID_LOW_HEAP, (uint16_t)(freeHeap / 1024));
+      trace.instant(TRACE_ID_RESTART, TRACE_RESTART_LOW_HEAP);
       delay(1000);
       ESP.restart();
     }
@@ -1,5 +1,6 @@
 #include "ExternalPower.h"
 #include "../device.h"
+#include "utils/Log.h"
 
 #ifdef RTC_INT_PIN
 ExternalPower externalPower(RTC_INT_PIN);
@@ -11,8 +12,7 @@ ExternalPower::ExternalPower(int pin)
       _last_state(false),
       _last_check_time(0),
       _last_change_time(0),
-      _raw_state(false),
-      _debug(false)
+      _raw_state(false)
 {
 }
 
@@ -27,7 +27,7 @@ void ExternalPower::begin()
     _last_change_time = millis();
     
     // 更新设备状态
-    device_state.external_power = _is_connected;
+    deviceState.set(DS_EXTERNAL_POWER, &device_state_t::external_power, _is_connected);
     
     debugPrint(String("外部电源检测初始化完成，引脚: ") + String(_pin) + 
                ", 初始状态: " + (_is_connected ? "已连接" : "未连接"));
@@ -62,7 +62,7 @@ void ExternalPower::updateState()
     {
         _raw_state = current_raw_state;
         _last_change_time = current_time;
-        debugPrint(String("外部电源原始状态变化: ") + (current_raw_state ? "已连接" : "未连接"));
+        LOGD(POWER, "外部电源原始状态变化: %s", current_raw_state ? "已连接" : "未连接");
     }
     
     // 防抖处理：状态稳定一段时间后才更新
@@ -73,9 +73,9 @@ void ExternalPower::updateState()
             _is_connected = _raw_state;
             
             // 更新设备状态
-            device_state.external_power = _is_connected;
+            deviceState.set(DS_EXTERNAL_POWER, &device_state_t::external_power, _is_connected);
             
-            debugPrint(String("外部电源状态确认变化: ") + (_is_connected ? "已连接" : "未连接"));
+            LOGD(POWER, "外部电源状态确认变化: %s", _is_connected ? "已连接" : "未连接");
             
             // 可以在这里添加状态变化的回调处理
             if (_is_connected)
@@ -97,7 +97,7 @@ bool ExternalPower::isConnected()
 
 void ExternalPower::debugPrint(const String& message)
 {
-    if (_debug)
+    if (logEnabled(LOG_CH_POWER, (uint8_t)DebugLevel::DEBUG))
     {
         Serial.println("[外部电源] " + message);
     }
@@ -12,9 +12,6 @@ public:
     
     // 获取外部电源状态
     bool isConnected();
-    
-    // 添加调试控制
-    void setDebug(bool debug) { _debug = debug; }
 
 private:
     const int _pin;
@@ -28,9 +25,7 @@ private:
     unsigned long _last_change_time;
     bool _raw_state;
     
-    // 调试相关
-    bool _debug;
-    void debugPrint(const String& message);
+    void debugPrint(const String& message);     // POWER 通道为调试级别时输出
     
     // 状态检测
     bool readRawState();
@@ -0,0 +1,384 @@
+#include "PowerAccounting.h"
+#include "config.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include <string.h>
+#include <ArduinoJson.h>
+
+PowerAccounting powerAccounting;
+
+#define PA_RTC_MAGIC 0x50414343   // "PACC"
+
+// 跨深度睡眠保留的累计值，上电时为零
+struct PowerAccountingRtc {
+    uint32_t magic;
+    uint8_t hasTrip;
+    uint32_t tripSec;
+    int64_t elapsedUs;
+    int64_t totalUs[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    int64_t tripUs[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+};
+
+RTC_DATA_ATTR static PowerAccountingRtc rtc;
+
+static const char* const SUBSYSTEM_NAMES[PA_SUBSYSTEM_COUNT] = {
+    "cpu", "gnss", "modem", "ble", "audio", "sd", "led"};
+
+static const uint8_t STATE_COUNT[PA_SUBSYSTEM_COUNT] = {4, 3, 3, 4, 2, 2, 3};
+
+static const char* const STATE_NAMES[PA_SUBSYSTEM_COUNT][PA_MAX_STATES] = {
+    {"sleep", "min", "apb", "max"},
+    {"off", "acquire", "fix"},
+    {"off", "idle", "tx"},
+    {"off", "adv", "scan", "conn"},
+    {"off", "play"},
+    {"idle", "write"},
+    {"off", "blink", "on"},
+};
+
+// 各状态的估计电流（mA）
+static const float STATE_MA[PA_SUBSYSTEM_COUNT][PA_MAX_STATES] = {
+    {PA_CPU_SLEEP_MA, PA_CPU_MIN_MA, PA_CPU_APB_MA, PA_CPU_MAX_MA},
+    {0, PA_GNSS_ACQUIRE_MA, PA_GNSS_FIX_MA},
+    {0, PA_MODEM_IDLE_MA, PA_MODEM_TX_MA},
+    {0, PA_BLE_ADV_MA, PA_BLE_SCAN_MA, PA_BLE_CONNECTED_MA},
+    {0, PA_AUDIO_PLAY_MA},
+    {PA_SD_IDLE_MA, PA_SD_WRITE_MA},
+    {0, PA_LED_BLINK_MA, PA_LED_ON_MA},
+};
+
+PowerAccounting::PowerAccounting()
+    : mux(portMUX_INITIALIZER_UNLOCKED),
+      inTrip(false),
+      tripStartUs(0),
+      tripEndUs(0),
+      carriedUs(0),
+      tripRestored(false),
+      restoredTripSec(0)
+{
+    memset(current, 0, sizeof(current));
+    memset(base, 0, sizeof(base));
+    memset(holdUntilUs, 0, sizeof(holdUntilUs));
+    // esp_timer 从上电开始计时，初始状态从 0 算起即包含启动过程
+    memset(sinceUs, 0, sizeof(sinceUs));
+    memset(totalUs, 0, sizeof(totalUs));
+    memset(tripUs, 0, sizeof(tripUs));
+    // 启动时CPU全速运行，powerLocks.begin() 后切到动态调频
+    current[PA_CPU] = PA_CPU_MAX;
+    base[PA_CPU] = PA_CPU_MAX;
+}
+
+void PowerAccounting::begin(bool warm, uint32_t sleptSec)
+{
+    portENTER_CRITICAL(&mux);
+    if (warm && rtc.magic == PA_RTC_MAGIC)
+    {
+        int64_t sleptUs = (int64_t)sleptSec * 1000000;
+        for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+        {
+            for (int s = 0; s < PA_MAX_STATES; s++)
+            {
+                totalUs[i][s] += rtc.totalUs[i][s];
+            }
+            totalUs[i][0] += sleptUs;
+        }
+        carriedUs = rtc.elapsedUs + sleptUs;
+        if (rtc.hasTrip)
+        {
+            memcpy(tripUs, rtc.tripUs, sizeof(tripUs));
+            restoredTripSec = rtc.tripSec;
+            tripRestored = true;
+        }
+    }
+    // 已接上或无效，异常复位后不会重复计入
+    rtc.magic = 0;
+    portEXIT_CRITICAL(&mux);
+}
+
+void PowerAccounting::prepareForSleep()
+{
+    int64_t total[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    int64_t trip[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    uint32_t upSeconds = 0;
+    uint32_t tripSeconds = 0;
+    snapshot(total, false, &upSeconds);
+    snapshot(trip, true, &tripSeconds);
+
+    portENTER_CRITICAL(&mux);
+    rtc.elapsedUs = carriedUs + esp_timer_get_time();
+    memcpy(rtc.totalUs, total, sizeof(rtc.totalUs));
+    rtc.hasTrip = (inTrip || tripEndUs != 0 || tripRestored) ? 1 : 0;
+    memcpy(rtc.tripUs, trip, sizeof(rtc.tripUs));
+    rtc.tripSec = tripSeconds;
+    rtc.magic = PA_RTC_MAGIC;
+    portEXIT_CRITICAL(&mux);
+}
+
+void PowerAccounting::setState(PowerSubsystem sub, uint8_t state)
+{
+    if (sub >= PA_SUBSYSTEM_COUNT || state >= STATE_COUNT[sub])
+    {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&mux);
+    advance(sub, now);
+    base[sub] = state;
+    // 关闭时结束 hold；其他状态在 hold 到期后生效
+    if (state == 0)
+    {
+        holdUntilUs[sub] = 0;
+    }
+    if (holdUntilUs[sub] == 0)
+    {
+        current[sub] = state;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+uint8_t PowerAccounting::state(PowerSubsystem sub)
+{
+    if (sub >= PA_SUBSYSTEM_COUNT)
+    {
+        return 0;
+    }
+    return base[sub];
+}
+
+void PowerAccounting::hold(PowerSubsystem sub, uint8_t state, uint32_t ms)
+{
+    if (sub >= PA_SUBSYSTEM_COUNT || state >= STATE_COUNT[sub])
+    {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&mux);
+    advance(sub, now);
+    if (base[sub] != 0)
+    {
+        current[sub] = state;
+        holdUntilUs[sub] = now + (int64_t)ms * 1000;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void PowerAccounting::startTrip()
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&mux);
+    // 先结算到现在，骑行前的时间不计入
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        advance((PowerSubsystem)i, now);
+    }
+    memset(tripUs, 0, sizeof(tripUs));
+    tripStartUs = now;
+    inTrip = true;
+    tripRestored = false;
+    portEXIT_CRITICAL(&mux);
+}
+
+void PowerAccounting::endTrip()
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        advance((PowerSubsystem)i, now);
+    }
+    tripEndUs = now;
+    inTrip = false;
+    portEXIT_CRITICAL(&mux);
+}
+
+// 调用方持有 mux
+void PowerAccounting::advance(PowerSubsystem sub, int64_t nowUs)
+{
+    if (holdUntilUs[sub] != 0 && nowUs >= holdUntilUs[sub])
+    {
+        addTime(sub, current[sub], holdUntilUs[sub] - sinceUs[sub]);
+        sinceUs[sub] = holdUntilUs[sub];
+        holdUntilUs[sub] = 0;
+        current[sub] = base[sub];
+    }
+    addTime(sub, current[sub], nowUs - sinceUs[sub]);
+    sinceUs[sub] = nowUs;
+}
+
+void PowerAccounting::addTime(PowerSubsystem sub, uint8_t state, int64_t us)
+{
+    if (us <= 0)
+    {
+        return;
+    }
+    totalUs[sub][state] += us;
+    if (inTrip)
+    {
+        tripUs[sub][state] += us;
+    }
+}
+
+void PowerAccounting::snapshot(int64_t out[PA_SUBSYSTEM_COUNT][PA_MAX_STATES], bool trip, uint32_t* seconds)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        advance((PowerSubsystem)i, now);
+    }
+    memcpy(out, trip ? tripUs : totalUs, sizeof(tripUs));
+    if (seconds)
+    {
+        if (!trip)
+        {
+            *seconds = (uint32_t)((carriedUs + now) / 1000000);
+        }
+        else if (inTrip || !tripRestored)
+        {
+            *seconds = (uint32_t)(((inTrip ? now : tripEndUs) - tripStartUs) / 1000000);
+        }
+        else
+        {
+            *seconds = restoredTripSec;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+float PowerAccounting::toMah(PowerSubsystem sub, const int64_t us[PA_MAX_STATES])
+{
+    float mah = 0.0f;
+    for (int s = 0; s < STATE_COUNT[sub]; s++)
+    {
+        mah += STATE_MA[sub][s] * (float)us[s] / 3.6e9f;
+    }
+    return mah;
+}
+
+float PowerAccounting::mah(PowerSubsystem sub, bool trip)
+{
+    if (sub >= PA_SUBSYSTEM_COUNT)
+    {
+        return 0.0f;
+    }
+    int64_t us[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    snapshot(us, trip, NULL);
+    return toMah(sub, us[sub]);
+}
+
+float PowerAccounting::totalMah(bool trip)
+{
+    int64_t us[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    snapshot(us, trip, NULL);
+    float sum = 0.0f;
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        sum += toMah((PowerSubsystem)i, us[i]);
+    }
+    return sum;
+}
+
+void PowerAccounting::printSummary(bool trip)
+{
+    int64_t us[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    uint32_t seconds = 0;
+    snapshot(us, trip, &seconds);
+
+    float mah[PA_SUBSYSTEM_COUNT];
+    float sum = 0.0f;
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        mah[i] = toMah((PowerSubsystem)i, us[i]);
+        sum += mah[i];
+    }
+
+    if (trip)
+    {
+        Serial.printf("=== %s骑行耗电 ===\n", inTrip ? "本次" : "上次");
+    }
+    else
+    {
+        Serial.println("=== 开机以来耗电 ===");
+    }
+    Serial.printf("时长: %lu 秒, 合计: %.2f mAh (平均 %.1f mA)\n", (unsigned long)seconds, sum,
+                  seconds ? sum * 3600.0f / seconds : 0.0f);
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        PowerSubsystem sub = (PowerSubsystem)i;
+        Serial.printf("  %-6s %7.2f mAh (%4.1f%%)  ", SUBSYSTEM_NAMES[i], mah[i], sum > 0.0f ? mah[i] * 100.0f / sum : 0.0f);
+        for (int s = 0; s < STATE_COUNT[i]; s++)
+        {
+            Serial.printf(" %s %lus", STATE_NAMES[i][s], (unsigned long)(us[i][s] / 1000000));
+        }
+        Serial.printf("  [当前: %s]\n", STATE_NAMES[i][current[sub]]);
+    }
+}
+
+// 上报开机以来各子系统耗电量，和当前（或上一次）骑行的耗电量及各状态停留秒数
+// {"up":秒,"mah":{"cpu":..},"trip":{"active":true,"sec":秒,"mah":{..},"s":{"cpu":[各状态秒数],..}}}
+String PowerAccounting::toJson()
+{
+    int64_t total[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    int64_t trip[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    uint32_t upSeconds = 0;
+    uint32_t tripSeconds = 0;
+    snapshot(total, false, &upSeconds);
+    snapshot(trip, true, &tripSeconds);
+
+    DynamicJsonDocument doc(1024);
+    doc["up"] = upSeconds;
+    JsonObject mahObj = doc.createNestedObject("mah");
+    for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+    {
+        mahObj[SUBSYSTEM_NAMES[i]] = roundf(toMah((PowerSubsystem)i, total[i]) * 100.0f) / 100.0f;
+    }
+
+    if (inTrip || tripEndUs != 0 || tripRestored)
+    {
+        JsonObject tripObj = doc.createNestedObject("trip");
+        tripObj["active"] = inTrip;
+        tripObj["sec"] = tripSeconds;
+        JsonObject tripMah = tripObj.createNestedObject("mah");
+        JsonObject tripStates = tripObj.createNestedObject("s");
+        for (int i = 0; i < PA_SUBSYSTEM_COUNT; i++)
+        {
+            tripMah[SUBSYSTEM_NAMES[i]] = roundf(toMah((PowerSubsystem)i, trip[i]) * 100.0f) / 100.0f;
+            JsonArray states = tripStates.createNestedArray(SUBSYSTEM_NAMES[i]);
+            for (int s = 0; s < STATE_COUNT[i]; s++)
+            {
+                states.add((uint32_t)(trip[i][s] / 1000000));
+            }
+        }
+    }
+    return doc.as<String>();
+}
+
+const char* PowerAccounting::subsystemName(PowerSubsystem sub)
+{
+    return sub < PA_SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[sub] : "?";
+}
+
+const char* PowerAccounting::stateName(PowerSubsystem sub, uint8_t state)
+{
+    if (sub >= PA_SUBSYSTEM_COUNT || state >= STATE_COUNT[sub])
+    {
+        return "?";
+    }
+    return STATE_NAMES[sub][state];
+}
+
+uint8_t PowerAccounting::stateCount(PowerSubsystem sub)
+{
+    return sub < PA_SUBSYSTEM_COUNT ? STATE_COUNT[sub] : 0;
+}
+
+PowerStateGuard::PowerStateGuard(PowerSubsystem sub, uint8_t state)
+    : sub(sub), previous(powerAccounting.state(sub))
+{
+    powerAccounting.setState(sub, state);
+}
+
+PowerStateGuard::~PowerStateGuard()
+{
+    powerAccounting.setState(sub, previous);
+}
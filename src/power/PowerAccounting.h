@@ -0,0 +1,113 @@
+#ifndef POWER_ACCOUNTING_H
+#define POWER_ACCOUNTING_H
+
+#include <Arduino.h>
+
+/*
+ * 分子系统功耗统计
+ *
+ * 各子系统在状态切换时调用 setState()，统计模块按 config.h 中 PA_*_MA 的各状态估计电流
+ * 对停留时间积分，得到每个子系统的耗电量（mAh）。统计分两份：开机以来的累计值，
+ * 和电门打开到关闭的一次骑行（关闭后保留为上一次骑行，直到下次打开）。
+ * 结果通过 MQTT telemetry/power 上报，骑行结束时输出到串口，用于按车队数据调整各模块的工作周期。
+ *
+ * 电流是估计值，不是测量值；各子系统之间的相对大小和骑行之间的比较比绝对值更可靠。
+ * 4G模块的发射无法从外部观察，按每次上报成功后保持 PA_MODEM_TX_TAIL_MS 的连接态计算（hold）。
+ *
+ * 进入深度睡眠前累计值和上一次骑行存入RTC内存，热启动后接着累计，
+ * 睡眠时长计入各子系统的初始状态（CPU按睡眠电流，其余为关闭或空闲）。
+ */
+
+enum PowerSubsystem : uint8_t {
+    PA_CPU = 0,         // 主控CPU（按动态调频档位）
+    PA_GNSS,            // GNSS
+    PA_MODEM,           // 4G模块
+    PA_BLE,             // BLE
+    PA_AUDIO,           // 音频功放
+    PA_SD,              // SD卡
+    PA_LED,             // 指示灯
+    PA_SUBSYSTEM_COUNT
+};
+
+#define PA_MAX_STATES 4
+
+// 各子系统的状态，0 为初始状态
+enum { PA_CPU_SLEEP = 0, PA_CPU_MIN, PA_CPU_APB, PA_CPU_MAX };
+enum { PA_GNSS_OFF = 0, PA_GNSS_ACQUIRE, PA_GNSS_FIX };
+enum { PA_MODEM_OFF = 0, PA_MODEM_IDLE, PA_MODEM_TX };
+enum { PA_BLE_OFF = 0, PA_BLE_ADV, PA_BLE_SCAN, PA_BLE_CONNECTED };
+enum { PA_AUDIO_OFF = 0, PA_AUDIO_PLAY };
+enum { PA_SD_IDLE = 0, PA_SD_WRITE };
+enum { PA_LED_OFF = 0, PA_LED_BLINK, PA_LED_ON };
+
+class PowerAccounting {
+public:
+    PowerAccounting();
+
+    // warmBoot.begin() 之后调用：热启动时接上睡眠前的累计值并计入睡眠时长，否则从零开始
+    void begin(bool warm, uint32_t sleptSec);
+
+    // 进入深度睡眠前调用，把累计值和上一次骑行存入RTC内存
+    void prepareForSleep();
+
+    // 子系统进入新状态，状态不变时忽略，可在任意任务中调用
+    void setState(PowerSubsystem sub, uint8_t state);
+    uint8_t state(PowerSubsystem sub);
+
+    /**
+     * @brief 临时进入某状态一段时间，到期后回到 setState() 设置的状态
+     *        期间再次调用会延长，用于无法观察结束时刻的突发（4G发射）
+     */
+    void hold(PowerSubsystem sub, uint8_t state, uint32_t ms);
+
+    // 电门打开时开始一次骑行，关闭时结束并保留结果
+    void startTrip();
+    void endTrip();
+    bool tripActive() const { return inTrip; }
+
+    // 耗电量（mAh），trip 为 true 时取当前骑行（未在骑行时为上一次骑行）
+    float mah(PowerSubsystem sub, bool trip);
+    float totalMah(bool trip);
+
+    void printSummary(bool trip);
+    String toJson();
+
+    static const char* subsystemName(PowerSubsystem sub);
+    static const char* stateName(PowerSubsystem sub, uint8_t state);
+    static uint8_t stateCount(PowerSubsystem sub);
+
+private:
+    portMUX_TYPE mux;
+    uint8_t current[PA_SUBSYSTEM_COUNT];
+    uint8_t base[PA_SUBSYSTEM_COUNT];           // hold 结束后回到的状态
+    int64_t holdUntilUs[PA_SUBSYSTEM_COUNT];    // 0 表示没有 hold
+    int64_t sinceUs[PA_SUBSYSTEM_COUNT];
+    int64_t totalUs[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    int64_t tripUs[PA_SUBSYSTEM_COUNT][PA_MAX_STATES];
+    bool inTrip;
+    int64_t tripStartUs;
+    int64_t tripEndUs;
+    int64_t carriedUs;          // 本次启动之前的累计时长（含深度睡眠）
+    bool tripRestored;          // 上一次骑行来自睡眠前
+    uint32_t restoredTripSec;
+
+    void advance(PowerSubsystem sub, int64_t nowUs);
+    void addTime(PowerSubsystem sub, uint8_t state, int64_t us);
+    void snapshot(int64_t out[PA_SUBSYSTEM_COUNT][PA_MAX_STATES], bool trip, uint32_t* seconds);
+    static float toMah(PowerSubsystem sub, const int64_t us[PA_MAX_STATES]);
+};
+
+// 作用域内进入某状态，结束时回到之前的状态，用于SD卡写入等突发操作
+class PowerStateGuard {
+public:
+    PowerStateGuard(PowerSubsystem sub, uint8_t state);
+    ~PowerStateGuard();
+
+private:
+    PowerSubsystem sub;
+    uint8_t previous;
+};
+
+extern PowerAccounting powerAccounting;
+
+#endif // POWER_ACCOUNTING_H
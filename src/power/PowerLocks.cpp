@@ -0,0 +1,282 @@
+#include "PowerLocks.h"
+#include "PowerAccounting.h"
+#include "esp_timer.h"
+
+PowerLockManager powerLocks;
+
+// 每个模块需要的锁
+static const uint8_t CLIENT_LOCKS[PM_CLIENT_COUNT] = {
+    PM_LOCK_CPU_FREQ_MAX | PM_LOCK_NO_LIGHT_SLEEP,   // BLE：连接事件处理和加解密
+    PM_LOCK_APB_FREQ_MAX | PM_LOCK_NO_LIGHT_SLEEP,   // 音频：I2S时钟，混音开销很小不需要升频
+    PM_LOCK_CPU_FREQ_MAX | PM_LOCK_APB_FREQ_MAX,     // SD卡：SPI时钟和FAT计算
+    PM_LOCK_APB_FREQ_MAX | PM_LOCK_NO_LIGHT_SLEEP,   // 4G模块：UART波特率
+};
+
+static const uint32_t LEVEL_FREQ_MHZ[PM_FREQ_LEVEL_COUNT] = {
+    PM_MIN_CPU_FREQ_MHZ,
+    PM_MIN_CPU_FREQ_MHZ < PM_APB_FREQ_MHZ ? PM_APB_FREQ_MHZ : PM_MIN_CPU_FREQ_MHZ,
+    PM_MAX_CPU_FREQ_MHZ,
+};
+
+PowerLockManager::PowerLockManager()
+    : initialized(false),
+      cpuMaxCount(0),
+      apbMaxCount(0),
+      noLightSleepCount(0),
+      currentLevel(PM_FREQ_MAX),
+      levelSinceUs(0)
+{
+    // 全局对象构造时堆已可用，互斥量在这里创建，begin() 之前的持锁也能正确计数
+    mutex = xSemaphoreCreateMutex();
+    memset(held, 0, sizeof(held));
+    memset(acquireCount, 0, sizeof(acquireCount));
+    memset(residencyUs, 0, sizeof(residencyUs));
+#if CONFIG_PM_ENABLE
+    pmConfigured = false;
+    memset(locks, 0, sizeof(locks));
+#endif
+}
+
+void PowerLockManager::begin()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+#if CONFIG_PM_ENABLE
+    static const esp_pm_lock_type_t types[3] = {ESP_PM_CPU_FREQ_MAX, ESP_PM_APB_FREQ_MAX, ESP_PM_NO_LIGHT_SLEEP};
+    for (int c = 0; c < PM_CLIENT_COUNT; c++)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            if ((CLIENT_LOCKS[c] & (1 << t)) == 0)
+            {
+                continue;
+            }
+            if (esp_pm_lock_create(types[t], 0, clientName((PowerLockClient)c), &locks[c][t]) != ESP_OK)
+            {
+                locks[c][t] = NULL;
+                continue;
+            }
+            // begin() 之前已持有的锁补上
+            if (held[c] > 0)
+            {
+                esp_pm_lock_acquire(locks[c][t]);
+            }
+        }
+    }
+
+#if CONFIG_IDF_TARGET_ESP32S3
+    esp_pm_config_esp32s3_t config;
+#else
+    esp_pm_config_esp32_t config;
+#endif
+    config.max_freq_mhz = PM_MAX_CPU_FREQ_MHZ;
+    config.min_freq_mhz = PM_MIN_CPU_FREQ_MHZ;
+    // 自动浅睡眠会丢失串口数据，浅睡眠只在驻车模式中显式进入
+    config.light_sleep_enable = false;
+    esp_err_t err = esp_pm_configure(&config);
+    pmConfigured = (err == ESP_OK);
+    if (!pmConfigured)
+    {
+        Serial.printf("[电源锁] esp_pm配置失败: %s，改用手动调频\n", esp_err_to_name(err));
+    }
+#endif
+
+    initialized = true;
+    levelSinceUs = esp_timer_get_time();
+    applyLevel();
+    xSemaphoreGive(mutex);
+
+    Serial.printf("[电源锁] 动态调频已启用: %u-%u MHz，当前 %u MHz\n",
+                  (unsigned)PM_MIN_CPU_FREQ_MHZ, (unsigned)PM_MAX_CPU_FREQ_MHZ, (unsigned)getCpuFrequencyMhz());
+}
+
+void PowerLockManager::acquire(PowerLockClient client)
+{
+    if (client >= PM_CLIENT_COUNT)
+    {
+        return;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (held[client]++ == 0)
+    {
+        uint8_t mask = CLIENT_LOCKS[client];
+        if (mask & PM_LOCK_CPU_FREQ_MAX) cpuMaxCount++;
+        if (mask & PM_LOCK_APB_FREQ_MAX) apbMaxCount++;
+        if (mask & PM_LOCK_NO_LIGHT_SLEEP) noLightSleepCount++;
+        acquireCount[client]++;
+
+#if CONFIG_PM_ENABLE
+        for (int t = 0; t < 3; t++)
+        {
+            if (locks[client][t])
+            {
+                esp_pm_lock_acquire(locks[client][t]);
+            }
+        }
+#endif
+        applyLevel();
+    }
+    xSemaphoreGive(mutex);
+}
+
+void PowerLockManager::release(PowerLockClient client)
+{
+    if (client >= PM_CLIENT_COUNT)
+    {
+        return;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (held[client] > 0 && --held[client] == 0)
+    {
+        uint8_t mask = CLIENT_LOCKS[client];
+        if (mask & PM_LOCK_CPU_FREQ_MAX) cpuMaxCount--;
+        if (mask & PM_LOCK_APB_FREQ_MAX) apbMaxCount--;
+        if (mask & PM_LOCK_NO_LIGHT_SLEEP) noLightSleepCount--;
+
+#if CONFIG_PM_ENABLE
+        for (int t = 0; t < 3; t++)
+        {
+            if (locks[client][t])
+            {
+                esp_pm_lock_release(locks[client][t]);
+            }
+        }
+#endif
+        applyLevel();
+    }
+    xSemaphoreGive(mutex);
+}
+
+bool PowerLockManager::beginLightSleep()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (noLightSleepCount > 0)
+    {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    return true;
+}
+
+void PowerLockManager::endLightSleep()
+{
+    xSemaphoreGive(mutex);
+}
+
+PowerFreqLevel PowerLockManager::targetLevel() const
+{
+    if (cpuMaxCount > 0)
+    {
+        return PM_FREQ_MAX;
+    }
+    if (apbMaxCount > 0 && PM_MIN_CPU_FREQ_MHZ < PM_APB_FREQ_MHZ)
+    {
+        return PM_FREQ_APB;
+    }
+    return PM_FREQ_MIN;
+}
+
+// 调用方持有互斥量
+void PowerLockManager::applyLevel()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    PowerFreqLevel level = targetLevel();
+    if (level == currentLevel)
+    {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    residencyUs[currentLevel] += now - levelSinceUs;
+    levelSinceUs = now;
+    currentLevel = level;
+    powerAccounting.setState(PA_CPU, PA_CPU_MIN + level);
+
+#if CONFIG_PM_ENABLE
+    if (pmConfigured)
+    {
+        return; // 频率由 esp_pm 根据锁切换
+    }
+#endif
+    if (getCpuFrequencyMhz() != LEVEL_FREQ_MHZ[level])
+    {
+        setCpuFrequencyMhz(LEVEL_FREQ_MHZ[level]);
+    }
+}
+
+uint32_t PowerLockManager::getResidencyMs(PowerFreqLevel level)
+{
+    if (level >= PM_FREQ_LEVEL_COUNT)
+    {
+        return 0;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int64_t us = residencyUs[level];
+    if (initialized && level == currentLevel)
+    {
+        us += esp_timer_get_time() - levelSinceUs;
+    }
+    xSemaphoreGive(mutex);
+    return (uint32_t)(us / 1000);
+}
+
+void PowerLockManager::resetStats()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    memset(residencyUs, 0, sizeof(residencyUs));
+    memset(acquireCount, 0, sizeof(acquireCount));
+    levelSinceUs = esp_timer_get_time();
+    xSemaphoreGive(mutex);
+}
+
+void PowerLockManager::printStats()
+{
+    uint32_t ms[PM_FREQ_LEVEL_COUNT];
+    uint32_t total = 0;
+    for (int i = 0; i < PM_FREQ_LEVEL_COUNT; i++)
+    {
+        ms[i] = getResidencyMs((PowerFreqLevel)i);
+        total += ms[i];
+    }
+
+    Serial.println("=== CPU频率统计 ===");
+    Serial.printf("当前频率: %u MHz\n", (unsigned)getCpuFrequencyMhz());
+    for (int i = 0; i < PM_FREQ_LEVEL_COUNT; i++)
+    {
+        // 最低频率不低于80MHz时 APB 档与最低档相同，不单独显示
+        if (i == PM_FREQ_APB && PM_MIN_CPU_FREQ_MHZ >= PM_APB_FREQ_MHZ)
+        {
+            continue;
+        }
+        Serial.printf("  %3u MHz: %lu 秒 (%.1f%%)\n", (unsigned)LEVEL_FREQ_MHZ[i], (unsigned long)(ms[i] / 1000),
+                      total ? ms[i] * 100.0f / total : 0.0f);
+    }
+    Serial.println("持锁情况:");
+    for (int c = 0; c < PM_CLIENT_COUNT; c++)
+    {
+        Serial.printf("  %-6s %s, 获取 %lu 次\n", clientName((PowerLockClient)c),
+                      held[c] ? "持有" : "空闲", (unsigned long)acquireCount[c]);
+    }
+}
+
+const char* PowerLockManager::clientName(PowerLockClient client)
+{
+    static const char* const names[PM_CLIENT_COUNT] = {"ble", "audio", "sd", "modem"};
+    return client < PM_CLIENT_COUNT ? names[client] : "?";
+}
+
+PowerLockGuard::PowerLockGuard(PowerLockClient client) : client(client)
+{
+    powerLocks.acquire(client);
+}
+
+PowerLockGuard::~PowerLockGuard()
+{
+    powerLocks.release(client);
+}
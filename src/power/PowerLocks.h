@@ -0,0 +1,121 @@
+#ifndef POWER_LOCKS_H
+#define POWER_LOCKS_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+/*
+ * 电源管理锁
+ *
+ * 平时CPU运行在 PM_MIN_CPU_FREQ_MHZ，只有持有锁的工作期间才升频：
+ * - CPU_FREQ_MAX：需要算力（BLE连接、SD卡突发写入）
+ * - APB_FREQ_MAX：外设时钟不能变化（I2S、SPI、UART），最低频率低于80MHz时才有影响
+ * - NO_LIGHT_SLEEP：禁止驻车浅睡眠
+ *
+ * 固件启用了 CONFIG_PM_ENABLE 时直接使用 esp_pm 锁；Arduino 预编译库未启用时
+ * 按引用计数调用 setCpuFrequencyMhz()，UART波特率由 Arduino 的 APB 回调自动修正。
+ * 两种方式都按锁状态统计各频率的停留时间，用于评估每次骑行的节电效果。
+ */
+
+#ifndef PM_MAX_CPU_FREQ_MHZ
+#define PM_MAX_CPU_FREQ_MHZ     240
+#endif
+#ifndef PM_MIN_CPU_FREQ_MHZ
+#define PM_MIN_CPU_FREQ_MHZ     80      // 不低于80MHz时APB保持80MHz，串口输出不受影响
+#endif
+#define PM_APB_FREQ_MHZ         80
+
+// 锁类型，可组合
+#define PM_LOCK_CPU_FREQ_MAX    0x01
+#define PM_LOCK_APB_FREQ_MAX    0x02
+#define PM_LOCK_NO_LIGHT_SLEEP  0x04
+
+// 持锁的模块，每个模块一组锁
+enum PowerLockClient : uint8_t {
+    PM_CLIENT_BLE = 0,      // BLE连接期间
+    PM_CLIENT_AUDIO,        // I2S播放期间
+    PM_CLIENT_SD,           // SD卡突发读写
+    PM_CLIENT_MODEM,        // 4G模块串口收发
+    PM_CLIENT_COUNT
+};
+
+// 统计的频率档位
+enum PowerFreqLevel : uint8_t {
+    PM_FREQ_MIN = 0,        // PM_MIN_CPU_FREQ_MHZ
+    PM_FREQ_APB,            // 80MHz（最低频率低于80MHz时持有APB锁）
+    PM_FREQ_MAX,            // PM_MAX_CPU_FREQ_MHZ
+    PM_FREQ_LEVEL_COUNT
+};
+
+class PowerLockManager {
+public:
+    PowerLockManager();
+
+    // 初始化并降到最低频率，在 setup() 完成后调用，启动过程保持全速
+    void begin();
+
+    void acquire(PowerLockClient client);
+    void release(PowerLockClient client);
+
+    // 模块当前是否持锁（即是否正在工作），电量估计据此判断已知负载
+    bool isHeld(PowerLockClient client) const { return held[client] > 0; }
+
+    // 没有模块持有 NO_LIGHT_SLEEP 锁时可以浅睡眠
+    bool lightSleepAllowed() const { return noLightSleepCount == 0; }
+
+    /**
+     * @brief 进入浅睡眠前紧接 esp_light_sleep_start() 调用：取得互斥量后再确认没有 NO_LIGHT_SLEEP 锁
+     * @return true 时一直持有互斥量，其他任务的 acquire()/release() 等待到 endLightSleep()，
+     * 不会在确认之后、睡眠之前开始串口或I2S收发；false 时已释放，本次不能睡眠
+     */
+    bool beginLightSleep();
+    void endLightSleep();
+
+    // 各频率档位停留时间（毫秒）
+    uint32_t getResidencyMs(PowerFreqLevel level);
+    void resetStats();
+    void printStats();
+
+    static const char* clientName(PowerLockClient client);
+
+private:
+    bool initialized;
+    SemaphoreHandle_t mutex;
+    volatile uint8_t held[PM_CLIENT_COUNT]; // 每个模块的嵌套持锁次数
+    uint8_t cpuMaxCount;
+    uint8_t apbMaxCount;
+    volatile uint8_t noLightSleepCount;
+    uint32_t acquireCount[PM_CLIENT_COUNT];
+
+    PowerFreqLevel currentLevel;
+    int64_t levelSinceUs;
+    int64_t residencyUs[PM_FREQ_LEVEL_COUNT];
+
+#if CONFIG_PM_ENABLE
+    bool pmConfigured;
+    esp_pm_lock_handle_t locks[PM_CLIENT_COUNT][3];
+#endif
+
+    PowerFreqLevel targetLevel() const;
+    void applyLevel();
+};
+
+// 作用域内持锁，用于SD卡、串口等突发操作
+class PowerLockGuard {
+public:
+    explicit PowerLockGuard(PowerLockClient client);
+    ~PowerLockGuard();
+
+private:
+    PowerLockClient client;
+};
+
+extern PowerLockManager powerLocks;
+
+#endif // POWER_LOCKS_H
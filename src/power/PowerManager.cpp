@@ -8,6 +8,23 @@
 #include "driver/periph_ctrl.h"
 #include "soc/periph_defs.h"
 #include "device.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "WarmBoot.h"
+#include "SleepMonitor.h"
+#include "PowerAccounting.h"
+#include "imu/MotionWake.h"
+#include "utils/Trace.h"
+#include "utils/Log.h"
+
+#ifdef BAT_PIN
+#include "bat/BAT.h"
+#endif
+
+#ifdef USE_AIR780EG_GSM
+#include <Air780EG.h>
+#endif
 
 #ifdef ENABLE_AUDIO
 #include "audio/AudioManager.h"
@@ -21,6 +38,23 @@ RTC_DATA_ATTR bool PowerManager::sleepEnabled = true;
 RTC_DATA_ATTR bool PowerManager::sleepEnabled = false;
 #endif
 
+// 状态迁移日志和唤醒耗时统计，保存在RTC内存中跨深度睡眠保留
+RTC_DATA_ATTR static PowerStateLog powerStateLog;
+
+// 最近一次进入深度睡眠前关闭外设的耗时（毫秒），唤醒后在 power.status 中查看
+struct ShutdownTiming {
+    uint16_t radioMs;       // WiFi和蓝牙（并行任务）
+    uint16_t displayMs;     // 显示屏（并行任务）
+    uint16_t audioMs;       // 等待睡眠提示音播放结束
+    uint16_t busMs;         // I2C、ADC、按钮和外设时钟
+    uint16_t totalMs;
+};
+RTC_DATA_ATTR static ShutdownTiming lastShutdown;
+
+#ifdef MODE_ALLINONE
+static const int COUNTDOWN_MAX_BRIGHTNESS = 255;    // 倒计时从最大亮度逐渐降低
+#endif
+
 PowerManager powerManager;
 
 PowerManager::PowerManager()
@@ -28,10 +62,17 @@ PowerManager::PowerManager()
     Serial.println("[电源管理] 初始化开始");
     // 设置默认值
     lastMotionTime = 0;
-    powerState = POWER_STATE_NORMAL;
-    sleepTimeSec = get_device_state()->sleep_time;
-
-    powerState = POWER_STATE_NORMAL;
+    lastMotionCheck = 0;
+    lastVehicleCheck = 0;
+    lastVehicleState = false;
+    vehicleStateKnown = false;
+    parkedSince = 0;
+    checkinStart = 0;
+    parkedCheckins = 0;
+    imuParked = false;
+    countdownStart = 0;
+    countdownShown = -1;
+    sleepTimeSec = 0;
 }
 
 void PowerManager::begin()
@@ -41,6 +82,7 @@ void PowerManager::begin()
     // 启动时从存储读取休眠时间（秒），如无则用默认值
     sleepTimeSec = PreferencesUtils::loadSleepTime();
     idleThreshold = sleepTimeSec * 1000;
+    deviceState.set(DS_SLEEP_TIME, &device_state_t::sleep_time, sleepTimeSec);
 
     // 处理唤醒事件
     handleWakeup();
@@ -54,6 +96,13 @@ void PowerManager::handleWakeup()
     esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
     Serial.printf("[电源管理] 唤醒原因: %d\n", wakeup_reason);
 
+    // 先收集ULP睡眠监测结果，唤醒源判定要用到ULP唤醒原因
+    sleepMonitor.handleWakeup(wakeup_reason);
+    deviceState.set(DS_SLEEP_ALARM, &device_state_t::sleep_alarm, sleepMonitor.wakeReason());
+
+    // 状态机从 WAKING 开始，setup() 完成后由 markSystemReady() 进入 ACTIVE
+    stateMachine.begin(&powerStateLog, detectWakeSource(wakeup_reason), millis());
+
     // 解除所有GPIO保持
     gpio_deep_sleep_hold_dis();
 
@@ -64,24 +113,10 @@ void PowerManager::handleWakeup()
 #if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
         if (IMU_INT_PIN >= 0 && IMU_INT_PIN <= 21)
         {
-            // 等待引脚状态稳定
-            delay(100);
+            // IMU 由 Device::begin() 中的 imu.begin() 统一复位并重新配置，这里不再单独恢复
             int pinState = digitalRead(IMU_INT_PIN);
-            Serial.printf("[电源管理] IMU引脚状态: %d\n", pinState);
-
-            // 恢复IMU
-            extern IMU imu;
-            Serial.println("[电源管理] 从IMU运动唤醒，恢复IMU状态");
-            imu.restoreFromDeepSleep();
-
-            if (imu.checkWakeOnMotionEvent())
-            {
-                Serial.println("[电源管理] ✅ 确认为运动唤醒事件");
-            }
-            else
-            {
-                Serial.println("[电源管理] ⚠️ 未检测到运动事件，可能为其他原因唤醒");
-            }
+            Serial.printf("[电源管理] 从IMU运动唤醒，IMU引脚状态: %d\n", pinState);
+            motionWake.reportWakeup();
         }
 #endif
         break;
@@ -96,31 +131,104 @@ void PowerManager::handleWakeup()
 
     // 重置运动检测时间
     lastMotionTime = millis();
-    
-    // 恢复SD卡
-#ifdef ENABLE_SDCARD
-    extern SDManager sdManager;
-    if (!sdManager.isInitialized()) {
-        Serial.println("[电源管理] 从睡眠恢复，重新初始化SD卡");
-        if (sdManager.begin()) {
-            Serial.println("[电源管理] SD卡重新初始化成功");
-            // 记录唤醒日志（简化版）
-            String wakeupLog = "设备从深度睡眠唤醒，原因: ";
-            switch (wakeup_reason) {
-                case ESP_SLEEP_WAKEUP_EXT0:
-                    wakeupLog += "运动检测";
-                    break;
-                case ESP_SLEEP_WAKEUP_TIMER:
-                    wakeupLog += "定时器";
-                    break;
-                default:
-                    wakeupLog += "其他";
-                    break;
-            }
-            Serial.println("[电源管理] " + wakeupLog);
+    // SD卡由 setup() 在并行任务中初始化
+}
+
+PowerWakeSource PowerManager::detectWakeSource(esp_sleep_wakeup_cause_t cause)
+{
+    switch (cause)
+    {
+    case ESP_SLEEP_WAKEUP_EXT0:
+        return POWER_WAKE_MOTION;      // IMU中断接在EXT0
+    case ESP_SLEEP_WAKEUP_EXT1:
+        return POWER_WAKE_IGNITION;    // 电门检测接在EXT1
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return POWER_WAKE_TIMER;
+    case ESP_SLEEP_WAKEUP_ULP:
+        return (sleepMonitor.wakeReason() & SLEEP_WAKE_IGNITION) ? POWER_WAKE_IGNITION : POWER_WAKE_MONITOR;
+    case ESP_SLEEP_WAKEUP_UNDEFINED:
+        return POWER_WAKE_POWER_ON;
+    default:
+        return POWER_WAKE_OTHER;
+    }
+}
+
+bool PowerManager::postEvent(PowerEvent event)
+{
+    PowerMode from = stateMachine.mode();
+    if (!stateMachine.handle(event, millis()))
+    {
+        return false;
+    }
+    Serial.printf("[电源管理] 状态: %s -> %s (%s)\n", powerModeName(from),
+                  powerModeName(stateMachine.mode()), powerEventName(event));
+    trace.power((uint8_t)from, (uint8_t)stateMachine.mode());
+    return true;
+}
+
+void PowerManager::markSystemReady()
+{
+    // esp_timer 从应用启动开始计时，包含 setup() 中所有初始化的耗时
+    uint32_t latencyMs = (uint32_t)(esp_timer_get_time() / 1000);
+    if (stateMachine.markReady(latencyMs, millis()))
+    {
+        Serial.printf("[电源管理] 系统就绪，唤醒源: %s，唤醒到就绪耗时: %u ms\n",
+                      powerWakeSourceName(stateMachine.wakeSource()), (unsigned)latencyMs);
+    }
+    // 初始化期间不计入空闲时间
+    lastMotionTime = millis();
+}
+
+void PowerManager::printPowerStatus()
+{
+    Serial.println("=== 电源状态 ===");
+    Serial.printf("当前状态: %s (已持续 %lu ms)\n", powerModeName(stateMachine.mode()),
+                  millis() - stateMachine.modeEnteredMs());
+    Serial.printf("启动序号: %u, 唤醒源: %s\n", stateMachine.bootIndex(),
+                  powerWakeSourceName(stateMachine.wakeSource()));
+    Serial.printf("休眠功能: %s, 休眠时间: %lu 秒, 已静止: %lu 秒\n", sleepEnabled ? "启用" : "禁用",
+                  sleepTimeSec, (millis() - lastMotionTime) / 1000);
+    Serial.printf("车辆电门: %s\n", isVehicleStarted() ? "已启动" : "未启动");
+    if (stateMachine.mode() == POWER_MODE_PARKED)
+    {
+        Serial.printf("驻车: %lu 秒, 定时上报 %lu 次, IMU WOM: %s\n", (millis() - parkedSince) / 1000,
+                      parkedCheckins, imuParked ? "是" : "否");
+    }
+    if (stateMachine.mode() == POWER_MODE_SLEEP_COUNTDOWN)
+    {
+        Serial.printf("休眠倒计时: 剩余 %d 秒\n", countdownShown);
+    }
+    if (lastShutdown.totalMs)
+    {
+        Serial.printf("上次睡眠前关闭外设: %u ms（WiFi/蓝牙 %u ms，显示 %u ms，等待音频 %u ms，总线和时钟 %u ms）\n",
+                      lastShutdown.totalMs, lastShutdown.radioMs, lastShutdown.displayMs, lastShutdown.audioMs,
+                      lastShutdown.busMs);
+    }
+
+    Serial.println("唤醒到就绪耗时:");
+    for (int i = 0; i < POWER_WAKE_SOURCE_COUNT; i++)
+    {
+        const PowerWakeLatency &l = stateMachine.latency((PowerWakeSource)i);
+        if (l.count == 0)
+        {
+            continue;
         }
+        Serial.printf("  %-9s 次数 %u, 最近 %u ms, 平均 %u ms, 最小 %u ms, 最大 %u ms\n",
+                      powerWakeSourceName((PowerWakeSource)i), (unsigned)l.count, (unsigned)l.lastMs,
+                      (unsigned)(l.totalMs / l.count), (unsigned)l.minMs, (unsigned)l.maxMs);
+    }
+}
+
+void PowerManager::printTransitionLog()
+{
+    Serial.printf("=== 电源状态迁移日志（最近 %u 条）===\n", (unsigned)stateMachine.recordCount());
+    for (size_t i = 0; i < stateMachine.recordCount(); i++)
+    {
+        const PowerTransitionRecord &r = stateMachine.recordAt(i);
+        Serial.printf("  启动#%-4u %10u ms  %-11s -> %-11s (%s)\n", r.bootIndex, (unsigned)r.timestampMs,
+                      powerModeName((PowerMode)r.from), powerModeName((PowerMode)r.to),
+                      powerEventName((PowerEvent)r.event));
     }
-#endif
 }
 
 void PowerManager::configurePowerDomains()
@@ -132,6 +240,73 @@ void PowerManager::configurePowerDomains()
     esp_sleep_pd_config(ESP_PD_DOMAIN_XTAL, ESP_PD_OPTION_OFF);         // 关闭XTAL
 }
 
+void PowerManager::filterMotionWakeup()
+{
+#if defined(ENABLE_SLEEP) && defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    if (IMU_INT_PIN < 0 || IMU_INT_PIN > 21)
+    {
+        return;
+    }
+    // 唤醒风暴暂停到期：恢复IMU唤醒，继续等备用定时唤醒
+    bool holdoffEnded = motionWake.holdoffEnded();
+    if (!holdoffEnded && motionWake.classifyWakeup() != MOTION_WAKE_FALSE)
+    {
+        return;
+    }
+    // 阈值提高后重新配置WOM，失败时走完整启动，由 imu.begin() 处理
+    if (motionWake.rearmNeeded() && !imu.rearmWakeOnMotion(motionWake.threshold()))
+    {
+        return;
+    }
+#if SLEEP_MONITOR_ENABLED
+    if (!sleepMonitor.resume())
+    {
+        return;
+    }
+#endif
+
+    Serial.begin(115200);
+    const MotionWakeState& s = motionWake.state();
+    if (holdoffEnded)
+    {
+        Serial.printf("[IMU唤醒] 唤醒风暴暂停结束，恢复IMU唤醒 (阈值 %u mg)，继续睡眠\n", s.thresholdMg);
+    }
+    else
+    {
+        Serial.printf("[IMU唤醒] 误唤醒（姿态变化 %.2f°，晃动 %u mg），第 %lu 次，阈值 %u mg%s，继续睡眠\n",
+                      s.lastTiltCdeg / 100.0f, s.lastShakeMg, (unsigned long)s.falseWakes, s.thresholdMg,
+                      motionWake.suppressed() ? "，唤醒风暴，暂停IMU唤醒" : "");
+    }
+    resleepAfterFalseWake();
+#endif
+}
+
+void PowerManager::resleepAfterFalseWake()
+{
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    // IMU、电门引脚和 ULP 保持睡眠前的配置，只需重新使能唤醒源
+    if (!motionWake.suppressed())
+    {
+        esp_sleep_enable_ext0_wakeup((gpio_num_t)IMU_INT_PIN, 0);
+    }
+    else
+    {
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT0);
+    }
+    esp_sleep_enable_timer_wakeup(motionWake.sleepTimerUs());
+#ifdef RTC_INT_PIN
+    if (RTC_INT_PIN >= 0 && RTC_INT_PIN <= 21 && rtc_gpio_is_valid_gpio((gpio_num_t)RTC_INT_PIN))
+    {
+        esp_sleep_enable_ext1_wakeup(1ULL << RTC_INT_PIN, ESP_EXT1_WAKEUP_ALL_LOW);
+    }
+#endif
+    configurePowerDomains();
+    motionWake.markResleep();
+    Serial.flush();
+    esp_deep_sleep_start();
+#endif
+}
+
 bool PowerManager::configureWakeupSources()
 {
     Serial.println("[电源管理] 🔧 开始配置唤醒源...");
@@ -141,7 +316,12 @@ bool PowerManager::configureWakeupSources()
 
 // 2. 配置IMU运动唤醒
 #if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
-    if (IMU_INT_PIN >= 0 && IMU_INT_PIN <= 21)
+    if (!deviceState.get(&device_state_t::imuReady))
+    {
+        // IMU故障时只靠电门和定时唤醒，不因为可选传感器放弃睡眠
+        Serial.println("[电源管理] ⚠️ IMU故障，本次睡眠不使用IMU唤醒");
+    }
+    else if (IMU_INT_PIN >= 0 && IMU_INT_PIN <= 21)
     {
         // 检查是否为有效的RTC GPIO
         if (!rtc_gpio_is_valid_gpio((gpio_num_t)IMU_INT_PIN))
@@ -180,30 +360,43 @@ bool PowerManager::configureWakeupSources()
             }
         }
 
-        // 配置EXT0唤醒
-        ret = esp_sleep_enable_ext0_wakeup((gpio_num_t)IMU_INT_PIN, 0);
-        if (ret != ESP_OK)
+        // 配置EXT0唤醒，唤醒风暴暂停期间不使用IMU唤醒（IMU仍配置为WOM，以便记录重力方向）
+        if (motionWake.suppressed())
         {
-            Serial.printf("[电源管理] ❌ EXT0唤醒配置失败: %s\n", esp_err_to_name(ret));
-            return false;
+            Serial.println("[电源管理] ⚠️ IMU唤醒风暴暂停中，本次睡眠不使用IMU唤醒");
         }
+        else
+        {
+            ret = esp_sleep_enable_ext0_wakeup((gpio_num_t)IMU_INT_PIN, 0);
+            if (ret != ESP_OK)
+            {
+                Serial.printf("[电源管理] ❌ EXT0唤醒配置失败: %s\n", esp_err_to_name(ret));
+                return false;
+            }
 
-        Serial.printf("[电源管理] ✅ IMU唤醒配置成功 (GPIO%d)\n", IMU_INT_PIN);
+            Serial.printf("[电源管理] ✅ IMU唤醒配置成功 (GPIO%d)\n", IMU_INT_PIN);
+        }
 
         // 配置IMU
         extern IMU imu;
         if (!imu.configureForDeepSleep())
         {
-            Serial.println("[电源管理] ❌ IMU深度睡眠配置失败");
-            return false;
+            // 中断引脚电平不确定，取消IMU唤醒，只靠电门和定时唤醒
+            Serial.println("[电源管理] ⚠️ IMU深度睡眠配置失败，本次睡眠不使用IMU唤醒");
+            esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT0);
+        }
+        else
+        {
+            Serial.println("[电源管理] ✅ IMU已配置为深度睡眠模式");
         }
-        Serial.println("[电源管理] ✅ IMU已配置为深度睡眠模式");
     }
 #endif
 
     // 3. 配置定时器唤醒（小时）
-    const uint64_t BACKUP_WAKEUP_TIME = 60 * 60 * 1000000ULL;
-    esp_err_t ret = esp_sleep_enable_timer_wakeup(BACKUP_WAKEUP_TIME);
+    // 唤醒风暴暂停先到期时提前唤醒，恢复IMU唤醒后继续睡到备用定时唤醒
+    const uint32_t BACKUP_WAKEUP_SEC = 60 * 60;
+    motionWake.setTimerDeadline(BACKUP_WAKEUP_SEC);
+    esp_err_t ret = esp_sleep_enable_timer_wakeup(motionWake.sleepTimerUs());
     if (ret != ESP_OK)
     {
         Serial.printf("[电源管理] ❌ 定时器唤醒配置失败: %s\n", esp_err_to_name(ret));
@@ -264,30 +457,57 @@ bool PowerManager::configureWakeupSources()
     return true;
 }
 
-void PowerManager::disablePeripherals()
+// 关闭外设的并行任务，各自操作独立的外设
+static bool shutdownRadioJob()
 {
-    // ===== 第一阶段：高级通信协议关闭 =====
-    Serial.println("[电源管理] 开始第一阶段：关闭通信协议...");
-    Serial.flush();
-    delay(50);
-
-    // 1. WiFi关闭
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
-    Serial.println("[电源管理] WiFi已安全关闭");
-    Serial.flush();
-    delay(50);
-
-    // 2. 蓝牙关闭
     btStop();
-    Serial.println("[电源管理] 蓝牙已安全关闭");
-    Serial.flush();
-    delay(50);
+    return true;
+}
 
-    // ===== 第二阶段：外设任务停止 =====
-    Serial.println("[电源管理] 开始第二阶段：停止外设任务...");
-    Serial.flush();
-    delay(50);
+#ifdef MODE_ALLINONE
+static bool shutdownDisplayJob()
+{
+    extern void tft_sleep();
+    tft_sleep();
+
+    // 关闭显示屏相关GPIO
+#ifdef TFT_CS
+    pinMode(TFT_CS, INPUT);
+#endif
+#ifdef TFT_DC
+    pinMode(TFT_DC, INPUT);
+#endif
+#ifdef TFT_RST
+    pinMode(TFT_RST, INPUT);
+#endif
+#ifdef TFT_BL
+    pinMode(TFT_BL, INPUT);
+    digitalWrite(TFT_BL, LOW);
+#endif
+    return true;
+}
+#endif
+
+static uint16_t msSince(int64_t startUs)
+{
+    int64_t ms = (esp_timer_get_time() - startUs) / 1000;
+    return ms > 65535 ? 65535 : (uint16_t)ms;
+}
+
+void PowerManager::disablePeripherals()
+{
+    int64_t start = esp_timer_get_time();
+
+    // ===== 第一阶段：通信和显示并行关闭 =====
+    // 超时后任务仍可能访问，不能放在栈上
+    static BootJob radioJob;
+    radioJob.start("SleepRadio", shutdownRadioJob, 4096);
+#ifdef MODE_ALLINONE
+    static BootJob displayJob;
+    displayJob.start("SleepTFT", shutdownDisplayJob, 4096);
+#endif
 
 #if defined(MODE_ALLINONE) || defined(MODE_SERVER)
     // GPS任务停止
@@ -296,9 +516,6 @@ void PowerManager::disablePeripherals()
     {
         vTaskDelete(gpsTaskHandle);
         gpsTaskHandle = NULL;
-        Serial.println("[电源管理] GPS任务已停止");
-        Serial.flush();
-        delay(50);
     }
 
     // GPS串口关闭
@@ -306,53 +523,42 @@ void PowerManager::disablePeripherals()
     Serial2.end();
     pinMode(GPS_RX_PIN, INPUT);
     pinMode(GPS_TX_PIN, INPUT);
-    Serial.println("[电源管理] GPS串口已关闭");
-    Serial.flush();
-    delay(50);
 #endif
 #endif
 
-    // ===== 第三阶段：显示和LED关闭 =====
-    Serial.println("[电源管理] 开始第三阶段：关闭显示和LED...");
-    Serial.flush();
-    delay(50);
-
+    // ===== 第二阶段：等待并行任务和睡眠提示音 =====
+    if (!radioJob.join(2000))
+    {
+        Serial.println("[电源管理] ⚠️ WiFi/蓝牙关闭超时");
+    }
+    lastShutdown.radioMs = radioJob.elapsedMs();
 #ifdef MODE_ALLINONE
-    extern void tft_sleep();
-    tft_sleep();
-
-    // 关闭显示屏相关GPIO
-#ifdef TFT_CS
-    pinMode(TFT_CS, INPUT);
-#endif
-#ifdef TFT_DC
-    pinMode(TFT_DC, INPUT);
-#endif
-#ifdef TFT_RST
-    pinMode(TFT_RST, INPUT);
-#endif
-#ifdef TFT_BL
-    pinMode(TFT_BL, INPUT);
-    digitalWrite(TFT_BL, LOW);
+    if (!displayJob.join(1000))
+    {
+        Serial.println("[电源管理] ⚠️ 显示屏关闭超时");
+    }
+    lastShutdown.displayMs = displayJob.elapsedMs();
+#else
+    lastShutdown.displayMs = 0;
 #endif
 
-    Serial.println("[电源管理] 显示屏已完全关闭");
-    Serial.flush();
-    delay(50);
+    int64_t stepStart = esp_timer_get_time();
+#ifdef ENABLE_AUDIO
+    // 必须在关闭I2S外设时钟之前播放完
+    if (deviceState.get(&device_state_t::audioReady) && !audioManager.waitUntilIdle(2000))
+    {
+        Serial.println("[电源管理] ⚠️ 音频播放超时，强制停止");
+        audioManager.stop();
+    }
 #endif
+    lastShutdown.audioMs = msSince(stepStart);
 
-    // ===== 第四阶段：传感器和I2C关闭 =====
-    Serial.println("[电源管理] 开始第四阶段：关闭传感器和I2C...");
-    Serial.flush();
-    delay(50);
-
+    // ===== 第三阶段：总线、ADC、按钮和外设时钟 =====
+    stepStart = esp_timer_get_time();
 #if defined(MODE_ALLINONE) || defined(MODE_SERVER)
     // 先关闭I2C总线
     Wire.end();
     Wire1.end();
-    Serial.println("[电源管理] I2C总线已关闭");
-    Serial.flush();
-    delay(50);
 
     // 关闭其他I2C设备的引脚
 #ifdef GPS_COMPASS_SDA
@@ -361,33 +567,9 @@ void PowerManager::disablePeripherals()
 #ifdef GPS_COMPASS_SCL
     pinMode(GPS_COMPASS_SCL, INPUT);
 #endif
-
-    Serial.println("[电源管理] I2C设备已配置为低功耗模式");
-    Serial.flush();
-    delay(50);
 #endif
 
-    // ===== SD卡睡眠准备 =====
-#ifdef ENABLE_SDCARD
-    Serial.println("[电源管理] 开始SD卡睡眠准备...");
-    Serial.flush();
-    delay(50);
-    
-    extern SDManager sdManager;
-    if (sdManager.isInitialized()) {
-        // 记录进入睡眠的日志（简化版）
-        Serial.println("[电源管理] 设备进入深度睡眠模式");
-        // 简化版SD管理器不需要特殊的睡眠准备
-        Serial.println("[电源管理] SD卡已准备进入睡眠");
-    }
-    Serial.flush();
-    delay(50);
-#endif
-
-    // ===== 第五阶段：ADC和按钮配置 =====
-    Serial.println("[电源管理] 开始第五阶段：配置ADC和按钮...");
-    Serial.flush();
-    delay(50);
+    // SD卡写入都是同步完成的，热启动状态已由 warmBoot.prepareForSleep() 保存，不需要额外准备
 
     // ADC配置
     adc1_config_width(ADC_WIDTH_BIT_12);
@@ -402,40 +584,32 @@ void PowerManager::disablePeripherals()
     pinMode(BTN_PIN, INPUT_PULLUP);
 #endif
 
-    Serial.println("[电源管理] ADC和按钮已配置完成");
-    Serial.flush();
-    delay(50);
-
-    // ===== 最后阶段：关闭时钟和降低CPU频率 =====
-    Serial.println("[电源管理] 开始最后阶段：关闭时钟和降低CPU频率...");
-    Serial.flush();
-    delay(100);
-
     // 关闭不必要的外设时钟
     periph_module_disable(PERIPH_LEDC_MODULE);
     periph_module_disable(PERIPH_I2S0_MODULE);
     periph_module_disable(PERIPH_I2S1_MODULE);
     periph_module_disable(PERIPH_UART1_MODULE);
     periph_module_disable(PERIPH_UART2_MODULE);
+    lastShutdown.busMs = msSince(stepStart);
+    lastShutdown.totalMs = msSince(start);
 
-    Serial.println("[电源管理] 外设时钟已关闭，准备进入深度睡眠...");
-    Serial.println("[电源管理] 💤 即将进入深度睡眠模式");
-    Serial.flush();
-    delay(500); // 确保最后的消息能够发送完成
-    
-    // 完全关闭串口以避免乱码
-    Serial.end();
-    
-    // 不降低CPU频率，直接进入深度睡眠
-    // setCpuFrequencyMhz(10); // 注释掉这行，避免串口乱码
+    Serial.printf("[电源管理] ✅ 外设关闭完成，耗时 %u ms（WiFi/蓝牙 %u ms，显示 %u ms，等待音频 %u ms，总线和时钟 %u ms）\n",
+                  lastShutdown.totalMs, lastShutdown.radioMs, lastShutdown.displayMs, lastShutdown.audioMs,
+                  lastShutdown.busMs);
+    // 不降低CPU频率，直接进入深度睡眠，避免串口乱码
 }
 
 void PowerManager::loop()
 {
-    static unsigned long lastMotionCheck = 0;
-    static unsigned long lastVehicleCheck = 0;
     unsigned long now = millis();
 
+    // 倒计时期间每次都检查，其他检测由倒计时自己完成
+    if (stateMachine.mode() == POWER_MODE_SLEEP_COUNTDOWN)
+    {
+        handleCountdown(now);
+        return;
+    }
+
     // 每隔1秒检测一次车辆状态
     if (now - lastVehicleCheck >= 1000)
     {
@@ -444,61 +618,262 @@ void PowerManager::loop()
     }
 
     // 只每隔200ms检测一次运动
-    if (now - lastMotionCheck >= 200)
+    if (now - lastMotionCheck < 200)
     {
-        lastMotionCheck = now;
+        return;
+    }
+    lastMotionCheck = now;
 
-#ifndef ENABLE_SLEEP
-        // 如果编译时禁用了休眠功能，始终保持在正常状态
-        if (powerState != POWER_STATE_NORMAL)
-        {
-            powerState = POWER_STATE_NORMAL;
-        }
+    switch (stateMachine.mode())
+    {
+    case POWER_MODE_ACTIVE:
+        handleActive(now);
+        break;
+    case POWER_MODE_PARKED:
+        handleParked(now);
+        break;
+    default:
+        // WAKING 时初始化未完成，LIGHT_SLEEP/DEEP_SLEEP 期间不会执行到这里
+        break;
+    }
+}
+
+void PowerManager::handleActive(unsigned long now)
+{
+    // 车辆启动时直接刷新运动时间，跳过IMU运动检测
+    if (isVehicleStarted())
+    {
+        lastMotionTime = now;
         return;
+    }
+
+#ifdef ENABLE_IMU
+    if (imu.detectMotion())
+    {
+        lastMotionTime = now;
+        return;
+    }
+
+    // 休眠功能由编译时配置决定（ENABLE_SLEEP），禁用时始终保持 ACTIVE
+    if (sleepEnabled && isDeviceIdle())
+    {
+        Serial.printf("[电源管理] 设备已静止超过%lu秒，准备进入低功耗模式...\n", sleepTimeSec);
+        device_state_t state = deviceState.snapshot();
+        Serial.printf("[电源管理] 电池状态: %d%%, 电压: %dmV\n", state.battery_percentage, state.battery_voltage);
+
+#if PARKED_LIGHT_SLEEP_ENABLED
+        enterParkedMode();
 #else
+        enterLowPowerMode();
+#endif
+    }
+#endif
+}
+
+void PowerManager::enterParkedMode()
+{
+#ifdef MODE_CLIENT
+    return;
+#endif
+    if (!postEvent(POWER_EVENT_IDLE_TIMEOUT))
+    {
+        return;
+    }
+
+    parkedSince = millis();
+    checkinStart = parkedSince; // 先保持一个上报窗口，上报驻车位置
+    parkedCheckins = 0;
+
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    // IMU切到WOM，浅睡眠期间由中断引脚唤醒
+    imuParked = imu.configureForDeepSleep();
+    if (!imuParked)
+    {
+        Serial.println("[电源管理] ⚠️ IMU WOM配置失败，驻车期间依靠定时唤醒检测运动");
+    }
+#endif
 
-        // 优化：当车辆启动时，跳过IMU运动检测
+    Serial.printf("[电源管理] 🅿️ 进入驻车模式，每%d秒唤醒上报位置，%d秒后转入深度睡眠\n",
+                  PARKED_CHECKIN_INTERVAL_SEC, PARKED_DEEP_SLEEP_AFTER_SEC);
+}
+
+void PowerManager::leaveParkedMode()
+{
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    if (imuParked)
+    {
+        imu.restoreFromDeepSleep();
+        imuParked = false;
+    }
+#endif
+}
+
+void PowerManager::handleParked(unsigned long now)
+{
+    // 电门开启由 handleVehicleStateChange() 处理
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    // WOM中断引脚被拉低表示有运动
+    if (imuParked ? digitalRead(IMU_INT_PIN) == LOW : imu.detectMotion())
+    {
+        interruptLowPowerMode(POWER_EVENT_MOTION);
+        return;
+    }
+#endif
+
+    // 驻车时间到，转入深度睡眠流程（倒计时期间仍可被运动打断）
+    unsigned long parkedMs = now - parkedSince;
+    if (parkedMs >= PARKED_DEEP_SLEEP_AFTER_SEC * 1000UL)
+    {
+        Serial.printf("[电源管理] 驻车已超过%d秒，共上报%lu次，转入深度睡眠\n",
+                      PARKED_DEEP_SLEEP_AFTER_SEC, parkedCheckins);
+        enterLowPowerMode();
+        return;
+    }
+
+    // 上报窗口内保持唤醒，让数据任务通过4G模块发送位置
+    if (now - checkinStart < PARKED_CHECKIN_WINDOW_MS || !canLightSleep())
+    {
+        return;
+    }
+
+    unsigned long sleepMs = PARKED_CHECKIN_INTERVAL_SEC * 1000UL - PARKED_CHECKIN_WINDOW_MS;
+    unsigned long remainingMs = PARKED_DEEP_SLEEP_AFTER_SEC * 1000UL - parkedMs;
+    lightSleepUntilCheckin(sleepMs < remainingMs ? sleepMs : remainingMs);
+}
+
+bool PowerManager::canLightSleep()
+{
+    // 有BLE连接或WiFi开启（配网中）时保持唤醒，浅睡眠会中断无线连接
+    if (deviceState.get(&device_state_t::bleConnected) || WiFi.getMode() != WIFI_OFF)
+    {
+        return false;
+    }
+    // 音频播放、4G模块串口收发等持有 NO_LIGHT_SLEEP 锁
+    if (!powerLocks.lightSleepAllowed())
+    {
+        return false;
+    }
+#ifdef ENABLE_AUDIO
+    // 已入队但音频任务还没开始播放的请求也要等，否则浅睡眠会把它推迟到唤醒之后
+    if (audioManager.isBusy())
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+
+void PowerManager::lightSleepUntilCheckin(unsigned long sleepMs)
+{
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+
+    // IMU WOM、电门、按钮均为低电平有效；IMU的ISR在电平唤醒期间先解除
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    if (imuParked)
+    {
+        detachInterrupt(IMU_INT_PIN);
+        gpio_wakeup_enable((gpio_num_t)IMU_INT_PIN, GPIO_INTR_LOW_LEVEL);
+    }
+#endif
 #ifdef RTC_INT_PIN
-        bool vehicle_started = (digitalRead(RTC_INT_PIN) == LOW);
-        if (vehicle_started) {
-            // 车辆启动时，直接更新运动时间，跳过IMU检测
-            lastMotionTime = millis();
-            if (powerState != POWER_STATE_NORMAL) {
-                powerState = POWER_STATE_NORMAL;
-                Serial.println("[电源管理] 车辆启动，设备保持正常工作状态");
-            }
-            return; // 直接返回，跳过后续的IMU运动检测
-        }
+    gpio_wakeup_enable((gpio_num_t)RTC_INT_PIN, GPIO_INTR_LOW_LEVEL);
 #endif
+#ifdef BTN_PIN
+    gpio_wakeup_enable((gpio_num_t)BTN_PIN, GPIO_INTR_LOW_LEVEL);
+#endif
+    esp_sleep_enable_gpio_wakeup();
 
-#ifdef ENABLE_IMU
-        // 仅在正常工作状态下且车辆未启动时检测运动和空闲状态
-        if (powerState == POWER_STATE_NORMAL)
-        {
-            // 检测设备是否有运动
-            if (imu.detectMotion())
-            {
-                // 如果有运动，更新最后一次运动时间
-                lastMotionTime = millis();
-            }
-            else
-            {
-                // 检查设备是否空闲足够长的时间
-                if (isDeviceIdle())
-                {
-                    Serial.printf("[电源管理] 设备已静止超过%lu秒，准备进入低功耗模式...\n", sleepTimeSec);
-                    Serial.printf("[电源管理] 电池状态: %d%%, 电压: %dmV\n",
-                                  get_device_state()->battery_percentage,
-                                  get_device_state()->battery_voltage);
+#ifdef USE_AIR780EG_GSM
+    // 4G模块下发数据（MQTT控制命令）时唤醒，触发唤醒的前几个字符会丢失
+    uart_set_wakeup_threshold(UART_NUM_1, 3);
+    esp_sleep_enable_uart_wakeup(UART_NUM_1);
+#endif
 
-                    enterLowPowerMode();
-                }
-            }
+    postEvent(POWER_EVENT_LIGHT_SLEEP);
+    logFlush();
+    Serial.flush();
+
+    // canLightSleep() 之后刷新日志要几十毫秒，数据任务、音频任务可能已经开始收发：
+    // 持有电源锁互斥量再确认一次，直到唤醒前其他任务不能再持锁
+    bool slept = false;
+    if (powerLocks.beginLightSleep())
+    {
+#ifdef ENABLE_AUDIO
+        slept = !audioManager.isBusy();
+#else
+        slept = true;
+#endif
+        if (slept)
+        {
+            uint8_t cpuState = powerAccounting.state(PA_CPU);
+            powerAccounting.setState(PA_CPU, PA_CPU_SLEEP);
+            esp_light_sleep_start();
+            powerAccounting.setState(PA_CPU, cpuState);
         }
+        powerLocks.endLightSleep();
+    }
+
+    esp_sleep_wakeup_cause_t cause = slept ? esp_sleep_get_wakeup_cause() : ESP_SLEEP_WAKEUP_UNDEFINED;
+    bool imuWake = false;
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    if (imuParked)
+    {
+        imuWake = digitalRead(IMU_INT_PIN) == LOW;
+        gpio_wakeup_disable((gpio_num_t)IMU_INT_PIN);
+        attachInterrupt(IMU_INT_PIN, IMU::motionISR, CHANGE);
+    }
+#endif
+#ifdef RTC_INT_PIN
+    gpio_wakeup_disable((gpio_num_t)RTC_INT_PIN);
 #endif
+#ifdef BTN_PIN
+    gpio_wakeup_disable((gpio_num_t)BTN_PIN);
+    bool buttonWake = digitalRead(BTN_PIN) == LOW;
+#else
+    bool buttonWake = false;
 #endif
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+
+    if (!slept)
+    {
+        // 回到驻车模式，不重新开始上报窗口，模块空闲后 handleParked() 再尝试
+        Serial.println("[电源管理] 浅睡眠前有模块开始工作，取消本次浅睡眠");
+        postEvent(POWER_EVENT_TIMER_WAKE);
+        return;
+    }
+
+    switch (cause)
+    {
+    case ESP_SLEEP_WAKEUP_TIMER:
+        parkedCheckins++;
+        checkinStart = millis();
+        postEvent(POWER_EVENT_TIMER_WAKE);
+        break;
+    case ESP_SLEEP_WAKEUP_UART:
+        checkinStart = millis();
+        postEvent(POWER_EVENT_MODEM_DATA);
+        break;
+    case ESP_SLEEP_WAKEUP_GPIO:
+        if (isVehicleStarted())
+        {
+            interruptLowPowerMode(POWER_EVENT_IGNITION_ON);
+        }
+        else if (buttonWake && !imuWake)
+        {
+            interruptLowPowerMode(POWER_EVENT_USER);
+        }
+        else
+        {
+            // WOM脉冲可能在唤醒后已结束，其余GPIO唤醒都按运动处理
+            interruptLowPowerMode(POWER_EVENT_MOTION);
+        }
+        break;
+    default:
+        checkinStart = millis();
+        postEvent(POWER_EVENT_TIMER_WAKE);
+        break;
     }
-    // 其他低频逻辑可以继续执行
 }
 
 bool PowerManager::isDeviceIdle()
@@ -525,76 +900,128 @@ void PowerManager::enterLowPowerMode()
         return;
     }
 
-    Serial.println("[电源管理] 正在进入低功耗模式...");
-    powerState = POWER_STATE_COUNTDOWN;
+    // ACTIVE -> PARKED -> COUNTDOWN；驻车模式超时后直接从 PARKED 开始
+    if (stateMachine.mode() == POWER_MODE_ACTIVE)
+    {
+        postEvent(POWER_EVENT_IDLE_TIMEOUT);
+    }
+    if (!postEvent(POWER_EVENT_SLEEP_START))
+    {
+        Serial.printf("[电源管理] 当前状态 %s 不能进入低功耗模式\n", powerModeName(stateMachine.mode()));
+        return;
+    }
 
-    // 倒计时总时间（秒）
-    const int countdownTime = 10;
+    // 倒计时由 loop() 推进，期间串口命令、按钮、电池采样照常处理
+    countdownStart = millis();
+    countdownShown = -1;
+    Serial.printf("[电源管理] %d秒倒计时开始，如有动作、电门开启或按钮按下将取消进入低功耗模式...\n",
+                  SLEEP_COUNTDOWN_SEC);
+#endif
+}
 
-// 添加UI提示
-#ifdef MODE_ALLINONE
-    // 保存当前亮度设置
-    static const int maxBrightness = 255;
+void PowerManager::handleCountdown(unsigned long now)
+{
+    // 每次 loop() 都检查取消条件，在一个周期内生效
+    PowerEvent cancel = POWER_EVENT_COUNT;
+    if (isVehicleStarted())
+    {
+        cancel = POWER_EVENT_IGNITION_ON;
+    }
+#ifdef BTN_PIN
+    else if (digitalRead(BTN_PIN) == LOW)
+    {
+        cancel = POWER_EVENT_USER;
+    }
+#endif
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+    else if (imuParked)
+    {
+        // WOM中断引脚被拉低表示有运动
+        if (digitalRead(IMU_INT_PIN) == LOW)
+        {
+            cancel = POWER_EVENT_MOTION;
+        }
+    }
+#endif
+#ifdef ENABLE_IMU
+    // 运动检测按 imu.loop() 的数据更新周期采样，重复的样本会拉低平均变化量
+    else if (now - lastMotionCheck >= 10)
+    {
+        lastMotionCheck = now;
+        if (imu.detectMotion())
+        {
+            cancel = POWER_EVENT_MOTION;
+        }
+    }
 #endif
 
-    // 添加10秒倒计时
-    Serial.println("[电源管理] 10秒倒计时开始，如有动作或按钮按下将取消进入低功耗模式...");
+    unsigned long elapsed = now - countdownStart;
+    if (cancel != POWER_EVENT_COUNT)
+    {
+        Serial.printf("[电源管理] 收到打断请求 (%s)，取消进入低功耗模式，倒计时已进行 %lu ms\n",
+                      powerEventName(cancel), elapsed);
+        interruptLowPowerMode(cancel);
+        return;
+    }
 
-    for (int i = countdownTime; i > 0; i--)
+    if (elapsed >= SLEEP_COUNTDOWN_SEC * 1000UL)
     {
-        Serial.printf("[电源管理] 倒计时: %d 秒\n", i);
+        enterDeepSleep();
+        return;
+    }
 
+    int remaining = SLEEP_COUNTDOWN_SEC - (int)(elapsed / 1000);
+    if (remaining != countdownShown)
+    {
+        countdownShown = remaining;
+        Serial.printf("[电源管理] 倒计时: %d 秒\n", remaining);
 // 设置屏幕亮度，逐渐降低
 #ifdef MODE_ALLINONE
-        int brightness = map(i, countdownTime, 1, maxBrightness, maxBrightness / 10);
+        int brightness = map(remaining, SLEEP_COUNTDOWN_SEC, 1, COUNTDOWN_MAX_BRIGHTNESS, COUNTDOWN_MAX_BRIGHTNESS / 10);
         tft_set_brightness(brightness);
-        Serial.printf("[电源管理] 屏幕亮度设置为 %d/%d\n", brightness, maxBrightness);
 #endif
-
-        // 使用更小的时间间隔检查中断请求，提高响应速度
-        unsigned long countdownStartTime = millis();
-        while (millis() - countdownStartTime < 1000)
-        { // 每秒分为多个小间隔检查
-            // 检查是否已请求打断
-            if (imu.detectMotion())
-            {
-                Serial.println("[电源管理] 收到打断请求，取消进入低功耗模式");
-                interruptLowPowerMode();
-                // 恢复屏幕亮度到最大
-#ifdef MODE_ALLINONE
-                tft_set_brightness(maxBrightness);
-                Serial.println("[电源管理] 恢复屏幕亮度到最大");
-#endif
-
-// 恢复屏幕亮度到最大
-#ifdef MODE_ALLINONE
-                tft_set_brightness(maxBrightness);
-                Serial.println("[电源管理] 恢复屏幕亮度到最大");
-#endif
-                return; // 退出函数，不进入低功耗模式
-            }
-
-            delay(10); // 小间隔检查，更快响应
-        }
     }
+}
 
-    // 设置电源状态为准备睡眠
-    powerState = POWER_STATE_PREPARING_SLEEP;
-
+void PowerManager::enterDeepSleep()
+{
+#ifdef ENABLE_SLEEP
     // 1. 先配置唤醒源（在关闭外设之前）
     Serial.println("[电源管理] ⏸️ 配置唤醒源...");
     if (!configureWakeupSources())
     {
         Serial.println("[电源管理] ❌ 唤醒源配置失败，终止休眠流程");
-        powerState = POWER_STATE_NORMAL;
+        interruptLowPowerMode(POWER_EVENT_SLEEP_ABORT);
         return;
     }
     Serial.println("[电源管理] ✅ 唤醒源配置完成");
 
+    // COUNTDOWN -> DEEP_SLEEP，此后不再返回，迁移记录在唤醒后仍可查看
+    postEvent(POWER_EVENT_SLEEP_COMMIT);
+
+    // 保存热启动状态，唤醒后据此跳过重复初始化
+#ifdef USE_AIR780EG_GSM
+    if (air780eg.getGNSS().isDataValid())
+    {
+        warmBoot.setLastFix(air780eg.getGNSS().gnss_data.latitude, air780eg.getGNSS().gnss_data.longitude,
+                            air780eg.getGNSS().gnss_data.altitude);
+    }
+#endif
+    warmBoot.prepareForSleep();
+    powerAccounting.prepareForSleep();
+
+#ifdef ENABLE_AUDIO
+    // 播放睡眠模式音频提示（高优先级会压低正在播放的提示音），与关闭外设同时进行，
+    // disablePeripherals() 在关闭I2S外设之前等待播放结束
+    if (deviceState.get(&device_state_t::audioReady) && AUDIO_SLEEP_MODE_ENABLED) {
+        Serial.println("[电源管理] 播放睡眠模式音频提示");
+        audioManager.playSleepModeSound();
+    }
+#endif
+
     // 2. 关闭外设
     Serial.println("[电源管理] ⏸️ 开始关闭外设...");
     disablePeripherals();
-    Serial.println("[电源管理] ✅ 外设关闭完成");
 
     // 3. 配置电源域
     Serial.println("[电源管理] ⏸️ 配置电源域...");
@@ -603,38 +1030,49 @@ void PowerManager::enterLowPowerMode()
 
     // 4. 最后的准备和信息输出
     Serial.println("[电源管理] 🌙 准备进入深度睡眠...");
-    
-#ifdef ENABLE_AUDIO
-    // 播放睡眠模式音频提示
-    if (device_state.audioReady && AUDIO_SLEEP_MODE_ENABLED) {
-        Serial.println("[电源管理] 播放睡眠模式音频提示");
-        audioManager.playSleepModeSound();
-        delay(1000); // 等待音频播放完成
-    }
-#endif
 
 #if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
     Serial.printf("[电源管理] - IMU中断引脚: GPIO%d\n", IMU_INT_PIN);
 #endif
     Serial.printf("[电源管理] - 定时器唤醒: 1小时\n");
-    Serial.println("[电源管理] - 系统将在3秒后进入深度睡眠");
+
+#if SLEEP_MONITOR_ENABLED
+    // ULP 放在最后启动：它在主CPU醒着时触发唤醒会直接停止，不能让关闭外设期间的电门变化把监测用掉
+    // 低电量已由 BAT 上报过的本次睡眠不再用低电量唤醒
+#ifdef BAT_PIN
+    bool lowReported = bat.isLow();
+    bat.end();  // 停止后台采样，ADC交给ULP
+#else
+    bool lowReported = false;
+#endif
+    if (!sleepMonitor.arm(lowReported))
+    {
+        Serial.println("[电源管理] 深度睡眠监测未启动，仅使用IMU和定时器唤醒");
+    }
+#endif
+    // 输出缓冲区中的日志，等待串口输出完成后关闭，避免乱码
+    logFlush();
     Serial.flush();
-    
-    // 给足够时间让串口输出完成
-    delay(3000);
-    
-    // 最后关闭串口
     Serial.end();
 
     // 5. 进入深度睡眠
+    trace.instant(TRACE_ID_DEEP_SLEEP, (uint16_t)(lastShutdown.totalMs));
     esp_deep_sleep_start();
 #endif
 }
 
-void PowerManager::interruptLowPowerMode()
+void PowerManager::interruptLowPowerMode(PowerEvent reason)
 {
-    // 重置电源状态
-    powerState = POWER_STATE_NORMAL;
+#ifdef MODE_ALLINONE
+    if (stateMachine.mode() == POWER_MODE_SLEEP_COUNTDOWN)
+    {
+        // 恢复倒计时期间降低的屏幕亮度
+        tft_set_brightness(COUNTDOWN_MAX_BRIGHTNESS);
+    }
+#endif
+    // PARKED/LIGHT_SLEEP/COUNTDOWN -> ACTIVE
+    postEvent(reason);
+    leaveParkedMode();
     // 重置运动检测窗口时间
     lastMotionTime = millis();
 }
@@ -699,31 +1137,35 @@ bool PowerManager::isVehicleStarted()
 void PowerManager::handleVehicleStateChange()
 {
 #ifdef RTC_INT_PIN
-    static bool last_vehicle_state = false;
-    static bool first_check = true;
     bool current_vehicle_state = isVehicleStarted();
     
     // 首次检查时记录当前状态，但不输出变化日志
-    if (first_check) {
-        last_vehicle_state = current_vehicle_state;
-        first_check = false;
+    if (!vehicleStateKnown) {
+        lastVehicleState = current_vehicle_state;
+        vehicleStateKnown = true;
         if (current_vehicle_state) {
             Serial.println("[电源管理] 🚗 检测到车辆电门已启动");
+            // 电门唤醒或上电时已打开，从这里开始统计本次骑行
+            powerAccounting.startTrip();
             Serial.println("[电源管理] 将跳过IMU运动检测，直接保持活跃状态");
         }
         return;
     }
     
-    if (current_vehicle_state != last_vehicle_state) {
+    if (current_vehicle_state != lastVehicleState) {
         if (current_vehicle_state) {
             Serial.println("[电源管理] 🚗 车辆电门启动检测到！");
             Serial.println("[电源管理] 设备将保持活跃状态");
             Serial.println("[电源管理] ⚡ 优化：跳过IMU运动检测，节省CPU资源");
             // 重置运动时间，防止进入休眠
             lastMotionTime = millis();
+            // 开始新的一次骑行，重新统计各频率停留时间和各子系统耗电
+            powerLocks.resetStats();
+            powerAccounting.startTrip();
             // 如果正在倒计时，取消进入休眠
-            if (powerState == POWER_STATE_COUNTDOWN) {
-                interruptLowPowerMode();
+            if (stateMachine.mode() == POWER_MODE_PARKED || stateMachine.mode() == POWER_MODE_LIGHT_SLEEP ||
+                stateMachine.mode() == POWER_MODE_SLEEP_COUNTDOWN) {
+                interruptLowPowerMode(POWER_EVENT_IGNITION_ON);
                 Serial.println("[电源管理] 车辆启动，取消休眠倒计时");
             }
         } else {
@@ -732,8 +1174,13 @@ void PowerManager::handleVehicleStateChange()
             Serial.println("[电源管理] ⚡ 恢复：重新启用IMU运动检测");
             // 重置运动时间，开始新的空闲计时
             lastMotionTime = millis();
+            postEvent(POWER_EVENT_IGNITION_OFF);
+            // 输出本次骑行的调频统计和耗电
+            powerLocks.printStats();
+            powerAccounting.endTrip();
+            powerAccounting.printSummary(true);
         }
-        last_vehicle_state = current_vehicle_state;
+        lastVehicleState = current_vehicle_state;
     }
 #endif
 }
@@ -780,7 +1227,7 @@ void PowerManager::printWakeupReason()
         Serial.println("[系统] 从触摸唤醒");
         break;
     case ESP_SLEEP_WAKEUP_ULP:
-        Serial.println("[系统] 从ULP唤醒");
+        Serial.printf("[系统] 从ULP唤醒，原因: %s\n", sleepWakeReasonName(sleepMonitor.wakeReason()));
         break;
     default:
         Serial.printf("[系统] 从非深度睡眠唤醒，原因代码: %d\n", wakeup_reason);
@@ -846,7 +1293,7 @@ void PowerManager::checkWakeupCause()
 // 新增：设置休眠时间（秒），并保存到存储，同时更新设备状态，重新计时休眠
 void PowerManager::setSleepTime(unsigned long seconds)
 {
-    get_device_state()->sleep_time = seconds; // 更新设备状态
+    deviceState.set(DS_SLEEP_TIME, &device_state_t::sleep_time, seconds); // 更新设备状态
     sleepTimeSec = seconds;
     idleThreshold = sleepTimeSec * 1000;
     lastMotionTime = millis(); // 新增：重置空闲计时
@@ -857,9 +1304,10 @@ void PowerManager::setSleepTime(unsigned long seconds)
 // 新增：获取休眠时间（秒）
 unsigned long PowerManager::getSleepTime() const
 {
-    if (get_device_state()->sleep_time != sleepTimeSec)
+    int deviceSleepTime = deviceState.get(&device_state_t::sleep_time);
+    if ((unsigned long)deviceSleepTime != sleepTimeSec)
     {
-        Serial.printf("[电源管理] 出现问题：休眠时间不一致 %lu 秒，device: %lu 秒\n", sleepTimeSec, get_device_state()->sleep_time);
+        Serial.printf("[电源管理] 出现问题：休眠时间不一致 %lu 秒，device: %d 秒\n", sleepTimeSec, deviceSleepTime);
     }
     return sleepTimeSec;
 }
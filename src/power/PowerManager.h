@@ -9,25 +9,26 @@
 #include "imu/qmi8658.h"
 #include "utils/PreferencesUtils.h"
 #include "config.h"
+#include "PowerStateMachine.h"
+#include "PowerLocks.h"
 
 #ifdef ENABLE_SDCARD
 #include "SD/SDManager.h"
 #endif
 
-// 低功耗模式状态枚举
-enum PowerState {
-    POWER_STATE_NORMAL,           // 正常工作状态
-    POWER_STATE_COUNTDOWN,        // 倒计时状态
-    POWER_STATE_PREPARING_SLEEP   // 正在准备进入睡眠状态
-};
-
 class PowerManager {
 public:
     PowerManager();
-    PowerState powerState;        // 当前电源状态
     void begin();
     void loop();
-    bool requestLowPowerMode;
+
+    /**
+     * @brief 深度睡眠被 IMU 误唤醒时直接回到睡眠，在 setup() 最前面调用
+     * 真实运动、其他唤醒原因或判定失败时返回，继续完整启动
+     */
+    void filterMotionWakeup();
+
+    // 开始深度睡眠倒计时，立即返回；倒计时由 loop() 推进
     void enterLowPowerMode();
     bool configureWakeupSources();
     bool isDeviceIdle();
@@ -36,8 +37,16 @@ public:
     void setSleepTime(unsigned long seconds);
     unsigned long getSleepTime() const;
     
-    // 新增：获取当前电源状态
-    PowerState getPowerState() { return powerState; }
+    // 获取当前电源状态
+    PowerMode getPowerMode() const { return stateMachine.mode(); }
+    PowerWakeSource getWakeSource() const { return stateMachine.wakeSource(); }
+
+    // 初始化完成，记录本次唤醒到就绪的耗时（在 setup() 末尾调用）
+    void markSystemReady();
+
+    // 打印状态、迁移日志和各唤醒源的唤醒耗时
+    void printPowerStatus();
+    void printTransitionLog();
 
     // 检查休眠功能是否启用（由编译时配置决定）
     bool isSleepEnabled() { return sleepEnabled; }
@@ -46,8 +55,8 @@ public:
     void printWakeupReason();
     void checkWakeupCause();
 
-     // 新增：打断低功耗模式进入过程
-    void interruptLowPowerMode();
+    // 打断低功耗模式进入过程
+    void interruptLowPowerMode(PowerEvent reason = POWER_EVENT_USER);
 
     // 新增：GPIO39稳定性检查
     bool checkGPIO39Stability();
@@ -67,13 +76,38 @@ private:
     static const int SAMPLE_COUNT = 5;  // 运动检测采样次数
     float accumulatedDelta;      // 累积变化量
     
-    void disablePeripherals();    // 关闭外设
+    void disablePeripherals();    // 关闭外设（通信和显示并行关闭，各阶段计时）
     void handleWakeup();          // 处理唤醒事件
     void configurePowerDomains(); // 配置电源域
+    void resleepAfterFalseWake(); // 误唤醒后按原唤醒源回到深度睡眠
+    bool postEvent(PowerEvent event); // 向状态机提交事件，发生迁移时打印
+    void handleActive(unsigned long now);
+    void handleParked(unsigned long now);
+    void handleCountdown(unsigned long now);  // 休眠倒计时，每次 loop() 检查取消条件
+    void enterDeepSleep();                    // 倒计时结束：配置唤醒源、关闭外设、进入深度睡眠
+    void enterParkedMode();           // ACTIVE -> PARKED，IMU切到WOM
+    void leaveParkedMode();           // 恢复IMU正常模式
+    bool canLightSleep();
+    void lightSleepUntilCheckin(unsigned long sleepMs);
+    PowerWakeSource detectWakeSource(esp_sleep_wakeup_cause_t cause);
 
+    PowerStateMachine stateMachine;
     unsigned long lastMotionTime; // 最后一次检测到运动的时间
     unsigned long sleepTimeSec;   // 休眠时间（秒）
-   
+    unsigned long lastMotionCheck;
+    unsigned long lastVehicleCheck;
+    bool lastVehicleState;        // 上一次检测到的电门状态
+    bool vehicleStateKnown;       // 是否已完成首次电门检测
+
+    // 驻车模式
+    unsigned long parkedSince;    // 进入驻车的时间
+    unsigned long checkinStart;   // 本次上报窗口开始时间
+    unsigned long parkedCheckins; // 本次驻车的定时上报次数
+    bool imuParked;               // IMU是否处于WOM模式
+
+    // 休眠倒计时
+    unsigned long countdownStart;
+    int countdownShown;           // 已输出的剩余秒数
 };
 
 extern PowerManager powerManager;
@@ -0,0 +1,250 @@
+#ifndef POWER_STATE_MACHINE_H
+#define POWER_STATE_MACHINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * 电源状态机核心
+ *
+ * 状态迁移完全由常量表 {当前状态, 事件} -> 新状态 决定，表中没有的组合直接忽略，
+ * 休眠策略的调整只需要改表。每次迁移写入环形日志（启动序号、时间戳、前后状态、
+ * 触发事件）；日志和唤醒耗时统计放在同一个结构体里，由调用方放到 RTC 内存中，
+ * 深度睡眠前的最后几次迁移在唤醒后仍然可以查看。
+ * 状态迁移的仿真见 tools/power_fsm_sim.cpp。
+ */
+
+#define POWER_LOG_SIZE      16           // 迁移日志条数
+#define POWER_LOG_MAGIC     0x50534D31   // "PSM1"，RTC 内存内容无效时重新初始化
+
+// 电源状态
+enum PowerMode : uint8_t {
+    POWER_MODE_WAKING = 0,      // 上电或唤醒后初始化中
+    POWER_MODE_ACTIVE,          // 正常工作（电门开启或有运动）
+    POWER_MODE_PARKED,          // 驻车：电门关闭且静止，准备休眠
+    POWER_MODE_LIGHT_SLEEP,     // 浅睡眠：驻车期间的间歇睡眠
+    POWER_MODE_DEEP_SLEEP,      // 深度睡眠，只能通过唤醒重新启动
+    POWER_MODE_SLEEP_COUNTDOWN, // 进入深度睡眠前的倒计时，运动、电门、按钮可取消
+    POWER_MODE_COUNT
+};
+
+// 触发迁移的事件，同时作为迁移日志中的原因
+enum PowerEvent : uint8_t {
+    POWER_EVENT_READY = 0,      // 初始化完成
+    POWER_EVENT_MOTION,         // 检测到运动
+    POWER_EVENT_IGNITION_ON,    // 电门开启
+    POWER_EVENT_IGNITION_OFF,   // 电门关闭
+    POWER_EVENT_IDLE_TIMEOUT,   // 静止超过休眠时间
+    POWER_EVENT_USER,           // 用户操作（按钮、串口、BLE命令）
+    POWER_EVENT_LIGHT_SLEEP,    // 进入浅睡眠
+    POWER_EVENT_TIMER_WAKE,     // 浅睡眠定时唤醒（位置上报）
+    POWER_EVENT_MODEM_DATA,     // 浅睡眠期间4G模块下发数据
+    POWER_EVENT_SLEEP_COMMIT,   // 休眠准备完成，进入深度睡眠
+    POWER_EVENT_SLEEP_ABORT,    // 休眠准备失败（唤醒源配置失败等）
+    POWER_EVENT_SLEEP_START,    // 开始深度睡眠倒计时
+    POWER_EVENT_COUNT
+};
+
+// 唤醒源，决定唤醒耗时记在哪一项统计里
+enum PowerWakeSource : uint8_t {
+    POWER_WAKE_POWER_ON = 0,    // 上电或复位
+    POWER_WAKE_IGNITION,        // 电门（EXT1）
+    POWER_WAKE_MOTION,          // IMU运动中断（EXT0）
+    POWER_WAKE_TIMER,           // 定时器
+    POWER_WAKE_MONITOR,         // 深度睡眠监测（ULP）：低电量、防拆
+    POWER_WAKE_OTHER,
+    POWER_WAKE_SOURCE_COUNT
+};
+
+struct PowerTransition {
+    PowerMode from;
+    PowerEvent event;
+    PowerMode to;
+};
+
+// 迁移表：同一 {from, event} 只能出现一次
+static const PowerTransition POWER_TRANSITIONS[] = {
+    {POWER_MODE_WAKING,      POWER_EVENT_READY,        POWER_MODE_ACTIVE},
+
+    {POWER_MODE_ACTIVE,      POWER_EVENT_IDLE_TIMEOUT, POWER_MODE_PARKED},
+
+    {POWER_MODE_PARKED,      POWER_EVENT_MOTION,       POWER_MODE_ACTIVE},
+    {POWER_MODE_PARKED,      POWER_EVENT_IGNITION_ON,  POWER_MODE_ACTIVE},
+    {POWER_MODE_PARKED,      POWER_EVENT_USER,         POWER_MODE_ACTIVE},
+    {POWER_MODE_PARKED,      POWER_EVENT_LIGHT_SLEEP,  POWER_MODE_LIGHT_SLEEP},
+    {POWER_MODE_PARKED,      POWER_EVENT_SLEEP_START,  POWER_MODE_SLEEP_COUNTDOWN},
+
+    {POWER_MODE_SLEEP_COUNTDOWN, POWER_EVENT_MOTION,       POWER_MODE_ACTIVE},
+    {POWER_MODE_SLEEP_COUNTDOWN, POWER_EVENT_IGNITION_ON,  POWER_MODE_ACTIVE},
+    {POWER_MODE_SLEEP_COUNTDOWN, POWER_EVENT_USER,         POWER_MODE_ACTIVE},
+    {POWER_MODE_SLEEP_COUNTDOWN, POWER_EVENT_SLEEP_ABORT,  POWER_MODE_ACTIVE},
+    {POWER_MODE_SLEEP_COUNTDOWN, POWER_EVENT_SLEEP_COMMIT, POWER_MODE_DEEP_SLEEP},
+
+    {POWER_MODE_LIGHT_SLEEP, POWER_EVENT_TIMER_WAKE,   POWER_MODE_PARKED},
+    {POWER_MODE_LIGHT_SLEEP, POWER_EVENT_MODEM_DATA,   POWER_MODE_PARKED},
+    {POWER_MODE_LIGHT_SLEEP, POWER_EVENT_MOTION,       POWER_MODE_ACTIVE},
+    {POWER_MODE_LIGHT_SLEEP, POWER_EVENT_IGNITION_ON,  POWER_MODE_ACTIVE},
+    {POWER_MODE_LIGHT_SLEEP, POWER_EVENT_USER,         POWER_MODE_ACTIVE},
+};
+
+static const size_t POWER_TRANSITION_COUNT = sizeof(POWER_TRANSITIONS) / sizeof(POWER_TRANSITIONS[0]);
+
+// 一条迁移记录，8 字节
+struct PowerTransitionRecord {
+    uint32_t timestampMs;   // 本次启动后的毫秒数
+    uint16_t bootIndex;     // 启动序号，区分跨深度睡眠的记录
+    uint8_t from;
+    uint8_t to : 4;
+    uint8_t event : 4;
+};
+
+// 单个唤醒源的唤醒到就绪耗时统计
+struct PowerWakeLatency {
+    uint32_t count;
+    uint32_t lastMs;
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t totalMs;
+};
+
+// 需要跨深度睡眠保留的全部数据
+struct PowerStateLog {
+    uint32_t magic;
+    uint16_t bootIndex;
+    uint8_t head;           // 下一条记录写入位置
+    uint8_t count;
+    PowerTransitionRecord records[POWER_LOG_SIZE];
+    PowerWakeLatency latency[POWER_WAKE_SOURCE_COUNT];
+};
+
+static inline const char* powerModeName(PowerMode mode) {
+    static const char* const names[POWER_MODE_COUNT] = {
+        "WAKING", "ACTIVE", "PARKED", "LIGHT_SLEEP", "DEEP_SLEEP", "COUNTDOWN"
+    };
+    return mode < POWER_MODE_COUNT ? names[mode] : "?";
+}
+
+static inline const char* powerEventName(PowerEvent event) {
+    static const char* const names[POWER_EVENT_COUNT] = {
+        "ready", "motion", "ignition_on", "ignition_off", "idle_timeout",
+        "user", "light_sleep", "timer_wake", "modem_data", "sleep_commit", "sleep_abort",
+        "sleep_start"
+    };
+    return event < POWER_EVENT_COUNT ? names[event] : "?";
+}
+
+static inline const char* powerWakeSourceName(PowerWakeSource source) {
+    static const char* const names[POWER_WAKE_SOURCE_COUNT] = {
+        "power_on", "ignition", "motion", "timer", "monitor", "other"
+    };
+    return source < POWER_WAKE_SOURCE_COUNT ? names[source] : "?";
+}
+
+/**
+ * @brief 查表得到迁移目标
+ * @param from 当前状态
+ * @param event 事件
+ * @param to 输出目标状态
+ * @return 表中有此迁移时返回 true
+ */
+static inline bool powerLookupTransition(PowerMode from, PowerEvent event, PowerMode& to) {
+    for (size_t i = 0; i < POWER_TRANSITION_COUNT; i++) {
+        if (POWER_TRANSITIONS[i].from == from && POWER_TRANSITIONS[i].event == event) {
+            to = POWER_TRANSITIONS[i].to;
+            return true;
+        }
+    }
+    return false;
+}
+
+class PowerStateMachine {
+public:
+    PowerStateMachine() : log(NULL), current(POWER_MODE_WAKING), source(POWER_WAKE_POWER_ON), enteredMs(0) {}
+
+    /**
+     * @brief 开始一次启动周期，进入 WAKING
+     * @param store 日志存储，魔数不对时清空（首次上电或 RTC 内存损坏）
+     * @param wakeSource 本次启动的唤醒源
+     * @param nowMs 当前时间
+     */
+    void begin(PowerStateLog* store, PowerWakeSource wakeSource, uint32_t nowMs) {
+        log = store;
+        if (log->magic != POWER_LOG_MAGIC || log->head >= POWER_LOG_SIZE || log->count > POWER_LOG_SIZE) {
+            memset(log, 0, sizeof(*log));
+            log->magic = POWER_LOG_MAGIC;
+        }
+        log->bootIndex++;
+        current = POWER_MODE_WAKING;
+        source = wakeSource < POWER_WAKE_SOURCE_COUNT ? wakeSource : POWER_WAKE_OTHER;
+        enteredMs = nowMs;
+    }
+
+    /**
+     * @brief 处理一个事件
+     * @return 发生迁移时返回 true，当前状态不接受该事件时返回 false
+     */
+    bool handle(PowerEvent event, uint32_t nowMs) {
+        PowerMode next;
+        if (!powerLookupTransition(current, event, next)) {
+            return false;
+        }
+        record(current, next, event, nowMs);
+        current = next;
+        enteredMs = nowMs;
+        return true;
+    }
+
+    /**
+     * @brief 初始化完成，记录唤醒到就绪的耗时并进入 ACTIVE
+     * @param latencyMs 从芯片启动到就绪的耗时
+     */
+    bool markReady(uint32_t latencyMs, uint32_t nowMs) {
+        if (current != POWER_MODE_WAKING) {
+            return false;
+        }
+        PowerWakeLatency& stat = log->latency[source];
+        if (stat.count == 0 || latencyMs < stat.minMs) stat.minMs = latencyMs;
+        if (latencyMs > stat.maxMs) stat.maxMs = latencyMs;
+        stat.lastMs = latencyMs;
+        stat.totalMs += latencyMs;
+        stat.count++;
+        return handle(POWER_EVENT_READY, nowMs);
+    }
+
+    PowerMode mode() const { return current; }
+    PowerWakeSource wakeSource() const { return source; }
+    uint32_t modeEnteredMs() const { return enteredMs; }
+    uint16_t bootIndex() const { return log ? log->bootIndex : 0; }
+
+    size_t recordCount() const { return log ? log->count : 0; }
+
+    // 按时间顺序取记录，0 为最早的一条
+    const PowerTransitionRecord& recordAt(size_t index) const {
+        size_t start = (log->head + POWER_LOG_SIZE - log->count) % POWER_LOG_SIZE;
+        return log->records[(start + index) % POWER_LOG_SIZE];
+    }
+
+    const PowerWakeLatency& latency(PowerWakeSource wakeSource) const { return log->latency[wakeSource]; }
+
+private:
+    PowerStateLog* log;
+    PowerMode current;
+    PowerWakeSource source;
+    uint32_t enteredMs;
+
+    void record(PowerMode from, PowerMode to, PowerEvent event, uint32_t nowMs) {
+        PowerTransitionRecord& r = log->records[log->head];
+        r.timestampMs = nowMs;
+        r.bootIndex = log->bootIndex;
+        r.from = from;
+        r.to = to;
+        r.event = event;
+        log->head = (log->head + 1) % POWER_LOG_SIZE;
+        if (log->count < POWER_LOG_SIZE) {
+            log->count++;
+        }
+    }
+};
+
+#endif // POWER_STATE_MACHINE_H
@@ -0,0 +1,356 @@
+#include "SleepMonitor.h"
+#include "WarmBoot.h"
+
+#if CONFIG_IDF_TARGET_ESP32 && CONFIG_ESP32_ULP_COPROC_ENABLED && defined(BAT_PIN) && defined(RTC_INT_PIN)
+#define SLEEP_MONITOR_ULP 1
+#include "esp32/ulp.h"
+#include "driver/adc.h"
+#include "driver/rtc_io.h"
+#include "bat/BatteryAdc.h"
+#include "soc/rtc_cntl_reg.h"
+#include "soc/rtc_io_reg.h"
+#include "soc/adc_channel.h"
+#else
+#define SLEEP_MONITOR_ULP 0
+#endif
+
+#define SLEEP_MONITOR_MAGIC 0x554C504D   // "ULPM"
+
+RTC_DATA_ATTR static SleepMonitorLog rtcLog;
+
+SleepMonitor sleepMonitor;
+
+#if SLEEP_MONITOR_ULP
+
+// 数据区放在 ULP 保留内存的末尾，程序从 0 开始加载
+// 前 4 个字对应 SleepMonitorConfig，之后对应 SleepMonitorState
+enum {
+    CFG_LOW_RAW = 0,
+    CFG_CUT_RAW,
+    CFG_DEBOUNCE,
+    CFG_GLITCH_MAX,
+    ST_IGN_STABLE,
+    ST_IGN_COUNT,
+    ST_LOW_COUNT,
+    ST_GLITCHES,
+    ST_LAST_RAW,
+    ST_MIN_RAW,
+    ST_MAX_RAW,
+    ST_SAMPLES,
+    ST_WAKE,
+    DATA_WORDS
+};
+
+static const uint32_t ULP_WORDS = CONFIG_ESP32_ULP_COPROC_RESERVE_MEM / sizeof(uint32_t);
+static const uint32_t DATA_BASE = ULP_WORDS - DATA_WORDS;
+
+enum {
+    L_NO_SAT,
+    L_MIN_DONE,
+    L_MAX_DONE,
+    L_LOW_COUNT,
+    L_IGNITION,
+    L_IGN_SAME,
+    L_TAMPER,
+    L_WAKE,
+    L_WAIT_READY,
+    L_DONE,
+};
+
+// ULP 写入的数据只有低16位有效
+static inline uint16_t ulpWord(int index)
+{
+    return (uint16_t)(RTC_SLOW_MEM[DATA_BASE + index] & 0xFFFF);
+}
+
+// 与醒着时的电池采样使用同一条校准曲线
+static int rawToBatteryMv(uint16_t raw)
+{
+    return batteryAdc.rawToMv(raw) * BAT_VOLTAGE_DIVIDER;
+}
+
+/**
+ * @brief 加载 ULP 程序，逐条对应 sleepMonitorStep()
+ * 比较用减法的溢出标志：a - b 溢出说明 a < b
+ */
+static bool loadProgram(int adcChannel, int rtcio)
+{
+    const ulp_insn_t program[] = {
+        I_MOVI(R3, DATA_BASE),
+
+        // 电池：4次采样平均 -> R1
+        I_ADC(R1, 0, adcChannel),
+        I_ADC(R0, 0, adcChannel),
+        I_ADDR(R1, R1, R0),
+        I_ADC(R0, 0, adcChannel),
+        I_ADDR(R1, R1, R0),
+        I_ADC(R0, 0, adcChannel),
+        I_ADDR(R1, R1, R0),
+        I_RSHI(R1, R1, 2),
+
+        I_LD(R0, R3, ST_SAMPLES),
+        M_BGE(L_NO_SAT, 0xFFFF),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, ST_SAMPLES),
+        M_LABEL(L_NO_SAT),
+
+        I_LD(R2, R3, ST_MIN_RAW),
+        I_SUBR(R0, R2, R1),
+        M_BXF(L_MIN_DONE),
+        I_ST(R1, R3, ST_MIN_RAW),
+        M_LABEL(L_MIN_DONE),
+
+        I_LD(R2, R3, ST_MAX_RAW),
+        I_SUBR(R0, R1, R2),
+        M_BXF(L_MAX_DONE),
+        I_ST(R1, R3, ST_MAX_RAW),
+        M_LABEL(L_MAX_DONE),
+        I_ST(R1, R3, ST_LAST_RAW),
+
+        // 断线
+        I_LD(R2, R3, CFG_CUT_RAW),
+        I_SUBR(R0, R1, R2),
+        M_BXF(L_TAMPER),
+
+        // 低电量
+        I_LD(R2, R3, CFG_LOW_RAW),
+        I_SUBR(R0, R1, R2),
+        M_BXF(L_LOW_COUNT),
+        I_MOVI(R0, 0),
+        I_ST(R0, R3, ST_LOW_COUNT),
+        M_BX(L_IGNITION),
+        M_LABEL(L_LOW_COUNT),
+        I_LD(R0, R3, ST_LOW_COUNT),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, ST_LOW_COUNT),
+        I_LD(R2, R3, CFG_DEBOUNCE),
+        I_SUBR(R0, R0, R2),
+        M_BXF(L_IGNITION),
+        I_MOVI(R2, SLEEP_WAKE_LOW_BATTERY),
+        M_BX(L_WAKE),
+
+        // 电门
+        M_LABEL(L_IGNITION),
+        I_RD_REG(RTC_GPIO_IN_REG, RTC_GPIO_IN_NEXT_S + rtcio, RTC_GPIO_IN_NEXT_S + rtcio),
+        I_MOVR(R1, R0),
+        I_LD(R2, R3, ST_IGN_STABLE),
+        I_SUBR(R0, R1, R2),
+        M_BXZ(L_IGN_SAME),
+        I_LD(R0, R3, ST_IGN_COUNT),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, ST_IGN_COUNT),
+        I_LD(R2, R3, CFG_DEBOUNCE),
+        I_SUBR(R0, R0, R2),
+        M_BXF(L_DONE),
+        I_ST(R1, R3, ST_IGN_STABLE),
+        I_MOVI(R2, SLEEP_WAKE_IGNITION),
+        M_BX(L_WAKE),
+
+        M_LABEL(L_IGN_SAME),
+        I_LD(R0, R3, ST_IGN_COUNT),
+        M_BL(L_DONE, 1),
+        I_MOVI(R0, 0),
+        I_ST(R0, R3, ST_IGN_COUNT),
+        I_LD(R0, R3, ST_GLITCHES),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R3, ST_GLITCHES),
+        I_LD(R2, R3, CFG_GLITCH_MAX),
+        I_SUBR(R0, R0, R2),
+        M_BXF(L_DONE),
+
+        M_LABEL(L_TAMPER),
+        I_MOVI(R2, SLEEP_WAKE_TAMPER),
+
+        // 记录原因，等 RTC 控制器允许唤醒后唤醒主CPU并停止定时器
+        M_LABEL(L_WAKE),
+        I_ST(R2, R3, ST_WAKE),
+        M_LABEL(L_WAIT_READY),
+        I_RD_REG(RTC_CNTL_LOW_POWER_ST_REG, RTC_CNTL_RDY_FOR_WAKEUP_S, RTC_CNTL_RDY_FOR_WAKEUP_S),
+        M_BL(L_WAIT_READY, 1),
+        I_WAKE(),
+        I_END(),
+
+        M_LABEL(L_DONE),
+        I_HALT(),
+    };
+
+    size_t size = sizeof(program) / sizeof(ulp_insn_t);
+    esp_err_t err = ulp_process_macros_and_load(0, program, &size);
+    if (err != ESP_OK)
+    {
+        Serial.printf("[睡眠监测] ULP程序加载失败: %s\n", esp_err_to_name(err));
+        return false;
+    }
+    if (size > DATA_BASE)
+    {
+        Serial.printf("[睡眠监测] ULP程序 %u 字超出可用空间 %u 字\n", (unsigned)size, (unsigned)DATA_BASE);
+        return false;
+    }
+    return true;
+}
+
+#endif // SLEEP_MONITOR_ULP
+
+SleepMonitor::SleepMonitor() : lastWake(0), supported(SLEEP_MONITOR_ULP != 0)
+{
+}
+
+void SleepMonitor::handleWakeup(esp_sleep_wakeup_cause_t cause)
+{
+    lastWake = 0;
+    if (rtcLog.magic != SLEEP_MONITOR_MAGIC || esp_reset_reason() != ESP_RST_DEEPSLEEP)
+    {
+        memset(&rtcLog, 0, sizeof(rtcLog));
+        rtcLog.magic = SLEEP_MONITOR_MAGIC;
+        return;
+    }
+    if (!rtcLog.armed)
+    {
+        return;
+    }
+    rtcLog.armed = 0;
+
+#if SLEEP_MONITOR_ULP
+    // 停止 ULP 定时器，释放 ADC 和电门引脚给主程序
+    CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+    rtc_gpio_deinit((gpio_num_t)RTC_INT_PIN);
+
+    SleepMonitorRecord& r = rtcLog.records[rtcLog.head];
+    r.sleptSec = warmBoot.sleptSeconds();
+    r.samples = ulpWord(ST_SAMPLES);
+    uint16_t glitches = ulpWord(ST_GLITCHES);
+    r.glitches = glitches > 255 ? 255 : (uint8_t)glitches;
+    r.wake = cause == ESP_SLEEP_WAKEUP_ULP ? (uint8_t)ulpWord(ST_WAKE) : 0;
+    if (r.samples > 0)
+    {
+        r.minMv = (uint16_t)rawToBatteryMv(ulpWord(ST_MIN_RAW));
+        r.maxMv = (uint16_t)rawToBatteryMv(ulpWord(ST_MAX_RAW));
+        r.lastMv = (uint16_t)rawToBatteryMv(ulpWord(ST_LAST_RAW));
+    }
+    else
+    {
+        r.minMv = r.maxMv = r.lastMv = 0;
+    }
+    rtcLog.head = (rtcLog.head + 1) % SLEEP_MONITOR_LOG_SIZE;
+    if (rtcLog.count < SLEEP_MONITOR_LOG_SIZE)
+    {
+        rtcLog.count++;
+    }
+
+    lastWake = r.wake;
+    Serial.printf("[睡眠监测] 采样 %u 次，电池 %u~%u mV，电门抖动 %u 次，唤醒原因: %s\n",
+                  r.samples, r.minMv, r.maxMv, r.glitches, sleepWakeReasonName(r.wake));
+#else
+    (void)cause;
+#endif
+}
+
+bool SleepMonitor::arm(bool lowReported)
+{
+    rtcLog.armed = 0;
+#if SLEEP_MONITOR_ULP
+    int adcChannel = digitalPinToAnalogChannel(BAT_PIN);
+    int rtcio = rtc_io_number_get((gpio_num_t)RTC_INT_PIN);
+    if (adcChannel < 0 || adcChannel >= ADC1_CHANNEL_MAX || rtcio < 0)
+    {
+        Serial.println("[睡眠监测] 电池引脚不是ADC1或电门引脚不是RTC GPIO，ULP监测不可用");
+        return false;
+    }
+
+    if (!loadProgram(adcChannel, rtcio))
+    {
+        return false;
+    }
+
+    SleepMonitorConfig config = sleepMonitorMakeConfig(lowReported, BAT_LOW_VOLTAGE_MV, BAT_TAMPER_VOLTAGE_MV,
+                                                       SLEEP_MONITOR_DEBOUNCE, SLEEP_MONITOR_GLITCH_MAX,
+                                                       rawToBatteryMv);
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten((adc1_channel_t)adcChannel, ADC_ATTEN_DB_11);
+    adc1_ulp_enable();
+
+    rtc_gpio_init((gpio_num_t)RTC_INT_PIN);
+    rtc_gpio_set_direction((gpio_num_t)RTC_INT_PIN, RTC_GPIO_MODE_INPUT_ONLY);
+    int level = rtc_gpio_get_level((gpio_num_t)RTC_INT_PIN);
+
+    SleepMonitorState state;
+    sleepMonitorReset(state, level);
+    const uint16_t words[DATA_WORDS] = {
+        config.lowRaw, config.cutRaw, config.debounce, config.glitchMax,
+        state.ignStable, state.ignCount, state.lowCount, state.glitches,
+        state.lastRaw, state.minRaw, state.maxRaw, state.samples, state.wake,
+    };
+    for (int i = 0; i < DATA_WORDS; i++)
+    {
+        RTC_SLOW_MEM[DATA_BASE + i] = words[i];
+    }
+
+    ulp_set_wakeup_period(0, (uint32_t)SLEEP_MONITOR_INTERVAL_MS * 1000);
+    esp_err_t err = ulp_run(0);
+    if (err == ESP_OK)
+    {
+        err = esp_sleep_enable_ulp_wakeup();
+    }
+    if (err != ESP_OK)
+    {
+        Serial.printf("[睡眠监测] ULP启动失败: %s\n", esp_err_to_name(err));
+        return false;
+    }
+
+    rtcLog.armed = 1;
+    Serial.printf("[睡眠监测] ULP已启动: 每 %d ms 采样，低电量阈值 %u%s，断线阈值 %u，电门电平 %d\n",
+                  SLEEP_MONITOR_INTERVAL_MS, config.lowRaw, lowReported ? " (已上报，不再唤醒)" : "",
+                  config.cutRaw, level);
+    return true;
+#else
+    (void)lowReported;
+    return false;
+#endif
+}
+
+bool SleepMonitor::resume()
+{
+#if SLEEP_MONITOR_ULP
+    // 睡眠前没有启动 ULP，不需要恢复
+    if (rtcLog.magic != SLEEP_MONITOR_MAGIC || !rtcLog.armed)
+    {
+        return true;
+    }
+    // 醒着期间 ULP 已判定需要唤醒，交给完整启动处理
+    if (ulpWord(ST_WAKE) != 0)
+    {
+        return false;
+    }
+    return esp_sleep_enable_ulp_wakeup() == ESP_OK;
+#else
+    return true;
+#endif
+}
+
+void SleepMonitor::printLog()
+{
+    Serial.println("=== 深度睡眠监测 ===");
+    if (!supported)
+    {
+        Serial.println("当前硬件不支持ULP监测");
+        return;
+    }
+    Serial.printf("低电量阈值: %d mV，断线阈值: %d mV，采样周期: %d ms，去抖: %d 次\n",
+                  BAT_LOW_VOLTAGE_MV, BAT_TAMPER_VOLTAGE_MV, SLEEP_MONITOR_INTERVAL_MS, SLEEP_MONITOR_DEBOUNCE);
+    Serial.printf("本次唤醒: %s\n", sleepWakeReasonName(lastWake));
+    if (rtcLog.count == 0)
+    {
+        Serial.println("暂无睡眠记录");
+        return;
+    }
+    // 从新到旧
+    for (uint8_t i = 0; i < rtcLog.count; i++)
+    {
+        int index = (rtcLog.head + SLEEP_MONITOR_LOG_SIZE - 1 - i) % SLEEP_MONITOR_LOG_SIZE;
+        const SleepMonitorRecord& r = rtcLog.records[index];
+        Serial.printf("  #%u 睡眠 %lu 秒，采样 %u 次，电池 %u~%u mV (最后 %u)，抖动 %u，唤醒: %s\n",
+                      i + 1, (unsigned long)r.sleptSec, r.samples, r.minMv, r.maxMv, r.lastMv,
+                      r.glitches, sleepWakeReasonName(r.wake));
+    }
+}
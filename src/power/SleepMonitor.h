@@ -0,0 +1,79 @@
+#ifndef SLEEP_MONITOR_H
+#define SLEEP_MONITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sdkconfig.h"
+#include "SleepMonitorLogic.h"
+
+/*
+ * 深度睡眠监测（ULP 协处理器）
+ *
+ * 进入深度睡眠前把 ULP 程序和阈值写入 RTC 慢速内存并启动，主CPU睡眠期间 ULP
+ * 每 SLEEP_MONITOR_INTERVAL_MS 采样一次电池ADC和电门引脚，判定逻辑见
+ * SleepMonitorLogic.h。唤醒后读取本次睡眠的采样统计（最低/最高电压、采样次数、
+ * 电门抖动次数、唤醒原因），写入保存在 RTC 内存中的环形日志。
+ *
+ * ULP 只能读 ADC1 和 RTC GPIO，需要 BAT_PIN 为 ADC1 引脚、RTC_INT_PIN 为 RTC GPIO；
+ * 仅支持 ESP32 的 FSM 型 ULP，其他芯片或条件不满足时 arm() 返回 false，
+ * 睡眠流程不受影响。
+ */
+
+#define SLEEP_MONITOR_LOG_SIZE  8
+
+// 一次深度睡眠的监测记录
+struct SleepMonitorRecord {
+    uint32_t sleptSec;      // 睡眠时长
+    uint16_t minMv;         // 电池最低电压
+    uint16_t maxMv;         // 电池最高电压
+    uint16_t lastMv;        // 唤醒前最后一次采样
+    uint16_t samples;
+    uint8_t glitches;       // 电门抖动次数
+    uint8_t wake;           // ULP 唤醒原因，其他唤醒源唤醒时为 0
+};
+
+struct SleepMonitorLog {
+    uint32_t magic;
+    uint8_t armed;          // 睡眠前 ULP 已启动
+    uint8_t head;
+    uint8_t count;
+    uint8_t reserved;
+    SleepMonitorRecord records[SLEEP_MONITOR_LOG_SIZE];
+};
+
+class SleepMonitor {
+public:
+    SleepMonitor();
+
+    /**
+     * @brief 唤醒后停止 ULP 并收集本次睡眠的采样统计，在状态机 begin() 之前调用
+     * @param cause 唤醒原因
+     */
+    void handleWakeup(esp_sleep_wakeup_cause_t cause);
+
+    /**
+     * @brief 加载 ULP 程序并启动监测，进入深度睡眠前最后调用
+     * @param lowReported 低电量已上报，本次睡眠不再用低电量唤醒
+     * @return 监测已启动
+     */
+    bool arm(bool lowReported);
+
+    /**
+     * @brief 误唤醒直接回到睡眠时继续使用睡眠前启动的 ULP（不停止、不重新加载，统计连续累计）
+     * @return 没有待处理的 ULP 唤醒原因（睡眠前未启动 ULP 时也返回 true）；返回 false 时应走完整启动
+     */
+    bool resume();
+
+    // 本次由 ULP 唤醒的原因（SLEEP_WAKE_*），不是 ULP 唤醒时为 0
+    uint16_t wakeReason() const { return lastWake; }
+
+    void printLog();
+
+private:
+    uint16_t lastWake;
+    bool supported;
+};
+
+extern SleepMonitor sleepMonitor;
+
+#endif // SLEEP_MONITOR_H
@@ -0,0 +1,174 @@
+#ifndef SLEEP_MONITOR_LOGIC_H
+#define SLEEP_MONITOR_LOGIC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * 深度睡眠监测判定逻辑
+ *
+ * 深度睡眠期间由 ULP 协处理器按固定周期采样电池ADC和电门引脚（RTC_INT_PIN），
+ * 只在以下情况唤醒主CPU：
+ * - 低电量：电池电压连续 debounce 次低于低电量阈值
+ * - 电门变化：电门引脚连续 debounce 次与睡眠前的稳定电平不同
+ * - 防拆：电池采样低于断线阈值（电池或采样线被剪断），或电门引脚抖动次数过多
+ *
+ * sleepMonitorStep() 是 ULP 程序（SleepMonitor.cpp）逐条对应的参考实现，只用
+ * 16位无符号加减和比较，与 ULP 的运算能力一致。电池分压系数和低电量迟滞判定
+ * 由 BAT 共用，保证醒着和睡着时的低电量标准相同。
+ * 睡眠期间判定的仿真见 tools/sleep_monitor_sim.cpp。
+ */
+
+#define BAT_VOLTAGE_DIVIDER         2       // 电池分压比，ADC电压 x2 为电池电压
+
+// 唤醒原因，可组合
+#define SLEEP_WAKE_LOW_BATTERY      0x01
+#define SLEEP_WAKE_IGNITION         0x02
+#define SLEEP_WAKE_TAMPER           0x04
+
+#define SLEEP_MONITOR_DISABLED_RAW  0       // 阈值为0时对应判定永不触发
+#define SLEEP_MONITOR_NEVER         0xFFFF  // 抖动次数上限为该值时不判定抖动
+
+// 主CPU在睡眠前写入的参数（ADC原始值）
+struct SleepMonitorConfig {
+    uint16_t lowRaw;        // 低电量阈值
+    uint16_t cutRaw;        // 断线阈值
+    uint16_t debounce;      // 连续采样次数
+    uint16_t glitchMax;     // 电门抖动次数上限
+};
+
+// ULP 维护的状态，与 RTC 慢速内存中的数据区一一对应
+struct SleepMonitorState {
+    uint16_t ignStable;     // 电门稳定电平（睡眠前由主CPU写入）
+    uint16_t ignCount;      // 连续与稳定电平不同的次数
+    uint16_t lowCount;      // 连续低于低电量阈值的次数
+    uint16_t glitches;      // 未达到 debounce 就恢复的电门变化次数
+    uint16_t lastRaw;       // 最近一次电池采样
+    uint16_t minRaw;
+    uint16_t maxRaw;
+    uint16_t samples;       // 采样次数，到 0xFFFF 不再增加
+    uint16_t wake;          // 唤醒原因
+};
+
+static inline void sleepMonitorReset(SleepMonitorState& s, uint16_t ignitionLevel) {
+    memset(&s, 0, sizeof(s));
+    s.ignStable = ignitionLevel ? 1 : 0;
+    s.minRaw = 0xFFFF;
+    s.maxRaw = 0;
+}
+
+/**
+ * @brief 处理一次采样，与 ULP 程序的判定顺序一致
+ * @param raw 电池ADC原始值（4次平均）
+ * @param level 电门引脚电平
+ * @return 需要唤醒时返回唤醒原因，否则返回 0；唤醒后状态保持，直到主CPU重新复位
+ */
+static inline uint16_t sleepMonitorStep(SleepMonitorState& s, const SleepMonitorConfig& c, uint16_t raw, uint16_t level) {
+    if (s.wake) {
+        return s.wake;
+    }
+
+    if (s.samples < 0xFFFF) s.samples++;
+    if (raw < s.minRaw) s.minRaw = raw;
+    if (raw > s.maxRaw) s.maxRaw = raw;
+    s.lastRaw = raw;
+
+    // 断线：分压电阻之后的采样点悬空或接地，读数接近0
+    if (raw < c.cutRaw) {
+        s.wake = SLEEP_WAKE_TAMPER;
+        return s.wake;
+    }
+
+    // 低电量
+    if (raw < c.lowRaw) {
+        s.lowCount++;
+        if (s.lowCount >= c.debounce) {
+            s.wake = SLEEP_WAKE_LOW_BATTERY;
+            return s.wake;
+        }
+    } else {
+        s.lowCount = 0;
+    }
+
+    // 电门
+    level = level ? 1 : 0;
+    if (level != s.ignStable) {
+        s.ignCount++;
+        if (s.ignCount >= c.debounce) {
+            s.ignStable = level;
+            s.wake = SLEEP_WAKE_IGNITION;
+            return s.wake;
+        }
+    } else if (s.ignCount > 0) {
+        // 变化没有持续到 debounce 就恢复，计为一次抖动
+        s.ignCount = 0;
+        s.glitches++;
+        if (s.glitches >= c.glitchMax) {
+            s.wake = SLEEP_WAKE_TAMPER;
+            return s.wake;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 低电量迟滞判定，BAT 和睡眠监测共用
+ * 低于 lowMv 进入低电量，回升到 lowMv + hysteresisMv 以上才解除
+ */
+static inline bool batteryLowUpdate(bool wasLow, int batteryMv, int lowMv, int hysteresisMv) {
+    if (wasLow) {
+        return batteryMv < lowMv + hysteresisMv;
+    }
+    return batteryMv < lowMv;
+}
+
+/**
+ * @brief 电池电压对应的最小ADC原始值
+ * ADC特性曲线单调递增，二分查找第一个换算后不低于目标电压的原始值
+ * @param toBatteryMv 原始值到电池电压（mV）的换算
+ */
+template <typename Convert>
+static inline uint16_t sleepMonitorRawForMv(int batteryMv, Convert toBatteryMv) {
+    if (batteryMv <= 0) {
+        return 0;
+    }
+    uint16_t lo = 0, hi = 4095;
+    if (toBatteryMv(hi) < batteryMv) {
+        return hi;
+    }
+    while (lo < hi) {
+        uint16_t mid = (uint16_t)((lo + hi) / 2);
+        if (toBatteryMv(mid) < batteryMv) {
+            lo = (uint16_t)(mid + 1);
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief 睡眠前生成监测参数
+ * @param lowReported 低电量已经上报过（BAT 仍处于低电量状态），不再用低电量唤醒，避免反复唤醒
+ */
+template <typename Convert>
+static inline SleepMonitorConfig sleepMonitorMakeConfig(bool lowReported, int lowMv, int cutMv,
+                                                       uint16_t debounce, uint16_t glitchMax,
+                                                       Convert toBatteryMv) {
+    SleepMonitorConfig c;
+    c.lowRaw = lowReported ? SLEEP_MONITOR_DISABLED_RAW : sleepMonitorRawForMv(lowMv, toBatteryMv);
+    c.cutRaw = sleepMonitorRawForMv(cutMv, toBatteryMv);
+    c.debounce = debounce ? debounce : 1;
+    c.glitchMax = glitchMax ? glitchMax : SLEEP_MONITOR_NEVER;
+    return c;
+}
+
+static inline const char* sleepWakeReasonName(uint16_t wake) {
+    if (wake & SLEEP_WAKE_TAMPER) return "tamper";
+    if (wake & SLEEP_WAKE_LOW_BATTERY) return "low_battery";
+    if (wake & SLEEP_WAKE_IGNITION) return "ignition";
+    return "none";
+}
+
+#endif // SLEEP_MONITOR_LOGIC_H
@@ -0,0 +1,324 @@
+#include "WarmBoot.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+#include <sys/time.h>
+#include "version.h"
+#include "utils/PreferencesUtils.h"
+
+// 跨深度睡眠保留，上电时为零
+RTC_DATA_ATTR static WarmBootState rtc;
+
+WarmBoot warmBoot;
+
+static const char* KEY_SESSION_ID = "sessionId";
+
+WarmBoot::WarmBoot() : warm(false), slept(0), phaseCount(0), firstFixUs(0), mux(portMUX_INITIALIZER_UNLOCKED)
+{
+}
+
+void WarmBoot::begin()
+{
+    // 只有深度睡眠唤醒时RTC内存内容才可信
+    bool valid = esp_reset_reason() == ESP_RST_DEEPSLEEP &&
+                 rtc.magic == WARM_BOOT_MAGIC &&
+                 rtc.version == WARM_BOOT_VERSION &&
+                 rtc.size == sizeof(WarmBootState) &&
+                 rtc.buildId == buildId() &&
+                 rtc.crc == computeCrc();
+
+    if (valid)
+    {
+        warm = true;
+        int64_t sleptSec = nowSec() - rtc.sleepEnteredSec;
+        slept = sleptSec > 0 ? (uint32_t)sleptSec : 0;
+    }
+    else
+    {
+        if (esp_reset_reason() == ESP_RST_DEEPSLEEP)
+        {
+            Serial.println("[启动] RTC状态校验失败，按冷启动初始化");
+        }
+        memset(&rtc, 0, sizeof(rtc));
+        rtc.magic = WARM_BOOT_MAGIC;
+        rtc.version = WARM_BOOT_VERSION;
+        rtc.size = sizeof(WarmBootState);
+        rtc.buildId = buildId();
+    }
+
+    // 冷启动或停车较久后开始新的记录会话，会话号保存在NVS中避免重复
+    if (!warm || slept > WARM_BOOT_SESSION_RESUME_SEC || rtc.sessionId == 0)
+    {
+        rtc.sessionId = PreferencesUtils::loadULong(PreferencesUtils::NS_POWER, KEY_SESSION_ID, 0) + 1;
+        PreferencesUtils::saveULong(PreferencesUtils::NS_POWER, KEY_SESSION_ID, rtc.sessionId);
+    }
+    portENTER_CRITICAL(&mux);
+    commit();
+    portEXIT_CRITICAL(&mux);
+
+    if (warm)
+    {
+        Serial.printf("[启动] 热启动，睡眠 %lu 秒，GPS会话 %lu\n", (unsigned long)slept, (unsigned long)rtc.sessionId);
+    }
+    else
+    {
+        Serial.printf("[启动] 冷启动，GPS会话 %lu\n", (unsigned long)rtc.sessionId);
+    }
+}
+
+const WarmBootState& WarmBoot::state() const
+{
+    return rtc;
+}
+
+uint32_t WarmBoot::sessionId() const
+{
+    return rtc.sessionId;
+}
+
+void WarmBoot::setSDLayout(uint32_t cardSizeMB, uint32_t freeMB, bool layoutReady)
+{
+    portENTER_CRITICAL(&mux);
+    rtc.sdLayoutReady = layoutReady ? 1 : 0;
+    rtc.sdCardSizeMB = cardSizeMB;
+    rtc.sdFreeMB = freeMB;
+    commit();
+    portEXIT_CRITICAL(&mux);
+}
+
+void WarmBoot::setSDFreeMB(uint32_t freeMB)
+{
+    portENTER_CRITICAL(&mux);
+    if (rtc.sdFreeMB != freeMB)
+    {
+        rtc.sdFreeMB = freeMB;
+        commit();
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+bool WarmBoot::sdLayoutValid(uint32_t cardSizeMB) const
+{
+    return warm && rtc.sdLayoutReady && rtc.sdCardSizeMB == cardSizeMB;
+}
+
+void WarmBoot::setCompassCalibration(const int16_t offset[3], const float scale[3])
+{
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < 3; i++)
+    {
+        rtc.compassOffset[i] = offset[i];
+        rtc.compassScale[i] = scale[i];
+    }
+    rtc.compassCalibrated = 1;
+    commit();
+    portEXIT_CRITICAL(&mux);
+}
+
+void WarmBoot::setImuConfig(const WarmBootImuConfig& config)
+{
+    portENTER_CRITICAL(&mux);
+    rtc.imu = config;
+    rtc.imu.valid = 1;
+    commit();
+    portEXIT_CRITICAL(&mux);
+}
+
+void WarmBoot::setLastFix(double latitude, double longitude, float altitude)
+{
+    int64_t now = nowSec();
+    portENTER_CRITICAL(&mux);
+    rtc.fixLatitude = latitude;
+    rtc.fixLongitude = longitude;
+    rtc.fixAltitude = altitude;
+    rtc.fixTimeSec = now;
+    rtc.fixValid = 1;
+    commit();
+    portEXIT_CRITICAL(&mux);
+}
+
+bool WarmBoot::lastFix(double& latitude, double& longitude) const
+{
+    if (!warm || !rtc.fixValid)
+    {
+        return false;
+    }
+    latitude = rtc.fixLatitude;
+    longitude = rtc.fixLongitude;
+    return true;
+}
+
+void WarmBoot::prepareForSleep()
+{
+    int64_t now = nowSec();
+    portENTER_CRITICAL(&mux);
+    rtc.sleepEnteredSec = now;
+    commit();
+    portEXIT_CRITICAL(&mux);
+}
+
+void WarmBoot::markPhase(const char* name)
+{
+    if (phaseCount < BOOT_PHASE_MAX)
+    {
+        phases[phaseCount].name = name;
+        phases[phaseCount].us = esp_timer_get_time();
+        phaseCount++;
+    }
+}
+
+void WarmBoot::markFirstFix()
+{
+    if (firstFixUs != 0)
+    {
+        return;
+    }
+    firstFixUs = esp_timer_get_time();
+    Serial.printf("[启动] 首次定位上报: %lu ms (%s)\n", (unsigned long)(firstFixUs / 1000),
+                  warm ? "热启动" : "冷启动");
+}
+
+void WarmBoot::printBootTiming()
+{
+    Serial.printf("=== 启动耗时 (%s) ===\n", warm ? "热启动" : "冷启动");
+    int64_t prev = 0;
+    for (uint8_t i = 0; i < phaseCount; i++)
+    {
+        Serial.printf("  %-10s %6lu ms  (+%lu ms)\n", phases[i].name, (unsigned long)(phases[i].us / 1000),
+                      (unsigned long)((phases[i].us - prev) / 1000));
+        prev = phases[i].us;
+    }
+    if (firstFixUs != 0)
+    {
+        Serial.printf("  %-10s %6lu ms\n", "first_fix", (unsigned long)(firstFixUs / 1000));
+    }
+    else
+    {
+        Serial.printf("  %-10s 尚未定位\n", "first_fix");
+    }
+}
+
+void WarmBoot::printStatus()
+{
+    printBootTiming();
+    Serial.println("=== 热启动状态 ===");
+    Serial.printf("GPS会话: %lu, 上次睡眠: %lu 秒\n", (unsigned long)rtc.sessionId, (unsigned long)slept);
+    Serial.printf("SD卡: 目录和设备信息%s, 容量 %lu MB, 剩余 %lu MB\n", rtc.sdLayoutReady ? "已就绪" : "未就绪",
+                  (unsigned long)rtc.sdCardSizeMB, (unsigned long)rtc.sdFreeMB);
+    if (rtc.compassCalibrated)
+    {
+        Serial.printf("罗盘校准: 偏移 (%d, %d, %d), 比例 (%.2f, %.2f, %.2f)\n",
+                      rtc.compassOffset[0], rtc.compassOffset[1], rtc.compassOffset[2],
+                      rtc.compassScale[0], rtc.compassScale[1], rtc.compassScale[2]);
+    }
+    else
+    {
+        Serial.println("罗盘校准: 无");
+    }
+    if (rtc.imu.valid)
+    {
+        Serial.printf("IMU配置: 量程 %u, 输出率 %u, 陀螺仪%s, WOM阈值 %umg\n", rtc.imu.accelRange, rtc.imu.accelOdr,
+                      rtc.imu.gyroEnabled ? "开" : "关", rtc.imu.womThresholdMg);
+    }
+    else
+    {
+        Serial.println("IMU配置: 无");
+    }
+    if (rtc.fixValid)
+    {
+        Serial.printf("最后定位: %.6f, %.6f, %.1f m (%lld 秒前)\n", rtc.fixLatitude, rtc.fixLongitude,
+                      rtc.fixAltitude, (long long)(nowSec() - rtc.fixTimeSec));
+    }
+    else
+    {
+        Serial.println("最后定位: 无");
+    }
+}
+
+// 魔数、版本、长度、编译标识和CRC本身不参与计算
+uint32_t WarmBoot::computeCrc() const
+{
+    const size_t offset = offsetof(WarmBootState, crc) + sizeof(rtc.crc);
+    return esp_rom_crc32_le(0, (const uint8_t*)&rtc + offset, sizeof(WarmBootState) - offset);
+}
+
+void WarmBoot::commit()
+{
+    rtc.crc = computeCrc();
+}
+
+// 版本号和编译时间的 FNV-1a 哈希
+uint32_t WarmBoot::buildId()
+{
+    const VersionInfo& info = getVersionInfo();
+    const char* parts[2] = {info.firmware_version, info.build_time};
+    uint32_t hash = 2166136261u;
+    for (int p = 0; p < 2; p++)
+    {
+        for (const char* c = parts[p]; c && *c; c++)
+        {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+int64_t WarmBoot::nowSec()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec;
+}
+
+BootJob::BootJob() : name(""), func(NULL), done(NULL), result(false), elapsed(0)
+{
+}
+
+bool BootJob::start(const char* jobName, Func jobFunc, uint32_t stackSize)
+{
+    name = jobName;
+    func = jobFunc;
+    done = xSemaphoreCreateBinary();
+    if (done != NULL && xTaskCreate(run, jobName, stackSize, this, 1, NULL) == pdPASS)
+    {
+        return true;
+    }
+
+    // 资源不足时退回串行执行
+    Serial.printf("[启动] %s 并行任务创建失败，改为串行执行\n", jobName);
+    int64_t begin = esp_timer_get_time();
+    result = func();
+    elapsed = (uint32_t)((esp_timer_get_time() - begin) / 1000);
+    if (done != NULL)
+    {
+        xSemaphoreGive(done);
+    }
+    return false;
+}
+
+bool BootJob::join(uint32_t timeoutMs)
+{
+    if (done == NULL)
+    {
+        return result;
+    }
+    if (xSemaphoreTake(done, pdMS_TO_TICKS(timeoutMs)) != pdTRUE)
+    {
+        // 任务仍在运行并持有 this，信号量不能释放
+        Serial.printf("[启动] %s 超过 %lu ms 未完成\n", name, (unsigned long)timeoutMs);
+        return false;
+    }
+    vSemaphoreDelete(done);
+    done = NULL;
+    return result;
+}
+
+void BootJob::run(void* arg)
+{
+    BootJob* job = (BootJob*)arg;
+    int64_t begin = esp_timer_get_time();
+    job->result = job->func();
+    job->elapsed = (uint32_t)((esp_timer_get_time() - begin) / 1000);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
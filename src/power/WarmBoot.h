@@ -0,0 +1,158 @@
+#ifndef WARM_BOOT_H
+#define WARM_BOOT_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "config.h"
+
+/*
+ * 热启动
+ *
+ * 深度睡眠唤醒后 setup() 会完整重跑一遍，但很多初始化结果在睡眠前后不会变化。
+ * 这里把睡眠前已验证的状态（SD卡目录和设备信息、罗盘校准、IMU配置、最后定位、GPS会话号）
+ * 放在 RTC 内存中，唤醒时校验魔数、版本、固件编译标识和 CRC，全部通过才算热启动，
+ * 各模块据此跳过重复的初始化、延时和写卡。上电、复位或刷写新固件后一律冷启动。
+ *
+ * 同时记录启动各阶段的耗时和首次定位上报时间，用于跟踪唤醒到首次上报的速度。
+ */
+
+#define WARM_BOOT_MAGIC         0x57424F54   // "WBOT"
+#define WARM_BOOT_VERSION       2
+#define BOOT_PHASE_MAX          16
+
+// IMU 睡眠前的工作配置，唤醒后按它恢复正常模式
+struct WarmBootImuConfig {
+    uint8_t valid;
+    uint8_t accelRange;         // SensorQMI8658::AccelRange
+    uint8_t accelOdr;           // SensorQMI8658::AccelODR
+    uint8_t womThresholdMg;     // 睡眠时的 WOM 阈值
+    uint8_t gyroEnabled;
+    uint8_t motionDetect;       // 运动检测中断是否启用
+    uint8_t reserved[2];
+    float motionThreshold;      // 运动检测阈值（g）
+};
+
+// 需要跨深度睡眠保留的初始化结果
+struct WarmBootState {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t buildId;           // 固件编译标识，刷写新固件后失效
+    uint32_t crc;               // 以下字段的 CRC32
+
+    uint32_t sessionId;         // 当前GPS记录会话号
+    int64_t sleepEnteredSec;    // 进入深度睡眠时的系统时间（RTC计时，睡眠期间继续走）
+
+    // SD卡：同一张卡上目录已建好、设备信息已写入
+    uint8_t sdLayoutReady;
+    uint8_t reserved[3];
+    uint32_t sdCardSizeMB;      // 用容量识别是否换了卡
+    uint32_t sdFreeMB;          // 睡眠前的剩余空间，唤醒后先用它，10秒后后台刷新
+
+    // 罗盘校准
+    uint8_t compassCalibrated;
+    uint8_t reserved2[3];
+    int16_t compassOffset[3];
+    float compassScale[3];
+
+    WarmBootImuConfig imu;
+
+    // 最后一次有效定位
+    uint8_t fixValid;
+    uint8_t reserved3[3];
+    double fixLatitude;
+    double fixLongitude;
+    float fixAltitude;
+    int64_t fixTimeSec;         // 定位时的系统时间
+};
+
+// 启动阶段计时
+struct BootPhase {
+    const char* name;
+    int64_t us;                 // esp_timer 时间
+};
+
+class WarmBoot {
+public:
+    WarmBoot();
+
+    // 校验RTC状态并决定冷/热启动，Serial.begin() 之后第一步调用
+    void begin();
+
+    bool isWarm() const { return warm; }
+    const WarmBootState& state() const;
+
+    // 距上次进入深度睡眠的秒数，冷启动返回 0
+    uint32_t sleptSeconds() const { return slept; }
+
+    // GPS记录会话号：冷启动或睡眠超过 WARM_BOOT_SESSION_RESUME_SEC 开始新会话
+    uint32_t sessionId() const;
+
+    // 各模块写入已验证的状态（SD启动任务、数据任务、系统任务并发调用，字段和CRC在锁内一起更新）
+    void setSDLayout(uint32_t cardSizeMB, uint32_t freeMB, bool layoutReady);
+    void setSDFreeMB(uint32_t freeMB);
+    bool sdLayoutValid(uint32_t cardSizeMB) const;
+    void setCompassCalibration(const int16_t offset[3], const float scale[3]);
+    void setImuConfig(const WarmBootImuConfig& config);
+    void setLastFix(double latitude, double longitude, float altitude);
+
+    // 热启动且睡眠前有定位时返回 true，GNSS定位之前先用它作为当前位置
+    bool lastFix(double& latitude, double& longitude) const;
+
+    // 进入深度睡眠前调用，记录时间并更新CRC
+    void prepareForSleep();
+
+    // 启动阶段计时
+    void markPhase(const char* name);
+    void markFirstFix();
+    void printBootTiming();
+    void printStatus();
+
+private:
+    bool warm;
+    uint32_t slept;
+    BootPhase phases[BOOT_PHASE_MAX];
+    uint8_t phaseCount;
+    int64_t firstFixUs;
+    portMUX_TYPE mux;
+
+    uint32_t computeCrc() const;
+    void commit();  // 调用方持有 mux
+    static uint32_t buildId();
+    static int64_t nowSec();
+};
+
+/**
+ * @brief 启动阶段的并行任务
+ *
+ * 独立总线上的外设（SPI上的SD卡、Wire上的罗盘、Wire1上的IMU）可以同时初始化，
+ * start() 把初始化函数放到临时任务中执行，join() 等待结果，任务结束后自行删除。
+ * 任务创建失败时直接在调用线程执行，保证结果不变。
+ */
+class BootJob {
+public:
+    typedef bool (*Func)();
+
+    BootJob();
+
+    bool start(const char* name, Func func, uint32_t stackSize = 4096);
+
+    // 等待任务完成并返回初始化结果，超时返回 false
+    bool join(uint32_t timeoutMs);
+
+    uint32_t elapsedMs() const { return elapsed; }
+
+private:
+    const char* name;
+    Func func;
+    SemaphoreHandle_t done;
+    volatile bool result;
+    volatile uint32_t elapsed;
+
+    static void run(void* arg);
+};
+
+extern WarmBoot warmBoot;
+
+#endif // WARM_BOOT_H
@@ -0,0 +1,120 @@
+#ifndef ALLOC_SITES_H
+#define ALLOC_SITES_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 按调用点统计堆分配
+ *
+ * 调用点为分配时的调用栈前 ALLOC_SITE_DEPTH 层返回地址（String、ArduinoJson 的分配都发生在库内部，
+ * 只取一层看不出是谁拼的字符串），按地址组合散列到固定大小的表中，记录次数和字节数。
+ * 表满后新的调用点只计入溢出计数，不丢失总数。记录只做散列和几次比较，不分配内存，
+ * 可以在 malloc 包装函数中调用（见 utils/HeapMonitor.h）。
+ *
+ * 调用点统计的仿真见 tools/alloc_sites_sim.cpp。
+ */
+
+#ifndef ALLOC_SITE_DEPTH
+#define ALLOC_SITE_DEPTH 3
+#endif
+
+#ifndef ALLOC_SITE_SLOTS
+#define ALLOC_SITE_SLOTS 64     // 2 的幂
+#endif
+
+struct AllocSite {
+    uint32_t pc[ALLOC_SITE_DEPTH];  // 0 表示空槽
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t maxBytes;
+};
+
+struct AllocSiteTable {
+    AllocSite slots[ALLOC_SITE_SLOTS];
+    uint32_t used;
+    uint32_t total;             // 分配次数（含溢出）
+    uint64_t totalBytes;
+    uint32_t frees;
+    uint32_t overflow;          // 表满后未能单独记录的分配次数
+};
+
+static inline void allocSitesReset(AllocSiteTable& t) {
+    memset(&t, 0, sizeof(t));
+}
+
+static inline uint32_t allocSiteHash(const uint32_t* pc) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < ALLOC_SITE_DEPTH; i++) {
+        h = (h ^ pc[i]) * 16777619u;
+    }
+    return h;
+}
+
+static inline bool allocSiteMatch(const AllocSite& s, const uint32_t* pc) {
+    for (int i = 0; i < ALLOC_SITE_DEPTH; i++) {
+        if (s.pc[i] != pc[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// pc[0] 不能为 0
+static inline void allocSitesRecord(AllocSiteTable& t, const uint32_t* pc, uint32_t size) {
+    t.total++;
+    t.totalBytes += size;
+
+    uint32_t mask = ALLOC_SITE_SLOTS - 1;
+    uint32_t i = allocSiteHash(pc) & mask;
+    for (uint32_t probe = 0; probe < ALLOC_SITE_SLOTS; probe++, i = (i + 1) & mask) {
+        AllocSite& s = t.slots[i];
+        if (s.pc[0] == 0) {
+            // 留一个空槽，保证查找总能结束
+            if (t.used >= ALLOC_SITE_SLOTS - 1) {
+                break;
+            }
+            memcpy(s.pc, pc, sizeof(s.pc));
+            t.used++;
+        } else if (!allocSiteMatch(s, pc)) {
+            continue;
+        }
+        s.count++;
+        s.bytes += size;
+        if (size > s.maxBytes) {
+            s.maxBytes = size;
+        }
+        return;
+    }
+    t.overflow++;
+}
+
+static inline void allocSitesFree(AllocSiteTable& t) {
+    t.frees++;
+}
+
+// 按字节数从大到小取前 n 个调用点的槽位下标，返回实际个数
+static inline int allocSitesTop(const AllocSiteTable& t, int* out, int n) {
+    int found = 0;
+    for (int i = 0; i < ALLOC_SITE_SLOTS; i++) {
+        if (t.slots[i].pc[0] == 0) {
+            continue;
+        }
+        int pos = found < n ? found : n;
+        while (pos > 0 && t.slots[out[pos - 1]].bytes < t.slots[i].bytes) {
+            if (pos < n) {
+                out[pos] = out[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < n) {
+            out[pos] = i;
+            if (found < n) {
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+#endif // ALLOC_SITES_H
@@ -1,29 +1,128 @@
 #include "DebugUtils.h"
+#include "PreferencesUtils.h"
 
 // 静态成员变量定义
 DebugLevel DebugManager::globalLevel = (DebugLevel)GLOBAL_DEBUG_LEVEL;
-DebugLevel DebugManager::atLevel = (DebugLevel)AT_COMMAND_DEBUG_LEVEL;
-DebugLevel DebugManager::gnssLevel = (DebugLevel)GNSS_DEBUG_LEVEL;
-DebugLevel DebugManager::mqttLevel = (DebugLevel)MQTT_DEBUG_LEVEL;
+
+// AT、GNSS、MQTT 保留原来的默认级别，其余通道跟随全局级别
+#define DEFAULT_OVERRIDES { \
+    LOG_CH_FOLLOW_GLOBAL, \
+    (uint8_t)AT_COMMAND_DEBUG_LEVEL, \
+    (uint8_t)GNSS_DEBUG_LEVEL, \
+    (uint8_t)MQTT_DEBUG_LEVEL, \
+    LOG_CH_FOLLOW_GLOBAL, LOG_CH_FOLLOW_GLOBAL, LOG_CH_FOLLOW_GLOBAL, LOG_CH_FOLLOW_GLOBAL, \
+    LOG_CH_FOLLOW_GLOBAL, LOG_CH_FOLLOW_GLOBAL, LOG_CH_FOLLOW_GLOBAL, LOG_CH_FOLLOW_GLOBAL, \
+}
+static_assert(LOG_CH_COUNT == 12, "新增通道时补充 DEFAULT_OVERRIDES、CHANNEL_NAMES 和 effective 的初值");
+
+static const char* const CHANNEL_NAMES[LOG_CH_COUNT] = {
+    "SYS", "AT", "GNSS", "MQTT", "IMU", "BAT", "POWER", "SD", "NET", "BLE", "AUDIO", "COMPASS",
+};
+
+uint8_t DebugManager::overrides[LOG_CH_COUNT] = DEFAULT_OVERRIDES;
+
+// begin() 之前按默认值过滤
+uint8_t DebugManager::effective[LOG_CH_COUNT] = {
+    (uint8_t)GLOBAL_DEBUG_LEVEL,
+    (uint8_t)AT_COMMAND_DEBUG_LEVEL,
+    (uint8_t)GNSS_DEBUG_LEVEL,
+    (uint8_t)MQTT_DEBUG_LEVEL,
+    (uint8_t)GLOBAL_DEBUG_LEVEL, (uint8_t)GLOBAL_DEBUG_LEVEL, (uint8_t)GLOBAL_DEBUG_LEVEL,
+    (uint8_t)GLOBAL_DEBUG_LEVEL, (uint8_t)GLOBAL_DEBUG_LEVEL, (uint8_t)GLOBAL_DEBUG_LEVEL,
+    (uint8_t)GLOBAL_DEBUG_LEVEL, (uint8_t)GLOBAL_DEBUG_LEVEL,
+};
+
+static inline bool validLevel(uint8_t level) {
+    return level <= (uint8_t)DebugLevel::VERBOSE;
+}
+
+void DebugManager::begin() {
+    // 第一个字节为全局级别，其后按通道下标；旧版本保存的通道数较少时，多出的通道保持默认
+    uint8_t saved[1 + LOG_CH_COUNT];
+    size_t len = PreferencesUtils::loadLogLevels(saved, sizeof(saved));
+    if (len == 0) {
+        return;
+    }
+    if (validLevel(saved[0])) {
+        globalLevel = (DebugLevel)saved[0];
+    }
+    for (size_t i = 1; i < len; i++) {
+        if (validLevel(saved[i]) || saved[i] == LOG_CH_FOLLOW_GLOBAL) {
+            overrides[i - 1] = saved[i];
+        }
+    }
+    update();
+    Serial.printf("[DebugManager] 已加载保存的日志级别，全局: %d\n", (int)globalLevel);
+}
+
+void DebugManager::update() {
+    for (int i = 0; i < LOG_CH_COUNT; i++) {
+        effective[i] = overrides[i] == LOG_CH_FOLLOW_GLOBAL ? (uint8_t)globalLevel : overrides[i];
+    }
+}
+
+void DebugManager::save() {
+    uint8_t saved[1 + LOG_CH_COUNT];
+    saved[0] = (uint8_t)globalLevel;
+    memcpy(saved + 1, overrides, LOG_CH_COUNT);
+    PreferencesUtils::saveLogLevels(saved, sizeof(saved));
+}
 
 void DebugManager::setGlobalLevel(DebugLevel level) {
     globalLevel = level;
+    update();
     Serial.printf("[DebugManager] 全局调试级别设置为: %d\n", (int)level);
 }
 
 void DebugManager::setATLevel(DebugLevel level) {
-    atLevel = level;
-    Serial.printf("[DebugManager] AT指令调试级别设置为: %d\n", (int)level);
+    setChannelLevel(LOG_CH_AT, (uint8_t)level);
 }
 
 void DebugManager::setGNSSLevel(DebugLevel level) {
-    gnssLevel = level;
-    Serial.printf("[DebugManager] GNSS调试级别设置为: %d\n", (int)level);
+    setChannelLevel(LOG_CH_GNSS, (uint8_t)level);
 }
 
 void DebugManager::setMQTTLevel(DebugLevel level) {
-    mqttLevel = level;
-    Serial.printf("[DebugManager] MQTT调试级别设置为: %d\n", (int)level);
+    setChannelLevel(LOG_CH_MQTT, (uint8_t)level);
+}
+
+void DebugManager::setChannelLevel(LogChannel channel, uint8_t level) {
+    if (channel >= LOG_CH_COUNT || !(validLevel(level) || level == LOG_CH_FOLLOW_GLOBAL)) {
+        return;
+    }
+    overrides[channel] = level;
+    update();
+    if (level == LOG_CH_FOLLOW_GLOBAL) {
+        Serial.printf("[DebugManager] %s 调试级别跟随全局: %d\n", CHANNEL_NAMES[channel], (int)globalLevel);
+    } else {
+        Serial.printf("[DebugManager] %s 调试级别设置为: %d\n", CHANNEL_NAMES[channel], (int)level);
+    }
+}
+
+bool DebugManager::setLevelByName(const char* name, uint8_t level) {
+    if (strcasecmp(name, "all") == 0) {
+        if (!validLevel(level)) {
+            return false;
+        }
+        setGlobalLevel((DebugLevel)level);
+    } else {
+        int channel = findChannel(name);
+        if (channel < 0 || !(validLevel(level) || level == LOG_CH_FOLLOW_GLOBAL)) {
+            return false;
+        }
+        setChannelLevel((LogChannel)channel, level);
+    }
+    save();
+    return true;
+}
+
+void DebugManager::resetLevels() {
+    globalLevel = (DebugLevel)GLOBAL_DEBUG_LEVEL;
+    static const uint8_t defaults[LOG_CH_COUNT] = DEFAULT_OVERRIDES;
+    memcpy(overrides, defaults, sizeof(overrides));
+    update();
+    PreferencesUtils::clearLogLevels();
+    Serial.println("[DebugManager] 日志级别已恢复默认");
 }
 
 DebugLevel DebugManager::getGlobalLevel() {
@@ -31,23 +130,37 @@ DebugLevel DebugManager::getGlobalLevel() {
 }
 
 DebugLevel DebugManager::getATLevel() {
-    return atLevel;
+    return (DebugLevel)effective[LOG_CH_AT];
 }
 
 DebugLevel DebugManager::getGNSSLevel() {
-    return gnssLevel;
+    return (DebugLevel)effective[LOG_CH_GNSS];
 }
 
 DebugLevel DebugManager::getMQTTLevel() {
-    return mqttLevel;
+    return (DebugLevel)effective[LOG_CH_MQTT];
+}
+
+const char* DebugManager::channelName(LogChannel channel) {
+    return channel < LOG_CH_COUNT ? CHANNEL_NAMES[channel] : "?";
+}
+
+int DebugManager::findChannel(const char* name) {
+    for (int i = 0; i < LOG_CH_COUNT; i++) {
+        if (strcasecmp(name, CHANNEL_NAMES[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
 }
 
 void DebugManager::printCurrentLevels() {
     Serial.println("=== 当前调试级别配置 ===");
     Serial.printf("全局级别: %d\n", (int)globalLevel);
-    Serial.printf("AT指令级别: %d\n", (int)atLevel);
-    Serial.printf("GNSS级别: %d\n", (int)gnssLevel);
-    Serial.printf("MQTT级别: %d\n", (int)mqttLevel);
+    for (int i = 0; i < LOG_CH_COUNT; i++) {
+        Serial.printf("  %-8s %d%s\n", CHANNEL_NAMES[i], (int)effective[i],
+                      overrides[i] == LOG_CH_FOLLOW_GLOBAL ? " (跟随全局)" : "");
+    }
     Serial.println("级别说明: 0=无, 1=错误, 2=警告, 3=信息, 4=调试, 5=详细");
     Serial.println("========================");
 }
@@ -14,6 +14,26 @@ enum class DebugLevel {
     VERBOSE = 5  // 详细调试信息（包括AT指令）
 };
 
+// 日志通道，每个模块一个（utils/Log.h 的 LOGx(通道, ...) 使用）
+// 级别按下标保存在 Preferences 中，新通道只能加在末尾
+enum LogChannel : uint8_t {
+    LOG_CH_SYS = 0,     // 未归属模块
+    LOG_CH_AT,
+    LOG_CH_GNSS,
+    LOG_CH_MQTT,
+    LOG_CH_IMU,
+    LOG_CH_BAT,
+    LOG_CH_POWER,
+    LOG_CH_SD,
+    LOG_CH_NET,
+    LOG_CH_BLE,
+    LOG_CH_AUDIO,
+    LOG_CH_COMPASS,
+    LOG_CH_COUNT
+};
+
+#define LOG_CH_FOLLOW_GLOBAL 0xFF    // 通道未单独设置，跟随全局级别
+
 // 全局调试级别配置
 #ifndef GLOBAL_DEBUG_LEVEL
 #ifdef DEBUG
@@ -106,25 +126,41 @@ enum class DebugLevel {
     } } while(0)
 
 // 运行时调试级别控制
+// 每个通道可单独设置级别，未设置的跟随全局级别；生效级别预先算好，过滤只需一次比较
 class DebugManager {
 public:
+    // 从 Preferences 读取保存的级别，在 PreferencesUtils::init() 之后调用
+    static void begin();
+
     static void setGlobalLevel(DebugLevel level);
     static void setATLevel(DebugLevel level);
     static void setGNSSLevel(DebugLevel level);
     static void setMQTTLevel(DebugLevel level);
-    
+
+    // level 为 LOG_CH_FOLLOW_GLOBAL 时恢复跟随全局级别
+    static void setChannelLevel(LogChannel channel, uint8_t level);
+    // 按名称设置，"all" 为全局级别；供串口、MQTT、BLE 命令使用，设置后保存
+    static bool setLevelByName(const char* name, uint8_t level);
+    static void resetLevels();
+
     static DebugLevel getGlobalLevel();
     static DebugLevel getATLevel();
     static DebugLevel getGNSSLevel();
     static DebugLevel getMQTTLevel();
-    
+
+    static inline uint8_t channelLevel(LogChannel channel) { return effective[channel]; }
+    static const char* channelName(LogChannel channel);
+    static int findChannel(const char* name);
+
     static void printCurrentLevels();
-    
+
 private:
+    static void update();
+    static void save();
+
     static DebugLevel globalLevel;
-    static DebugLevel atLevel;
-    static DebugLevel gnssLevel;
-    static DebugLevel mqttLevel;
+    static uint8_t overrides[LOG_CH_COUNT];
+    static uint8_t effective[LOG_CH_COUNT];
 };
 
 #endif // DEBUG_UTILS_H
@@ -0,0 +1,193 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 传感器计算用的快速数学函数和 Q16.16 定点数
+ *
+ * 姿态、航向每个采样都要算 atan2 和 sqrt。libm 的 atan2/sqrt 是 double 版本，
+ * ESP32 的 FPU 只支持单精度，double 全部走软件模拟；没有 FPU 的芯片上 float 也是软件模拟。
+ * 这里的近似只用乘加和一次除法：
+ *   fastAtan2Deg  9 次多项式，最大误差约 0.0007°（float），0.003°（Q16）
+ *   fastSqrt      平方根倒数近似加牛顿迭代，float 相对误差小于 5e-6，Q16 误差不超过 1 个最低位
+ * 误差和每次耗时见 tools/bench_sensor_math.cpp。
+ *
+ * SensorMath<T> 把 float 和 Q16 的运算统一起来，滤波器按数值类型写成模板（见 imu/AttitudeFilter.h），
+ * 用 SENSOR_MATH_FIXED 选择固件使用的类型。
+ * 近似误差和耗时见 tools/bench_sensor_math.cpp。
+ */
+
+#ifndef SENSOR_MATH_FIXED
+#define SENSOR_MATH_FIXED 0
+#endif
+
+// ---------------- Q16.16 定点数 ----------------
+
+// 整数部分 16 位（±32767），小数分辨率 1/65536；乘除中间结果用 64 位，不溢出时与 float 同样使用
+struct Q16 {
+    int32_t raw;
+
+    Q16() : raw(0) {}
+    Q16(float v) : raw((int32_t)(v * 65536.0f + (v >= 0 ? 0.5f : -0.5f))) {}
+
+    static Q16 fromRaw(int32_t r) {
+        Q16 q;
+        q.raw = r;
+        return q;
+    }
+    static Q16 fromInt(int32_t v) { return fromRaw(v * 65536); }
+
+    float toFloat() const { return raw / 65536.0f; }
+    int32_t toInt() const { return (raw + 0x8000) >> 16; }   // 四舍五入
+
+    Q16 operator+(Q16 b) const { return fromRaw(raw + b.raw); }
+    Q16 operator-(Q16 b) const { return fromRaw(raw - b.raw); }
+    Q16 operator-() const { return fromRaw(-raw); }
+    Q16 operator*(Q16 b) const { return fromRaw((int32_t)(((int64_t)raw * b.raw + 0x8000) >> 16)); }
+    Q16 operator/(Q16 b) const { return fromRaw(b.raw == 0 ? 0 : (int32_t)(((int64_t)raw << 16) / b.raw)); }
+    Q16& operator+=(Q16 b) { raw += b.raw; return *this; }
+    Q16& operator-=(Q16 b) { raw -= b.raw; return *this; }
+    bool operator<(Q16 b) const { return raw < b.raw; }
+    bool operator>(Q16 b) const { return raw > b.raw; }
+};
+
+// ---------------- float ----------------
+
+static const float FAST_RAD_TO_DEG = 57.29577951f;
+static const float FAST_DEG_TO_RAD = 0.017453293f;
+
+// atan(z) * 180/π，0 <= z <= 1
+static inline float fastAtanDegUnit(float z) {
+    float z2 = z * z;
+    return z * (57.2881f + z2 * (-18.92477f + z2 * (10.32132f + z2 * (-4.87776f + z2 * 1.19376f))));
+}
+
+// 返回 -180 ~ 180 度，x、y 都为 0 时返回 0
+static inline float fastAtan2Deg(float y, float x) {
+    float ax = x < 0 ? -x : x;
+    float ay = y < 0 ? -y : y;
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    float a = ay > ax ? 90.0f - fastAtanDegUnit(ax / ay) : fastAtanDegUnit(ay / ax);
+    if (x < 0) {
+        a = 180.0f - a;
+    }
+    return y < 0 ? -a : a;
+}
+
+static inline float fastSqrt(float x) {
+    if (!(x > 0)) {
+        return 0;
+    }
+    uint32_t i;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5F375A86 - (i >> 1);
+    float r;
+    memcpy(&r, &i, sizeof(r));
+    float h = 0.5f * x;
+    r = r * (1.5f - h * r * r);
+    r = r * (1.5f - h * r * r);
+    return x * r;
+}
+
+// ---------------- Q16 ----------------
+
+// 系数同 fastAtanDegUnit，z 和结果都是 Q16
+static inline int32_t q16AtanDegUnit(int32_t z) {
+    static const int32_t C1 = 3754433;      // 57.2881 * 65536
+    static const int32_t C3 = -1240254;
+    static const int32_t C5 = 676418;
+    static const int32_t C7 = -319669;
+    static const int32_t C9 = 78234;
+    int32_t z2 = (int32_t)(((int64_t)z * z) >> 16);
+    int32_t acc = C9;
+    acc = C7 + (int32_t)(((int64_t)acc * z2) >> 16);
+    acc = C5 + (int32_t)(((int64_t)acc * z2) >> 16);
+    acc = C3 + (int32_t)(((int64_t)acc * z2) >> 16);
+    acc = C1 + (int32_t)(((int64_t)acc * z2) >> 16);
+    return (int32_t)(((int64_t)acc * z) >> 16);
+}
+
+static inline Q16 fastAtan2Deg(Q16 y, Q16 x) {
+    uint32_t ax = x.raw < 0 ? (uint32_t)-x.raw : (uint32_t)x.raw;
+    uint32_t ay = y.raw < 0 ? (uint32_t)-y.raw : (uint32_t)y.raw;
+    uint32_t mx = ax > ay ? ax : ay;
+    uint32_t mn = ax > ay ? ay : ax;
+    if (mx == 0) {
+        return Q16();
+    }
+    // 比值只与相对大小有关：把较大值缩放到 [2^14, 2^15)，用 32 位除法得到 Q16 的比值
+    int shift = (31 - __builtin_clz(mx)) - 14;
+    if (shift > 0) {
+        mx >>= shift;
+        mn >>= shift;
+    } else {
+        mx <<= -shift;
+        mn <<= -shift;
+    }
+    int32_t z = (int32_t)((mn << 16) / mx);
+    int32_t a = q16AtanDegUnit(z);
+    if (ay > ax) {
+        a = (90 << 16) - a;
+    }
+    if (x.raw < 0) {
+        a = (180 << 16) - a;
+    }
+    return Q16::fromRaw(y.raw < 0 ? -a : a);
+}
+
+// 平方根倒数的牛顿迭代，只用乘法：把 raw 移偶数位规格化到 [0.5, 2)（Q30），查表得到初值，
+// 迭代三次后乘回得到平方根，再移回 Q16。负数返回 0
+static inline Q16 fastSqrt(Q16 x) {
+    static const uint32_t RSQRT_SEED[16] = {
+        0, 0, 1920767767, 1623345051, 1431655765, 1294981364, 1191209601, 1108955787,
+        1041682578, 985333074, 937238702, 895562589, 858993459, 826566842, 797555404, 771398898};
+    if (x.raw <= 0) {
+        return Q16();
+    }
+    uint32_t v = (uint32_t)x.raw;
+    int shift = (__builtin_clz(v) - 1) & ~1;
+    uint32_t m = v << shift;
+    uint32_t y = RSQRT_SEED[m >> 27];
+    for (int i = 0; i < 3; i++) {
+        uint32_t y2 = (uint32_t)(((uint64_t)y * y) >> 30);
+        uint32_t t = (uint32_t)(((uint64_t)m * y2) >> 30);
+        y = (uint32_t)(((uint64_t)y * (0xC0000000u - t)) >> 31);   // y * (3 - m * y^2) / 2
+    }
+    uint32_t r = (uint32_t)(((uint64_t)m * y) >> 30);
+    // sqrt(raw << 16) = sqrt(m / 2^30) * 2^(23 - shift / 2)
+    int down = 7 + shift / 2;
+    return Q16::fromRaw((int32_t)((r + (1u << (down - 1))) >> down));
+}
+
+// ---------------- 按数值类型分派 ----------------
+
+template <typename T>
+struct SensorMath;
+
+template <>
+struct SensorMath<float> {
+    static float from(float v) { return v; }
+    static float toFloat(float v) { return v; }
+    static float sqrt(float v) { return fastSqrt(v); }
+    static float atan2Deg(float y, float x) { return fastAtan2Deg(y, x); }
+};
+
+template <>
+struct SensorMath<Q16> {
+    static Q16 from(float v) { return Q16(v); }
+    static float toFloat(Q16 v) { return v.toFloat(); }
+    static Q16 sqrt(Q16 v) { return fastSqrt(v); }
+    static Q16 atan2Deg(Q16 y, Q16 x) { return fastAtan2Deg(y, x); }
+};
+
+#if SENSOR_MATH_FIXED
+typedef Q16 sensor_real_t;
+#else
+typedef float sensor_real_t;
+#endif
+
+#endif // FAST_MATH_H
@@ -0,0 +1,197 @@
+#include "HeapMonitor.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+
+HeapMonitor heapMonitor;
+
+#ifdef ENABLE_ALLOC_TRACE
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "esp_debug_helpers.h"
+#endif
+
+// 链接参数 -Wl,--wrap=malloc 等把所有对 malloc 的调用转到 __wrap_malloc，__real_malloc 为原函数
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+// 静态零初始化，构造函数运行前的分配也能记录
+static AllocSiteTable allocSites;
+static portMUX_TYPE allocMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Xtensa 返回地址高 2 位是窗口增量，还原成代码地址并指向调用指令
+static inline uint32_t callSitePc(uint32_t pc)
+{
+    if (pc & 0x80000000)
+    {
+        pc = (pc & 0x3FFFFFFF) | 0x40000000;
+    }
+    return pc - 3;
+}
+
+static void __attribute__((noinline)) recordAlloc(uint32_t size)
+{
+    uint32_t pc[ALLOC_SITE_DEPTH] = {0};
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    esp_backtrace_frame_t frame;
+    esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+    // 跳过 recordAlloc 和 __wrap_* 两层，从调用 malloc 的函数开始
+    bool valid = esp_backtrace_get_next_frame(&frame) && esp_backtrace_get_next_frame(&frame);
+    for (int i = 0; valid && i < ALLOC_SITE_DEPTH; i++)
+    {
+        pc[i] = callSitePc(frame.pc);
+        valid = frame.next_pc != 0 && esp_backtrace_get_next_frame(&frame);
+    }
+#else
+    // 没有回溯接口时只取调用 malloc 的函数（需要帧指针）
+    pc[0] = (uint32_t)__builtin_return_address(1);
+#endif
+    if (pc[0] == 0)
+    {
+        pc[0] = 1;  // 取不到调用栈的分配归为一类
+    }
+    portENTER_CRITICAL(&allocMux);
+    allocSitesRecord(allocSites, pc, size);
+    portEXIT_CRITICAL(&allocMux);
+}
+
+extern "C" void* __wrap_malloc(size_t size)
+{
+    void* p = __real_malloc(size);
+    if (p != NULL)
+    {
+        recordAlloc(size);
+    }
+    return p;
+}
+
+extern "C" void* __wrap_calloc(size_t n, size_t size)
+{
+    void* p = __real_calloc(n, size);
+    if (p != NULL)
+    {
+        recordAlloc(n * size);
+    }
+    return p;
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size)
+{
+    void* p = __real_realloc(ptr, size);
+    if (p != NULL && size > 0)
+    {
+        recordAlloc(size);
+    }
+    return p;
+}
+
+extern "C" void __wrap_free(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        portENTER_CRITICAL(&allocMux);
+        allocSitesFree(allocSites);
+        portEXIT_CRITICAL(&allocMux);
+    }
+    __real_free(ptr);
+}
+#endif
+
+HeapMonitor::HeapMonitor() : head(0), count(0), minLargestBlock(0xFFFFFFFF), markMs(0)
+{
+    memset(history, 0, sizeof(history));
+}
+
+uint32_t HeapMonitor::fragmentationPermille(uint32_t freeBytes, uint32_t largestBlock)
+{
+    if (freeBytes == 0 || largestBlock >= freeBytes)
+    {
+        return 0;
+    }
+    return 1000 - (uint32_t)((uint64_t)largestBlock * 1000 / freeBytes);
+}
+
+void HeapMonitor::sample()
+{
+    HeapSample& s = history[head];
+    s.uptimeSec = millis() / 1000;
+    s.freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    head = (head + 1) % HEAP_HISTORY_SIZE;
+    if (count < HEAP_HISTORY_SIZE)
+    {
+        count++;
+    }
+    if (s.largestBlock < minLargestBlock)
+    {
+        minLargestBlock = s.largestBlock;
+    }
+}
+
+void HeapMonitor::mark()
+{
+#ifdef ENABLE_ALLOC_TRACE
+    portENTER_CRITICAL(&allocMux);
+    allocSitesReset(allocSites);
+    portEXIT_CRITICAL(&allocMux);
+#endif
+    markMs = millis();
+}
+
+void HeapMonitor::printReport()
+{
+    uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    uint32_t frag = fragmentationPermille(freeBytes, largest);
+
+    Serial.println("=== 内存 ===");
+    Serial.printf("空闲 %lu B, 最低 %lu B, 最大块 %lu B, 碎片 %lu.%lu%%\n", (unsigned long)freeBytes,
+                  (unsigned long)ESP.getMinFreeHeap(), (unsigned long)largest, (unsigned long)(frag / 10),
+                  (unsigned long)(frag % 10));
+    if (count > 0)
+    {
+        Serial.printf("最大块历史最低: %lu B\n", (unsigned long)minLargestBlock);
+        Serial.println("--- 最近记录 ---");
+        Serial.println("  运行(秒)      空闲    最大块   碎片");
+        int shown = count < 12 ? count : 12;
+        for (int i = shown; i > 0; i--)
+        {
+            const HeapSample& s = history[(head - i + HEAP_HISTORY_SIZE) % HEAP_HISTORY_SIZE];
+            uint32_t f = fragmentationPermille(s.freeBytes, s.largestBlock);
+            Serial.printf("  %8lu %9lu %9lu %3lu.%lu%%\n", (unsigned long)s.uptimeSec, (unsigned long)s.freeBytes,
+                          (unsigned long)s.largestBlock, (unsigned long)(f / 10), (unsigned long)(f % 10));
+        }
+    }
+
+#ifdef ENABLE_ALLOC_TRACE
+    // 先复制再打印，打印本身也会分配
+    static AllocSiteTable copy;
+    portENTER_CRITICAL(&allocMux);
+    copy = allocSites;
+    portEXIT_CRITICAL(&allocMux);
+
+    uint32_t seconds = (millis() - markMs) / 1000;
+    Serial.printf("--- 分配调用点（%lu 秒内） ---\n", (unsigned long)seconds);
+    Serial.printf("分配 %lu 次 %llu B，释放 %lu 次，表满未单独记录 %lu 次\n", (unsigned long)copy.total,
+                  (unsigned long long)copy.totalBytes, (unsigned long)copy.frees, (unsigned long)copy.overflow);
+    int top[ALLOC_REPORT_TOP];
+    int n = allocSitesTop(copy, top, ALLOC_REPORT_TOP);
+    Serial.println("      次数       字节   单次最大  调用栈");
+    for (int i = 0; i < n; i++)
+    {
+        const AllocSite& s = copy.slots[top[i]];
+        Serial.printf("  %8lu %10lu %10lu ", (unsigned long)s.count, (unsigned long)s.bytes,
+                      (unsigned long)s.maxBytes);
+        for (int d = 0; d < ALLOC_SITE_DEPTH && s.pc[d] != 0; d++)
+        {
+            Serial.printf(" 0x%08lx", (unsigned long)s.pc[d]);
+        }
+        Serial.println();
+    }
+    Serial.println("地址解码: xtensa-esp32-elf-addr2line -pfiaC -e firmware.elf <地址>");
+#else
+    Serial.println("编译时未开启 ENABLE_ALLOC_TRACE，不统计分配调用点");
+#endif
+}
@@ -0,0 +1,51 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "utils/AllocSites.h"
+
+/*
+ * 堆空间和分配统计
+ *
+ * - 堆空间：主循环每 10 秒记录一次空闲内存和最大可分配块，保留最近 HEAP_HISTORY_SIZE 次，
+ *   碎片率 = 1 - 最大块 / 空闲；最大块过小时即使空闲内存充足，大块分配（TLS、JSON）也会失败
+ * - 分配调用点：编译时定义 ENABLE_ALLOC_TRACE 并用链接参数包装 malloc/calloc/realloc/free
+ *   （见 platformio.ini 中的注释），每次分配按调用栈记入 AllocSites 表；
+ *   串口 heap.mark 清零后骑行一段时间再看 heap，稳定运行时应用代码不应再出现在表中
+ *
+ * 串口命令：heap、heap.mark
+ */
+
+struct HeapSample {
+    uint32_t uptimeSec;
+    uint32_t freeBytes;
+    uint32_t largestBlock;
+};
+
+class HeapMonitor {
+public:
+    HeapMonitor();
+
+    // 记录一次堆空间，在主循环中定期调用
+    void sample();
+
+    // 清零分配统计，开始新的观察窗口
+    void mark();
+
+    void printReport();
+
+    // 碎片率（千分比）
+    static uint32_t fragmentationPermille(uint32_t freeBytes, uint32_t largestBlock);
+
+private:
+    HeapSample history[HEAP_HISTORY_SIZE];
+    int head;
+    int count;
+    uint32_t minLargestBlock;
+    unsigned long markMs;
+};
+
+extern HeapMonitor heapMonitor;
+
+#endif // HEAP_MONITOR_H
@@ -0,0 +1,77 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 循环耗时直方图
+ *
+ * 按 2 的幂分桶（微秒）：第 0 桶为 0-1us，第 i 桶为 [2^(i-1), 2^i) us，最后一桶收容更长的耗时。
+ * 记录只做一次前导零计数和几次加法，适合在每次循环迭代中调用；分位数按桶上界估计，
+ * 误差不超过一倍，用于发现偶发的长阻塞（串口AT命令超时、I2C卡死），不是精确计时。
+ *
+ * 每个直方图只由一个任务写入；其他任务读取时可能看到相差一次记录的计数，统计用途可以接受。
+ * 记录开销见 tools/bench_perf_probe.cpp。
+ */
+
+#define LATENCY_BUCKETS 24      // 最后一桶从约 4 秒开始
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs;
+};
+
+static inline void latencyReset(LatencyHistogram& h) {
+    memset(&h, 0, sizeof(h));
+}
+
+static inline int latencyBucket(uint32_t us) {
+    if (us == 0) {
+        return 0;
+    }
+    int b = 32 - __builtin_clz(us);
+    return b >= LATENCY_BUCKETS ? LATENCY_BUCKETS - 1 : b;
+}
+
+// 桶的上界（us），最后一桶返回最大值
+static inline uint32_t latencyBucketUpperUs(int bucket) {
+    if (bucket >= LATENCY_BUCKETS - 1) {
+        return 0xFFFFFFFFu;
+    }
+    return 1u << bucket;
+}
+
+static inline void latencyRecord(LatencyHistogram& h, uint32_t us) {
+    h.buckets[latencyBucket(us)]++;
+    h.count++;
+    h.sumUs += us;
+    if (us > h.maxUs) {
+        h.maxUs = us;
+    }
+}
+
+static inline uint32_t latencyMeanUs(const LatencyHistogram& h) {
+    return h.count ? (uint32_t)(h.sumUs / h.count) : 0;
+}
+
+// 分位数（permille 为千分比，如 990 表示 p99），返回所在桶的上界，不超过最大值
+static inline uint32_t latencyPercentileUs(const LatencyHistogram& h, uint32_t permille) {
+    if (h.count == 0) {
+        return 0;
+    }
+    uint64_t target = ((uint64_t)h.count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += h.buckets[i];
+        if (seen >= target) {
+            uint32_t upper = latencyBucketUpperUs(i);
+            return upper < h.maxUs ? upper : h.maxUs;
+        }
+    }
+    return h.maxUs;
+}
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,168 @@
+#include "Log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#ifdef ENABLE_SDCARD
+#include "SD/SDManager.h"
+extern SDManager sdManager;
+#endif
+
+struct LogLock {
+    portMUX_TYPE mux;
+    LogLock() : mux(portMUX_INITIALIZER_UNLOCKED) {}
+    void lock() { portENTER_CRITICAL_SAFE(&mux); }
+    void unlock() { portEXIT_CRITICAL_SAFE(&mux); }
+};
+
+static LogRing<LOG_RING_SIZE, LogLock> ring;
+static TaskHandle_t logTask = NULL;
+static SemaphoreHandle_t outputMutex = NULL;    // 格式化任务和 logFlush() 共用行缓冲区和SD缓冲区
+
+static const char* const LEVEL_NAMES[] = {"", "ERROR", "WARN", "INFO", "DEBUG", "VERBOSE"};
+
+#if LOG_SD_ENABLED && defined(ENABLE_SDCARD)
+static char sdBuffer[LOG_SD_BUFFER_SIZE];
+static size_t sdUsed = 0;
+
+static void flushSD()
+{
+    if (sdUsed == 0)
+    {
+        return;
+    }
+    sdBuffer[sdUsed - 1] = '\0';    // 最后一行的换行由 appendLine 补上
+    if (sdManager.isInitialized())
+    {
+        sdManager.appendLine(LOG_SD_PATH, sdBuffer);
+    }
+    sdUsed = 0;
+}
+#endif
+
+// 格式化一条记录并输出，调用方持有 outputMutex
+static void emit(const LogRecord& record)
+{
+    char line[LOG_LINE_SIZE];
+    int prefix = snprintf(line, sizeof(line), "[%lu][%s][%s] ", (unsigned long)record.tsMs,
+                          record.level < 6 ? LEVEL_NAMES[record.level] : "?", record.tag);
+    if (prefix < 0 || prefix >= (int)sizeof(line))
+    {
+        return;
+    }
+    size_t len = prefix + logFormatMessage(record, line + prefix, sizeof(line) - prefix);
+    Serial.println(line);
+
+#if LOG_SD_ENABLED && defined(ENABLE_SDCARD)
+    if (sdUsed + len + 1 > sizeof(sdBuffer))
+    {
+        flushSD();
+    }
+    if (len + 1 <= sizeof(sdBuffer))
+    {
+        memcpy(sdBuffer + sdUsed, line, len);
+        sdUsed += len;
+        sdBuffer[sdUsed++] = '\n';
+    }
+#else
+    (void)len;
+#endif
+}
+
+static void drain(bool toSD)
+{
+    LogRecord record;
+    if (outputMutex != NULL)
+    {
+        xSemaphoreTake(outputMutex, portMAX_DELAY);
+    }
+    while (ring.pop(record))
+    {
+        emit(record);
+    }
+#if LOG_SD_ENABLED && defined(ENABLE_SDCARD)
+    if (toSD)
+    {
+        flushSD();
+    }
+#else
+    (void)toSD;
+#endif
+    if (outputMutex != NULL)
+    {
+        xSemaphoreGive(outputMutex);
+    }
+}
+
+static void logTaskMain(void* param)
+{
+    for (;;)
+    {
+#if LOG_SD_ENABLED && defined(ENABLE_SDCARD)
+        // SD卡批量写入：有未写入的内容时最多等 LOG_SD_FLUSH_MS
+        bool timeout = ulTaskNotifyTake(pdTRUE, sdUsed > 0 ? pdMS_TO_TICKS(LOG_SD_FLUSH_MS) : portMAX_DELAY) == 0;
+        drain(timeout);
+#else
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        drain(false);
+#endif
+    }
+}
+
+void logSubmit(const LogRecord& record)
+{
+    if (ring.push(record) != LOG_PUSH_FIRST || logTask == NULL)
+    {
+        return;
+    }
+    // 缓冲区由空变为非空时唤醒一次，格式化任务会取空缓冲区
+    if (xPortInIsrContext())
+    {
+        vTaskNotifyGiveFromISR(logTask, NULL);
+    }
+    else
+    {
+        xTaskNotifyGive(logTask);
+    }
+}
+
+void logBegin()
+{
+    if (logTask != NULL)
+    {
+        return;
+    }
+    outputMutex = xSemaphoreCreateMutex();
+    if (xTaskCreate(logTaskMain, "TaskLog", LOG_TASK_STACK_SIZE, NULL, LOG_TASK_PRIORITY, &logTask) != pdPASS)
+    {
+        Serial.println("[日志] 格式化任务创建失败，日志只在 logFlush() 时输出");
+        logTask = NULL;
+        return;
+    }
+    // 任务创建前已经记录的日志
+    if (ring.pending() > 0)
+    {
+        xTaskNotifyGive(logTask);
+    }
+}
+
+void logFlush()
+{
+    drain(true);
+}
+
+void logPrintStats()
+{
+    Serial.println("=== 日志 ===");
+    Serial.printf("编译级别: %d（高于该级别的日志不在固件中）\n", LOG_COMPILE_LEVEL);
+    Serial.printf("缓冲区: %d 条 x %u 字节, 当前 %lu 条, 最多 %lu 条\n", ring.capacity(),
+                  (unsigned)sizeof(LogRecord), (unsigned long)ring.pending(), (unsigned long)ring.maxPending());
+    Serial.printf("累计记录: %lu 条, 缓冲区满丢弃: %lu 条\n", (unsigned long)ring.totalCount(),
+                  (unsigned long)ring.droppedCount());
+#if LOG_SD_ENABLED && defined(ENABLE_SDCARD)
+    Serial.printf("SD卡输出: %s\n", LOG_SD_PATH);
+#else
+    Serial.println("SD卡输出: 未启用");
+#endif
+    DebugManager::printCurrentLevels();
+}
@@ -0,0 +1,96 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "utils/DebugUtils.h"
+#include "utils/LogRing.h"
+
+/*
+ * 编译期过滤 + 延迟格式化的日志
+ *
+ *   LOGE / LOGW / LOGI / LOGD / LOGV (通道, 格式, 参数...)      例如 LOGD(IMU, "yaw %.1f", yaw)
+ *
+ * - 通道为 LogChannel 去掉 LOG_CH_ 前缀（utils/DebugUtils.h），同时作为输出的标签
+ * - 编译期：级别高于 LOG_COMPILE_LEVEL（config.h，数值同 DebugLevel）的调用展开为 if (0)，
+ *   不生成代码、不求值参数，但仍做 printf 格式检查
+ * - 运行时：各通道级别由 DebugManager 管理（串口 log.level、MQTT、BLE 设置并保存），
+ *   关闭的通道只做一次比较
+ * - 记录：只把格式串指针、标签、时间戳和参数二进制值放进环形缓冲区（见 LogRing.h），
+ *   不格式化、不分配内存，可在中断中调用；缓冲区满时丢弃并计数
+ * - 输出：低优先级任务 TaskLog 取出记录格式化后写串口，LOG_SD_ENABLED 时同时批量追加到SD卡
+ *
+ * 格式串必须是字符串常量；字符串参数复制到记录中（合计 LOG_TEXT_BYTES 字节，超出截断），
+ * String 需要传 c_str()。各模式开销见 tools/bench_log.cpp。
+ */
+
+#if LOG_COMPILE_LEVEL >= 1
+#define LOGE(ch, fmt, ...) LOG_AT(1, ch, fmt, ##__VA_ARGS__)
+#else
+#define LOGE(ch, fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL >= 2
+#define LOGW(ch, fmt, ...) LOG_AT(2, ch, fmt, ##__VA_ARGS__)
+#else
+#define LOGW(ch, fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL >= 3
+#define LOGI(ch, fmt, ...) LOG_AT(3, ch, fmt, ##__VA_ARGS__)
+#else
+#define LOGI(ch, fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL >= 4
+#define LOGD(ch, fmt, ...) LOG_AT(4, ch, fmt, ##__VA_ARGS__)
+#else
+#define LOGD(ch, fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL >= 5
+#define LOGV(ch, fmt, ...) LOG_AT(5, ch, fmt, ##__VA_ARGS__)
+#else
+#define LOGV(ch, fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#define LOG_AT(level, ch, fmt, ...) \
+    do { \
+        if (0) logFormatCheck(fmt, ##__VA_ARGS__); \
+        if (logEnabled(LOG_CH_##ch, level)) { \
+            logWrite(level, #ch, "" fmt "", ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_OFF(fmt, ...) \
+    do { \
+        if (0) logFormatCheck(fmt, ##__VA_ARGS__); \
+    } while (0)
+
+// 只用于编译器检查格式串和参数是否匹配，从不调用
+static inline void logFormatCheck(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void logFormatCheck(const char*, ...) {}
+
+static inline bool logEnabled(LogChannel channel, uint8_t level) {
+    return level <= DebugManager::channelLevel(channel);
+}
+
+// 写入一条记录并在需要时唤醒格式化任务
+void logSubmit(const LogRecord& record);
+
+template <typename... Args>
+static inline void logWrite(uint8_t level, const char* tag, const char* fmt, Args... args) {
+    LogRecord record;
+    logCapture(record, millis(), level, tag, fmt, args...);
+    logSubmit(record);
+}
+
+// 创建格式化任务，在 setup() 中 Serial.begin() 之后调用
+void logBegin();
+
+// 在调用方任务中立即输出缓冲区中的全部记录（进入深度睡眠前）
+void logFlush();
+
+void logPrintStats();
+
+#endif // LOG_H
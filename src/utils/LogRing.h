@@ -0,0 +1,333 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * 延迟格式化日志的记录和格式化
+ *
+ * 记录时只保存格式串指针（字符串常量，地址在本次编译内不变，相当于格式编号）、标签、级别、
+ * 时间戳和参数的二进制值：整数和浮点按 8 字节保存，字符串参数复制到记录内的小缓冲区（可能指向
+ * 调用方的临时缓冲区），超出部分截断。记录放进固定槽位的环形缓冲区，满时丢弃新记录并计数，
+ * 不阻塞调用方。格式化由低优先级任务取出记录后完成（见 utils/Log.h）。
+ *
+ * 格式化时逐个解析转换说明（支持标志、宽度、精度和 *），按保存的参数类型重新组装成单个参数的
+ * snprintf 调用，输出与直接 printf 一致；长度修饰符（l、ll、h、z）由保存的类型决定。
+ *
+ * Lock 需要提供 lock()/unlock()，临界区内只复制一条记录。
+ * 写入开销见 tools/bench_log.cpp。
+ */
+
+#ifndef LOG_MAX_ARGS
+#define LOG_MAX_ARGS 6
+#endif
+
+#ifndef LOG_TEXT_BYTES
+#define LOG_TEXT_BYTES 24       // 字符串参数共用的缓冲区
+#endif
+
+enum LogArgType : uint8_t {
+    LOG_ARG_INT = 1,        // 有符号整数，符号扩展到 64 位
+    LOG_ARG_UINT,           // 无符号整数
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STR,            // 值为 text 中的偏移
+    LOG_ARG_PTR,
+};
+
+union LogValue {
+    int64_t i;
+    uint64_t u;
+    double d;
+};
+
+struct LogRecord {
+    uint32_t tsMs;
+    const char* fmt;
+    const char* tag;
+    uint8_t level;
+    uint8_t nargs;
+    uint8_t textUsed;
+    uint8_t narrow;         // 按位标记原本不超过 32 位的整数，%x 等按 32 位输出
+    uint8_t types[LOG_MAX_ARGS];
+    LogValue args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_BYTES];
+};
+
+// ---------------- 参数捕获 ----------------
+
+static inline void logPutInt(LogRecord& r, LogArgType type, uint64_t bits, bool narrow) {
+    if (r.nargs >= LOG_MAX_ARGS) {
+        return;
+    }
+    r.types[r.nargs] = type;
+    r.args[r.nargs].u = bits;
+    if (narrow) {
+        r.narrow |= (uint8_t)(1u << r.nargs);
+    }
+    r.nargs++;
+}
+
+template <typename T>
+static inline void logPutSigned(LogRecord& r, T v) {
+    logPutInt(r, LOG_ARG_INT, (uint64_t)(int64_t)v, sizeof(T) <= 4);
+}
+
+template <typename T>
+static inline void logPutUnsigned(LogRecord& r, T v) {
+    logPutInt(r, LOG_ARG_UINT, (uint64_t)v, sizeof(T) <= 4);
+}
+
+static inline void logArg(LogRecord& r, char v) { logPutSigned(r, (int)v); }
+static inline void logArg(LogRecord& r, signed char v) { logPutSigned(r, (int)v); }
+static inline void logArg(LogRecord& r, unsigned char v) { logPutUnsigned(r, (unsigned)v); }
+static inline void logArg(LogRecord& r, short v) { logPutSigned(r, (int)v); }
+static inline void logArg(LogRecord& r, unsigned short v) { logPutUnsigned(r, (unsigned)v); }
+static inline void logArg(LogRecord& r, int v) { logPutSigned(r, v); }
+static inline void logArg(LogRecord& r, unsigned v) { logPutUnsigned(r, v); }
+static inline void logArg(LogRecord& r, long v) { logPutSigned(r, v); }
+static inline void logArg(LogRecord& r, unsigned long v) { logPutUnsigned(r, v); }
+static inline void logArg(LogRecord& r, long long v) { logPutSigned(r, v); }
+static inline void logArg(LogRecord& r, unsigned long long v) { logPutUnsigned(r, v); }
+static inline void logArg(LogRecord& r, bool v) { logPutSigned(r, (int)v); }
+
+static inline void logArg(LogRecord& r, double v) {
+    if (r.nargs >= LOG_MAX_ARGS) {
+        return;
+    }
+    r.types[r.nargs] = LOG_ARG_DOUBLE;
+    r.args[r.nargs].d = v;
+    r.nargs++;
+}
+
+static inline void logArg(LogRecord& r, float v) { logArg(r, (double)v); }
+
+static inline void logArg(LogRecord& r, const char* s) {
+    if (r.nargs >= LOG_MAX_ARGS) {
+        return;
+    }
+    if (s == NULL) {
+        s = "(null)";
+    }
+    // 复制到记录内，空间不够时截断，至少保留结尾的 0
+    uint8_t offset = r.textUsed < LOG_TEXT_BYTES ? r.textUsed : LOG_TEXT_BYTES - 1;
+    size_t room = LOG_TEXT_BYTES - offset;
+    size_t len = strlen(s);
+    if (len >= room) {
+        len = room - 1;
+    }
+    memcpy(r.text + offset, s, len);
+    r.text[offset + len] = '\0';
+    r.textUsed = (uint8_t)(offset + len + 1);
+    r.types[r.nargs] = LOG_ARG_STR;
+    r.args[r.nargs].u = offset;
+    r.nargs++;
+}
+
+static inline void logArg(LogRecord& r, char* s) { logArg(r, (const char*)s); }
+
+template <typename T>
+static inline void logArg(LogRecord& r, T* p) {
+    logPutInt(r, LOG_ARG_PTR, (uint64_t)(uintptr_t)p, false);
+}
+
+static inline void logPack(LogRecord&) {}
+
+template <typename T, typename... Rest>
+static inline void logPack(LogRecord& r, T v, Rest... rest) {
+    logArg(r, v);
+    logPack(r, rest...);
+}
+
+template <typename... Args>
+static inline void logCapture(LogRecord& r, uint32_t tsMs, uint8_t level, const char* tag, const char* fmt,
+                              Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "日志参数超过 LOG_MAX_ARGS");
+    r.tsMs = tsMs;
+    r.fmt = fmt;
+    r.tag = tag;
+    r.level = level;
+    r.nargs = 0;
+    r.textUsed = 0;
+    r.narrow = 0;
+    logPack(r, args...);
+}
+
+// ---------------- 环形缓冲区 ----------------
+
+enum LogPushResult : uint8_t {
+    LOG_PUSH_DROPPED = 0,   // 缓冲区满
+    LOG_PUSH_OK,
+    LOG_PUSH_FIRST,         // 缓冲区原本为空，需要唤醒格式化任务
+};
+
+template <int N, typename Lock>
+class LogRing {
+public:
+    LogRing() : head(0), count(0), highWater(0), dropped(0), total(0) {}
+
+    LogPushResult push(const LogRecord& r) {
+        lock.lock();
+        if (count >= N) {
+            dropped++;
+            lock.unlock();
+            return LOG_PUSH_DROPPED;
+        }
+        slots[(head + count) % N] = r;
+        count++;
+        total++;
+        if (count > highWater) {
+            highWater = count;
+        }
+        bool first = count == 1;
+        lock.unlock();
+        return first ? LOG_PUSH_FIRST : LOG_PUSH_OK;
+    }
+
+    bool pop(LogRecord& out) {
+        lock.lock();
+        if (count == 0) {
+            lock.unlock();
+            return false;
+        }
+        out = slots[head];
+        head = (head + 1) % N;
+        count--;
+        lock.unlock();
+        return true;
+    }
+
+    uint32_t pending() const { return count; }
+    uint32_t maxPending() const { return highWater; }
+    uint32_t droppedCount() const { return dropped; }
+    uint32_t totalCount() const { return total; }
+    static int capacity() { return N; }
+
+private:
+    Lock lock;
+    LogRecord slots[N];
+    uint32_t head;
+    volatile uint32_t count;
+    uint32_t highWater;
+    uint32_t dropped;
+    uint32_t total;
+};
+
+// ---------------- 格式化 ----------------
+
+static inline bool logIsFloatConv(char c) {
+    return c == 'f' || c == 'F' || c == 'e' || c == 'E' || c == 'g' || c == 'G' || c == 'a' || c == 'A';
+}
+
+static inline bool logIsUnsignedConv(char c) {
+    return c == 'u' || c == 'x' || c == 'X' || c == 'o';
+}
+
+// 按记录的格式串和参数生成消息文本，返回长度（不含结尾的 0），输出不超过 size - 1 个字符
+static inline size_t logFormatMessage(const LogRecord& r, char* out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t n = 0;
+    int argi = 0;
+    const char* p = r.fmt;
+    while (*p && n + 1 < size) {
+        if (*p != '%') {
+            out[n++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[n++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // %[标志][宽度][.精度][长度]转换
+        char spec[32];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0", *p) && s < 8) {
+            spec[s++] = *p++;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*p != '.') {
+                    break;
+                }
+                spec[s++] = *p++;
+            }
+            if (*p == '*') {
+                p++;
+                int v = 0;
+                if (argi < r.nargs && r.types[argi] != LOG_ARG_STR && r.types[argi] != LOG_ARG_DOUBLE) {
+                    v = (int)r.args[argi].i;
+                }
+                argi++;
+                s += snprintf(spec + s, sizeof(spec) - s - 4, "%d", v);
+            } else {
+                while (*p >= '0' && *p <= '9' && s < 20) {
+                    spec[s++] = *p++;
+                }
+            }
+        }
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;
+        }
+        char conv = *p;
+        if (conv == '\0') {
+            break;
+        }
+        p++;
+
+        char* dst = out + n;
+        size_t room = size - n;
+        int w = 0;
+        if (argi >= r.nargs) {
+            w = snprintf(dst, room, "?");
+        } else {
+            uint8_t type = r.types[argi];
+            const LogValue& v = r.args[argi];
+            bool narrow = (r.narrow >> argi) & 1;
+            argi++;
+            if (type == LOG_ARG_STR) {
+                spec[s++] = 's';
+                spec[s] = '\0';
+                w = snprintf(dst, room, spec, r.text + v.u);
+            } else if (type == LOG_ARG_PTR) {
+                spec[s++] = 'p';
+                spec[s] = '\0';
+                w = snprintf(dst, room, spec, (void*)(uintptr_t)v.u);
+            } else if (type == LOG_ARG_DOUBLE) {
+                spec[s++] = logIsFloatConv(conv) ? conv : 'g';
+                spec[s] = '\0';
+                w = snprintf(dst, room, spec, v.d);
+            } else if (logIsFloatConv(conv)) {
+                spec[s++] = conv;
+                spec[s] = '\0';
+                w = snprintf(dst, room, spec, type == LOG_ARG_INT ? (double)v.i : (double)v.u);
+            } else if (conv == 'c') {
+                spec[s++] = 'c';
+                spec[s] = '\0';
+                w = snprintf(dst, room, spec, (int)v.i);
+            } else {
+                spec[s++] = 'l';
+                spec[s++] = 'l';
+                spec[s++] = (conv == 'd' || conv == 'i' || logIsUnsignedConv(conv)) ? conv : 'd';
+                spec[s] = '\0';
+                uint64_t bits = v.u;
+                if (narrow && logIsUnsignedConv(conv)) {
+                    bits &= 0xFFFFFFFFu;    // 与 32 位 printf("%x", -1) 一致
+                }
+                w = snprintf(dst, room, spec, (long long)bits);
+            }
+        }
+        if (w > 0) {
+            n += (size_t)w < room ? (size_t)w : room - 1;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+#endif // LOG_RING_H
@@ -0,0 +1,260 @@
+#include "PerfMonitor.h"
+#include "config.h"
+#include <ArduinoJson.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef ENABLE_SDCARD
+#include "SD/SDManager.h"
+extern SDManager sdManager;
+#endif
+
+PerfMonitor perfMonitor;
+
+static const char* const PROBE_NAMES[PERF_PROBE_COUNT] = {
+    "task_system", "task_data", "air780eg", "imu", "compass", "ble", "power"};
+
+PerfMonitor::PerfMonitor()
+    : lastRunCount(0),
+      taskCount(0),
+      lastTotalRunTime(0),
+      resetUs(0),
+      lastSampleUs(0),
+      lastSampleCostUs(0),
+      sampleCostUs(0),
+      probeCostNs(0),
+      lastSampleMs(0),
+      lastLogMs(0)
+{
+    for (int i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        latencyReset(hist[i]);
+    }
+    memset(tasks, 0, sizeof(tasks));
+    memset(lastRunTime, 0, sizeof(lastRunTime));
+    memset(lastRunNumber, 0, sizeof(lastRunNumber));
+}
+
+void PerfMonitor::begin()
+{
+    // 标定单次探针耗时：两次取时间戳加一次记录
+    LatencyHistogram scratch;
+    latencyReset(scratch);
+    const int rounds = 1000;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < rounds; i++)
+    {
+        int64_t t = esp_timer_get_time();
+        latencyRecord(scratch, (uint32_t)(esp_timer_get_time() - t));
+    }
+    probeCostNs = (uint32_t)((esp_timer_get_time() - start) * 1000 / rounds);
+    resetUs = esp_timer_get_time();
+    Serial.printf("[性能] 探针开销 %lu ns/次\n", (unsigned long)probeCostNs);
+}
+
+void PerfMonitor::loop()
+{
+    unsigned long now = millis();
+    if (now - lastSampleMs >= PERF_SAMPLE_INTERVAL_MS)
+    {
+        lastSampleMs = now;
+        sample();
+    }
+
+#ifdef ENABLE_SDCARD
+    if (now - lastLogMs >= PERF_LOG_INTERVAL_MS)
+    {
+        lastLogMs = now;
+        if (sdManager.isInitialized())
+        {
+            sdManager.appendLine("/data/perf.log", toJson());
+        }
+    }
+#endif
+}
+
+void PerfMonitor::sample()
+{
+    int64_t start = esp_timer_get_time();
+#if configUSE_TRACE_FACILITY
+    static TaskStatus_t status[PERF_MAX_TASKS];
+    uint32_t totalRunTime = 0;
+    UBaseType_t n = uxTaskGetSystemState(status, PERF_MAX_TASKS, &totalRunTime);
+    if (n == 0)
+    {
+        Serial.printf("[性能] 任务数超过 %d，无法采样\n", PERF_MAX_TASKS);
+        return;
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    uint32_t totalDelta = totalRunTime - lastTotalRunTime;
+#endif
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        PerfTaskInfo& t = tasks[i];
+        strncpy(t.name, status[i].pcTaskName, sizeof(t.name) - 1);
+        t.name[sizeof(t.name) - 1] = '\0';
+        t.number = status[i].xTaskNumber;
+        // ESP-IDF 的栈以字节为单位
+        t.stackFreeBytes = status[i].usStackHighWaterMark;
+        t.priority = (uint8_t)status[i].uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+        t.core = status[i].xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status[i].xCoreID;
+#else
+        t.core = -1;
+#endif
+        t.cpuPermille = 0xFFFF;
+#if configGENERATE_RUN_TIME_STATS
+        // 占用按单个核心计算，双核上两个 IDLE 任务各自接近 100%
+        for (int j = 0; j < lastRunCount; j++)
+        {
+            if (lastRunNumber[j] == t.number && totalDelta > 0 && lastTotalRunTime != 0)
+            {
+                uint32_t delta = status[i].ulRunTimeCounter - lastRunTime[j];
+                t.cpuPermille = (uint16_t)((uint64_t)delta * 1000 / totalDelta);
+                break;
+            }
+        }
+#endif
+    }
+    taskCount = n;
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        lastRunNumber[i] = status[i].xTaskNumber;
+#if configGENERATE_RUN_TIME_STATS
+        lastRunTime[i] = status[i].ulRunTimeCounter;
+#endif
+    }
+    lastRunCount = n;
+    lastTotalRunTime = totalRunTime;
+#endif
+    lastSampleUs = esp_timer_get_time();
+    lastSampleCostUs = (uint32_t)(lastSampleUs - start);
+    sampleCostUs += lastSampleCostUs;
+}
+
+void PerfMonitor::reset()
+{
+    for (int i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        latencyReset(hist[i]);
+    }
+    sampleCostUs = 0;
+    resetUs = esp_timer_get_time();
+}
+
+// 统计开销占经过时间的千分比
+uint32_t PerfMonitor::overheadPermille()
+{
+    int64_t elapsed = esp_timer_get_time() - resetUs;
+    if (elapsed <= 0)
+    {
+        return 0;
+    }
+    uint64_t probes = 0;
+    for (int i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        probes += hist[i].count;
+    }
+    uint64_t costUs = probes * probeCostNs / 1000 + sampleCostUs;
+    return (uint32_t)(costUs * 1000 / elapsed);
+}
+
+void PerfMonitor::printReport()
+{
+    int64_t elapsed = esp_timer_get_time() - resetUs;
+    uint32_t seconds = (uint32_t)(elapsed / 1000000);
+    uint32_t ovh = overheadPermille();
+
+    Serial.println("=== 性能统计 ===");
+    Serial.printf("统计时长: %lu 秒, 统计开销: %lu.%lu%% (探针 %lu ns/次, 上次采样 %lu us)\n", (unsigned long)seconds,
+                  (unsigned long)(ovh / 10), (unsigned long)(ovh % 10), (unsigned long)probeCostNs,
+                  (unsigned long)lastSampleCostUs);
+    Serial.printf("内存: 空闲 %lu B, 最低 %lu B, 最大块 %lu B\n", (unsigned long)ESP.getFreeHeap(),
+                  (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap());
+
+    Serial.println("--- 任务 ---");
+    if (taskCount == 0)
+    {
+        Serial.println("尚未采样（SDK未开启任务跟踪时只有循环耗时）");
+    }
+    else
+    {
+        Serial.println("  名称             核心 优先级    CPU   栈余量");
+        for (int i = 0; i < taskCount; i++)
+        {
+            const PerfTaskInfo& t = tasks[i];
+            char cpu[12];
+            if (t.cpuPermille == 0xFFFF)
+            {
+                snprintf(cpu, sizeof(cpu), "-");
+            }
+            else
+            {
+                snprintf(cpu, sizeof(cpu), "%u.%u%%", t.cpuPermille / 10, t.cpuPermille % 10);
+            }
+            Serial.printf("  %-16s %4d %6u %7s %6lu B\n", t.name, t.core, t.priority, cpu,
+                          (unsigned long)t.stackFreeBytes);
+        }
+    }
+
+    Serial.println("--- 循环耗时 (us) ---");
+    Serial.println("  探针              次数     平均     p50     p99     最大   忙碌");
+    for (int i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        const LatencyHistogram& h = hist[i];
+        uint32_t busy = elapsed > 0 ? (uint32_t)(h.sumUs * 1000 / elapsed) : 0;
+        Serial.printf("  %-12s %10lu %8lu %7lu %7lu %8lu %3lu.%lu%%\n", PROBE_NAMES[i], (unsigned long)h.count,
+                      (unsigned long)latencyMeanUs(h), (unsigned long)latencyPercentileUs(h, 500),
+                      (unsigned long)latencyPercentileUs(h, 990), (unsigned long)h.maxUs,
+                      (unsigned long)(busy / 10), (unsigned long)(busy % 10));
+    }
+}
+
+// 上报诊断数据
+// {"up":秒,"ovh":统计开销‰,"heap":[空闲,最低,最大块],"tasks":[[名称,CPU‰,栈余量],..],"loops":{"imu":[次数,平均,p99,最大,忙碌‰],..}}
+String PerfMonitor::toJson()
+{
+    int64_t elapsed = esp_timer_get_time() - resetUs;
+    DynamicJsonDocument doc(2048);
+    doc["up"] = (uint32_t)(esp_timer_get_time() / 1000000);
+    doc["ovh"] = overheadPermille();
+    JsonArray heap = doc.createNestedArray("heap");
+    heap.add(ESP.getFreeHeap());
+    heap.add(ESP.getMinFreeHeap());
+    heap.add(ESP.getMaxAllocHeap());
+
+    JsonArray taskArr = doc.createNestedArray("tasks");
+    for (int i = 0; i < taskCount; i++)
+    {
+        JsonArray t = taskArr.createNestedArray();
+        t.add(tasks[i].name);
+        if (tasks[i].cpuPermille == 0xFFFF)
+        {
+            t.add(nullptr);
+        }
+        else
+        {
+            t.add(tasks[i].cpuPermille);
+        }
+        t.add(tasks[i].stackFreeBytes);
+    }
+
+    JsonObject loops = doc.createNestedObject("loops");
+    for (int i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        const LatencyHistogram& h = hist[i];
+        JsonArray l = loops.createNestedArray(PROBE_NAMES[i]);
+        l.add(h.count);
+        l.add(latencyMeanUs(h));
+        l.add(latencyPercentileUs(h, 990));
+        l.add(h.maxUs);
+        l.add(elapsed > 0 ? (uint32_t)(h.sumUs * 1000 / elapsed) : 0);
+    }
+    return doc.as<String>();
+}
+
+const char* PerfMonitor::probeName(PerfProbe probe)
+{
+    return probe < PERF_PROBE_COUNT ? PROBE_NAMES[probe] : "?";
+}
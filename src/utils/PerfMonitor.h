@@ -0,0 +1,109 @@
+#ifndef PERF_MONITOR_H
+#define PERF_MONITOR_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "utils/LatencyHistogram.h"
+#include "utils/Trace.h"
+
+/*
+ * 任务负载、栈余量和子系统循环耗时统计
+ *
+ * - 子系统循环耗时：在任务循环中用 PerfScope 包住 air780eg.loop()、imu.loop() 等调用，
+ *   每次迭代记入直方图（见 LatencyHistogram.h），任务整个循环体也各有一个探针，
+ *   探针耗时之和除以经过时间即为该任务的忙碌比例（不需要 FreeRTOS 运行时统计）
+ * - 任务统计：每 PERF_SAMPLE_INTERVAL_MS 取一次 FreeRTOS 任务状态，得到各任务的栈余量；
+ *   SDK 开启了运行时统计（configGENERATE_RUN_TIME_STATS）时同时计算各任务的CPU占用
+ * - 输出：串口命令 perf、MQTT diag/perf 主题、SD卡 /data/perf.log（每 PERF_LOG_INTERVAL_MS 一行JSON）
+ *
+ * 超过 TRACE_SLOW_SLICE_US 的单次循环同时记入事件跟踪（见 Trace.h），异常复位后可以看到复位前卡在哪里。
+ *
+ * 统计本身的开销（探针次数 × 标定的单次耗时 + 采样耗时）一并统计，目标低于 1% CPU。
+ */
+
+enum PerfProbe : uint8_t {
+    PERF_TASK_SYSTEM = 0,   // TaskSystem 循环体（不含 delay）
+    PERF_TASK_DATA,         // TaskData 循环体（不含 delay）
+    PERF_AIR780EG,          // air780eg.loop()
+    PERF_IMU,               // imu.loop()
+    PERF_COMPASS,           // compass.loop()
+    PERF_BLE,               // bs.loop()
+    PERF_POWER,             // powerManager.loop()
+    PERF_PROBE_COUNT
+};
+
+#define PERF_MAX_TASKS 24
+
+struct PerfTaskInfo {
+    char name[16];
+    uint32_t number;            // FreeRTOS 任务编号，用于和上一次采样对应
+    uint32_t stackFreeBytes;    // 栈历史最低余量
+    uint16_t cpuPermille;       // 上一个采样周期的CPU占用（千分比），不支持时为 0xFFFF
+    uint8_t priority;
+    int8_t core;                // 绑定的核心，-1 为不绑定
+};
+
+class PerfMonitor {
+public:
+    PerfMonitor();
+
+    // 标定探针开销，在任务创建前调用
+    void begin();
+
+    // 定期采样任务状态并写SD卡日志，在 TaskData 中调用
+    void loop();
+
+    inline void record(PerfProbe probe, uint32_t us) {
+        if (probe < PERF_PROBE_COUNT) {
+            latencyRecord(hist[probe], us);
+        }
+    }
+
+    void sample();
+    void reset();
+
+    void printReport();
+    String toJson();
+
+    static const char* probeName(PerfProbe probe);
+
+private:
+    LatencyHistogram hist[PERF_PROBE_COUNT];
+    PerfTaskInfo tasks[PERF_MAX_TASKS];
+    uint32_t lastRunTime[PERF_MAX_TASKS];
+    uint32_t lastRunNumber[PERF_MAX_TASKS];
+    int lastRunCount;
+    int taskCount;
+    uint32_t lastTotalRunTime;
+    int64_t resetUs;
+    int64_t lastSampleUs;
+    uint32_t lastSampleCostUs;
+    uint64_t sampleCostUs;      // 采样累计耗时
+    uint32_t probeCostNs;       // 单次探针（两次取时间戳和记录）的标定耗时
+    unsigned long lastSampleMs;
+    unsigned long lastLogMs;
+
+    uint32_t overheadPermille();
+};
+
+extern PerfMonitor perfMonitor;
+
+// 作用域计时：PerfScope scope(PERF_IMU); imu.loop();
+class PerfScope {
+public:
+    explicit PerfScope(PerfProbe probe) : probe(probe), startUs(esp_timer_get_time()) {}
+    ~PerfScope() {
+        uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+        perfMonitor.record(probe, us);
+        if (us >= TRACE_SLOW_SLICE_US) {
+            uint32_t ms = us / 1000;
+            trace.record(TRACE_SLICE, probe, (uint16_t)(ms > 0xFFFF ? 0xFFFF : ms), (uint32_t)startUs);
+        }
+    }
+
+private:
+    PerfProbe probe;
+    int64_t startUs;
+};
+
+#endif // PERF_MONITOR_H
@@ -89,4 +89,27 @@ void PreferencesUtils::saveSleepTime(unsigned long seconds) {
     prefs.begin(NS_POWER, false);
     prefs.putULong(KEY_SLEEP_TIME, seconds);
     prefs.end();
-}
\ No newline at end of file
+}
+
+// 日志级别，返回读到的字节数
+size_t PreferencesUtils::loadLogLevels(uint8_t* levels, size_t maxLen) {
+    Preferences prefs;
+    if (!prefs.begin(NS_LOG, true)) return 0;
+    size_t len = prefs.getBytes(KEY_LOG_LEVELS, levels, maxLen);
+    prefs.end();
+    return len;
+}
+
+void PreferencesUtils::saveLogLevels(const uint8_t* levels, size_t len) {
+    Preferences prefs;
+    prefs.begin(NS_LOG, false);
+    prefs.putBytes(KEY_LOG_LEVELS, levels, len);
+    prefs.end();
+}
+
+void PreferencesUtils::clearLogLevels() {
+    Preferences prefs;
+    prefs.begin(NS_LOG, false);
+    prefs.remove(KEY_LOG_LEVELS);
+    prefs.end();
+}
@@ -0,0 +1,166 @@
+#include "SensorHealth.h"
+#include <ArduinoJson.h>
+#include "utils/Trace.h"
+#include "utils/Log.h"
+
+static const SensorHealthConfig IMU_HEALTH_CONFIG = {
+    SENSOR_HEALTH_CHECK_MS,
+    IMU_HEALTH_TIMEOUT_MS,
+    IMU_HEALTH_STUCK_SAMPLES,
+    SENSOR_HEALTH_READ_ERROR_LIMIT,
+    SENSOR_HEALTH_FAULTS_TO_FAIL,
+    SENSOR_HEALTH_BACKOFF_MIN_MS,
+    SENSOR_HEALTH_BACKOFF_MAX_MS,
+};
+
+static const SensorHealthConfig COMPASS_HEALTH_CONFIG = {
+    SENSOR_HEALTH_CHECK_MS,
+    COMPASS_HEALTH_TIMEOUT_MS,
+    COMPASS_HEALTH_STUCK_SAMPLES,
+    SENSOR_HEALTH_READ_ERROR_LIMIT,
+    SENSOR_HEALTH_FAULTS_TO_FAIL,
+    SENSOR_HEALTH_BACKOFF_MIN_MS,
+    SENSOR_HEALTH_BACKOFF_MAX_MS,
+};
+
+static const char* const SENSOR_NAMES[SENSOR_COUNT] = {"imu", "compass"};
+
+SensorHealth sensorHealth;
+
+SensorHealth::SensorHealth()
+    : monitors{SensorHealthMonitor(IMU_HEALTH_CONFIG), SensorHealthMonitor(COMPASS_HEALTH_CONFIG)}
+{
+}
+
+const char* SensorHealth::sensorName(SensorId id)
+{
+    return id < SENSOR_COUNT ? SENSOR_NAMES[id] : "?";
+}
+
+void SensorHealth::reportFailed(SensorId id)
+{
+    const SensorHealthMonitor& m = monitors[id];
+    LOGW(SYS, "传感器 %s 故障（%s），停止读取并尝试恢复", sensorName(id), sensorFaultName(m.lastFault()));
+    trace.error(TRACE_ID_SENSOR_FAIL, (uint16_t)((id << 8) | m.lastFault()));
+}
+
+void SensorHealth::reportRecovery(SensorId id, SensorRecoveryAction action, bool ok)
+{
+    const SensorHealthMonitor& m = monitors[id];
+    const char* how = action == SENSOR_RECOVER_BUS_RESET ? "复位总线并重新初始化" : "重新初始化";
+    if (ok)
+    {
+        LOGI(SYS, "传感器 %s %s成功（第 %lu 次），等待数据确认", sensorName(id), how,
+             (unsigned long)m.attemptsInEpisode());
+    }
+    else
+    {
+        LOGW(SYS, "传感器 %s %s失败（第 %lu 次），%lu 秒后重试", sensorName(id), how,
+             (unsigned long)m.attemptsInEpisode(), (unsigned long)(m.currentBackoffMs() / 1000));
+    }
+    trace.instant(TRACE_ID_SENSOR_RECOVER, (uint16_t)((id << 8) | (action << 1) | (ok ? 1 : 0)));
+}
+
+void SensorHealth::retryAll()
+{
+    uint32_t now = millis();
+    for (int i = 0; i < SENSOR_COUNT; i++)
+    {
+        monitors[i].retryNow(now);
+    }
+}
+
+void SensorHealth::resetStats()
+{
+    uint32_t now = millis();
+    for (int i = 0; i < SENSOR_COUNT; i++)
+    {
+        monitors[i].resetStats(now);
+    }
+}
+
+void SensorHealth::printStatus()
+{
+    uint32_t now = millis();
+    Serial.println("=== 传感器健康状态 ===");
+    Serial.printf("检查周期 %d ms，连续 %d 次异常判为故障，恢复间隔 %lu ~ %lu 秒\n", SENSOR_HEALTH_CHECK_MS,
+                  SENSOR_HEALTH_FAULTS_TO_FAIL, (unsigned long)(SENSOR_HEALTH_BACKOFF_MIN_MS / 1000),
+                  (unsigned long)(SENSOR_HEALTH_BACKOFF_MAX_MS / 1000));
+    for (int i = 0; i < SENSOR_COUNT; i++)
+    {
+        const SensorHealthMonitor& m = monitors[i];
+        const SensorHealthStats& s = m.stats();
+        Serial.printf("[%s] %s", SENSOR_NAMES[i], sensorHealthStatusName(m.status()));
+        if (m.lastFault() != SENSOR_FAULT_NONE)
+        {
+            Serial.printf("，最近异常: %s", sensorFaultName(m.lastFault()));
+        }
+        if (m.status() == SENSOR_FAILED)
+        {
+            Serial.printf("，已恢复 %lu 次未成功，%lu 秒后重试", (unsigned long)m.attemptsInEpisode(),
+                          (unsigned long)(m.msUntilRetry(now) / 1000));
+        }
+        Serial.println();
+        Serial.printf("  采样 %lu，读取失败 %lu，芯片ID错误 %lu，无数据 %lu，数据不变 %lu\n", (unsigned long)s.samples,
+                      (unsigned long)s.readErrors, (unsigned long)s.idErrors, (unsigned long)s.timeouts,
+                      (unsigned long)s.stuck);
+        Serial.printf("  故障 %lu 次，恢复尝试 %lu 次，恢复 %lu 次，累计故障 %lu 秒\n", (unsigned long)s.failures,
+                      (unsigned long)s.recoveryAttempts, (unsigned long)s.recoveries,
+                      (unsigned long)(m.downMs(now) / 1000));
+    }
+}
+
+// {"imu":[状态,最近异常,采样,读取失败,ID错误,无数据,数据不变,故障,恢复尝试,恢复,故障秒数],...}
+String SensorHealth::toJson()
+{
+    uint32_t now = millis();
+    StaticJsonDocument<512> doc;
+    for (int i = 0; i < SENSOR_COUNT; i++)
+    {
+        const SensorHealthMonitor& m = monitors[i];
+        const SensorHealthStats& s = m.stats();
+        JsonArray a = doc.createNestedArray(SENSOR_NAMES[i]);
+        a.add(m.status());
+        a.add(m.lastFault());
+        a.add(s.samples);
+        a.add(s.readErrors);
+        a.add(s.idErrors);
+        a.add(s.timeouts);
+        a.add(s.stuck);
+        a.add(s.failures);
+        a.add(s.recoveryAttempts);
+        a.add(s.recoveries);
+        a.add(m.downMs(now) / 1000);
+    }
+    return doc.as<String>();
+}
+
+bool SensorHealth::recoverBus(TwoWire& wire, int sda, int scl)
+{
+    wire.end();
+    pinMode(sda, INPUT_PULLUP);
+    pinMode(scl, OUTPUT_OPEN_DRAIN);
+    digitalWrite(scl, HIGH);
+    delayMicroseconds(5);
+    for (int i = 0; i < 9 && digitalRead(sda) == LOW; i++)
+    {
+        digitalWrite(scl, LOW);
+        delayMicroseconds(5);
+        digitalWrite(scl, HIGH);
+        delayMicroseconds(5);
+    }
+    // STOP：SCL 为高时 SDA 由低变高
+    pinMode(sda, OUTPUT_OPEN_DRAIN);
+    digitalWrite(sda, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sda, HIGH);
+    delayMicroseconds(5);
+    pinMode(sda, INPUT_PULLUP);
+    pinMode(scl, INPUT_PULLUP);
+    bool released = digitalRead(sda) == HIGH;
+    if (!released)
+    {
+        LOGW(SYS, "I2C 总线恢复后 SDA(GPIO%d) 仍为低", sda);
+    }
+    return released;
+}
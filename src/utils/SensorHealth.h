@@ -0,0 +1,58 @@
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "config.h"
+#include "utils/SensorHealthLogic.h"
+
+/*
+ * 传感器健康状态
+ *
+ * 每个可选传感器一个 SensorHealthMonitor（判定和退避见 SensorHealthLogic.h），
+ * 驱动在自己的 loop() 中检查和恢复，与数据读取在同一个任务，不会与重新初始化并发。
+ * 故障期间驱动把对应的 xxxReady 状态置为 false，依赖它的功能（振动分析、运动检测、航向）自行降级；
+ * 可选传感器故障不重启系统。
+ *
+ * 判为故障和恢复记入事件跟踪，统计用串口命令 sensors 查看，并定期通过 MQTT diag/sensors 上报。
+ */
+
+enum SensorId : uint8_t {
+    SENSOR_IMU = 0,
+    SENSOR_COMPASS,
+    SENSOR_COUNT
+};
+
+class SensorHealth {
+public:
+    SensorHealth();
+
+    SensorHealthMonitor& monitor(SensorId id) { return monitors[id]; }
+
+    // 驱动调用：记录判为故障和恢复结果（输出日志和事件跟踪）
+    void reportFailed(SensorId id);
+    void reportRecovery(SensorId id, SensorRecoveryAction action, bool ok);
+
+    // 故障的传感器立即重试（串口命令 sensors.retry）
+    void retryAll();
+    void resetStats();
+
+    void printStatus();
+    String toJson();
+
+    static const char* sensorName(SensorId id);
+
+    /**
+     * @brief I2C 总线恢复：从设备在传输中途复位时可能一直拉低 SDA，
+     * 结束总线后手动输出最多 9 个 SCL 脉冲让它移出剩余的位，再产生 STOP
+     * @return SDA 是否已释放；之后由驱动重新初始化（会重新调用 begin）
+     */
+    static bool recoverBus(TwoWire& wire, int sda, int scl);
+
+private:
+    SensorHealthMonitor monitors[SENSOR_COUNT];
+};
+
+extern SensorHealth sensorHealth;
+
+#endif // SENSOR_HEALTH_H
@@ -0,0 +1,306 @@
+#ifndef SENSOR_HEALTH_LOGIC_H
+#define SENSOR_HEALTH_LOGIC_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 传感器健康监测和故障恢复
+ *
+ * 驱动每次读到数据时调用 onSample()（附带原始值的指纹），查询时数据未就绪调用 onNoData()，
+ * 读取失败时调用 onReadError()，每次循环调用 due() 取得要做的事：
+ * - SENSOR_DO_CHECK：读芯片 ID 后调用 check()。芯片 ID 不对、驱动持续查询超过 dataTimeoutMs 没有新数据、
+ *   连续 stuckSamples 个采样完全相同、检查周期内读取失败超过 readErrorLimit 次，都记为一次异常；
+ *   连续 faultsToFail 次检查异常时判为故障
+ * - SENSOR_DO_RECOVER：故障后按 recoveryAction() 恢复（重新初始化芯片，或先复位 I2C 总线再初始化），
+ *   结果交给 recovered()。失败后等待时间从 backoffMinMs 起每次加倍，最长 backoffMaxMs，
+ *   恢复后通过一次检查才结束本次故障，反复故障时等待时间继续增加
+ * 故障期间 usable() 为 false，驱动不读取传感器，依赖它的功能按传感器不可用处理，不重启系统。
+ *
+ * 无数据只按 onNoData() 的时间计算：驱动所在任务被其他工作阻塞、浅睡眠期间没有查询，不算传感器无数据。
+ * 时间为 millis()，按差值比较，回绕不影响。
+ * 故障场景的仿真见 tools/sensor_health_sim.cpp。
+ */
+
+enum SensorHealthStatus : uint8_t {
+    SENSOR_OK = 0,
+    SENSOR_DEGRADED,        // 最近的检查有异常，尚未判为故障，仍然读取
+    SENSOR_FAILED,          // 故障，停止读取，等待恢复
+};
+
+enum SensorFault : uint8_t {
+    SENSOR_FAULT_NONE = 0,
+    SENSOR_FAULT_INIT,      // 初始化或恢复失败
+    SENSOR_FAULT_ID,        // 芯片 ID 不对或没有应答
+    SENSOR_FAULT_TIMEOUT,   // 没有新数据
+    SENSOR_FAULT_STUCK,     // 数据不变
+    SENSOR_FAULT_READ,      // 读取失败过多
+};
+
+enum SensorHealthDue : uint8_t {
+    SENSOR_DO_NOTHING = 0,
+    SENSOR_DO_CHECK,
+    SENSOR_DO_RECOVER,
+};
+
+enum SensorRecoveryAction : uint8_t {
+    SENSOR_RECOVER_REINIT = 0,  // 重新初始化芯片
+    SENSOR_RECOVER_BUS_RESET,   // 复位 I2C 总线（释放被拉低的 SDA）后重新初始化
+};
+
+struct SensorHealthConfig {
+    uint32_t checkIntervalMs;
+    uint32_t dataTimeoutMs;
+    uint16_t stuckSamples;      // 0 为不检查
+    uint16_t readErrorLimit;
+    uint8_t faultsToFail;
+    uint32_t backoffMinMs;
+    uint32_t backoffMaxMs;
+};
+
+struct SensorHealthStats {
+    uint32_t samples;
+    uint32_t readErrors;
+    uint32_t idErrors;          // 各类异常的检查次数
+    uint32_t timeouts;
+    uint32_t stuck;
+    uint32_t failures;          // 判为故障的次数
+    uint32_t recoveryAttempts;
+    uint32_t recoveries;        // 恢复成功并通过检查的次数
+    uint32_t downMs;            // 已结束的故障累计时长
+};
+
+static inline const char* sensorHealthStatusName(uint8_t status) {
+    switch (status) {
+    case SENSOR_OK: return "正常";
+    case SENSOR_DEGRADED: return "异常";
+    case SENSOR_FAILED: return "故障";
+    default: return "?";
+    }
+}
+
+static inline const char* sensorFaultName(uint8_t fault) {
+    switch (fault) {
+    case SENSOR_FAULT_INIT: return "初始化失败";
+    case SENSOR_FAULT_ID: return "芯片ID错误";
+    case SENSOR_FAULT_TIMEOUT: return "无数据";
+    case SENSOR_FAULT_STUCK: return "数据不变";
+    case SENSOR_FAULT_READ: return "读取失败";
+    default: return "无";
+    }
+}
+
+// 原始数据的指纹（FNV-1a），用于判断连续采样是否完全相同
+static inline uint32_t sensorFingerprint(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+class SensorHealthMonitor {
+public:
+    explicit SensorHealthMonitor(const SensorHealthConfig& config)
+        : cfg(config), state(SENSOR_FAILED), fault(SENSOR_FAULT_NONE), began(false), inEpisode(false),
+          waitingData(false), consecutiveFaults(0), attempts(0), lastFingerprint(0), sameCount(0), errorsSinceCheck(0),
+          noDataSinceMs(0), lastNoDataMs(0), lastCheckMs(0), nextAttemptMs(0), failedSinceMs(0), backoffMs(0) {
+        memset(&st, 0, sizeof(st));
+    }
+
+    // 初始化结果；失败时按退避时间重试，不在启动流程中反复等待
+    void begin(uint32_t nowMs, bool ok) {
+        began = true;
+        if (ok) {
+            markHealthy(nowMs);
+            return;
+        }
+        fault = SENSOR_FAULT_INIT;
+        enterFailed(nowMs);
+        scheduleRetry(nowMs);
+    }
+
+    void onSample(uint32_t fingerprint) {
+        st.samples++;
+        waitingData = false;
+        if (fingerprint == lastFingerprint) {
+            if (sameCount < 0xFFFF) {
+                sameCount++;
+            }
+        } else {
+            sameCount = 0;
+            lastFingerprint = fingerprint;
+        }
+    }
+
+    // 查询时数据未就绪，从第一次未就绪到最近一次未就绪的时间超过 dataTimeoutMs 为无数据
+    void onNoData(uint32_t nowMs) {
+        if (!waitingData) {
+            waitingData = true;
+            noDataSinceMs = nowMs;
+        }
+        lastNoDataMs = nowMs;
+    }
+
+    void onReadError() {
+        st.readErrors++;
+        errorsSinceCheck++;
+    }
+
+    SensorHealthDue due(uint32_t nowMs) const {
+        if (!began) {
+            return SENSOR_DO_NOTHING;
+        }
+        if (state == SENSOR_FAILED) {
+            return (int32_t)(nowMs - nextAttemptMs) >= 0 ? SENSOR_DO_RECOVER : SENSOR_DO_NOTHING;
+        }
+        return nowMs - lastCheckMs >= cfg.checkIntervalMs ? SENSOR_DO_CHECK : SENSOR_DO_NOTHING;
+    }
+
+    // 周期检查，idOk 为芯片 ID 读取结果；返回是否刚判为故障
+    bool check(uint32_t nowMs, bool idOk) {
+        lastCheckMs = nowMs;
+        uint8_t found = SENSOR_FAULT_NONE;
+        if (!idOk) {
+            st.idErrors++;
+            found = SENSOR_FAULT_ID;
+        } else if (waitingData && lastNoDataMs - noDataSinceMs > cfg.dataTimeoutMs) {
+            st.timeouts++;
+            found = SENSOR_FAULT_TIMEOUT;
+        } else if (cfg.stuckSamples > 0 && sameCount >= cfg.stuckSamples) {
+            st.stuck++;
+            found = SENSOR_FAULT_STUCK;
+        } else if (errorsSinceCheck > cfg.readErrorLimit) {
+            found = SENSOR_FAULT_READ;
+        }
+        errorsSinceCheck = 0;
+
+        if (found == SENSOR_FAULT_NONE) {
+            consecutiveFaults = 0;
+            state = SENSOR_OK;
+            if (inEpisode) {
+                // 恢复后第一次检查通过，本次故障结束
+                inEpisode = false;
+                attempts = 0;
+                backoffMs = 0;
+                st.recoveries++;
+                st.downMs += nowMs - failedSinceMs;
+            }
+            return false;
+        }
+
+        fault = found;
+        if (++consecutiveFaults < cfg.faultsToFail) {
+            state = SENSOR_DEGRADED;
+            return false;
+        }
+        enterFailed(nowMs);
+        // 第一次恢复立即进行；恢复后又出现异常的，等待时间继续加倍
+        if (attempts == 0) {
+            nextAttemptMs = nowMs;
+        } else {
+            scheduleRetry(nowMs);
+        }
+        return true;
+    }
+
+    // 本次恢复应执行的动作：重新初始化和复位总线交替进行
+    SensorRecoveryAction recoveryAction() const {
+        return (attempts & 1) ? SENSOR_RECOVER_BUS_RESET : SENSOR_RECOVER_REINIT;
+    }
+
+    void recovered(uint32_t nowMs, bool ok) {
+        st.recoveryAttempts++;
+        attempts++;
+        if (!ok) {
+            fault = SENSOR_FAULT_INIT;
+            scheduleRetry(nowMs);
+            return;
+        }
+        // 恢复成功，数据从现在开始计时；是否真正恢复由下一次检查确认
+        state = SENSOR_DEGRADED;
+        consecutiveFaults = cfg.faultsToFail > 0 ? cfg.faultsToFail - 1 : 0;
+        sameCount = 0;
+        errorsSinceCheck = 0;
+        waitingData = false;
+        lastCheckMs = nowMs;
+    }
+
+    // 故障后重新开始（例如串口命令手动重试），下一次 due() 立即恢复
+    void retryNow(uint32_t nowMs) {
+        if (state == SENSOR_FAILED) {
+            nextAttemptMs = nowMs;
+        }
+    }
+
+    bool usable() const { return began && state != SENSOR_FAILED; }
+    uint8_t status() const { return state; }
+    uint8_t lastFault() const { return fault; }
+    uint32_t attemptsInEpisode() const { return attempts; }
+    uint32_t currentBackoffMs() const { return backoffMs; }
+    uint32_t msUntilRetry(uint32_t nowMs) const {
+        return state == SENSOR_FAILED && (int32_t)(nextAttemptMs - nowMs) > 0 ? nextAttemptMs - nowMs : 0;
+    }
+    // 累计故障时长，包括正在进行的故障
+    uint32_t downMs(uint32_t nowMs) const { return st.downMs + (inEpisode ? nowMs - failedSinceMs : 0); }
+    const SensorHealthStats& stats() const { return st; }
+
+    // 正在进行的故障从现在开始重新计时
+    void resetStats(uint32_t nowMs) {
+        memset(&st, 0, sizeof(st));
+        if (inEpisode) {
+            failedSinceMs = nowMs;
+        }
+    }
+
+private:
+    SensorHealthConfig cfg;
+    SensorHealthStats st;
+    uint8_t state;
+    uint8_t fault;
+    bool began;
+    bool inEpisode;
+    bool waitingData;           // 上次采样之后查询过且数据未就绪
+    uint8_t consecutiveFaults;
+    uint32_t attempts;          // 本次故障的恢复次数
+    uint32_t lastFingerprint;
+    uint16_t sameCount;
+    uint16_t errorsSinceCheck;
+    uint32_t noDataSinceMs;
+    uint32_t lastNoDataMs;
+    uint32_t lastCheckMs;
+    uint32_t nextAttemptMs;
+    uint32_t failedSinceMs;
+    uint32_t backoffMs;
+
+    void markHealthy(uint32_t nowMs) {
+        state = SENSOR_OK;
+        consecutiveFaults = 0;
+        sameCount = 0;
+        errorsSinceCheck = 0;
+        waitingData = false;
+        lastCheckMs = nowMs;
+    }
+
+    void enterFailed(uint32_t nowMs) {
+        state = SENSOR_FAILED;
+        consecutiveFaults = 0;
+        if (!inEpisode) {
+            inEpisode = true;
+            failedSinceMs = nowMs;
+            st.failures++;
+        }
+    }
+
+    void scheduleRetry(uint32_t nowMs) {
+        if (backoffMs == 0) {
+            backoffMs = cfg.backoffMinMs;
+        } else {
+            backoffMs = backoffMs > cfg.backoffMaxMs / 2 ? cfg.backoffMaxMs : backoffMs * 2;
+        }
+        nextAttemptMs = nowMs + backoffMs;
+    }
+};
+
+#endif // SENSOR_HEALTH_LOGIC_H
@@ -0,0 +1,263 @@
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 串口二进制帧（与文本命令共用同一个串口）
+ *
+ * 帧格式：0x00 COBS(类型 序号 负载... CRC16) 0x00
+ *   类型   命令或应答编号（SERIAL_FRAME_*），应答为请求类型 | 0x80
+ *   序号   请求方填写，应答原样带回，用于匹配请求
+ *   CRC16  CRC-16/CCITT-FALSE（多项式 0x1021，初值 0xFFFF），覆盖类型到负载末尾，小端
+ *
+ * COBS 编码后帧内不含 0x00，文本（UTF-8）也从不含 0x00，所以接收端按字节区分：
+ * 文本状态下收到 0x00 进入帧状态，帧状态下再收到 0x00 结束并解码帧，然后回到文本状态；
+ * 其余字节在文本状态下按行（'\n'）组成文本命令。两端都用同一规则，设备的日志输出和帧应答可以交错。
+ *
+ * 解析逐字节进行，不阻塞，不分配内存。
+ * 主机端测试见 tools/serial_frame_sim.cpp，上位机实现见 monitor_serial.py。
+ */
+
+#ifndef SERIAL_FRAME_MAX_PAYLOAD
+#define SERIAL_FRAME_MAX_PAYLOAD 512
+#endif
+
+#ifndef SERIAL_LINE_MAX
+#define SERIAL_LINE_MAX 128
+#endif
+
+#define SERIAL_FRAME_OVERHEAD 4     // 类型、序号、CRC16
+#define SERIAL_FRAME_MAX_RAW (SERIAL_FRAME_MAX_PAYLOAD + SERIAL_FRAME_OVERHEAD)
+// COBS 每 254 字节最多多 1 字节，再加首尾分隔符
+#define SERIAL_FRAME_MAX_ENCODED (SERIAL_FRAME_MAX_RAW + SERIAL_FRAME_MAX_RAW / 254 + 1 + 2)
+
+enum SerialFrameType : uint8_t {
+    SERIAL_FRAME_PING = 0x01,           // 应答：运行毫秒数 u32，固件版本字符串
+    SERIAL_FRAME_TEXT = 0x02,           // 负载为文本命令，输出仍为文本，执行完后应答
+    SERIAL_FRAME_TELEMETRY_START = 0x10,// 负载：间隔毫秒 u16
+    SERIAL_FRAME_TELEMETRY_STOP = 0x11,
+    SERIAL_FRAME_FILE_INFO = 0x20,      // 负载：路径；应答：文件大小 u32
+    SERIAL_FRAME_FILE_READ = 0x21,      // 负载：偏移 u32，长度 u16，路径；应答：偏移 u32，数据
+
+    SERIAL_FRAME_REPLY = 0x80,          // 应答类型 = 请求类型 | 0x80
+    SERIAL_FRAME_TELEMETRY = 0x90,      // 设备主动发送的遥测，负载见 SerialTelemetry
+    SERIAL_FRAME_ERROR = 0xFF,          // 负载：错误码 u8，原请求类型 u8
+};
+
+enum SerialFrameError : uint8_t {
+    SERIAL_ERR_UNKNOWN_TYPE = 1,
+    SERIAL_ERR_BAD_ARGS,
+    SERIAL_ERR_NOT_READY,               // SD卡未就绪等
+    SERIAL_ERR_IO,
+};
+
+// ---------------- CRC 和 COBS ----------------
+
+static inline uint16_t serialCrc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// COBS 编码，输出不含分隔符，返回编码后长度；out 至少 len + len / 254 + 1 字节
+static inline size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t codeIndex = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codeIndex] = code;
+            codeIndex = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) {
+            out[codeIndex] = code;
+            codeIndex = o++;
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return o;
+}
+
+// COBS 解码（可原地解码），格式错误或超出 maxLen 时返回 0
+static inline size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t maxLen) {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            if (o >= maxLen) {
+                return 0;
+            }
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < len) {
+            if (o >= maxLen) {
+                return 0;
+            }
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+// 组帧：加 CRC、COBS 编码、首尾分隔符，返回写入 out 的字节数，out 至少 SERIAL_FRAME_MAX_ENCODED 字节
+static inline size_t serialFrameEncode(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len, uint8_t* out) {
+    if (len > SERIAL_FRAME_MAX_PAYLOAD) {
+        return 0;
+    }
+    uint8_t raw[SERIAL_FRAME_MAX_RAW];
+    raw[0] = type;
+    raw[1] = seq;
+    if (len > 0) {
+        memcpy(raw + 2, payload, len);
+    }
+    uint16_t crc = serialCrc16(raw, len + 2);
+    raw[len + 2] = (uint8_t)crc;
+    raw[len + 3] = (uint8_t)(crc >> 8);
+    out[0] = 0;
+    size_t n = cobsEncode(raw, len + SERIAL_FRAME_OVERHEAD, out + 1);
+    out[n + 1] = 0;
+    return n + 2;
+}
+
+// ---------------- 接收 ----------------
+
+enum SerialRxEvent : uint8_t {
+    SERIAL_RX_NONE = 0,
+    SERIAL_RX_LINE,         // line() 为一行文本命令（不含换行）
+    SERIAL_RX_FRAME,        // frameType()、frameSeq()、payload() 有效
+    SERIAL_RX_BAD_FRAME,    // COBS 或 CRC 错误、超长，已丢弃
+};
+
+class SerialFrameParser {
+public:
+    SerialFrameParser() : inFrame(false), overflow(false), lineLen(0), frameLen(0), rawLen(0),
+                          frames(0), badFrames(0), lines(0) {}
+
+    // 每收到一个字节调用一次
+    SerialRxEvent feed(uint8_t c) {
+        if (inFrame) {
+            if (c != 0) {
+                if (frameLen < sizeof(frameBuf)) {
+                    frameBuf[frameLen++] = c;
+                } else {
+                    overflow = true;
+                }
+                return SERIAL_RX_NONE;
+            }
+            inFrame = false;
+            if (frameLen == 0) {
+                return SERIAL_RX_NONE;  // 连续两个分隔符，用于同步
+            }
+            return finishFrame();
+        }
+
+        if (c == 0) {
+            // 帧开始，丢弃未完成的文本行
+            inFrame = true;
+            overflow = false;
+            frameLen = 0;
+            lineLen = 0;
+            return SERIAL_RX_NONE;
+        }
+        if (c == '\n' || c == '\r') {
+            if (lineLen == 0) {
+                return SERIAL_RX_NONE;
+            }
+            lineBuf[lineLen] = '\0';
+            lineLen = 0;
+            lines++;
+            return SERIAL_RX_LINE;
+        }
+        if (lineLen < SERIAL_LINE_MAX) {
+            lineBuf[lineLen++] = (char)c;
+        }
+        return SERIAL_RX_NONE;
+    }
+
+    // 帧状态下长时间没有数据时调用，回到文本状态
+    void reset() {
+        inFrame = false;
+        frameLen = 0;
+        lineLen = 0;
+    }
+
+    bool receivingFrame() const { return inFrame; }
+    const char* line() const { return lineBuf; }
+    uint8_t frameType() const { return raw[0]; }
+    uint8_t frameSeq() const { return raw[1]; }
+    const uint8_t* payload() const { return raw + 2; }
+    size_t payloadLen() const { return rawLen - SERIAL_FRAME_OVERHEAD; }
+    uint32_t frameCount() const { return frames; }
+    uint32_t badFrameCount() const { return badFrames; }
+    uint32_t lineCount() const { return lines; }
+
+private:
+    SerialRxEvent finishFrame() {
+        size_t n = overflow ? 0 : cobsDecode(frameBuf, frameLen, raw, sizeof(raw));
+        frameLen = 0;
+        if (n < SERIAL_FRAME_OVERHEAD) {
+            badFrames++;
+            return SERIAL_RX_BAD_FRAME;
+        }
+        uint16_t crc = (uint16_t)(raw[n - 2] | (raw[n - 1] << 8));
+        if (serialCrc16(raw, n - 2) != crc) {
+            badFrames++;
+            return SERIAL_RX_BAD_FRAME;
+        }
+        rawLen = n;
+        frames++;
+        return SERIAL_RX_FRAME;
+    }
+
+    bool inFrame;
+    bool overflow;
+    size_t lineLen;
+    size_t frameLen;
+    size_t rawLen;
+    uint32_t frames;
+    uint32_t badFrames;
+    uint32_t lines;
+    char lineBuf[SERIAL_LINE_MAX + 1];
+    uint8_t frameBuf[SERIAL_FRAME_MAX_ENCODED];
+    uint8_t raw[SERIAL_FRAME_MAX_RAW];
+};
+
+// ---------------- 遥测 ----------------
+
+// 遥测负载，小端，上位机按 monitor_serial.py 中的 TELEMETRY_FORMAT 解析，增加字段时只能加在末尾并更新版本
+#define SERIAL_TELEMETRY_VERSION 1
+
+#pragma pack(push, 1)
+struct SerialTelemetry {
+    uint8_t version;
+    uint8_t flags;          // 0 位 GNSS 就绪，1 位 IMU 就绪，2 位充电，3 位外部电源，4 位 SD卡就绪
+    uint16_t batteryMv;
+    uint32_t uptimeMs;
+    float accel[3];         // g
+    float gyro[3];          // °/s
+    float roll;
+    float pitch;
+    float yaw;
+    double latitude;
+    double longitude;
+    uint8_t satellites;
+    int8_t batteryPercent;
+    uint16_t heapFreeKb;
+};
+#pragma pack(pop)
+
+#endif // SERIAL_FRAME_H
@@ -0,0 +1,283 @@
+#include "SerialLink.h"
+#include "device.h"
+#include "utils/serialCommand.h"
+#include "version.h"
+#include "imu/qmi8658.h"
+#ifdef ENABLE_SDCARD
+#include "SD/SDManager.h"
+extern SDManager sdManager;
+#endif
+
+SerialLink serialLink;
+
+static inline uint32_t readU32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void writeU32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// 负载中不带结尾 0 的路径复制为字符串
+static bool copyPath(const uint8_t* data, size_t len, char* path, size_t size)
+{
+    if (len == 0 || len >= size || data[0] != '/')
+    {
+        return false;
+    }
+    memcpy(path, data, len);
+    path[len] = '\0';
+    return true;
+}
+
+// ---------------- 命令表 ----------------
+
+typedef void (*SerialFrameHandler)(uint8_t seq, const uint8_t* payload, size_t len);
+
+static void onPing(uint8_t seq, const uint8_t* payload, size_t len)
+{
+    uint8_t reply[64];
+    writeU32(reply, millis());
+    const char* version = getVersionInfo().firmware_version;
+    size_t n = strnlen(version, sizeof(reply) - 4);
+    memcpy(reply + 4, version, n);
+    serialLink.sendFrame(SERIAL_FRAME_PING | SERIAL_FRAME_REPLY, seq, reply, 4 + n);
+}
+
+static void onText(uint8_t seq, const uint8_t* payload, size_t len)
+{
+    if (len == 0 || len > SERIAL_LINE_MAX)
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_TEXT, SERIAL_ERR_BAD_ARGS);
+        return;
+    }
+    char line[SERIAL_LINE_MAX + 1];
+    memcpy(line, payload, len);
+    line[len] = '\0';
+    // 命令输出仍为文本，应答帧表示输出结束
+    handleSerialCommand(String(line));
+    serialLink.sendFrame(SERIAL_FRAME_TEXT | SERIAL_FRAME_REPLY, seq, NULL, 0);
+}
+
+static void onTelemetryStart(uint8_t seq, const uint8_t* payload, size_t len)
+{
+    uint16_t intervalMs = len >= 2 ? (uint16_t)(payload[0] | (payload[1] << 8)) : 100;
+    serialLink.startTelemetry(intervalMs);
+    serialLink.sendFrame(SERIAL_FRAME_TELEMETRY_START | SERIAL_FRAME_REPLY, seq, NULL, 0);
+}
+
+static void onTelemetryStop(uint8_t seq, const uint8_t* payload, size_t len)
+{
+    serialLink.stopTelemetry();
+    serialLink.sendFrame(SERIAL_FRAME_TELEMETRY_STOP | SERIAL_FRAME_REPLY, seq, NULL, 0);
+}
+
+static void onFileInfo(uint8_t seq, const uint8_t* payload, size_t len)
+{
+#ifdef ENABLE_SDCARD
+    char path[96];
+    if (!copyPath(payload, len, path, sizeof(path)))
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_FILE_INFO, SERIAL_ERR_BAD_ARGS);
+        return;
+    }
+    if (!sdManager.isInitialized())
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_FILE_INFO, SERIAL_ERR_NOT_READY);
+        return;
+    }
+    int64_t size = sdManager.fileSize(path);
+    if (size < 0 || size > 0xFFFFFFFFLL)
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_FILE_INFO, SERIAL_ERR_IO);
+        return;
+    }
+    uint8_t reply[4];
+    writeU32(reply, (uint32_t)size);
+    serialLink.sendFrame(SERIAL_FRAME_FILE_INFO | SERIAL_FRAME_REPLY, seq, reply, sizeof(reply));
+#else
+    serialLink.sendError(seq, SERIAL_FRAME_FILE_INFO, SERIAL_ERR_NOT_READY);
+#endif
+}
+
+// 上位机按偏移逐块请求，每块一问一答，丢帧时重发同一偏移即可
+static void onFileRead(uint8_t seq, const uint8_t* payload, size_t len)
+{
+#ifdef ENABLE_SDCARD
+    char path[96];
+    if (len < 6 || !copyPath(payload + 6, len - 6, path, sizeof(path)))
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_FILE_READ, SERIAL_ERR_BAD_ARGS);
+        return;
+    }
+    if (!sdManager.isInitialized())
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_FILE_READ, SERIAL_ERR_NOT_READY);
+        return;
+    }
+    uint32_t offset = readU32(payload);
+    size_t want = payload[4] | (payload[5] << 8);
+    if (want > SERIAL_FRAME_MAX_PAYLOAD - 4)
+    {
+        want = SERIAL_FRAME_MAX_PAYLOAD - 4;
+    }
+    static uint8_t reply[SERIAL_FRAME_MAX_PAYLOAD];
+    int n = sdManager.readFile(path, offset, reply + 4, want);
+    if (n < 0)
+    {
+        serialLink.sendError(seq, SERIAL_FRAME_FILE_READ, SERIAL_ERR_IO);
+        return;
+    }
+    writeU32(reply, offset);
+    serialLink.sendFrame(SERIAL_FRAME_FILE_READ | SERIAL_FRAME_REPLY, seq, reply, 4 + n);
+#else
+    serialLink.sendError(seq, SERIAL_FRAME_FILE_READ, SERIAL_ERR_NOT_READY);
+#endif
+}
+
+static const struct
+{
+    uint8_t type;
+    SerialFrameHandler handler;
+} FRAME_COMMANDS[] = {
+    {SERIAL_FRAME_PING, onPing},
+    {SERIAL_FRAME_TEXT, onText},
+    {SERIAL_FRAME_TELEMETRY_START, onTelemetryStart},
+    {SERIAL_FRAME_TELEMETRY_STOP, onTelemetryStop},
+    {SERIAL_FRAME_FILE_INFO, onFileInfo},
+    {SERIAL_FRAME_FILE_READ, onFileRead},
+};
+
+// ---------------- SerialLink ----------------
+
+SerialLink::SerialLink()
+    : lastByteMs(0), telemetryIntervalMs(0), lastTelemetryMs(0), telemetrySent(0), framesSent(0)
+{
+}
+
+void SerialLink::poll()
+{
+    unsigned long now = millis();
+    int available = Serial.available();
+    if (available > 0)
+    {
+        lastByteMs = now;
+    }
+    else if (parser.receivingFrame() && now - lastByteMs > SERIAL_FRAME_TIMEOUT_MS)
+    {
+        parser.reset();
+    }
+
+    while (available-- > 0)
+    {
+        int c = Serial.read();
+        if (c < 0)
+        {
+            break;
+        }
+        SerialRxEvent event = parser.feed((uint8_t)c);
+        if (event == SERIAL_RX_LINE)
+        {
+            handleSerialCommand(String(parser.line()));
+        }
+        else if (event == SERIAL_RX_FRAME)
+        {
+            handleFrame();
+        }
+    }
+
+    if (telemetryIntervalMs > 0 && now - lastTelemetryMs >= telemetryIntervalMs)
+    {
+        lastTelemetryMs = now;
+        sendTelemetry();
+    }
+}
+
+void SerialLink::handleFrame()
+{
+    uint8_t type = parser.frameType();
+    for (size_t i = 0; i < sizeof(FRAME_COMMANDS) / sizeof(FRAME_COMMANDS[0]); i++)
+    {
+        if (FRAME_COMMANDS[i].type == type)
+        {
+            FRAME_COMMANDS[i].handler(parser.frameSeq(), parser.payload(), parser.payloadLen());
+            return;
+        }
+    }
+    sendError(parser.frameSeq(), type, SERIAL_ERR_UNKNOWN_TYPE);
+}
+
+void SerialLink::sendFrame(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len)
+{
+    size_t n = serialFrameEncode(type, seq, payload, len, txBuf);
+    if (n > 0)
+    {
+        Serial.write(txBuf, n);
+        framesSent++;
+    }
+}
+
+void SerialLink::sendError(uint8_t seq, uint8_t requestType, SerialFrameError error)
+{
+    uint8_t payload[2] = {(uint8_t)error, requestType};
+    sendFrame(SERIAL_FRAME_ERROR, seq, payload, sizeof(payload));
+}
+
+void SerialLink::startTelemetry(uint16_t intervalMs)
+{
+    telemetryIntervalMs = intervalMs < SERIAL_TELEMETRY_MIN_MS ? SERIAL_TELEMETRY_MIN_MS : intervalMs;
+    lastTelemetryMs = millis() - telemetryIntervalMs;
+}
+
+void SerialLink::stopTelemetry()
+{
+    telemetryIntervalMs = 0;
+}
+
+void SerialLink::sendTelemetry()
+{
+    device_state_t state = deviceState.snapshot();
+    SerialTelemetry t;
+    t.version = SERIAL_TELEMETRY_VERSION;
+    t.flags = (state.gnssReady ? 0x01 : 0) | (state.imuReady ? 0x02 : 0) | (state.is_charging ? 0x04 : 0) |
+              (state.external_power ? 0x08 : 0) | (state.sdCardReady ? 0x10 : 0);
+    t.batteryMv = (uint16_t)state.battery_voltage;
+    t.uptimeMs = millis();
+    t.accel[0] = imu_data.accel_x;
+    t.accel[1] = imu_data.accel_y;
+    t.accel[2] = imu_data.accel_z;
+    t.gyro[0] = imu_data.gyro_x;
+    t.gyro[1] = imu_data.gyro_y;
+    t.gyro[2] = imu_data.gyro_z;
+    t.roll = imu_data.roll;
+    t.pitch = imu_data.pitch;
+    t.yaw = imu_data.yaw;
+    t.latitude = state.latitude;
+    t.longitude = state.longitude;
+    t.satellites = (uint8_t)state.satellites;
+    t.batteryPercent = (int8_t)state.battery_percentage;
+    t.heapFreeKb = (uint16_t)(ESP.getFreeHeap() / 1024);
+    sendFrame(SERIAL_FRAME_TELEMETRY, 0, (const uint8_t*)&t, sizeof(t));
+    telemetrySent++;
+}
+
+void SerialLink::printStatus()
+{
+    Serial.println("=== 串口帧 ===");
+    Serial.printf("收到文本命令 %lu 条，帧 %lu 个，错误帧 %lu 个，发送帧 %lu 个\n",
+                  (unsigned long)parser.lineCount(), (unsigned long)parser.frameCount(),
+                  (unsigned long)parser.badFrameCount(), (unsigned long)framesSent);
+    if (telemetryIntervalMs > 0)
+    {
+        Serial.printf("遥测: 每 %u ms，已发送 %lu 帧\n", telemetryIntervalMs, (unsigned long)telemetrySent);
+    }
+    else
+    {
+        Serial.println("遥测: 关闭");
+    }
+}
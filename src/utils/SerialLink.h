@@ -0,0 +1,51 @@
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "utils/SerialFrame.h"
+
+/*
+ * 串口输入：文本命令和二进制帧（格式见 SerialFrame.h）
+ *
+ * poll() 只读取已到达的字节，逐字节解析，不等待：
+ * - 文本行交给 handleSerialCommand()，原有命令不变
+ * - 二进制帧按命令表分发：PING、执行文本命令、开始/停止遥测、SD卡文件信息和分块读取
+ * 开启遥测后 poll() 按设定间隔发送 SerialTelemetry 帧（最小 SERIAL_TELEMETRY_MIN_MS），
+ * 供台架工具高频采集。上位机：python3 monitor_serial.py --ping / --telemetry / --download
+ *
+ * 串口命令：link（收发统计）
+ */
+
+class SerialLink {
+public:
+    SerialLink();
+
+    // 在 taskSystem 中循环调用
+    void poll();
+
+    // 发送一帧，整帧一次写入串口，不会与其他任务的日志输出交错；只在 taskSystem 中调用
+    void sendFrame(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len);
+    void sendError(uint8_t seq, uint8_t requestType, SerialFrameError error);
+
+    void startTelemetry(uint16_t intervalMs);
+    void stopTelemetry();
+
+    void printStatus();
+
+private:
+    void handleFrame();
+    void sendTelemetry();
+
+    SerialFrameParser parser;
+    unsigned long lastByteMs;
+    uint16_t telemetryIntervalMs;   // 0 为关闭
+    unsigned long lastTelemetryMs;
+    uint32_t telemetrySent;
+    uint32_t framesSent;
+    uint8_t txBuf[SERIAL_FRAME_MAX_ENCODED];
+};
+
+extern SerialLink serialLink;
+
+#endif // SERIAL_LINK_H
@@ -0,0 +1,245 @@
+#ifndef STATE_BUS_H
+#define STATE_BUS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+/*
+ * 状态总线：多任务共享的 POD 状态结构，seqlock 读取 + 按字段订阅变化
+ *
+ * 写入方持有 Lock（ESP32 上为 portMUX 临界区）逐字段用 == 比较后写入，只有值确实变化时才把序号置为奇数、
+ * 写完再置回偶数，并把所属字段位 OR 到订阅了该字段的订阅者的待处理掩码上。
+ * 读取方不加锁：序号为奇数或读取前后序号不同就重读，得到不会撕裂的完整快照（double、uint64、
+ * 同一次写入的多个字段保持一致）。快照和字段读取都是 memcpy，不分配内存，因此 T 必须是 POD。
+ *
+ * 订阅者注册关心的字段掩码：
+ * - 有回调的订阅者由 dispatch() 在调用方任务中统一通知，参数为快照和变化的字段
+ * - 没有回调的订阅者在自己的任务里用 take() 取走变化的字段（例如必须在模块串口所在任务上报的 MQTT）
+ *
+ * 比较按值而不是按字节：填充字节不参与，浮点数 -0.0 与 0.0 相等，NaN 与 NaN 视为相同（不会每次写入都通知）。
+ * store() 整体比较需要 T 提供 operator==，逐字段比较时浮点字段用 stateValueEqual()。
+ * Lock 需要提供 lock()/unlock()，写入时持有，临界区内只做比较和拷贝。
+ * 验证见 tools/state_bus_stress.cpp。
+ */
+
+template <typename V>
+inline bool stateValueEqual(const V& a, const V& b) {
+    return a == b;
+}
+
+inline bool stateValueEqual(float a, float b) {
+    return a == b || (a != a && b != b);
+}
+
+inline bool stateValueEqual(double a, double b) {
+    return a == b || (a != a && b != b);
+}
+
+template <typename T, typename Lock, int MAX_SUBSCRIBERS = 8>
+class StateBus {
+public:
+    typedef void (*Callback)(const T& state, uint32_t changed, void* ctx);
+
+    /**
+     * @brief 一次写入：构造时加锁，析构时解锁并通知变化的字段
+     * 同一次写入的多个字段对读取方同时可见
+     */
+    class Writer {
+    public:
+        explicit Writer(StateBus& bus) : bus(bus), changed(0), open(false) {
+            bus.lock.lock();
+        }
+
+        ~Writer() {
+            if (open) {
+                bus.seq.store(bus.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                bus.notifyLocked(changed);
+            }
+            bus.lock.unlock();
+        }
+
+        template <typename V, typename U>
+        bool set(int field, V T::*member, const U& value) {
+            V v = (V)value;
+            if (stateValueEqual(bus.data.*member, v)) {
+                return false;
+            }
+            begin();
+            bus.data.*member = v;
+            changed |= 1UL << field;
+            return true;
+        }
+
+        // 整体替换，fields 为可能变化的字段
+        bool store(const T& next, uint32_t fields) {
+            if (bus.data == next) {
+                return false;
+            }
+            begin();
+            memcpy(&bus.data, &next, sizeof(T));
+            changed |= fields;
+            return true;
+        }
+
+        uint32_t changes() const { return changed; }
+
+    private:
+        StateBus& bus;
+        uint32_t changed;
+        bool open;
+
+        void begin() {
+            if (!open) {
+                open = true;
+                bus.seq.store(bus.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+        }
+
+        Writer(const Writer&);
+        Writer& operator=(const Writer&);
+    };
+
+    StateBus() : seq(0), count(0), retryCount(0) {
+        memset(&data, 0, sizeof(data));
+        for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+            subs[i].mask = 0;
+            subs[i].callback = nullptr;
+            subs[i].ctx = nullptr;
+            subs[i].pending.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 写入单个字段，值未变化时不通知
+    template <typename V, typename U>
+    bool set(int field, V T::*member, const U& value) {
+        Writer w(*this);
+        return w.set(field, member, value);
+    }
+
+    bool store(const T& next, uint32_t fields) {
+        Writer w(*this);
+        return w.store(next, fields);
+    }
+
+    void snapshot(T& out) const {
+        for (;;) {
+            uint32_t s1 = seq.load(std::memory_order_acquire);
+            if ((s1 & 1) == 0) {
+                memcpy(&out, (const void*)&data, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) == s1) {
+                    return;
+                }
+            }
+            retryCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    T snapshot() const {
+        T out;
+        snapshot(out);
+        return out;
+    }
+
+    template <typename V>
+    V get(V T::*member) const {
+        V out;
+        for (;;) {
+            uint32_t s1 = seq.load(std::memory_order_acquire);
+            if ((s1 & 1) == 0) {
+                memcpy(&out, (const void*)&(data.*member), sizeof(V));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) == s1) {
+                    return out;
+                }
+            }
+            retryCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 注册订阅者，启动时在任务创建前调用
+     * @param mask 关心的字段位
+     * @param callback 为 nullptr 时只记录变化，由订阅者用 take() 取走
+     * @return 订阅者编号，已满时返回 -1
+     */
+    int subscribe(uint32_t mask, Callback callback, void* ctx = nullptr) {
+        lock.lock();
+        int id = count.load(std::memory_order_relaxed);
+        if (id < MAX_SUBSCRIBERS) {
+            subs[id].mask = mask;
+            subs[id].callback = callback;
+            subs[id].ctx = ctx;
+            subs[id].pending.store(0, std::memory_order_relaxed);
+            count.store(id + 1, std::memory_order_release);
+        } else {
+            id = -1;
+        }
+        lock.unlock();
+        return id;
+    }
+
+    // 取走订阅者自上次以来变化的字段
+    uint32_t take(int id) {
+        if (id < 0 || id >= count.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        return subs[id].pending.exchange(0, std::memory_order_acq_rel);
+    }
+
+    // 通知有回调的订阅者，所有回调共用同一份快照
+    void dispatch() {
+        int n = count.load(std::memory_order_acquire);
+        T state;
+        bool taken = false;
+        for (int i = 0; i < n; i++) {
+            if (subs[i].callback == nullptr || subs[i].pending.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            uint32_t changed = subs[i].pending.exchange(0, std::memory_order_acq_rel);
+            if (changed == 0) {
+                continue;
+            }
+            if (!taken) {
+                snapshot(state);
+                taken = true;
+            }
+            subs[i].callback(state, changed, subs[i].ctx);
+        }
+    }
+
+    uint32_t sequence() const { return seq.load(std::memory_order_relaxed); }
+    uint32_t retries() const { return retryCount.load(std::memory_order_relaxed); }
+    int subscribers() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    struct Subscriber {
+        uint32_t mask;
+        Callback callback;
+        void* ctx;
+        std::atomic<uint32_t> pending;
+    };
+
+    T data;
+    std::atomic<uint32_t> seq;
+    std::atomic<int> count;
+    mutable std::atomic<uint32_t> retryCount;
+    Subscriber subs[MAX_SUBSCRIBERS];
+    Lock lock;
+
+    void notifyLocked(uint32_t changed) {
+        int n = count.load(std::memory_order_relaxed);
+        for (int i = 0; i < n; i++) {
+            if (subs[i].mask & changed) {
+                subs[i].pending.fetch_or(subs[i].mask & changed, std::memory_order_release);
+            }
+        }
+    }
+
+    StateBus(const StateBus&);
+    StateBus& operator=(const StateBus&);
+};
+
+#endif // STATE_BUS_H
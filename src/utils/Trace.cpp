@@ -0,0 +1,204 @@
+#include "Trace.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+
+#ifdef ENABLE_SDCARD
+#include "SD/SDManager.h"
+extern SDManager sdManager;
+#endif
+
+// 软件复位、看门狗、异常复位后保留，上电时内容随机
+RTC_NOINIT_ATTR static TraceRing<TRACE_CAPACITY> ring;
+
+Trace trace;
+
+static const char* resetReasonName(esp_reset_reason_t reason)
+{
+    switch (reason)
+    {
+    case ESP_RST_POWERON: return "上电";
+    case ESP_RST_EXT: return "外部复位";
+    case ESP_RST_SW: return "软件重启";
+    case ESP_RST_PANIC: return "异常";
+    case ESP_RST_INT_WDT: return "中断看门狗";
+    case ESP_RST_TASK_WDT: return "任务看门狗";
+    case ESP_RST_WDT: return "看门狗";
+    case ESP_RST_DEEPSLEEP: return "深度睡眠唤醒";
+    case ESP_RST_BROWNOUT: return "欠压";
+    default: return "未知";
+    }
+}
+
+Trace::Trace()
+    : mux(portMUX_INITIALIZER_UNLOCKED),
+      taskCount(0),
+      pendingDump(false),
+      resetReason(ESP_RST_UNKNOWN)
+{
+    memset(taskHandles, 0, sizeof(taskHandles));
+    memset(taskTags, 0, sizeof(taskTags));
+}
+
+void Trace::begin()
+{
+    resetReason = esp_reset_reason();
+    bool valid = traceRingValid(ring);
+    if (!valid || resetReason == ESP_RST_POWERON || resetReason == ESP_RST_EXT)
+    {
+        traceRingInit(ring);
+    }
+    else
+    {
+        // 上次运行的结束原因只能从复位原因得知，非正常结束才需要保存现场
+        pendingDump = resetReason == ESP_RST_PANIC || resetReason == ESP_RST_INT_WDT ||
+                      resetReason == ESP_RST_TASK_WDT || resetReason == ESP_RST_WDT ||
+                      resetReason == ESP_RST_SW || resetReason == ESP_RST_BROWNOUT;
+    }
+    ring.boots++;
+
+    registerTask(TRACE_TASK_MAIN);
+    record(TRACE_BOOT, TRACE_ID_BOOT, (uint16_t)resetReason);
+    if (pendingDump)
+    {
+        Serial.printf("[跟踪] 上次%s复位，保留 %lu 个事件待写入SD卡\n", resetReasonName(resetReason),
+                      (unsigned long)traceRingCount(ring));
+    }
+}
+
+void Trace::registerTask(TraceTask tag)
+{
+    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < taskCount; i++)
+    {
+        if (taskHandles[i] == handle)
+        {
+            taskTags[i] = tag;
+            portEXIT_CRITICAL(&mux);
+            return;
+        }
+    }
+    if (taskCount < TRACE_MAX_TASKS)
+    {
+        taskHandles[taskCount] = handle;
+        taskTags[taskCount] = tag;
+        taskCount++;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+// 在临界区内调用
+uint8_t Trace::currentTask()
+{
+    if (xPortInIsrContext())
+    {
+        return TRACE_TASK_ISR;
+    }
+    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < taskCount; i++)
+    {
+        if (taskHandles[i] == handle)
+        {
+            return taskTags[i];
+        }
+    }
+    return TRACE_TASK_OTHER;
+}
+
+void Trace::record(TraceType type, uint8_t id, uint16_t arg)
+{
+    record(type, id, arg, (uint32_t)esp_timer_get_time());
+}
+
+void Trace::record(TraceType type, uint8_t id, uint16_t arg, uint32_t tsUs)
+{
+    TraceEvent e;
+    e.tsUs = tsUs;
+    e.id = id;
+    e.arg = arg;
+    portENTER_CRITICAL_SAFE(&mux);
+    e.flags = traceFlags(type, currentTask(), (uint8_t)xPortGetCoreID());
+    traceRingPush(ring, e);
+    portEXIT_CRITICAL_SAFE(&mux);
+}
+
+bool Trace::dumpToSD(String* path)
+{
+#ifdef ENABLE_SDCARD
+    if (!sdManager.isInitialized())
+    {
+        return false;
+    }
+
+    // 先复制出来再写卡，写卡期间其他任务可以继续记录
+    static uint8_t buffer[sizeof(TraceFileHeader) + sizeof(TraceEvent) * TRACE_CAPACITY];
+    portENTER_CRITICAL(&mux);
+    TraceFileHeader header = traceFileHeader(ring);
+    memcpy(buffer, &header, sizeof(header));
+    TraceEvent* events = (TraceEvent*)(buffer + sizeof(header));
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        events[i] = traceRingAt(ring, i);
+    }
+    portEXIT_CRITICAL(&mux);
+
+    char name[32];
+    snprintf(name, sizeof(name), "trace_%lu.bin", (unsigned long)header.boots);
+    size_t len = sizeof(header) + sizeof(TraceEvent) * header.count;
+    if (!sdManager.writeFile("/data/trace", name, buffer, len))
+    {
+        Serial.println("[跟踪] 写入SD卡失败");
+        return false;
+    }
+    pendingDump = false;
+    instant(TRACE_ID_TRACE_DUMP, (uint16_t)header.count);
+    Serial.printf("[跟踪] %lu 个事件已写入 /data/trace/%s\n", (unsigned long)header.count, name);
+    if (path != NULL)
+    {
+        *path = String("/data/trace/") + name;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Trace::clear()
+{
+    portENTER_CRITICAL(&mux);
+    uint32_t boots = ring.boots;
+    traceRingInit(ring);
+    ring.boots = boots;
+    portEXIT_CRITICAL(&mux);
+    pendingDump = false;
+}
+
+void Trace::printStatus()
+{
+    Serial.println("=== 事件跟踪 ===");
+    Serial.printf("复位原因: %s, 启动序号: %lu\n", resetReasonName(resetReason), (unsigned long)ring.boots);
+    Serial.printf("事件: %lu / %d (累计写入 %lu)\n", (unsigned long)traceRingCount(ring), TRACE_CAPACITY,
+                  (unsigned long)ring.head);
+    Serial.printf("待写入SD卡: %s\n", pendingDump ? "是" : "否");
+}
+
+void Trace::printEvents(int last)
+{
+    static TraceEvent events[TRACE_CAPACITY];
+    portENTER_CRITICAL(&mux);
+    uint32_t count = traceRingCount(ring);
+    uint32_t first = (last > 0 && (uint32_t)last < count) ? count - last : 0;
+    for (uint32_t i = first; i < count; i++)
+    {
+        events[i - first] = traceRingAt(ring, i);
+    }
+    portEXIT_CRITICAL(&mux);
+
+    Serial.println("  时间(us)    核心 任务 类型 编号   参数");
+    for (uint32_t i = 0; i < count - first; i++)
+    {
+        const TraceEvent& e = events[i];
+        Serial.printf("  %10lu %4u %4u %4u %4u %6u\n", (unsigned long)e.tsUs, e.flags >> 7, (e.flags >> 4) & 0x07,
+                      e.flags & 0x0F, e.id, e.arg);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "utils/TraceRing.h"
+#include "config.h"
+
+/*
+ * 事后分析用的二进制事件跟踪
+ *
+ * 环形缓冲区（格式见 TraceRing.h）放在 RTC_NOINIT 内存中，软件复位、看门狗、异常和欠压复位后内容仍在；
+ * 只有上电复位或校验失败时清空。因异常复位启动时，setup() 在SD卡就绪后把缓冲区写入
+ * /data/trace/trace_<启动序号>.bin，串口命令 trace.dump 可随时手动写入。
+ *
+ * 记录的事件：启动（含复位原因）、电源状态迁移、进入深度睡眠、主动重启及其原因、
+ * 超过 TRACE_SLOW_SLICE_US 的子系统循环（PerfScope）、定期的空闲内存。
+ * 每次记录只在临界区内写 8 字节，可在中断中调用，不打印、不分配内存。
+ *
+ * 时间戳取 esp_timer（微秒），不用 CCOUNT：动态调频会改变CPU时钟，且两个核心的 CCOUNT 不同步。
+ */
+
+#define TRACE_MAX_TASKS 6
+
+class Trace {
+public:
+    Trace();
+
+    // 校验缓冲区并记录启动事件，在 setup() 开始时调用
+    void begin();
+
+    // 记录当前任务的标记，在各任务函数开头调用
+    void registerTask(TraceTask tag);
+
+    void record(TraceType type, uint8_t id, uint16_t arg = 0);
+    void record(TraceType type, uint8_t id, uint16_t arg, uint32_t tsUs);
+
+    inline void instant(uint8_t id, uint16_t arg = 0) { record(TRACE_INSTANT, id, arg); }
+    inline void error(uint8_t id, uint16_t arg = 0) { record(TRACE_ERROR, id, arg); }
+    inline void counter(uint8_t id, uint16_t value) { record(TRACE_COUNTER, id, value); }
+    inline void power(uint8_t from, uint8_t to) { record(TRACE_INSTANT, TRACE_ID_POWER, (uint16_t)((from << 8) | to)); }
+
+    // 上次是异常复位时需要写入SD卡
+    bool dumpPending() const { return pendingDump; }
+
+    // 写入SD卡，成功返回 true；path 可为 NULL
+    bool dumpToSD(String* path = NULL);
+
+    void clear();
+    void printStatus();
+    void printEvents(int last);
+
+private:
+    portMUX_TYPE mux;
+    TaskHandle_t taskHandles[TRACE_MAX_TASKS];
+    uint8_t taskTags[TRACE_MAX_TASKS];
+    int taskCount;
+    bool pendingDump;
+    esp_reset_reason_t resetReason;
+
+    uint8_t currentTask();
+};
+
+extern Trace trace;
+
+#endif // TRACE_H
@@ -0,0 +1,142 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * 事件跟踪环形缓冲区（二进制，每个事件 8 字节）
+ *
+ * 放在不初始化的 RTC 内存中（见 utils/Trace.h），软件复位、看门狗复位、异常重启和深度睡眠后都保留，
+ * 下次启动时写入SD卡，用 tools/trace_to_perfetto.py 转换成 Chrome trace / Perfetto 时间线。
+ *
+ * 事件格式：
+ *   tsUs  本次启动以来的微秒数低 32 位（约 71 分钟回绕，转换工具按顺序展开）
+ *   flags 低 4 位事件类型，4-6 位任务标记，最高位 CPU 核心
+ *   id    子系统或事件编号（TRACE_ID_*）
+ *   arg   参数，含义由事件决定
+ *
+ * 回绕和校验的测试见 tools/trace_ring_sim.cpp。
+ */
+
+#define TRACE_MAGIC 0x4352544Du     // "MTRC"
+#define TRACE_VERSION 1
+
+enum TraceType : uint8_t {
+    TRACE_BOOT = 1,         // 启动，arg 为复位原因（esp_reset_reason_t）
+    TRACE_BEGIN,            // 区间开始
+    TRACE_END,              // 区间结束
+    TRACE_SLICE,            // 已结束的区间，tsUs 为开始时间，arg 为时长（ms）
+    TRACE_INSTANT,          // 瞬时事件
+    TRACE_ERROR,            // 错误
+    TRACE_COUNTER,          // 计数值，arg 为数值
+};
+
+// 任务标记（flags 4-6 位），转换后每个任务一条时间线
+enum TraceTask : uint8_t {
+    TRACE_TASK_OTHER = 0,
+    TRACE_TASK_MAIN,        // setup()/loop()
+    TRACE_TASK_SYSTEM,
+    TRACE_TASK_DATA,
+    TRACE_TASK_WIFI,
+    TRACE_TASK_AUDIO,
+    TRACE_TASK_ISR = 7,
+};
+
+// 0-15 与 PerfProbe 相同（子系统循环），其余为事件编号；修改时同步 tools/trace_to_perfetto.py
+enum TraceId : uint8_t {
+    TRACE_ID_BOOT = 32,
+    TRACE_ID_POWER,         // 电源状态迁移，arg 高 8 位为原状态，低 8 位为新状态
+    TRACE_ID_DEEP_SLEEP,    // 进入深度睡眠，arg 为关闭外设耗时（ms）
+    TRACE_ID_RESTART,       // 主动重启，arg 为 TraceRestartSource
+    TRACE_ID_IMU_INIT,      // IMU 初始化失败，arg 为已重试次数
+    TRACE_ID_LOW_HEAP,      // 内存不足，arg 为空闲内存（KB）
+    TRACE_ID_HEAP,          // 空闲内存计数（KB）
+    TRACE_ID_TRACE_DUMP,    // 跟踪已写入SD卡
+    TRACE_ID_SENSOR_FAIL,   // 传感器判为故障，arg 高 8 位为 SensorId，低 8 位为 SensorFault
+    TRACE_ID_SENSOR_RECOVER,// 传感器恢复尝试，arg 高 8 位为 SensorId，bit1 为复位总线，bit0 为是否成功
+};
+
+enum TraceRestartSource : uint16_t {
+    TRACE_RESTART_SERIAL = 1,
+    TRACE_RESTART_MQTT,
+    TRACE_RESTART_BUTTON,
+    TRACE_RESTART_WIFI,
+    TRACE_RESTART_LOW_HEAP,
+    TRACE_RESTART_IMU,      // 旧固件：IMU初始化失败重启，现在改为后台恢复（见 SensorHealth.h）
+};
+
+struct TraceEvent {
+    uint32_t tsUs;
+    uint8_t flags;
+    uint8_t id;
+    uint16_t arg;
+};
+
+static inline uint8_t traceFlags(TraceType type, uint8_t task, uint8_t core) {
+    return (uint8_t)((type & 0x0F) | ((task & 0x07) << 4) | ((core & 0x01) << 7));
+}
+
+template <int N>
+struct TraceRing {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t capacity;
+    uint32_t head;          // 累计写入的事件数，下一个写入位置为 head % N
+    uint32_t boots;         // 缓冲区建立以来的启动次数
+    TraceEvent events[N];
+};
+
+// SD卡文件格式：文件头后按时间顺序排列的事件（小端）
+struct TraceFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t eventSize;
+    uint32_t count;
+    uint32_t boots;
+};
+
+template <int N>
+static inline void traceRingInit(TraceRing<N>& r) {
+    memset(&r, 0, sizeof(r));
+    r.magic = TRACE_MAGIC;
+    r.version = TRACE_VERSION;
+    r.capacity = N;
+}
+
+// 上电时 RTC 内存内容随机，魔数、版本和容量都对上才沿用
+template <int N>
+static inline bool traceRingValid(const TraceRing<N>& r) {
+    return r.magic == TRACE_MAGIC && r.version == TRACE_VERSION && r.capacity == N;
+}
+
+template <int N>
+static inline void traceRingPush(TraceRing<N>& r, const TraceEvent& e) {
+    r.events[r.head % N] = e;
+    r.head++;
+}
+
+template <int N>
+static inline uint32_t traceRingCount(const TraceRing<N>& r) {
+    return r.head < (uint32_t)N ? r.head : (uint32_t)N;
+}
+
+// 第 i 个事件（0 为最早）
+template <int N>
+static inline const TraceEvent& traceRingAt(const TraceRing<N>& r, uint32_t i) {
+    uint32_t first = r.head < (uint32_t)N ? 0 : r.head % N;
+    return r.events[(first + i) % N];
+}
+
+template <int N>
+static inline TraceFileHeader traceFileHeader(const TraceRing<N>& r) {
+    TraceFileHeader h;
+    h.magic = TRACE_MAGIC;
+    h.version = TRACE_VERSION;
+    h.eventSize = sizeof(TraceEvent);
+    h.count = traceRingCount(r);
+    h.boots = r.boots;
+    return h;
+}
+
+#endif // TRACE_RING_H
@@ -1,23 +1,38 @@
 #include "utils/serialCommand.h"
+#include "power/WarmBoot.h"
+#include "power/SleepMonitor.h"
+#include "power/PowerAccounting.h"
+#include "imu/MotionWake.h"
+#include "imu/Vibration.h"
+#include "utils/PerfMonitor.h"
+#include "utils/Trace.h"
+#include "utils/HeapMonitor.h"
+#include "utils/Log.h"
+#include "utils/SerialLink.h"
+#include "utils/SensorHealth.h"
+#ifdef BAT_PIN
+#include "bat/BAT.h"
+#endif
 
 // ===================== 串口命令处理函数 =====================
 /**
  * 处理串口输入命令
  */
-void handleSerialCommand()
+void handleSerialCommand(String command)
 {
-    String command = Serial.readStringUntil('\n');
     command.trim();
 
     if (command.length() > 0)
     {
         Serial.println(">>> 收到命令: " + command);
+        // 命令处理期间使用同一份设备状态快照
+        device_state_t device_state = deviceState.snapshot();
         if (command == "info")
         {
             Serial.println("=== 设备信息 ===");
-            Serial.println("设备ID: " + device_state.device_id);
-            Serial.println("固件版本: " + String(device_state.device_firmware_version));
-            Serial.println("硬件版本: " + String(device_state.device_hardware_version));
+            Serial.println("设备ID: " + device_info.device_id);
+            Serial.println("固件版本: " + device_info.device_firmware_version);
+            Serial.println("硬件版本: " + device_info.device_hardware_version);
             Serial.println("运行时间: " + String(millis() / 1000) + " 秒");
             Serial.println("");
             Serial.println("--- 连接状态 ---");
@@ -49,7 +64,7 @@ void handleSerialCommand()
 
             // 显示已注册的主题
             Serial.println("--- MQTT主题配置 ---");
-            String deviceId = device_state.device_id;
+            String deviceId = device_info.device_id;
             String baseTopic = "vehicle/v1/" + deviceId;
             Serial.println("基础主题: " + baseTopic);
             Serial.println("设备信息: " + baseTopic + "/telemetry/device");
@@ -91,9 +106,15 @@ void handleSerialCommand()
             Serial.println("");
             Serial.println("--- 电源状态 ---");
             Serial.println("电池电压: " + String(device_state.battery_voltage) + " mV");
-            Serial.println("电池电量: " + String(device_state.battery_percentage) + "%");
+            Serial.println("电池电量: " + String(device_state.battery_percentage) + "% ±" + String(device_state.battery_soc_error) + "%");
+            if (device_state.battery_runtime_min >= 0)
+            {
+                Serial.println("剩余时间: " + String(device_state.battery_runtime_min) + " 分钟");
+            }
             Serial.println("充电状态: " + String(device_state.is_charging ? "充电中" : "未充电"));
             Serial.println("外部电源: " + String(device_state.external_power ? "已连接" : "未连接"));
+            Serial.printf("状态总线: 序号 %lu, 读取重试 %lu 次, 订阅者 %d\n", (unsigned long)deviceState.sequence(),
+                          (unsigned long)deviceState.retries(), deviceState.subscribers());
             Serial.println("");
 #ifdef ENABLE_SDCARD
             Serial.println("--- SD卡状态 ---");
@@ -229,6 +250,18 @@ void handleSerialCommand()
                     Serial.println("❌ 音频系统未就绪");
                 }
             }
+            else if (command == "audio.stop")
+            {
+                audioManager.stop();
+                Serial.println("已停止音频播放并清空队列");
+            }
+            else if (command == "audio.status")
+            {
+                static const char *stateNames[] = {"空闲", "播放中", "停止中"};
+                Serial.println("=== 音频状态 ===");
+                Serial.printf("状态: %s\n", stateNames[audioManager.getState()]);
+                Serial.printf("队列中请求: %d\n", audioManager.getPendingCount());
+            }
             else if (command == "audio.help")
             {
                 Serial.println("=== 音频命令帮助 ===");
@@ -238,6 +271,8 @@ void handleSerialCommand()
                 Serial.println("audio.gps     - 播放GPS定位音");
                 Serial.println("audio.battery - 播放低电量音");
                 Serial.println("audio.sleep   - 播放睡眠音");
+                Serial.println("audio.stop    - 停止播放并清空队列");
+                Serial.println("audio.status  - 显示播放状态和队列长度");
                 Serial.println("audio.help    - 显示此帮助信息");
             }
             else
@@ -248,9 +283,169 @@ void handleSerialCommand()
             Serial.println("音频功能未启用");
 #endif
         }
+        else if (command == "power.status")
+        {
+            powerManager.printPowerStatus();
+        }
+        else if (command == "power.log")
+        {
+            powerManager.printTransitionLog();
+        }
+        else if (command == "power.freq")
+        {
+            powerLocks.printStats();
+        }
+        else if (command == "power.freq.reset")
+        {
+            powerLocks.resetStats();
+            Serial.println("已清零CPU频率统计");
+        }
+        else if (command == "power.boot")
+        {
+            warmBoot.printStatus();
+        }
+        else if (command == "power.ulp")
+        {
+            sleepMonitor.printLog();
+        }
+        else if (command == "power.mah")
+        {
+            powerAccounting.printSummary(false);
+            powerAccounting.printSummary(true);
+        }
+        else if (command == "perf")
+        {
+            perfMonitor.printReport();
+        }
+        else if (command == "perf.reset")
+        {
+            perfMonitor.reset();
+            Serial.println("已清零循环耗时统计");
+        }
+        else if (command == "heap")
+        {
+            heapMonitor.printReport();
+        }
+        else if (command == "heap.mark")
+        {
+            heapMonitor.mark();
+            Serial.println("已清零分配统计");
+        }
+        else if (command == "log")
+        {
+            logPrintStats();
+        }
+        else if (command.startsWith("log.level"))
+        {
+            // log.level <通道|all> <0-5|default>
+            String args = command.substring(strlen("log.level"));
+            args.trim();
+            int space = args.indexOf(' ');
+            String name = space > 0 ? args.substring(0, space) : args;
+            String value = space > 0 ? args.substring(space + 1) : "";
+            value.trim();
+            uint8_t level = value == "default" ? LOG_CH_FOLLOW_GLOBAL : (uint8_t)value.toInt();
+            if (value.length() == 0 || !DebugManager::setLevelByName(name.c_str(), level))
+            {
+                Serial.println("用法: log.level <通道|all> <0-5|default>，设置后保存");
+                Serial.print("通道:");
+                for (int i = 0; i < LOG_CH_COUNT; i++)
+                {
+                    Serial.printf(" %s", DebugManager::channelName((LogChannel)i));
+                }
+                Serial.println();
+            }
+        }
+        else if (command == "log.reset")
+        {
+            DebugManager::resetLevels();
+        }
+        else if (command == "link")
+        {
+            serialLink.printStatus();
+        }
+        else if (command == "trace")
+        {
+            trace.printStatus();
+            trace.printEvents(20);
+        }
+        else if (command == "trace.dump")
+        {
+            if (!trace.dumpToSD())
+            {
+                Serial.println("写入失败（SD卡未就绪）");
+            }
+        }
+        else if (command == "trace.clear")
+        {
+            trace.clear();
+            Serial.println("已清空事件跟踪");
+        }
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+        else if (command == "imu.wom")
+        {
+            motionWake.printStats();
+        }
+        else if (command == "imu.wom.reset")
+        {
+            motionWake.resetStats();
+            Serial.println("已清零IMU唤醒统计");
+        }
+        else if (command.startsWith("imu.wom.base"))
+        {
+            int mg = command.substring(strlen("imu.wom.base")).toInt();
+            if (mg < 1 || mg > IMU_WOM_MAX_MG)
+            {
+                Serial.printf("当前基准阈值: %u mg，用法: imu.wom.base <1-%d>\n", motionWake.baseThreshold(),
+                              IMU_WOM_MAX_MG);
+            }
+            else
+            {
+                motionWake.setBaseThreshold((uint8_t)mg);
+                Serial.printf("IMU唤醒基准阈值已设置为 %d mg，下次睡眠生效\n", mg);
+            }
+        }
+#endif
+        else if (command == "sensors")
+        {
+            sensorHealth.printStatus();
+        }
+        else if (command == "sensors.retry")
+        {
+            sensorHealth.retryAll();
+            Serial.println("故障的传感器将立即尝试恢复");
+        }
+        else if (command == "sensors.reset")
+        {
+            sensorHealth.resetStats();
+            Serial.println("已清零传感器健康统计");
+        }
+#ifdef ENABLE_IMU
+        else if (command == "vib")
+        {
+            vibration.printStatus();
+        }
+        else if (command == "vib.on" || command == "vib.off")
+        {
+            vibration.setEnabled(command == "vib.on");
+            Serial.println(vibration.isEnabled() ? "振动分析已开启（重启后恢复默认）" : "振动分析已关闭");
+        }
+#endif
+#ifdef BAT_PIN
+        else if (command == "bat.soc")
+        {
+            bat.printSoc();
+        }
+        else if (command == "bat.trace")
+        {
+            bat.setTrace(!bat.isTracing());
+            Serial.println(bat.isTracing() ? "电池曲线记录已开启，每秒输出 bat,毫秒,mV,负载,充电" : "电池曲线记录已关闭");
+        }
+#endif
         else if (command == "restart" || command == "reboot")
         {
             Serial.println("正在重启设备...");
+            trace.instant(TRACE_ID_RESTART, TRACE_RESTART_SERIAL);
             Serial.flush();
             delay(1000);
             ESP.restart();
@@ -264,6 +459,51 @@ void handleSerialCommand()
             Serial.println("  restart  - 重启设备");
             Serial.println("  help     - 显示此帮助信息");
             Serial.println("");
+            Serial.println("电源命令:");
+            Serial.println("  power.status - 显示电源状态和各唤醒源的唤醒耗时");
+            Serial.println("  power.log    - 显示电源状态迁移日志（跨深度睡眠保留）");
+            Serial.println("  power.freq   - 显示各CPU频率停留时间和电源锁持有情况");
+            Serial.println("  power.freq.reset - 清零CPU频率统计");
+            Serial.println("  power.boot   - 显示启动各阶段耗时、首次定位时间和热启动状态");
+            Serial.println("  power.ulp    - 显示深度睡眠监测记录（电池最低/最高电压、电门抖动、唤醒原因）");
+            Serial.println("  power.mah    - 显示各子系统耗电量（开机以来和本次/上次骑行，各状态停留时间）");
+            Serial.println("");
+            Serial.println("性能命令:");
+            Serial.println("  perf       - 显示各任务CPU占用、栈余量和各子系统循环耗时分布");
+            Serial.println("  perf.reset - 清零循环耗时统计");
+            Serial.println("  heap       - 显示堆空间、碎片率和各调用点的分配统计");
+            Serial.println("  heap.mark  - 清零分配统计，开始新的观察窗口");
+            Serial.println("  log        - 显示日志级别、缓冲区占用和丢弃数");
+            Serial.println("  log.level <通道|all> <0-5|default> - 设置单个模块或全局日志级别并保存");
+            Serial.println("  log.reset  - 日志级别恢复默认");
+            Serial.println("  link       - 显示串口二进制帧收发统计（上位机: monitor_serial.py --ping/--telemetry/--download）");
+            Serial.println("  trace      - 显示事件跟踪状态和最近20个事件");
+            Serial.println("  trace.dump - 将事件跟踪写入SD卡 /data/trace/");
+            Serial.println("  trace.clear - 清空事件跟踪");
+            Serial.println("  sensors    - 显示传感器健康状态、异常和恢复统计");
+            Serial.println("  sensors.retry - 故障的传感器立即尝试恢复（不等待退避时间）");
+            Serial.println("  sensors.reset - 清零传感器健康统计");
+            Serial.println("");
+#if defined(ENABLE_IMU) && defined(IMU_INT_PIN)
+            Serial.println("IMU命令:");
+            Serial.println("  imu.wom        - 显示IMU唤醒阈值和误唤醒统计");
+            Serial.println("  imu.wom.base <mg> - 设置IMU唤醒基准阈值（保存，按安装位置调整）");
+            Serial.println("  imu.wom.reset  - 清零IMU唤醒统计");
+            Serial.println("");
+#endif
+#ifdef ENABLE_IMU
+            Serial.println("振动命令:");
+            Serial.println("  vib        - 显示振动分析结果（发动机转速、频带、健康度）和分析耗时");
+            Serial.println("  vib.on     - 开启振动分析（电门打开时采样）");
+            Serial.println("  vib.off    - 关闭振动分析");
+            Serial.println("");
+#endif
+#ifdef BAT_PIN
+            Serial.println("电池命令:");
+            Serial.println("  bat.soc    - 显示电量估计（电量、不确定度、剩余时间、负载）");
+            Serial.println("  bat.trace  - 开关电池曲线记录，输出可用 tools/soc_estimator_sim.cpp 回放");
+            Serial.println("");
+#endif
 #ifdef ENABLE_SDCARD
             Serial.println("SD卡命令:");
             Serial.println("  sd.info    - 显示SD卡详细信息");
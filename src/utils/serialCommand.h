@@ -5,4 +5,5 @@
 #include "Air780EG.h"
 #include "audio/AudioManager.h"
 
-void handleSerialCommand();
\ No newline at end of file
+// 执行一条文本命令，由 SerialLink 在收到一行文本或文本命令帧时调用
+void handleSerialCommand(String command);
\ No newline at end of file
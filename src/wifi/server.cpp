@@ -1,4 +1,5 @@
 #include "server.h"
+#include "utils/Trace.h"
 
 #ifdef ENABLE_WIFI
 WiFiConfigManager wifiManager;
@@ -7,7 +8,7 @@ WiFiConfigManager wifiManager;
 void WiFiEvent(WiFiEvent_t event)
 {
     // 电源倒计时的时候不处理
-    if (powerManager.powerState == POWER_STATE_COUNTDOWN) {
+    if (powerManager.getPowerMode() == POWER_MODE_SLEEP_COUNTDOWN) {
         return;
     }
     switch (event)
@@ -26,19 +27,16 @@ void WiFiEvent(WiFiEvent_t event)
         break;
     case SYSTEM_EVENT_STA_CONNECTED:
         Serial.println("已连接到WiFi网络");
-        device_state.wifiConnected = true;
-        state_changes.wifi_changed = true;
+        deviceState.set(DS_WIFI, &device_state_t::wifiConnected, true);
         break;
     case SYSTEM_EVENT_STA_DISCONNECTED:
         Serial.println("WiFi连接已断开");
-        device_state.wifiConnected = false;
-        state_changes.wifi_changed = true;
+        deviceState.set(DS_WIFI, &device_state_t::wifiConnected, false);
         break;
     case SYSTEM_EVENT_STA_GOT_IP:
         Serial.printf("获取到IP地址: %s\n", WiFi.localIP().toString().c_str());
         // 更新设备状态
-        device_state.wifiConnected = true;
-        state_changes.wifi_changed = true;
+        deviceState.set(DS_WIFI, &device_state_t::wifiConnected, true);
         break;
     default:
         break;
@@ -146,40 +144,32 @@ void WiFiConfigManager::setupWebServer()
     // WiFi扫描接口
     server.on("/scan", HTTP_GET, [this]() {
         int n = WiFi.scanNetworks();
-        DynamicJsonDocument doc(1024);
+        StaticJsonDocument<1024> doc;
         JsonArray arr = doc.to<JsonArray>();
         for (int i = 0; i < n; ++i) {
             arr.add(WiFi.SSID(i));
         }
-        String output;
-        serializeJson(doc, output);
-        server.send(200, "application/json", output);
+        sendJson(doc);
     });
 
     // 获取已保存WiFi（单个）
     server.on("/saved_wifi", HTTP_GET, [this]() {
         String ssid, password;
-        DynamicJsonDocument doc(256);
+        StaticJsonDocument<256> doc;
         JsonArray arr = doc.to<JsonArray>();
         if (PreferencesUtils::getWifi(ssid, password) && ssid.length() > 0) {
             JsonObject obj = arr.createNestedObject();
             obj["ssid"] = ssid;
             obj["password"] = password;
         }
-        String output;
-        serializeJson(arr, output);
-        server.send(200, "application/json", output);
+        sendJson(doc);
     });
 
     // 删除已保存WiFi
     server.on("/delete_wifi", HTTP_POST, [this]() {
         PreferencesUtils::clearWifi();
         // 返回空列表
-        DynamicJsonDocument doc(256);
-        JsonArray arr = doc.to<JsonArray>();
-        String output;
-        serializeJson(arr, output);
-        server.send(200, "application/json", output);
+        server.send_P(200, "application/json", "[]");
     });
 
     // 退出配网模式
@@ -217,9 +207,23 @@ void WiFiConfigManager::handleConfigSubmit()
     saveWiFiCredentials(newSSID, newPassword);
     server.send(200, "text/html", getSuccessPage());
     delay(2000);
+    trace.instant(TRACE_ID_RESTART, TRACE_RESTART_WIFI);
     ESP.restart();
 }
 
+// 序列化到静态缓冲区后发送，不经过 String
+void WiFiConfigManager::sendJson(const JsonDocument &doc)
+{
+    static char buffer[1024];
+    if (measureJson(doc) >= sizeof(buffer))
+    {
+        server.send_P(500, "application/json", "{\"error\":\"too large\"}");
+        return;
+    }
+    serializeJson(doc, buffer, sizeof(buffer));
+    server.send_P(200, "application/json", buffer);
+}
+
 void WiFiConfigManager::handleClient()
 {
     dnsServer.processNextRequest();
@@ -267,6 +271,7 @@ void WiFiConfigManager::reset()
     WiFi.disconnect(true, true);
     PreferencesUtils::clearWifi();
     delay(100);
+    trace.instant(TRACE_ID_RESTART, TRACE_RESTART_WIFI);
     ESP.restart();
 }
 
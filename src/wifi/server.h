@@ -32,6 +32,7 @@ private:
     void saveWiFiCredentials(const String &ssid, const String &password);
     void handleClient();
     bool isIp(String str);
+    void sendJson(const JsonDocument &doc);
     void startAP();
     void stopAP();
 public:
@@ -0,0 +1,173 @@
+/*
+ * 内置语音 IMA-ADPCM 解码精度验证（主机端）
+ *
+ * 用固件的 adpcmDecodeBlock()（src/audio/AdpcmCodec.h）按 AudioVoice 的方式逐块解码
+ * welcome_voice.h、dadada_daboluocheji.h 中的数据，与 tools/audio_files 中的原始16位WAV逐采样比较：
+ *   - 解码采样数与原始WAV帧数、头文件中的 sample_count 一致
+ *   - 每块第一个采样点无损（块头保存原始值）
+ *   - 信噪比不低于 MIN_SNR_DB
+ * 任一语音不符合预期时返回非零。
+ *
+ * WAV 默认在本文件所在目录或当前目录的 audio_files/ 中查找（仓库根目录和 tools/ 下都能运行），
+ * 也可以在命令行依次指定两个WAV的路径。
+ *
+ * 编译运行（在仓库根目录）：
+ *   g++ -O2 -std=c++11 -I src/audio tools/adpcm_decode_test.cpp -o /tmp/adpcm_decode_test
+ *   /tmp/adpcm_decode_test [welcome.wav dadada.wav]
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "AdpcmCodec.h"
+#include "VoiceInfo.h"
+#include "welcome_voice.h"
+#include "dadada_daboluocheji.h"
+
+static const double MIN_SNR_DB = 20.0;
+static const size_t MONO_SIZE = 1024;  // 不小于每块采样数，与 AUDIO_VOICE_MONO_SIZE 的用途相同
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+static uint32_t readLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 读取16位单声道WAV的采样，失败时返回 false
+static bool loadWav(const char* path, std::vector<int16_t>& samples, uint32_t& sampleRate) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    std::vector<uint8_t> file;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        file.insert(file.end(), buf, buf + n);
+    }
+    fclose(f);
+    if (file.size() < 12 || memcmp(&file[0], "RIFF", 4) != 0 || memcmp(&file[8], "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool fmtOk = false;
+    for (size_t pos = 12; pos + 8 <= file.size();) {
+        const uint8_t* chunk = &file[pos];
+        uint32_t len = readLe32(chunk + 4);
+        if (pos + 8 + len > file.size()) {
+            len = (uint32_t)(file.size() - pos - 8);
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0 && len >= 16) {
+            uint16_t format = chunk[8] | (chunk[9] << 8);
+            uint16_t channels = chunk[10] | (chunk[11] << 8);
+            uint16_t bits = chunk[22] | (chunk[23] << 8);
+            sampleRate = readLe32(chunk + 12);
+            fmtOk = format == 1 && channels == 1 && bits == 16;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!fmtOk) {
+                return false;
+            }
+            samples.resize(len / 2);
+            for (size_t i = 0; i < samples.size(); i++) {
+                samples[i] = (int16_t)(chunk[8 + 2 * i] | (chunk[9 + 2 * i] << 8));
+            }
+            return true;
+        }
+        pos += 8 + len + (len & 1);
+    }
+    return false;
+}
+
+// 与 AudioVoice 的 VOICE_SOURCE_ADPCM_MEMORY 相同：逐块解码，最后一块的补齐部分按 sample_count 截断
+static std::vector<int16_t> decodeVoice(const VoiceInfo& voice) {
+    std::vector<int16_t> out;
+    int16_t mono[MONO_SIZE];
+    uint32_t left = voice.sample_count;
+    for (size_t pos = 0; pos < voice.size && left > 0; pos += voice.block_align) {
+        size_t blockBytes = voice.size - pos;
+        if (blockBytes > voice.block_align) {
+            blockBytes = voice.block_align;
+        }
+        size_t samples = adpcmDecodeBlock(voice.data + pos, blockBytes, mono, MONO_SIZE);
+        if (samples > left) {
+            samples = left;
+        }
+        out.insert(out.end(), mono, mono + samples);
+        left -= samples;
+    }
+    return out;
+}
+
+static bool verifyVoice(const VoiceInfo& voice, const char* wavPath) {
+    char detail[240];
+    std::vector<int16_t> ref;
+    uint32_t sampleRate = 0;
+    if (!loadWav(wavPath, ref, sampleRate)) {
+        snprintf(detail, sizeof(detail), "无法读取16位单声道WAV %s", wavPath);
+        return check(voice.name, false, detail);
+    }
+    if (voice.format != VOICE_FORMAT_IMA_ADPCM || adpcmSamplesPerBlock(voice.block_align) > MONO_SIZE) {
+        snprintf(detail, sizeof(detail), "不是 IMA-ADPCM 数据或块大小 %u 不支持", voice.block_align);
+        return check(voice.name, false, detail);
+    }
+
+    std::vector<int16_t> decoded = decodeVoice(voice);
+    bool countOk = decoded.size() == ref.size() && voice.sample_count == ref.size() &&
+                   voice.sample_rate == sampleRate;
+
+    size_t n = decoded.size() < ref.size() ? decoded.size() : ref.size();
+    double signal = 0, noise = 0;
+    int maxError = 0;
+    size_t headerMismatch = 0;
+    size_t perBlock = adpcmSamplesPerBlock(voice.block_align);
+    for (size_t i = 0; i < n; i++) {
+        int err = (int)decoded[i] - ref[i];
+        signal += (double)ref[i] * ref[i];
+        noise += (double)err * err;
+        if (abs(err) > maxError) {
+            maxError = abs(err);
+        }
+        if (i % perBlock == 0 && err != 0) {
+            headerMismatch++;
+        }
+    }
+    double snr = noise > 0 ? 10.0 * log10(signal / noise) : INFINITY;
+
+    snprintf(detail, sizeof(detail), "%lu/%lu 个采样，SNR %.1f dB（要求 >= %.0f），最大误差 %d，块头不一致 %lu",
+             (unsigned long)decoded.size(), (unsigned long)ref.size(), snr, MIN_SNR_DB, maxError,
+             (unsigned long)headerMismatch);
+    return check(voice.name, countOk && headerMismatch == 0 && snr >= MIN_SNR_DB, detail);
+}
+
+// 依次在编译时本文件的目录（__FILE__ 为相对路径时相对于编译时的工作目录）和当前目录下的 audio_files/ 中查找
+static std::string findWav(const char* name) {
+    std::string file = __FILE__;
+    size_t slash = file.find_last_of('/');
+    std::string candidates[2] = {
+        (slash == std::string::npos ? std::string(".") : file.substr(0, slash)) + "/audio_files/" + name,
+        std::string("audio_files/") + name,
+    };
+    for (int i = 0; i < 2; i++) {
+        FILE* f = fopen(candidates[i].c_str(), "rb");
+        if (f) {
+            fclose(f);
+            return candidates[i];
+        }
+    }
+    return candidates[0];
+}
+
+int main(int argc, char** argv) {
+    std::string welcome = argc > 2 ? argv[1] : findWav("welcome_fixed.wav");
+    std::string dadada = argc > 2 ? argv[2] : findWav("dadada_daboluocheji_converted.wav");
+    int errors = 0;
+    errors += verifyVoice(WELCOME_VOICE_DATA_INFO, welcome.c_str()) ? 0 : 1;
+    errors += verifyVoice(DADADA_DABOLUOCHEJI_DATA_INFO, dadada.c_str()) ? 0 : 1;
+    return errors == 0 ? 0 : 1;
+}
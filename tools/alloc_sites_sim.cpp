@@ -0,0 +1,87 @@
+/*
+ * 分配调用点统计验证（主机端）
+ *
+ * 按已知的调用栈和次数回放分配，检查每个调用点的次数、字节数和单次最大值，
+ * 同一函数经不同调用者的分配分开统计；表满后的分配计入溢出但总数不丢；
+ * 按字节数排序的前 N 个调用点正确。最后测量单次记录的耗时。任一检查失败时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/utils tools/alloc_sites_sim.cpp -o /tmp/alloc_sites_sim
+ *   /tmp/alloc_sites_sim
+ */
+
+#include <chrono>
+#include <cstdio>
+#include "AllocSites.h"
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+static const AllocSite* find(const AllocSiteTable& t, const uint32_t* pc) {
+    for (int i = 0; i < ALLOC_SITE_SLOTS; i++) {
+        if (t.slots[i].pc[0] != 0 && allocSiteMatch(t.slots[i], pc)) {
+            return &t.slots[i];
+        }
+    }
+    return nullptr;
+}
+
+int main() {
+    int errors = 0;
+    char detail[160];
+    static AllocSiteTable t;
+    allocSitesReset(t);
+
+    // String::changeBuffer 由两个不同的函数调用，调用栈第二层不同
+    uint32_t gps[ALLOC_SITE_DEPTH] = {0x400d1000, 0x400d2000, 0x400d3000};
+    uint32_t bat[ALLOC_SITE_DEPTH] = {0x400d1000, 0x400d5000, 0x400d6000};
+    uint32_t json[ALLOC_SITE_DEPTH] = {0x400d7000, 0x400d8000, 0};
+    for (int i = 0; i < 100; i++) {
+        allocSitesRecord(t, gps, 64 + i % 3);
+    }
+    for (int i = 0; i < 10; i++) {
+        allocSitesRecord(t, bat, 200);
+        allocSitesFree(t);
+    }
+    allocSitesRecord(t, json, 1024);
+
+    const AllocSite* g = find(t, gps);
+    const AllocSite* b = find(t, bat);
+    const AllocSite* j = find(t, json);
+    bool ok = g && b && j && g->count == 100 && g->bytes == 100 * 64 + 33 + 2 * 33 && g->maxBytes == 66 &&
+              b->count == 10 && b->bytes == 2000 && j->count == 1 && t.used == 3 && t.total == 111 && t.frees == 10;
+    snprintf(detail, sizeof(detail), "3 个调用点，共 %u 次 %llu B", (unsigned)t.total,
+             (unsigned long long)t.totalBytes);
+    errors += check("per_site_counts", ok, detail) ? 0 : 1;
+
+    int top[2];
+    int n = allocSitesTop(t, top, 2);
+    ok = n == 2 && &t.slots[top[0]] == g && &t.slots[top[1]] == b;
+    errors += check("top_by_bytes", ok, "字节数前两位为 GPS 记录和电池日志") ? 0 : 1;
+
+    // 表满：留一个空槽，其余调用点计入溢出
+    allocSitesReset(t);
+    for (uint32_t i = 1; i <= ALLOC_SITE_SLOTS * 2; i++) {
+        uint32_t pc[ALLOC_SITE_DEPTH] = {0x40080000 + i * 4, 0x400d0000, 0};
+        allocSitesRecord(t, pc, 16);
+    }
+    snprintf(detail, sizeof(detail), "记录 %u 个调用点，溢出 %u 次，总数 %u", (unsigned)t.used,
+             (unsigned)t.overflow, (unsigned)t.total);
+    errors += check("overflow", t.used == ALLOC_SITE_SLOTS - 1 && t.overflow == ALLOC_SITE_SLOTS + 1 &&
+                    t.total == ALLOC_SITE_SLOTS * 2, detail) ? 0 : 1;
+
+    // 单次记录耗时（表中已有 63 个调用点，最坏情况的线性探测）
+    const int rounds = 2000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        uint32_t pc[ALLOC_SITE_DEPTH] = {0x40080000 + (uint32_t)(i % 40 + 1) * 4, 0x400d0000, 0};
+        allocSitesRecord(t, pc, 16);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    snprintf(detail, sizeof(detail), "%.1f ns/次（主机）", ns);
+    errors += check("record_cost", ns < 1000, detail) ? 0 : 1;
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/*
+ * 延迟格式化日志验证和开销对比（主机端）
+ *
+ * 先检查记录后再格式化的输出与直接 snprintf 逐字节一致（整数、负数的 %x、宽度精度、
+ * %*d、%%、%c、%p、long long、字符串截断），缓冲区满时丢弃并计数、取出顺序不变。
+ * 然后对比调用方一侧的耗时：
+ *   - 编译期关闭（if (0)，参数不求值）
+ *   - 运行时过滤（一次级别比较）
+ *   - 延迟格式化（捕获参数 + 写入环形缓冲区，格式化在低优先级任务中）
+ *   - 直接 snprintf
+ *   - std::string 拼接（相当于原来的 String 拼接）
+ * 任一检查失败时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/utils tools/bench_log.cpp -o /tmp/bench_log
+ *   /tmp/bench_log
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "LogRing.h"
+
+struct NoLock {
+    void lock() {}
+    void unlock() {}
+};
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+// 捕获后格式化，与 snprintf 的结果比较
+template <typename... Args>
+static bool same(const char* fmt, Args... args) {
+    char expect[256];
+    char got[256];
+    snprintf(expect, sizeof(expect), fmt, args...);
+    LogRecord r;
+    logCapture(r, 0, 3, "T", fmt, args...);
+    logFormatMessage(r, got, sizeof(got));
+    if (strcmp(expect, got) != 0) {
+        printf("    格式 \"%s\": 期望 \"%s\"，得到 \"%s\"\n", fmt, expect, got);
+        return false;
+    }
+    return true;
+}
+
+static volatile int sink;
+static volatile uint8_t runtimeLevel = 3;
+
+template <typename F>
+static double nsPerCall(int rounds, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        f(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+int main() {
+    int errors = 0;
+    char detail[160];
+
+    int mismatches = 0;
+    mismatches += !same("plain text");
+    mismatches += !same("%d %i %u", -42, 7, 3000000000u);
+    mismatches += !same("%x %X %o", -1, 0xBEEFu, 8);
+    mismatches += !same("%5d|%-5d|%05d|%+d", 42, 42, 42, 42);
+    mismatches += !same("%.2f %5.2f %e %g", 3.14159, -2.5, 12345.678, 0.0001);
+    mismatches += !same("%.6f,%.6f (卫星:%d)", 31.230416, 121.473701, 9);
+    mismatches += !same("%*d|%-*d|%.*f", 6, 12, 4, 3, 2, 1.23456);
+    mismatches += !same("100%% %c%c", 'o', 'k');
+    mismatches += !same("%lld %llu %lx", -9000000000LL, 18000000000ULL, 0x123456789ALL);
+    mismatches += !same("%s=%s", "key", "value");
+    mismatches += !same("%10s|%-4s|%.3s", "right", "l", "abcdef");
+    mismatches += !same("%p", (void*)&errors);
+    mismatches += !same("状态: %s, 电量: %d%%", "是", 87);
+    snprintf(detail, sizeof(detail), "13 组格式，%d 组不一致", mismatches);
+    errors += check("format_matches", mismatches == 0, detail) ? 0 : 1;
+
+    // 字符串参数超出 LOG_TEXT_BYTES 时截断，后面的参数不受影响
+    {
+        LogRecord r;
+        char out[128];
+        logCapture(r, 0, 3, "T", "%s|%s|%d", "0123456789012345678901234567890", "tail", 5);
+        logFormatMessage(r, out, sizeof(out));
+        bool ok = strncmp(out, "01234567890123456789012", LOG_TEXT_BYTES - 1) == 0 && strstr(out, "||5") != NULL;
+        snprintf(detail, sizeof(detail), "\"%s\"", out);
+        errors += check("string_truncate", ok, detail) ? 0 : 1;
+    }
+
+    // 缓冲区满时丢弃新记录，已有记录按顺序取出
+    {
+        static LogRing<8, NoLock> ring;
+        LogRecord r;
+        bool firstOk = true;
+        for (int i = 0; i < 12; i++) {
+            logCapture(r, i, 3, "T", "%d", i);
+            LogPushResult res = ring.push(r);
+            firstOk = firstOk && ((i == 0) == (res == LOG_PUSH_FIRST)) && ((i >= 8) == (res == LOG_PUSH_DROPPED));
+        }
+        bool orderOk = true;
+        for (int i = 0; i < 8; i++) {
+            orderOk = orderOk && ring.pop(r) && r.tsMs == (uint32_t)i;
+        }
+        bool ok = firstOk && orderOk && !ring.pop(r) && ring.droppedCount() == 4 && ring.totalCount() == 8 &&
+                  ring.maxPending() == 8;
+        snprintf(detail, sizeof(detail), "写入 12 条，保留 8 条，丢弃 %u 条", (unsigned)ring.droppedCount());
+        errors += check("ring_drop", ok, detail) ? 0 : 1;
+    }
+
+    // 调用方一侧的耗时，参数取自 BAT 的状态更新日志
+    const int rounds = 2000000;
+    static LogRing<64, NoLock> ring;
+    LogRecord popped;
+    double off = nsPerCall(rounds, [](int i) {
+        if (0) {
+            sink = snprintf(NULL, 0, "%d", i);
+        }
+    });
+    double filtered = nsPerCall(rounds, [](int i) {
+        if (4 <= runtimeLevel) {
+            sink = i;
+        }
+    });
+    double deferred = nsPerCall(rounds, [&](int i) {
+        LogRecord r;
+        logCapture(r, i, 4, "BAT", "状态更新 -> 充电: %s, 电量: %d%% ±%d%%, 剩余: %dmin", i & 1 ? "是" : "否",
+                   i % 100, 3, 240);
+        ring.push(r);
+        if (ring.pending() > 32) {
+            while (ring.pop(popped)) {
+            }
+        }
+    });
+    double formatCost = nsPerCall(rounds / 4, [&](int i) {
+        char out[256];
+        LogRecord r;
+        logCapture(r, i, 4, "BAT", "状态更新 -> 充电: %s, 电量: %d%% ±%d%%, 剩余: %dmin", i & 1 ? "是" : "否",
+                   i % 100, 3, 240);
+        sink = (int)logFormatMessage(r, out, sizeof(out));
+    });
+    double eager = nsPerCall(rounds / 4, [](int i) {
+        char out[256];
+        sink = snprintf(out, sizeof(out), "状态更新 -> 充电: %s, 电量: %d%% ±%d%%, 剩余: %dmin", i & 1 ? "是" : "否",
+                        i % 100, 3, 240);
+    });
+    double concat = nsPerCall(rounds / 4, [](int i) {
+        std::string s = std::string("状态更新 -> 充电: ") + (i & 1 ? "是" : "否") + ", 电量: " +
+                        std::to_string(i % 100) + "% ±" + std::to_string(3) + "%, 剩余: " + std::to_string(240) +
+                        "min";
+        sink = (int)s.size();
+    });
+
+    printf("\n调用方耗时（主机，ns/次）:\n");
+    printf("  编译期关闭     %8.1f\n", off);
+    printf("  运行时过滤     %8.1f\n", filtered);
+    printf("  延迟格式化     %8.1f   （格式化任务中另需 %.1f）\n", deferred, formatCost);
+    printf("  直接 snprintf  %8.1f\n", eager);
+    printf("  字符串拼接     %8.1f\n", concat);
+    printf("记录大小 %u 字节\n", (unsigned)sizeof(LogRecord));
+
+    snprintf(detail, sizeof(detail), "延迟 %.1f ns < 直接格式化 %.1f ns", deferred, eager);
+    errors += check("deferred_cheaper", deferred < eager, detail) ? 0 : 1;
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+/*
+ * 传感器计算误差和开销（主机端）
+ *
+ * 先检查 FastMath.h 近似的误差上限（与 libm double 结果比较）：
+ *   - fastAtan2Deg：全部象限、加速度计量级（0.001 ~ 8 g）和罗盘原始值量级（±32767）
+ *   - fastSqrt：float 相对误差，Q16 绝对误差
+ *   - AttitudeFilter<float>、AttitudeFilter<Q16> 与原来 double 写法的姿态在一段模拟行驶数据上的最大偏差
+ * 然后对比每个采样的姿态解算耗时：原来的 double atan2/sqrt、float 近似、Q16 定点。
+ * 主机有硬件双精度，double 不吃亏；ESP32 上 double 是软件模拟，差距会大得多，
+ * 固件上用串口 perf 看 TaskData 的占用确认。任一检查失败时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src -I src/utils tools/bench_sensor_math.cpp -o /tmp/bench_sensor_math
+ *   /tmp/bench_sensor_math
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "FastMath.h"
+#include "imu/AttitudeFilter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+struct Sample {
+    float ax, ay, az, gx, gy;
+};
+
+// 原来 IMU::loop 的写法（double 常量和 libm）
+struct ReferenceFilter {
+    float roll = 0;
+    float pitch = 0;
+    void update(const Sample& s) {
+        float rollAcc = atan2(s.ay, s.az) * 180 / M_PI;
+        float pitchAcc = atan2(-s.ax, sqrt(s.ay * s.ay + s.az * s.az)) * 180 / M_PI;
+        roll = 0.98 * (roll + s.gx * 0.01) + (1.0 - 0.98) * rollAcc;
+        pitch = 0.98 * (pitch + s.gy * 0.01) + (1.0 - 0.98) * pitchAcc;
+    }
+};
+
+static float frand(float lo, float hi) {
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+static double angleDiff(double a, double b) {
+    double d = fmod(a - b + 540.0, 360.0) - 180.0;
+    return fabs(d);
+}
+
+// 100Hz 模拟行驶：慢速侧倾、俯仰，叠加发动机振动和传感器噪声
+static std::vector<Sample> makeTrace(int n) {
+    std::vector<Sample> trace(n);
+    const float D2R = 0.017453293f;
+    for (int i = 0; i < n; i++) {
+        float t = i * 0.01f;
+        float roll = 35.0f * sinf(t * 0.4f);
+        float pitch = 12.0f * sinf(t * 0.15f + 1.0f);
+        float vib = 0.08f * sinf(t * 2 * 3.14159f * 45.0f);
+        Sample& s = trace[i];
+        s.ax = -sinf(pitch * D2R) + vib + frand(-0.01f, 0.01f);
+        s.ay = cosf(pitch * D2R) * sinf(roll * D2R) + vib * 0.5f + frand(-0.01f, 0.01f);
+        s.az = cosf(pitch * D2R) * cosf(roll * D2R) + vib + frand(-0.01f, 0.01f);
+        s.gx = 35.0f * 0.4f * cosf(t * 0.4f) + frand(-0.5f, 0.5f);
+        s.gy = 12.0f * 0.15f * cosf(t * 0.15f + 1.0f) + frand(-0.5f, 0.5f);
+    }
+    return trace;
+}
+
+static inline uint64_t ticks() {
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+template <typename F>
+static void timeFilter(const char* name, F& filter, const std::vector<Sample>& trace, int rounds, double& nsOut) {
+    volatile float sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t t0 = ticks();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < trace.size(); i++) {
+            filter.update(trace[i]);
+        }
+        sink = sink + filter.roll;
+    }
+    uint64_t t1 = ticks();
+    double n = (double)rounds * trace.size();
+    nsOut = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+    printf("       %-22s %6.1f ns/采样", name, nsOut);
+#ifdef HAVE_RDTSC
+    printf("  %6.0f 周期/采样（TSC）", (t1 - t0) / n);
+#endif
+    printf("\n");
+}
+
+template <typename T>
+struct FastFilter {
+    AttitudeFilter<T> f;
+    float roll;
+    FastFilter() : f(0.98f, 0.01f), roll(0) {}
+    void update(const Sample& s) {
+        f.update(s.ax, s.ay, s.az, s.gx, s.gy);
+        roll = f.roll();
+    }
+};
+
+int main() {
+    int errors = 0;
+    char detail[160];
+    srand(1);
+
+    // atan2
+    {
+        double maxFloat = 0;
+        double maxQ16 = 0;
+        static const float scales[] = {0.001f, 0.05f, 1.0f, 8.0f, 1000.0f, 32767.0f};
+        for (size_t si = 0; si < sizeof(scales) / sizeof(scales[0]); si++) {
+            for (int i = 0; i <= 3600; i++) {
+                double a = (i / 10.0 - 180.0) * M_PI / 180.0;
+                float r = scales[si];
+                float x = (float)(r * cos(a));
+                float y = (float)(r * sin(a));
+                double ref = atan2((double)y, (double)x) * 180.0 / M_PI;
+                maxFloat = fmax(maxFloat, angleDiff(fastAtan2Deg(y, x), ref));
+                Q16 qx(x);
+                Q16 qy(y);
+                double refQ = atan2((double)qy.raw, (double)qx.raw) * 180.0 / M_PI;
+                maxQ16 = fmax(maxQ16, angleDiff(fastAtan2Deg(qy, qx).toFloat(), refQ));
+            }
+        }
+        snprintf(detail, sizeof(detail), "最大误差 %.5f°", maxFloat);
+        errors += check("atan2_float", maxFloat < 0.001, detail) ? 0 : 1;
+        snprintf(detail, sizeof(detail), "最大误差 %.5f°", maxQ16);
+        errors += check("atan2_q16", maxQ16 < 0.005, detail) ? 0 : 1;
+        bool zero = fastAtan2Deg(0.0f, 0.0f) == 0 && fastAtan2Deg(Q16(), Q16()).raw == 0;
+        errors += check("atan2_zero", zero, "x、y 都为 0 时返回 0") ? 0 : 1;
+    }
+
+    // sqrt
+    {
+        double maxRel = 0;
+        double maxAbsQ = 0;
+        for (int i = 0; i < 200000; i++) {
+            float v = powf(10.0f, frand(-6.0f, 6.0f));
+            maxRel = fmax(maxRel, fabs(fastSqrt(v) - sqrt((double)v)) / sqrt((double)v));
+            float q = powf(10.0f, frand(-4.0f, 4.5f));
+            Q16 qv(q);
+            maxAbsQ = fmax(maxAbsQ, fabs(fastSqrt(qv).toFloat() - sqrt(qv.raw / 65536.0)));
+        }
+        bool edge = fastSqrt(0.0f) == 0 && fastSqrt(-1.0f) == 0 && fastSqrt(Q16(-1.0f)).raw == 0;
+        snprintf(detail, sizeof(detail), "float 相对误差 %.2e", maxRel);
+        errors += check("sqrt_float", maxRel < 5e-6 && edge, detail) ? 0 : 1;
+        snprintf(detail, sizeof(detail), "Q16 绝对误差 %.2e（分辨率 1.5e-5）", maxAbsQ);
+        errors += check("sqrt_q16", maxAbsQ < 2.0 / 65536, detail) ? 0 : 1;
+    }
+
+    // 姿态滤波与原写法比较
+    std::vector<Sample> trace = makeTrace(60000);
+    {
+        ReferenceFilter ref;
+        FastFilter<float> ff;
+        FastFilter<Q16> fq;
+        double maxF = 0;
+        double maxQ = 0;
+        for (size_t i = 0; i < trace.size(); i++) {
+            ref.update(trace[i]);
+            ff.update(trace[i]);
+            fq.update(trace[i]);
+            maxF = fmax(maxF, fmax(fabs(ff.f.roll() - ref.roll), fabs(ff.f.pitch() - ref.pitch)));
+            maxQ = fmax(maxQ, fmax(fabs(fq.f.roll() - ref.roll), fabs(fq.f.pitch() - ref.pitch)));
+        }
+        snprintf(detail, sizeof(detail), "10 分钟行驶数据最大偏差 %.4f°", maxF);
+        errors += check("attitude_float", maxF < 0.01, detail) ? 0 : 1;
+        snprintf(detail, sizeof(detail), "10 分钟行驶数据最大偏差 %.4f°", maxQ);
+        errors += check("attitude_q16", maxQ < 0.1, detail) ? 0 : 1;
+    }
+
+    // 耗时
+    {
+        printf("[耗时] 每个采样两次 atan2、一次 sqrt 和互补滤波（主机）\n");
+        ReferenceFilter ref;
+        FastFilter<float> ff;
+        FastFilter<Q16> fq;
+        double nsRef, nsF, nsQ;
+        timeFilter("double atan2/sqrt（原）", ref, trace, 50, nsRef);
+        timeFilter("float 近似", ff, trace, 50, nsF);
+        timeFilter("Q16 定点", fq, trace, 50, nsQ);
+        snprintf(detail, sizeof(detail), "float 近似为原写法的 %.0f%%，Q16 为 %.0f%%", nsF / nsRef * 100, nsQ / nsRef * 100);
+        errors += check("attitude_cost", nsF < nsRef, detail) ? 0 : 1;
+    }
+
+    return errors == 0 ? 0 : 1;
+}
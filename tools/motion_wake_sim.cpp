@@ -0,0 +1,158 @@
+/*
+ * IMU运动唤醒判定和阈值自适应验证（主机端）
+ *
+ * 用合成的唤醒后加速度采样（静止噪声、冲击余振、推车、持续晃动）检查判定结果，
+ * 再按时间序列回放误唤醒，检查阈值提高、同一冲击去重、唤醒风暴暂停和安静后降档。
+ * 任一场景不符合预期时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/imu tools/motion_wake_sim.cpp -o /tmp/motion_wake_sim
+ *   /tmp/motion_wake_sim
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "MotionWakeLogic.h"
+
+// 与 config.h 中的默认值一致
+static const MotionWakeConfig CONFIG = {
+    150,        // baseMg
+    255,        // maxMg
+    25,         // stepMg
+    6,          // stormCount
+    3,          // dedupSec
+    21600,      // decaySec
+    600,        // stormWindowSec
+    1800,       // stormHoldoffSec
+    5.0f,       // tiltDeg
+    30.0f,      // shakeMg
+};
+
+static const int SAMPLES = 10;          // 128Hz 下约 80ms
+
+static uint32_t rngState = 2024;
+static float noise(float sigma) {
+    float sum = 0.0f;
+    for (int i = 0; i < 12; i++) {
+        rngState = rngState * 1664525u + 1013904223u;
+        sum += (rngState >> 8) / 16777216.0f;
+    }
+    return (sum - 6.0f) * sigma;
+}
+
+// 车身稍有倾斜停放：重力主要在 z 轴
+static const int16_t REF[3] = {60, -120, 990};
+
+struct Sample {
+    const char* name;
+    float tiltDeg;          // 绕 x 轴转过的角度
+    float ringMg;           // 冲击余振幅度（逐渐衰减）
+    float shakeMg;          // 持续晃动幅度
+    MotionWakeVerdict expect;
+};
+
+static const Sample samples[] = {
+    {"quiet_after_impulse", 0.0f, 0.0f, 0.0f, MOTION_WAKE_FALSE},
+    {"ringing_pothole", 0.3f, 40.0f, 0.0f, MOTION_WAKE_FALSE},
+    {"pushed_off_stand", 8.0f, 0.0f, 0.0f, MOTION_WAKE_TILT},
+    {"handled_by_person", 1.0f, 0.0f, 120.0f, MOTION_WAKE_SHAKE},
+};
+
+static bool runSample(const Sample& sc) {
+    int16_t buf[SAMPLES][3];
+    float rad = sc.tiltDeg * (float)M_PI / 180.0f;
+    float c = cosf(rad), s = sinf(rad);
+    for (int i = 0; i < SAMPLES; i++) {
+        float y = REF[1] * c - REF[2] * s;
+        float z = REF[1] * s + REF[2] * c;
+        float ring = sc.ringMg * expf(-i / 1.5f) * (i % 2 ? -1.0f : 1.0f);
+        float shake = sc.shakeMg * sinf(i * 1.9f);
+        buf[i][0] = (int16_t)(REF[0] + noise(4.0f) + shake * 0.5f);
+        buf[i][1] = (int16_t)(y + noise(4.0f) + shake);
+        buf[i][2] = (int16_t)(z + noise(4.0f) + ring);
+    }
+    MotionWakeFeatures f = motionWakeFeatures(buf, SAMPLES, REF);
+    MotionWakeVerdict v = motionWakeClassify(f, true, CONFIG);
+    bool ok = v == sc.expect;
+    printf("[%s] %-22s 姿态变化 %5.2f°  晃动 %5.1f mg  判定 %s\n", ok ? "通过" : "失败", sc.name, f.tiltDeg,
+           f.shakeMg, motionWakeVerdictName(v));
+    return ok;
+}
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+int main() {
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        if (!runSample(samples[i])) {
+            failures++;
+        }
+    }
+
+    // 没有参考方向时不能判为误唤醒
+    int16_t flat[1][3] = {{0, 0, 1000}};
+    MotionWakeFeatures f = motionWakeFeatures(flat, 1, REF);
+    failures += check("no_reference", motionWakeClassify(f, false, CONFIG) == MOTION_WAKE_UNKNOWN,
+                      "无参考方向按真实运动处理") ? 0 : 1;
+
+    char detail[128];
+    MotionWakeState st;
+    int64_t t = 1000;
+
+    // 同一次冲击的余振在 dedupSec 内重复唤醒，只提高一档
+    motionWakeReset(st, CONFIG);
+    bool raised = motionWakeOnFalse(st, CONFIG, t);
+    bool raisedAgain = motionWakeOnFalse(st, CONFIG, t + 2);
+    snprintf(detail, sizeof(detail), "阈值 %u mg，去重 %lu 次", st.thresholdMg, (unsigned long)st.duplicates);
+    failures += check("dedup_same_impulse", raised && !raisedAgain && st.thresholdMg == 175 && st.duplicates == 1,
+                      detail) ? 0 : 1;
+
+    // 每 5 分钟一次误唤醒：逐档升到上限，不构成风暴
+    motionWakeReset(st, CONFIG);
+    for (int i = 0; i < 6; i++) {
+        motionWakeOnFalse(st, CONFIG, t + i * 300);
+    }
+    snprintf(detail, sizeof(detail), "阈值 %u mg，风暴 %lu 次", st.thresholdMg, (unsigned long)st.storms);
+    failures += check("climb_to_max", st.thresholdMg == 255 && st.storms == 0, detail) ? 0 : 1;
+
+    // 每 30 秒一次：10 分钟内第 6 次进入暂停
+    motionWakeReset(st, CONFIG);
+    int64_t stormAt = -1;
+    for (int i = 0; i < 10 && stormAt < 0; i++) {
+        motionWakeOnFalse(st, CONFIG, t + i * 30);
+        if (st.storms > 0) {
+            stormAt = t + i * 30;
+        }
+    }
+    bool suppressed = stormAt >= 0 && motionWakeSuppressed(st, stormAt + 60) &&
+                      !motionWakeSuppressed(st, stormAt + CONFIG.stormHoldoffSec);
+    snprintf(detail, sizeof(detail), "第 %lld 秒进入暂停，暂停 %lu 秒", stormAt < 0 ? -1LL : (long long)(stormAt - t),
+             (unsigned long)CONFIG.stormHoldoffSec);
+    failures += check("storm_holdoff", suppressed && stormAt - t == 150, detail) ? 0 : 1;
+
+    // 安静后逐档降回基准值，不低于基准值
+    motionWakeReset(st, CONFIG);
+    for (int i = 0; i < 4; i++) {
+        motionWakeOnFalse(st, CONFIG, t + i * 100);
+    }
+    uint8_t before = st.thresholdMg;
+    int64_t last = t + 300;
+    uint8_t after1 = motionWakeThreshold(st, CONFIG, last + CONFIG.decaySec + 10);
+    uint8_t after3 = motionWakeThreshold(st, CONFIG, last + 3 * CONFIG.decaySec + 10);
+    uint8_t afterAll = motionWakeThreshold(st, CONFIG, last + 20 * CONFIG.decaySec);
+    snprintf(detail, sizeof(detail), "%u -> %u -> %u -> %u mg", before, after1, after3, afterAll);
+    failures += check("quiet_decay", before == 250 && after1 == 225 && after3 == 175 && afterAll == 150,
+                      detail) ? 0 : 1;
+
+    // 修改基准值后立即生效
+    MotionWakeConfig higher = CONFIG;
+    higher.baseMg = 200;
+    motionWakeReset(st, CONFIG);
+    snprintf(detail, sizeof(detail), "基准 200 mg 时阈值 %u mg", motionWakeThreshold(st, higher, t));
+    failures += check("base_raised", st.thresholdMg == 200, detail) ? 0 : 1;
+
+    return failures == 0 ? 0 : 1;
+}
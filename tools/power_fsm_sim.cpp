@@ -0,0 +1,187 @@
+/*
+ * 电源状态机策略验证（主机端）
+ *
+ * 按脚本回放事件序列，检查每个场景的最终状态和迁移次数，并打印迁移日志，
+ * 修改 src/power/PowerStateMachine.h 中的迁移表后运行一遍即可确认休眠策略，
+ * 不需要上车测试。任一场景不符合预期时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/power tools/power_fsm_sim.cpp -o /tmp/power_fsm_sim
+ *   /tmp/power_fsm_sim
+ */
+
+#include <cstdio>
+#include "PowerStateMachine.h"
+
+struct Step {
+    uint32_t timeMs;
+    PowerEvent event;
+};
+
+struct Scenario {
+    const char* name;
+    PowerWakeSource wakeSource;
+    const Step* steps;
+    size_t stepCount;
+    PowerMode expectedMode;
+    size_t expectedTransitions;
+};
+
+#define STEPS(x) x, sizeof(x) / sizeof(x[0])
+
+// 骑行结束后停车，静止超时，倒计时结束进入深度睡眠
+static const Step parkAndSleep[] = {
+    {900, POWER_EVENT_READY},
+    {5000, POWER_EVENT_IGNITION_OFF},
+    {305000, POWER_EVENT_IDLE_TIMEOUT},
+    {305000, POWER_EVENT_SLEEP_START},
+    {315000, POWER_EVENT_SLEEP_COMMIT},
+};
+
+// 倒计时中有人推车，取消休眠
+static const Step countdownInterrupted[] = {
+    {900, POWER_EVENT_READY},
+    {300000, POWER_EVENT_IDLE_TIMEOUT},
+    {300000, POWER_EVENT_SLEEP_START},
+    {304000, POWER_EVENT_MOTION},
+};
+
+// 倒计时中按下按钮取消，之后再次空闲超时重新开始倒计时
+static const Step countdownButton[] = {
+    {900, POWER_EVENT_READY},
+    {300000, POWER_EVENT_IDLE_TIMEOUT},
+    {300000, POWER_EVENT_SLEEP_START},
+    {302000, POWER_EVENT_USER},
+    {602000, POWER_EVENT_IDLE_TIMEOUT},
+    {602000, POWER_EVENT_SLEEP_START},
+};
+
+// 唤醒源配置失败，回到正常状态等下一次空闲超时
+static const Step sleepAborted[] = {
+    {900, POWER_EVENT_READY},
+    {300000, POWER_EVENT_IDLE_TIMEOUT},
+    {300000, POWER_EVENT_SLEEP_START},
+    {310000, POWER_EVENT_SLEEP_ABORT},
+    {610000, POWER_EVENT_IDLE_TIMEOUT},
+};
+
+// 驻车浅睡眠周期唤醒，期间电门开启
+static const Step lightSleepIgnition[] = {
+    {900, POWER_EVENT_READY},
+    {300000, POWER_EVENT_IDLE_TIMEOUT},
+    {300100, POWER_EVENT_LIGHT_SLEEP},
+    {600100, POWER_EVENT_TIMER_WAKE},
+    {600300, POWER_EVENT_LIGHT_SLEEP},
+    {650000, POWER_EVENT_MODEM_DATA},
+    {650500, POWER_EVENT_LIGHT_SLEEP},
+    {700000, POWER_EVENT_IGNITION_ON},
+};
+
+// 驻车超过上限后从 PARKED 开始倒计时进入深度睡眠，驻车时不能跳过倒计时
+static const Step parkedThenDeepSleep[] = {
+    {900, POWER_EVENT_READY},
+    {300000, POWER_EVENT_IDLE_TIMEOUT},
+    {300100, POWER_EVENT_LIGHT_SLEEP},
+    {7500000, POWER_EVENT_TIMER_WAKE},
+    {7500000, POWER_EVENT_SLEEP_COMMIT},
+    {7500000, POWER_EVENT_SLEEP_START},
+    {7510000, POWER_EVENT_SLEEP_COMMIT},
+};
+
+// 初始化完成之前的事件全部忽略，正常工作时电门和运动事件不触发迁移
+static const Step ignoredEvents[] = {
+    {100, POWER_EVENT_MOTION},
+    {200, POWER_EVENT_SLEEP_COMMIT},
+    {900, POWER_EVENT_READY},
+    {1000, POWER_EVENT_MOTION},
+    {2000, POWER_EVENT_IGNITION_ON},
+    {3000, POWER_EVENT_SLEEP_COMMIT},
+    {4000, POWER_EVENT_TIMER_WAKE},
+};
+
+static const Scenario scenarios[] = {
+    {"park_and_sleep", POWER_WAKE_IGNITION, STEPS(parkAndSleep), POWER_MODE_DEEP_SLEEP, 4},
+    {"countdown_interrupted", POWER_WAKE_MOTION, STEPS(countdownInterrupted), POWER_MODE_ACTIVE, 4},
+    {"countdown_button", POWER_WAKE_TIMER, STEPS(countdownButton), POWER_MODE_SLEEP_COUNTDOWN, 6},
+    {"sleep_aborted", POWER_WAKE_TIMER, STEPS(sleepAborted), POWER_MODE_PARKED, 5},
+    {"light_sleep_ignition", POWER_WAKE_POWER_ON, STEPS(lightSleepIgnition), POWER_MODE_ACTIVE, 8},
+    {"parked_then_deep_sleep", POWER_WAKE_MOTION, STEPS(parkedThenDeepSleep), POWER_MODE_DEEP_SLEEP, 6},
+    {"ignored_events", POWER_WAKE_POWER_ON, STEPS(ignoredEvents), POWER_MODE_ACTIVE, 1},
+};
+
+// 迁移表中 {from, event} 不能重复，否则后面的条目永远不会生效
+static bool checkTableDeterministic() {
+    bool ok = true;
+    for (size_t i = 0; i < POWER_TRANSITION_COUNT; i++) {
+        for (size_t j = i + 1; j < POWER_TRANSITION_COUNT; j++) {
+            if (POWER_TRANSITIONS[i].from == POWER_TRANSITIONS[j].from &&
+                POWER_TRANSITIONS[i].event == POWER_TRANSITIONS[j].event) {
+                printf("迁移表重复: %s + %s\n", powerModeName(POWER_TRANSITIONS[i].from),
+                       powerEventName(POWER_TRANSITIONS[i].event));
+                ok = false;
+            }
+        }
+    }
+    // 深度睡眠是终止状态，只能通过重新启动离开
+    for (size_t i = 0; i < POWER_TRANSITION_COUNT; i++) {
+        if (POWER_TRANSITIONS[i].from == POWER_MODE_DEEP_SLEEP) {
+            printf("迁移表错误: DEEP_SLEEP 不应有出边\n");
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main() {
+    int failures = checkTableDeterministic() ? 0 : 1;
+
+    // 所有场景共用一份日志，模拟 RTC 内存跨多次启动保留
+    static PowerStateLog store;
+
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        const Scenario& sc = scenarios[s];
+        PowerStateMachine fsm;
+        fsm.begin(&store, sc.wakeSource, 0);
+
+        size_t transitions = 0;
+        for (size_t i = 0; i < sc.stepCount; i++) {
+            const Step& step = sc.steps[i];
+            bool moved = step.event == POWER_EVENT_READY
+                             ? fsm.markReady(step.timeMs, step.timeMs)
+                             : fsm.handle(step.event, step.timeMs);
+            if (moved) {
+                transitions++;
+            }
+        }
+
+        bool ok = fsm.mode() == sc.expectedMode && transitions == sc.expectedTransitions;
+        printf("[%s] %-22s 最终 %-11s 迁移 %u 次\n", ok ? "通过" : "失败", sc.name,
+               powerModeName(fsm.mode()), (unsigned)transitions);
+        if (!ok) {
+            printf("       期望 %s, %u 次\n", powerModeName(sc.expectedMode), (unsigned)sc.expectedTransitions);
+            failures++;
+        }
+    }
+
+    // 打印跨启动保留的日志（环形缓冲只保留最近 POWER_LOG_SIZE 条）
+    PowerStateMachine viewer;
+    viewer.begin(&store, POWER_WAKE_OTHER, 0);
+    printf("\n迁移日志（最近 %u 条）:\n", (unsigned)viewer.recordCount());
+    for (size_t i = 0; i < viewer.recordCount(); i++) {
+        const PowerTransitionRecord& r = viewer.recordAt(i);
+        printf("  #%-3u %8u ms  %-11s -> %-11s (%s)\n", r.bootIndex, r.timestampMs,
+               powerModeName((PowerMode)r.from), powerModeName((PowerMode)r.to),
+               powerEventName((PowerEvent)r.event));
+    }
+
+    printf("\n唤醒耗时:\n");
+    for (int w = 0; w < POWER_WAKE_SOURCE_COUNT; w++) {
+        const PowerWakeLatency& l = viewer.latency((PowerWakeSource)w);
+        if (l.count > 0) {
+            printf("  %-9s 次数 %u, 最近 %u ms, 最小 %u ms, 最大 %u ms\n",
+                   powerWakeSourceName((PowerWakeSource)w), l.count, l.lastMs, l.minMs, l.maxMs);
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
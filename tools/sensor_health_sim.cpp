@@ -0,0 +1,305 @@
+/*
+ * 传感器健康监测和故障恢复验证（主机端）
+ *
+ * 模拟 TaskData 每 10ms 一次的驱动循环（与 IMU::loop、Compass::loop 调用 SensorHealthMonitor 的方式相同），
+ * 传感器按场景正常输出、偶发异常、数据卡住、停止输出或失去应答，检查：
+ *   - 正常数据长时间运行不误判，millis() 回绕不影响
+ *   - 驱动所在任务被阻塞（4G 模块、SD 卡、浅睡眠）期间没有查询，不判为无数据
+ *   - 单次异常只标记为异常，不判故障
+ *   - 数据卡住、无数据、没有应答时判为故障，停止读取并立即尝试恢复
+ *   - 恢复失败后等待时间按倍数增加并封顶，重新初始化和复位总线交替进行
+ *   - 传感器恢复后通过检查结束故障，统计故障时长；反复故障时等待时间不回到最小值
+ *   - 初始化失败不阻塞，按退避时间重试
+ * 任一场景不符合预期时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/utils tools/sensor_health_sim.cpp -o /tmp/sensor_health_sim
+ *   /tmp/sensor_health_sim
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "SensorHealthLogic.h"
+
+// 与 config.h 中 IMU 的默认值一致
+static const SensorHealthConfig CONFIG = {
+    1000,       // checkIntervalMs
+    500,        // dataTimeoutMs
+    50,         // stuckSamples
+    20,         // readErrorLimit
+    2,          // faultsToFail
+    1000,       // backoffMinMs
+    300000,     // backoffMaxMs
+};
+
+static const uint32_t TICK_MS = 10;
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+// 模拟传感器
+enum SimMode {
+    SIM_OK,         // 正常，每次读取值不同
+    SIM_STUCK,      // 有应答，数据不变
+    SIM_SILENT,     // 有应答，没有新数据
+    SIM_DEAD,       // 没有应答，读取和初始化都失败
+    SIM_FLAKY,      // 初始化成功，但很快又停止输出
+};
+
+struct SimSensor {
+    SimMode mode;
+    uint32_t counter;
+    uint32_t initCalls;
+    uint32_t busResets;
+    bool idGlitch;              // 下一次读芯片 ID 失败一次
+    std::vector<uint32_t> attemptTimes;
+
+    SimSensor() : mode(SIM_OK), counter(0), initCalls(0), busResets(0), idGlitch(false) {}
+
+    bool init(uint32_t now) {
+        initCalls++;
+        attemptTimes.push_back(now);
+        // 有应答时初始化成功，之后的表现由场景决定
+        return mode != SIM_DEAD;
+    }
+
+    bool readId() {
+        if (idGlitch) {
+            idGlitch = false;
+            return false;
+        }
+        return mode != SIM_DEAD;
+    }
+};
+
+// 驱动循环一次，返回是否读取了传感器
+static bool driverLoop(SensorHealthMonitor& h, SimSensor& s, uint32_t now) {
+    switch (h.due(now)) {
+    case SENSOR_DO_CHECK:
+        h.check(now, s.readId());
+        break;
+    case SENSOR_DO_RECOVER:
+        if (h.recoveryAction() == SENSOR_RECOVER_BUS_RESET) {
+            s.busResets++;
+        }
+        h.recovered(now, s.init(now));
+        break;
+    default:
+        break;
+    }
+    if (!h.usable()) {
+        return false;
+    }
+    switch (s.mode) {
+    case SIM_OK:
+        h.onSample(++s.counter * 2654435761u);
+        break;
+    case SIM_STUCK:
+        h.onSample(0x12345678);
+        break;
+    case SIM_DEAD:
+        h.onReadError();
+        break;
+    case SIM_SILENT:
+    case SIM_FLAKY:
+        h.onNoData(now);
+        break;
+    }
+    return true;
+}
+
+static void runFor(SensorHealthMonitor& h, SimSensor& s, uint32_t& now, uint32_t ms, uint32_t* reads = NULL) {
+    for (uint32_t t = 0; t < ms; t += TICK_MS) {
+        now += TICK_MS;
+        bool read = driverLoop(h, s, now);
+        if (reads && read) {
+            (*reads)++;
+        }
+    }
+}
+
+int main() {
+    int errors = 0;
+    char detail[200];
+
+    // 正常运行 2 小时，跨越 millis() 回绕
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 0xFFFFFFFFu - 3600000u;
+        h.begin(now, true);
+        runFor(h, s, now, 7200000);
+        const SensorHealthStats& st = h.stats();
+        snprintf(detail, sizeof(detail), "%lu 个采样，状态 %s，故障 %lu 次", (unsigned long)st.samples,
+                 sensorHealthStatusName(h.status()), (unsigned long)st.failures);
+        errors += check("healthy_wrap", h.status() == SENSOR_OK && st.failures == 0 && st.samples > 700000, detail) ? 0 : 1;
+    }
+
+    // 单次芯片 ID 读取失败
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 1000;
+        h.begin(now, true);
+        runFor(h, s, now, 5000);
+        s.idGlitch = true;
+        runFor(h, s, now, 1000);
+        uint8_t during = h.status();
+        runFor(h, s, now, 5000);
+        snprintf(detail, sizeof(detail), "检查后 %s，之后 %s，故障 %lu 次，ID 错误 %lu 次", sensorHealthStatusName(during),
+                 sensorHealthStatusName(h.status()), (unsigned long)h.stats().failures, (unsigned long)h.stats().idErrors);
+        errors += check("transient_glitch", during == SENSOR_DEGRADED && h.status() == SENSOR_OK &&
+                                                h.stats().failures == 0 && h.stats().idErrors == 1, detail) ? 0 : 1;
+    }
+
+    // 数据卡住：判为故障并立即重新初始化，恢复后通过检查
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 1000;
+        h.begin(now, true);
+        runFor(h, s, now, 3000);
+        s.mode = SIM_STUCK;
+        uint32_t stuckAt = now;
+        uint32_t failedAt = 0;
+        while (h.stats().failures == 0 && now - stuckAt < 10000) {
+            now += TICK_MS;
+            driverLoop(h, s, now);
+        }
+        failedAt = now;
+        // 重新初始化后数据恢复
+        s.mode = SIM_OK;
+        runFor(h, s, now, 3000);
+        const SensorHealthStats& st = h.stats();
+        bool ok = st.failures == 1 && st.stuck >= 2 && st.recoveries == 1 && h.status() == SENSOR_OK &&
+                  s.initCalls == 1 && s.attemptTimes[0] - failedAt <= TICK_MS && failedAt - stuckAt <= 3000;
+        snprintf(detail, sizeof(detail), "卡住 %lu ms 后判为故障，恢复 %lu 次（重新初始化 %lu 次），故障时长 %lu ms",
+                 (unsigned long)(failedAt - stuckAt), (unsigned long)st.recoveries, (unsigned long)s.initCalls,
+                 (unsigned long)st.downMs);
+        errors += check("stuck_recover", ok, detail) ? 0 : 1;
+    }
+
+    // 失去应答 2 小时：退避加倍并封顶，动作交替，期间不读取，之后恢复
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 1000;
+        h.begin(now, true);
+        runFor(h, s, now, 3000);
+        s.mode = SIM_DEAD;
+        uint32_t reads = 0;
+        runFor(h, s, now, 7200000, &reads);
+        std::vector<uint32_t> t = s.attemptTimes;
+        bool doubling = t.size() >= 6;
+        uint32_t maxGap = 0;
+        for (size_t i = 1; i < t.size(); i++) {
+            uint32_t gap = t[i] - t[i - 1];
+            uint32_t expect = CONFIG.backoffMinMs << (i - 1 < 20 ? i - 1 : 20);
+            if (expect > CONFIG.backoffMaxMs) {
+                expect = CONFIG.backoffMaxMs;
+            }
+            if (gap < expect || gap > expect + TICK_MS) {
+                doubling = false;
+            }
+            if (gap > maxGap) {
+                maxGap = gap;
+            }
+        }
+        bool alternating = s.busResets == s.initCalls / 2;
+        // 故障后只有判定前的几次读取（最多两个检查周期）
+        bool stopped = reads <= 2 * CONFIG.checkIntervalMs / TICK_MS + 2;
+        uint32_t down = h.downMs(now);
+
+        s.mode = SIM_OK;
+        runFor(h, s, now, CONFIG.backoffMaxMs + 3000);
+        const SensorHealthStats& st = h.stats();
+        bool back = h.status() == SENSOR_OK && st.recoveries == 1 && st.failures == 1 &&
+                    h.currentBackoffMs() == 0 && st.downMs > 7200000 - 3000;
+        snprintf(detail, sizeof(detail),
+                 "%lu 次恢复尝试（复位总线 %lu 次），最长间隔 %lu 秒，失去应答后读取 %lu 次，2 小时故障 %lu 秒，之后%s",
+                 (unsigned long)t.size(), (unsigned long)s.busResets, (unsigned long)(maxGap / 1000),
+                 (unsigned long)reads, (unsigned long)(down / 1000), back ? "恢复" : "未恢复");
+        errors += check("dead_backoff", doubling && alternating && stopped && maxGap <= CONFIG.backoffMaxMs + TICK_MS && back,
+                        detail) ? 0 : 1;
+    }
+
+    // 反复故障：初始化成功但很快又没有数据，等待时间继续增加
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 1000;
+        h.begin(now, true);
+        runFor(h, s, now, 3000);
+        s.mode = SIM_FLAKY;
+        runFor(h, s, now, 600000);
+        std::vector<uint32_t> t = s.attemptTimes;
+        bool growing = t.size() >= 4;
+        for (size_t i = 2; i < t.size(); i++) {
+            if (t[i] - t[i - 1] <= t[i - 1] - t[i - 2]) {
+                growing = false;
+            }
+        }
+        const SensorHealthStats& st = h.stats();
+        snprintf(detail, sizeof(detail), "10 分钟内初始化 %lu 次，恢复成功 %lu 次，故障 %lu 次，当前等待 %lu 秒",
+                 (unsigned long)t.size(), (unsigned long)st.recoveries, (unsigned long)st.failures,
+                 (unsigned long)(h.currentBackoffMs() / 1000));
+        errors += check("flapping", growing && st.recoveries == 0 && st.failures == 1 && t.size() < 12, detail) ? 0 : 1;
+    }
+
+    // 启动时初始化失败：不阻塞，按退避时间重试，传感器接上后恢复
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        s.mode = SIM_DEAD;
+        uint32_t now = 1000;
+        h.begin(now, false);
+        bool notUsable = !h.usable() && h.msUntilRetry(now) == CONFIG.backoffMinMs;
+        runFor(h, s, now, 5000);
+        uint32_t attempts = s.initCalls;
+        s.mode = SIM_OK;
+        runFor(h, s, now, 20000);
+        snprintf(detail, sizeof(detail), "5 秒内重试 %lu 次，接上后 %s", (unsigned long)attempts,
+                 sensorHealthStatusName(h.status()));
+        errors += check("init_fail", notUsable && attempts == 2 && h.status() == SENSOR_OK && h.stats().recoveries == 1,
+                        detail) ? 0 : 1;
+    }
+
+    // 没有新数据（芯片有应答但数据就绪不再置位）
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 1000;
+        h.begin(now, true);
+        runFor(h, s, now, 3000);
+        s.mode = SIM_SILENT;
+        runFor(h, s, now, 2500);
+        snprintf(detail, sizeof(detail), "状态 %s，原因 %s，无数据 %lu 次", sensorHealthStatusName(h.status()),
+                 sensorFaultName(h.lastFault()), (unsigned long)h.stats().timeouts);
+        errors += check("silent", h.stats().failures == 1 && h.stats().timeouts >= 2, detail) ? 0 : 1;
+    }
+
+    // 驱动任务反复被阻塞 800 ms（超过无数据超时），传感器正常，不判为异常
+    {
+        SensorHealthMonitor h(CONFIG);
+        SimSensor s;
+        uint32_t now = 1000;
+        h.begin(now, true);
+        runFor(h, s, now, 3000);
+        for (int i = 0; i < 20; i++) {
+            now += 800;
+            runFor(h, s, now, 200);
+        }
+        // 浅睡眠 60 秒后唤醒，第一次检查在读取之前
+        now += 60000;
+        runFor(h, s, now, 3000);
+        snprintf(detail, sizeof(detail), "状态 %s，无数据 %lu 次，故障 %lu 次", sensorHealthStatusName(h.status()),
+                 (unsigned long)h.stats().timeouts, (unsigned long)h.stats().failures);
+        errors += check("task_stall", h.status() == SENSOR_OK && h.stats().timeouts == 0 && h.stats().failures == 0,
+                        detail) ? 0 : 1;
+    }
+
+    return errors == 0 ? 0 : 1;
+}
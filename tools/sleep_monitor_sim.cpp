@@ -0,0 +1,145 @@
+/*
+ * 深度睡眠监测判定验证（主机端）
+ *
+ * 用模拟的电池电压曲线和电门电平序列驱动 sleepMonitorStep()，检查唤醒原因和
+ * 唤醒时的采样次数。ULP 程序与 sleepMonitorStep() 逐条对应，修改
+ * src/power/SleepMonitorLogic.h 或 ULP 程序后运行一遍即可确认判定结果。
+ * 任一场景不符合预期时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/power tools/sleep_monitor_sim.cpp -o /tmp/sleep_monitor_sim
+ *   /tmp/sleep_monitor_sim
+ */
+
+#include <cstdio>
+#include "SleepMonitorLogic.h"
+
+// 线性ADC模型：11dB衰减下满量程约 3100mV，再乘分压比
+static int linearBatteryMv(uint16_t raw) {
+    return (int)raw * 3100 / 4095 * BAT_VOLTAGE_DIVIDER;
+}
+
+static uint16_t rawFor(int batteryMv) {
+    return sleepMonitorRawForMv(batteryMv, linearBatteryMv);
+}
+
+struct Scenario {
+    const char* name;
+    bool lowReported;
+    int (*batteryMv)(int sample);       // 第 n 次采样的电池电压
+    int (*ignition)(int sample);        // 第 n 次采样的电门电平
+    int ignitionBefore;                 // 睡眠前的电门电平
+    int maxSamples;
+    uint16_t expectedWake;
+    int expectedSamples;                // 唤醒时的采样次数，0 表示不检查
+};
+
+static int steady(int) { return 3900; }
+static int highLevel(int) { return 1; }
+static int lowLevel(int) { return 0; }
+
+// 每次采样下降 1mV，从 3420 降到低电量阈值以下
+static int slowDecay(int n) { return 3420 - n; }
+
+// 第 10 次采样起电门拉低（外部供电接入）并保持
+static int ignitionOn(int n) { return n >= 10 ? 0 : 1; }
+
+// 电门每隔 20 次采样出现一次持续 1 个采样的低电平
+static int ignitionBounce(int n) { return (n % 20 == 10) ? 0 : 1; }
+
+// 第 50 次采样起采样线被剪断
+static int wireCut(int n) { return n >= 50 ? 200 : 3900; }
+
+// 单次采样跌落（启动马达等瞬时负载），不应唤醒
+static int singleDip(int n) { return n == 30 ? 3300 : 3900; }
+
+static const Scenario scenarios[] = {
+    // 3400mV 以下第 3 次采样唤醒
+    {"slow_decay_low", false, slowDecay, highLevel, 1, 200, SLEEP_WAKE_LOW_BATTERY, 0},
+    {"low_already_reported", true, slowDecay, highLevel, 1, 200, 0, 0},
+    {"single_dip_ignored", false, singleDip, highLevel, 1, 200, 0, 0},
+    {"ignition_edge", false, steady, ignitionOn, 1, 200, SLEEP_WAKE_IGNITION, 13},
+    // 第 5 次抖动（第 91 次采样恢复高电平时）判定防拆
+    {"ignition_bounce_tamper", false, steady, ignitionBounce, 1, 200, SLEEP_WAKE_TAMPER, 92},
+    {"wire_cut_tamper", false, wireCut, highLevel, 1, 200, SLEEP_WAKE_TAMPER, 51},
+    // 睡眠前电门已打开（低电平），保持不变时不唤醒
+    {"ignition_on_steady", false, steady, lowLevel, 0, 200, 0, 0},
+};
+
+static bool runScenario(const Scenario& sc) {
+    SleepMonitorConfig config = sleepMonitorMakeConfig(sc.lowReported, 3400, 1500, 3, 5, linearBatteryMv);
+    SleepMonitorState state;
+    sleepMonitorReset(state, (uint16_t)sc.ignitionBefore);
+
+    uint16_t wake = 0;
+    for (int n = 0; n < sc.maxSamples && !wake; n++) {
+        wake = sleepMonitorStep(state, config, rawFor(sc.batteryMv(n)), (uint16_t)sc.ignition(n));
+    }
+
+    bool ok = wake == sc.expectedWake &&
+              (sc.expectedSamples == 0 || state.samples == sc.expectedSamples);
+    printf("[%s] %-24s 唤醒 %-11s 采样 %3u 次，电池 %d~%d mV，抖动 %u\n", ok ? "通过" : "失败", sc.name,
+           sleepWakeReasonName(wake), state.samples, linearBatteryMv(state.minRaw),
+           linearBatteryMv(state.maxRaw), state.glitches);
+    if (!ok) {
+        printf("       期望 %s, %d 次\n", sleepWakeReasonName(sc.expectedWake), sc.expectedSamples);
+    }
+    return ok;
+}
+
+// 唤醒后状态保持，后续采样不改变结果和统计
+static bool checkLatched() {
+    SleepMonitorConfig config = sleepMonitorMakeConfig(false, 3400, 1500, 3, 5, linearBatteryMv);
+    SleepMonitorState state;
+    sleepMonitorReset(state, 1);
+    for (int n = 0; n < 3; n++) {
+        sleepMonitorStep(state, config, rawFor(3000), 1);
+    }
+    uint16_t samples = state.samples;
+    bool ok = sleepMonitorStep(state, config, rawFor(3900), 0) == SLEEP_WAKE_LOW_BATTERY &&
+              state.samples == samples;
+    printf("[%s] %-24s\n", ok ? "通过" : "失败", "wake_latched");
+    return ok;
+}
+
+// 阈值换算：返回第一个不低于目标电压的原始值
+static bool checkRawForMv() {
+    bool ok = true;
+    for (int mv = 100; mv <= 6000; mv += 37) {
+        uint16_t raw = rawFor(mv);
+        if (linearBatteryMv(raw) < mv || (raw > 0 && linearBatteryMv(raw - 1) >= mv)) {
+            printf("       %d mV -> raw %u 错误\n", mv, raw);
+            ok = false;
+        }
+    }
+    ok = ok && rawFor(0) == 0 && rawFor(100000) == 4095;
+    printf("[%s] %-24s\n", ok ? "通过" : "失败", "raw_for_mv");
+    return ok;
+}
+
+// BAT 的低电量迟滞
+static bool checkHysteresis() {
+    const int trace[] = {3500, 3410, 3399, 3420, 3480, 3499, 3500, 3450, 3399};
+    const bool expected[] = {false, false, true, true, true, true, false, false, true};
+    bool low = false;
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        low = batteryLowUpdate(low, trace[i], 3400, 100);
+        ok = ok && low == expected[i];
+    }
+    printf("[%s] %-24s\n", ok ? "通过" : "失败", "battery_low_hysteresis");
+    return ok;
+}
+
+int main() {
+    int failures = 0;
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        if (!runScenario(scenarios[s])) {
+            failures++;
+        }
+    }
+    failures += checkLatched() ? 0 : 1;
+    failures += checkRawForMv() ? 0 : 1;
+    failures += checkHysteresis() ? 0 : 1;
+    return failures == 0 ? 0 : 1;
+}
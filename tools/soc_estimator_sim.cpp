@@ -0,0 +1,202 @@
+/*
+ * 电池SOC估计验证（主机端）
+ *
+ * 不带参数时用电芯模型生成放电曲线（OCV曲线、内阻、极化、ADC噪声、模型外的4G发射突发），
+ * 检查估计误差、输出是否随瞬时压降跳变、剩余时间和低电量误报。任一场景不符合预期时返回非零。
+ *
+ * 带参数时回放设备录制的曲线：串口命令 bat.trace 打开后每秒输出一行
+ *   bat,<毫秒>,<端电压mV>,<负载BAT_LOAD_*>,<充电0/1>
+ * 把串口日志保存成文件传入即可（其他行忽略），每分钟打印一次估计结果。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/bat tools/soc_estimator_sim.cpp -o /tmp/soc_estimator_sim
+ *   /tmp/soc_estimator_sim [serial.log]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "SocEstimator.h"
+
+// 与 config.h 中的默认值一致
+static const SocEstimatorConfig CONFIG = {
+    3000.0f,    // capacityMah
+    200.0f,     // resistanceMohm
+    15.0f,      // voltageNoiseMv
+    0.05f,      // driftPerHour
+    {45.0f, 35.0f, 25.0f, 120.0f, 15.0f, 500.0f},
+};
+
+// 简单电芯：OCV曲线 + 欧姆内阻 + 一阶极化
+struct Cell {
+    float soc;
+    float capacityMah;
+    float resistanceMohm;
+    float polarizationMv;
+
+    float step(float currentMa, float dt) {
+        soc -= currentMa * dt / 3600.0f / capacityMah;
+        if (soc < 0.0f) soc = 0.0f;
+        if (soc > 1.0f) soc = 1.0f;
+        // 极化电压：50mΩ，时间常数 30 秒
+        float target = currentMa * 50.0f / 1000.0f;
+        polarizationMv += (target - polarizationMv) * dt / (30.0f + dt);
+        return socOcvMv(soc) - currentMa * resistanceMohm / 1000.0f - polarizationMv;
+    }
+};
+
+static uint32_t rngState = 12345;
+static float noise(float sigma) {
+    // 12 个均匀分布求和近似正态
+    float sum = 0.0f;
+    for (int i = 0; i < 12; i++) {
+        rngState = rngState * 1664525u + 1013904223u;
+        sum += (rngState >> 8) / 16777216.0f;
+    }
+    return (sum - 6.0f) * sigma;
+}
+
+struct Scenario {
+    const char* name;
+    float startSoc;
+    float trueCapacityMah;
+    uint32_t durationSec;
+    uint8_t (*loads)(uint32_t sec);
+    bool (*charging)(uint32_t sec);
+    float trueChargeMa;
+    float maxErrorAfterSettle;      // 稳定后（30分钟后）允许的最大误差
+    bool checkLowAlarm;             // 真实电量高于 25% 时不能报 20% 以下
+};
+
+static bool never(uint32_t) { return false; }
+static uint8_t riding(uint32_t) { return BAT_LOAD_MODEM | BAT_LOAD_GNSS; }
+static uint8_t ridingWithAudio(uint32_t sec) {
+    uint8_t loads = BAT_LOAD_MODEM | BAT_LOAD_GNSS;
+    if (sec % 60 < 5) loads |= BAT_LOAD_AUDIO;
+    if (sec % 600 < 120) loads |= BAT_LOAD_BLE;
+    return loads;
+}
+static uint8_t idleModem(uint32_t) { return BAT_LOAD_MODEM; }
+static bool firstHour(uint32_t sec) { return sec < 3600; }
+
+static const Scenario scenarios[] = {
+    {"ride_full_to_half", 1.00f, 3000.0f, 12 * 3600, riding, never, 0.0f, 0.05f, false},
+    {"capacity_faded_20pct", 0.90f, 2400.0f, 10 * 3600, riding, never, 0.0f, 0.08f, false},
+    {"audio_ble_near_low", 0.32f, 3000.0f, 3 * 3600, ridingWithAudio, never, 0.0f, 0.05f, true},
+    {"charge_then_rest", 0.40f, 3000.0f, 3 * 3600, idleModem, firstHour, 450.0f, 0.08f, false},
+};
+
+static bool runScenario(const Scenario& sc) {
+    SocEstimator est(CONFIG);
+    Cell cell = {sc.startSoc, sc.trueCapacityMah, 170.0f, 0.0f};
+
+    float maxError = 0.0f;
+    int maxJump = 0;
+    int lastPercent = -1;
+    bool falseLow = false;
+    float runtimeError = -1.0f;
+    float trueAverageMa = socLoadCurrentMa(CONFIG.load, sc.loads(0));
+
+    for (uint32_t sec = 0; sec < sc.durationSec; sec++) {
+        uint8_t loads = sc.loads(sec);
+        bool charging = sc.charging(sec);
+        float currentMa = socLoadCurrentMa(CONFIG.load, loads) * 1.1f;   // 实际负载比模型高 10%
+        if ((loads & BAT_LOAD_MODEM) && sec % 30 < 2) {
+            currentMa += 400.0f;                                        // 模型外的4G发射突发
+        }
+        if (!charging) {
+            trueAverageMa += (currentMa - trueAverageMa) / (SocEstimator::AVERAGE_TAU_SEC + 1.0f);
+        }
+        if (charging) {
+            currentMa -= sc.trueChargeMa + socLoadCurrentMa(CONFIG.load, loads);
+        }
+        float terminal = cell.step(currentMa, 1.0f);
+
+        est.update(sec * 1000, terminal + noise(10.0f), loads, charging);
+
+        if (!est.isReady()) {
+            continue;
+        }
+        int percent = est.percent();
+        if (lastPercent >= 0) {
+            int jump = abs(percent - lastPercent);
+            if (jump > maxJump) maxJump = jump;
+        }
+        lastPercent = percent;
+
+        float error = fabsf(est.soc() - cell.soc);
+        if (sec >= 1800 && !charging && error > maxError) {
+            maxError = error;
+        }
+        if (sc.checkLowAlarm && percent <= 20 && cell.soc > 0.25f) {
+            falseLow = true;
+        }
+        // 剩余时间：按最近半小时的真实平均电流放电到 0 的时间
+        if (sec == sc.durationSec / 2 && !charging) {
+            float trueMinutes = cell.soc * cell.capacityMah / trueAverageMa * 60.0f;
+            runtimeError = fabsf(est.runtimeMinutes() - trueMinutes) / trueMinutes;
+        }
+    }
+
+    bool ok = maxError <= sc.maxErrorAfterSettle && maxJump <= 1 && !falseLow &&
+              (runtimeError < 0.0f || runtimeError < 0.35f);
+    printf("[%s] %-22s 最大误差 %4.1f%%  最大跳变 %d%%  剩余时间误差 %4.0f%%  剔除 %lu  终值 %3d%% (真实 %3.0f%%) ±%d%%%s\n",
+           ok ? "通过" : "失败", sc.name, maxError * 100.0f, maxJump,
+           runtimeError < 0.0f ? 0.0f : runtimeError * 100.0f, (unsigned long)est.rejectedCount(),
+           est.percent(), cell.soc * 100.0f, est.sigmaPercent(), falseLow ? "  低电量误报" : "");
+    return ok;
+}
+
+// 回放录制的曲线
+static int replay(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        printf("无法打开 %s\n", path);
+        return 1;
+    }
+    SocEstimator est(CONFIG);
+    char line[256];
+    uint32_t lastPrint = 0;
+    unsigned long count = 0;
+    while (fgets(line, sizeof(line), f)) {
+        const char* p = strstr(line, "bat,");
+        unsigned long ms;
+        int mv, loads, charging;
+        if (!p || sscanf(p, "bat,%lu,%d,%d,%d", &ms, &mv, &loads, &charging) != 4) {
+            continue;
+        }
+        est.update((uint32_t)ms, (float)mv, (uint8_t)loads, charging != 0);
+        count++;
+        if (count == 1 || (uint32_t)ms - lastPrint >= 60000) {
+            lastPrint = (uint32_t)ms;
+            printf("%8.1f min  %4d mV  OCV %4.0f mV  负载 %3.0f mA  SOC %3d%% ±%d%%  剩余 %d min\n",
+                   ms / 60000.0, mv, est.ocvMv(), est.loadMa(), est.percent(), est.sigmaPercent(),
+                   est.runtimeMinutes());
+        }
+    }
+    fclose(f);
+    printf("共 %lu 条采样，剔除 %lu 条\n", count, (unsigned long)est.rejectedCount());
+    return count > 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return replay(argv[1]);
+    }
+
+    // OCV曲线换算互逆
+    bool curveOk = true;
+    for (int i = 0; i <= 100; i++) {
+        float soc = i / 100.0f;
+        if (fabsf(socFromOcv(socOcvMv(soc)) - soc) > 0.001f) curveOk = false;
+    }
+    printf("[%s] %-22s\n", curveOk ? "通过" : "失败", "ocv_curve_inverse");
+
+    int failures = curveOk ? 0 : 1;
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        if (!runScenario(scenarios[s])) {
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
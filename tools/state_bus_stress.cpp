@@ -0,0 +1,171 @@
+/*
+ * 状态总线并发验证（主机端）
+ *
+ * 两个写线程各自成组写入一组字段（组内字段之间有固定关系，包括 double 和 uint64），
+ * 读线程不停取快照和单个字段检查组内关系，任何撕裂都会被发现；分发线程按字段掩码通知订阅者，
+ * 检查订阅者只收到自己注册的字段，值未变化的写入不产生通知（浮点按值比较：-0.0 与 0.0、
+ * NaN 与 NaN 视为相同）。任一检查失败时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -pthread -I src/utils tools/state_bus_stress.cpp -o /tmp/state_bus_stress
+ *   /tmp/state_bus_stress
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "StateBus.h"
+
+struct HostLock {
+    std::mutex m;
+    void lock() { m.lock(); }
+    void unlock() { m.unlock(); }
+};
+
+struct TestState {
+    int32_t a;
+    int32_t notA;           // ~a
+    double half;            // a * 0.5
+    uint64_t wide;          // a 同时写入高低 32 位
+    bool flag;
+    uint8_t pad[3];
+    int32_t b;
+    double bSquare;         // b * b
+    uint64_t bWide;
+};
+
+enum { F_A = 0, F_B = 1, F_FLAG = 2 };
+
+typedef StateBus<TestState, HostLock> Bus;
+
+static const int WRITES = 1000000;
+static Bus bus;
+static Bus floats;
+static std::atomic<bool> running(true);
+static std::atomic<uint32_t> failures(0);
+
+static bool groupAOk(const TestState& s) {
+    return s.notA == ~s.a && s.half == s.a * 0.5 &&
+           s.wide == (((uint64_t)(uint32_t)s.a << 32) | (uint32_t)s.a);
+}
+
+static bool groupBOk(const TestState& s) {
+    return s.bSquare == (double)s.b * s.b && s.bWide == (((uint64_t)(uint32_t)s.b << 32) | (uint32_t)s.b);
+}
+
+struct Counter {
+    std::atomic<uint32_t> calls;
+    std::atomic<uint32_t> wrong;
+    uint32_t mask;
+};
+
+static void onChange(const TestState& s, uint32_t changed, void* ctx) {
+    Counter* c = (Counter*)ctx;
+    c->calls++;
+    if (changed & ~c->mask) {
+        c->wrong++;
+    }
+    if (!groupAOk(s) || !groupBOk(s)) {
+        failures++;
+    }
+}
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+int main() {
+    int errors = 0;
+    char detail[160];
+
+    Counter onlyA = {{0}, {0}, 1u << F_A};
+    Counter onlyB = {{0}, {0}, 1u << F_B};
+    bus.subscribe(onlyA.mask, onChange, &onlyA);
+    bus.subscribe(onlyB.mask, onChange, &onlyB);
+    int polled = bus.subscribe(1u << F_FLAG, nullptr);
+
+    // 值未变化的写入不通知
+    bool changed = bus.set(F_FLAG, &TestState::flag, false);
+    errors += check("unchanged_no_notify", !changed && bus.take(polled) == 0, "写入相同的值") ? 0 : 1;
+    bus.set(F_FLAG, &TestState::flag, true);
+    errors += check("polled_subscriber", bus.take(polled) == (1u << F_FLAG) && bus.take(polled) == 0,
+                    "轮询订阅者取走一次") ? 0 : 1;
+
+    // 浮点字段按值比较
+    int floatSub = floats.subscribe(1u << F_A, nullptr);
+    floats.set(F_A, &TestState::half, 0.0);
+    bool negZero = floats.set(F_A, &TestState::half, -0.0);
+    floats.set(F_A, &TestState::half, NAN);
+    floats.take(floatSub);
+    bool nanAgain = floats.set(F_A, &TestState::half, NAN);
+    errors += check("float_compare", !negZero && !nanAgain && floats.take(floatSub) == 0,
+                    "-0.0 与 0.0、NaN 与 NaN 不通知") ? 0 : 1;
+
+    std::thread writerA([] {
+        for (int32_t i = 1; i <= WRITES; i++) {
+            Bus::Writer w(bus);
+            w.set(F_A, &TestState::a, i);
+            w.set(F_A, &TestState::notA, ~i);
+            w.set(F_A, &TestState::half, i * 0.5);
+            w.set(F_A, &TestState::wide, ((uint64_t)(uint32_t)i << 32) | (uint32_t)i);
+        }
+    });
+    std::thread writerB([] {
+        for (int32_t i = 1; i <= WRITES; i++) {
+            Bus::Writer w(bus);
+            w.set(F_B, &TestState::b, -i);
+            w.set(F_B, &TestState::bSquare, (double)i * i);
+            w.set(F_B, &TestState::bWide, ((uint64_t)(uint32_t)-i << 32) | (uint32_t)-i);
+        }
+    });
+
+    std::atomic<uint32_t> snapshots(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&snapshots] {
+            int32_t lastA = 0;
+            while (running) {
+                TestState s;
+                bus.snapshot(s);
+                if (!groupAOk(s) || !groupBOk(s) || s.a < lastA) {
+                    failures++;
+                }
+                lastA = s.a;
+                uint64_t wide = bus.get(&TestState::bWide);
+                if ((uint32_t)(wide >> 32) != (uint32_t)wide) {
+                    failures++;
+                }
+                snapshots++;
+            }
+        });
+    }
+    std::thread dispatcher([] {
+        while (running) {
+            bus.dispatch();
+        }
+    });
+
+    writerA.join();
+    writerB.join();
+    running = false;
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i].join();
+    }
+    dispatcher.join();
+    bus.dispatch();
+
+    TestState last = bus.snapshot();
+    snprintf(detail, sizeof(detail), "快照 %u 次，重读 %u 次，撕裂 %u 次", (unsigned)snapshots.load(),
+             (unsigned)bus.retries(), (unsigned)failures.load());
+    errors += check("no_torn_snapshot", failures == 0 && last.a == WRITES && last.b == -WRITES, detail) ? 0 : 1;
+
+    snprintf(detail, sizeof(detail), "A 通知 %u 次 B 通知 %u 次，收到未订阅字段 %u 次", (unsigned)onlyA.calls.load(),
+             (unsigned)onlyB.calls.load(), (unsigned)(onlyA.wrong + onlyB.wrong));
+    errors += check("mask_filter", onlyA.calls > 0 && onlyB.calls > 0 && onlyA.wrong == 0 && onlyB.wrong == 0 &&
+                    bus.take(polled) == 0, detail) ? 0 : 1;
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/*
+ * 事件跟踪环形缓冲区验证（主机端）
+ *
+ * 检查事件大小、回绕后按时间顺序读出、RTC内存内容随机时的校验，
+ * 再模拟两次运行（正常运行后看门狗复位，重启后记录到缓冲区回绕）生成一个示例跟踪文件，
+ * 可用 tools/trace_to_perfetto.py 转换查看。任一检查失败时返回非零。
+ *
+ * 编译运行：
+ *   g++ -O2 -std=c++11 -I src/utils tools/trace_ring_sim.cpp -o /tmp/trace_ring_sim
+ *   /tmp/trace_ring_sim /tmp/trace_sample.bin
+ *   python3 tools/trace_to_perfetto.py /tmp/trace_sample.bin -o /tmp/trace_sample.json
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "TraceRing.h"
+
+static const int CAPACITY = 128;        // 与 config.h 中的默认值一致
+typedef TraceRing<CAPACITY> Ring;
+
+// esp_reset_reason_t 中用到的值
+enum { RST_POWERON = 1, RST_SW = 3, RST_TASK_WDT = 6 };
+// PowerMode 中用到的值
+enum { MODE_WAKING = 0, MODE_ACTIVE = 1, MODE_PARKED = 2 };
+// PerfProbe 中用到的值
+enum { PROBE_AIR780EG = 2, PROBE_IMU = 3 };
+
+static bool check(const char* name, bool ok, const char* detail) {
+    printf("[%s] %-22s %s\n", ok ? "通过" : "失败", name, detail);
+    return ok;
+}
+
+static void push(Ring& r, uint32_t ts, TraceType type, uint8_t task, uint8_t id, uint16_t arg) {
+    TraceEvent e;
+    e.tsUs = ts;
+    e.flags = traceFlags(type, task, task == TRACE_TASK_DATA ? 1 : 0);
+    e.id = id;
+    e.arg = arg;
+    traceRingPush(r, e);
+}
+
+int main(int argc, char** argv) {
+    int errors = 0;
+    char detail[160];
+    static Ring ring;
+
+    errors += check("event_size", sizeof(TraceEvent) == 8 && sizeof(TraceFileHeader) == 16,
+                    "事件 8 字节，文件头 16 字节") ? 0 : 1;
+
+    // 上电时RTC内存内容随机
+    memset(&ring, 0xA5, sizeof(ring));
+    bool garbageValid = traceRingValid(ring);
+    traceRingInit(ring);
+    errors += check("garbage_rejected", !garbageValid && traceRingValid(ring) && traceRingCount(ring) == 0,
+                    "随机内容不被当作有效缓冲区") ? 0 : 1;
+
+    // 回绕：写入 CAPACITY + 37 个事件，读出最近 CAPACITY 个且按顺序
+    for (uint32_t i = 0; i < CAPACITY + 37; i++) {
+        push(ring, i * 10, TRACE_INSTANT, TRACE_TASK_SYSTEM, 0, (uint16_t)i);
+    }
+    bool ordered = traceRingCount(ring) == (uint32_t)CAPACITY && traceRingAt(ring, 0).arg == 37;
+    for (uint32_t i = 1; i < traceRingCount(ring); i++) {
+        ordered = ordered && traceRingAt(ring, i).arg == traceRingAt(ring, i - 1).arg + 1;
+    }
+    snprintf(detail, sizeof(detail), "写入 %u 个，保留 %u 个，最早 #%u", (unsigned)ring.head,
+             (unsigned)traceRingCount(ring), (unsigned)traceRingAt(ring, 0).arg);
+    errors += check("wrap_order", ordered, detail) ? 0 : 1;
+
+    // 示例：第一次运行正常工作后 TaskData 中 air780eg 卡住，任务看门狗复位
+    traceRingInit(ring);
+    ring.boots = 1;
+    push(ring, 1200, TRACE_BOOT, TRACE_TASK_MAIN, TRACE_ID_BOOT, RST_POWERON);
+    push(ring, 2100000, TRACE_INSTANT, TRACE_TASK_MAIN, TRACE_ID_POWER, (MODE_WAKING << 8) | MODE_ACTIVE);
+    uint32_t t = 2200000;
+    for (int i = 0; i < 60; i++) {
+        push(ring, t, TRACE_SLICE, TRACE_TASK_DATA, PROBE_IMU, 52 + i % 7);
+        if (i % 10 == 0) {
+            push(ring, t + 5000, TRACE_COUNTER, TRACE_TASK_MAIN, TRACE_ID_HEAP, (uint16_t)(180 - i / 3));
+        }
+        t += 250000;
+    }
+    push(ring, t, TRACE_INSTANT, TRACE_TASK_SYSTEM, TRACE_ID_POWER, (MODE_ACTIVE << 8) | MODE_PARKED);
+    push(ring, t + 400000, TRACE_SLICE, TRACE_TASK_DATA, PROBE_AIR780EG, 5000);
+
+    // 第二次运行：RTC内存保留，记录到缓冲区回绕，最早的事件被覆盖
+    ring.boots++;
+    push(ring, 900, TRACE_BOOT, TRACE_TASK_MAIN, TRACE_ID_BOOT, RST_TASK_WDT);
+    t = 1000000;
+    for (int i = 0; i < 80; i++) {
+        push(ring, t, TRACE_SLICE, TRACE_TASK_SYSTEM, PROBE_IMU, 60);
+        t += 100000;
+    }
+    push(ring, t, TRACE_ERROR, TRACE_TASK_MAIN, TRACE_ID_LOW_HEAP, 18);
+    push(ring, t + 10, TRACE_INSTANT, TRACE_TASK_MAIN, TRACE_ID_RESTART, TRACE_RESTART_LOW_HEAP);
+
+    uint32_t boots = 0;
+    for (uint32_t i = 0; i < traceRingCount(ring); i++) {
+        const TraceEvent& e = traceRingAt(ring, i);
+        if ((e.flags & 0x0F) == TRACE_BOOT) {
+            boots++;
+        }
+    }
+    snprintf(detail, sizeof(detail), "保留 %u 个事件，第一次启动事件已被覆盖，剩余启动事件 %u 个",
+             (unsigned)traceRingCount(ring), (unsigned)boots);
+    errors += check("overwrite_oldest", ring.head > (uint32_t)CAPACITY && boots == 1, detail) ? 0 : 1;
+
+    const char* path = argc > 1 ? argv[1] : "/tmp/trace_sample.bin";
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        printf("无法写入 %s\n", path);
+        return 1;
+    }
+    TraceFileHeader header = traceFileHeader(ring);
+    fwrite(&header, sizeof(header), 1, f);
+    for (uint32_t i = 0; i < header.count; i++) {
+        fwrite(&traceRingAt(ring, i), sizeof(TraceEvent), 1, f);
+    }
+    fclose(f);
+    printf("示例跟踪文件: %s（%u 个事件）\n", path, (unsigned)header.count);
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+事件跟踪转换工具
+把SD卡 /data/trace/trace_<N>.bin（格式见 src/utils/TraceRing.h）转换成 Chrome trace JSON，
+在 https://ui.perfetto.dev 或 chrome://tracing 中打开。
+
+每次启动显示为一个进程（标注复位原因），每个任务一条时间线；各次启动之间的实际间隔未知，
+按先后顺序排列并留出 1 秒空隙。
+
+用法:
+    python3 tools/trace_to_perfetto.py trace_12.bin [-o trace_12.json]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x4352544D
+HEADER = struct.Struct('<IHHII')
+EVENT = struct.Struct('<IBBH')
+
+# 与 TraceRing.h 中的枚举保持一致
+TYPE_BOOT, TYPE_BEGIN, TYPE_END, TYPE_SLICE, TYPE_INSTANT, TYPE_ERROR, TYPE_COUNTER = range(1, 8)
+
+TASK_NAMES = ['other', 'main', 'TaskSystem', 'TaskData', 'TaskWiFi', 'TaskAudio', '?', 'ISR']
+
+# 0-15 为 PerfProbe（PerfMonitor.h）
+ID_NAMES = {
+    0: 'task_system', 1: 'task_data', 2: 'air780eg', 3: 'imu', 4: 'compass', 5: 'ble', 6: 'power',
+    32: 'boot', 33: 'power_state', 34: 'deep_sleep', 35: 'restart', 36: 'imu_init',
+    37: 'low_heap', 38: 'heap_kb', 39: 'trace_dump',
+    40: 'sensor_fail', 41: 'sensor_recover',
+}
+
+RESET_REASONS = ['未知', '上电', '外部复位', '软件重启', '异常', '中断看门狗', '任务看门狗',
+                 '看门狗', '深度睡眠唤醒', '欠压', 'SDIO']
+
+POWER_MODES = ['WAKING', 'ACTIVE', 'PARKED', 'LIGHT_SLEEP', 'DEEP_SLEEP', 'SLEEP_COUNTDOWN']
+
+RESTART_SOURCES = ['?', 'serial', 'mqtt', 'button', 'wifi', 'low_heap', 'imu']
+
+# SensorHealth.h / SensorHealthLogic.h
+SENSOR_NAMES = ['imu', 'compass']
+SENSOR_FAULTS = ['none', 'init', 'chip_id', 'timeout', 'stuck', 'read']
+
+SEGMENT_GAP_US = 1000000
+
+
+def name_of(table, index):
+    if isinstance(table, dict):
+        return table.get(index, 'id_%d' % index)
+    return table[index] if 0 <= index < len(table) else str(index)
+
+
+def read_trace(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError('文件太短')
+    magic, version, event_size, count, boots = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError('不是跟踪文件（魔数 0x%08X）' % magic)
+    if version != 1 or event_size != EVENT.size:
+        raise ValueError('不支持的版本 %d / 事件大小 %d' % (version, event_size))
+    available = (len(data) - HEADER.size) // EVENT.size
+    if available < count:
+        print('警告: 文件截断，只有 %d / %d 个事件' % (available, count), file=sys.stderr)
+        count = available
+    events = [EVENT.unpack_from(data, HEADER.size + i * EVENT.size) for i in range(count)]
+    return boots, events
+
+
+def split_boots(events):
+    """按启动事件分段，缓冲区回绕后第一段可能没有启动事件"""
+    segments = []
+    current = None
+    for ev in events:
+        if ev[1] & 0x0F == TYPE_BOOT or current is None:
+            current = {'reason': ev[3] if ev[1] & 0x0F == TYPE_BOOT else None, 'events': []}
+            segments.append(current)
+        current['events'].append(ev)
+    return segments
+
+
+def describe(event_id, arg):
+    if event_id == 33:
+        return {'from': name_of(POWER_MODES, arg >> 8), 'to': name_of(POWER_MODES, arg & 0xFF)}
+    if event_id == 35:
+        return {'source': name_of(RESTART_SOURCES, arg)}
+    if event_id == 40:
+        return {'sensor': name_of(SENSOR_NAMES, arg >> 8), 'fault': name_of(SENSOR_FAULTS, arg & 0xFF)}
+    if event_id == 41:
+        return {'sensor': name_of(SENSOR_NAMES, arg >> 8), 'bus_reset': bool(arg & 2), 'ok': bool(arg & 1)}
+    if event_id == 34:
+        return {'shutdown_ms': arg}
+    return {'arg': arg}
+
+
+def convert(boots, events):
+    out = []
+    segments = split_boots(events)
+    offset = 0
+    first_boot = boots - sum(1 for s in segments if s['reason'] is not None) + 1
+    boot_no = first_boot
+    for pid, seg in enumerate(segments, 1):
+        if seg['reason'] is None:
+            label = '启动 #%d 之前（部分）' % first_boot
+        else:
+            label = '启动 #%d（%s）' % (boot_no, name_of(RESET_REASONS, seg['reason']))
+            boot_no += 1
+        out.append({'ph': 'M', 'pid': pid, 'name': 'process_name', 'args': {'name': label}})
+        out.append({'ph': 'M', 'pid': pid, 'name': 'process_sort_index', 'args': {'sort_index': pid}})
+
+        # 时间戳为 32 位微秒，约 71 分钟回绕一次
+        high = 0
+        last = None
+        end = 0
+        tasks = set()
+        for ts32, flags, event_id, arg in seg['events']:
+            if last is not None and ts32 < last and last - ts32 > 0x80000000:
+                high += 1 << 32
+            last = ts32
+            ts = offset + high + ts32
+            etype = flags & 0x0F
+            task = (flags >> 4) & 0x07
+            core = flags >> 7
+            tasks.add(task)
+            name = name_of(ID_NAMES, event_id)
+            base = {'pid': pid, 'tid': task, 'ts': ts}
+            if etype == TYPE_SLICE:
+                dur = arg * 1000
+                out.append(dict(base, ph='X', name=name, dur=dur, args={'ms': arg, 'core': core}))
+                end = max(end, ts + dur)
+            elif etype == TYPE_BEGIN:
+                out.append(dict(base, ph='B', name=name, args={'core': core}))
+            elif etype == TYPE_END:
+                out.append(dict(base, ph='E', name=name))
+            elif etype == TYPE_COUNTER:
+                out.append(dict(base, ph='C', name=name, args={name: arg}))
+            elif etype == TYPE_BOOT:
+                out.append(dict(base, ph='i', s='p', name='boot',
+                                args={'reset_reason': name_of(RESET_REASONS, arg)}))
+            else:
+                args = describe(event_id, arg)
+                args['core'] = core
+                event = dict(base, ph='i', s='g' if etype == TYPE_ERROR else 't', name=name, args=args)
+                if etype == TYPE_ERROR:
+                    event['cname'] = 'terrible'
+                out.append(event)
+            end = max(end, ts)
+        for task in sorted(tasks):
+            out.append({'ph': 'M', 'pid': pid, 'tid': task, 'name': 'thread_name',
+                        'args': {'name': name_of(TASK_NAMES, task)}})
+        offset = end + SEGMENT_GAP_US
+    return {'traceEvents': out, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='事件跟踪转换为 Perfetto / Chrome trace JSON')
+    parser.add_argument('input', help='SD卡上的 trace_<N>.bin')
+    parser.add_argument('-o', '--output', help='输出文件（默认与输入同名 .json）')
+    args = parser.parse_args()
+
+    try:
+        boots, events = read_trace(args.input)
+    except (OSError, ValueError) as e:
+        print('读取失败: %s' % e, file=sys.stderr)
+        return 1
+
+    output = args.output or (args.input.rsplit('.', 1)[0] + '.json')
+    with open(output, 'w', encoding='utf-8') as f:
+        json.dump(convert(boots, events), f, ensure_ascii=False)
+    print('%d 个事件，%d 次启动 -> %s' % (len(events), len(split_boots(events)), output))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
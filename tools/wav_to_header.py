@@ -4,8 +4,11 @@
 WAV文件转C头文件工具
 用于将语音文件转换为可以嵌入ESP32固件的C数组
 
+默认输出 IMA-ADPCM 编码（4:1压缩），由 AudioManager 播放时实时解码；
+加 --format=pcm 可输出原始WAV字节（兼容旧方式）。
+
 使用方法:
-python wav_to_header.py input.wav output.h variable_name "描述信息"
+python wav_to_header.py input.wav output.h variable_name "描述信息" [--format=adpcm|pcm] [--block-align=256]
 
 示例:
 python wav_to_header.py welcome.wav welcome_audio.h welcome_voice_data "大菠萝车机,扎西德勒"
@@ -15,9 +18,107 @@ import sys
 import os
 import wave
 import struct
+import math
 from datetime import datetime
 
-def wav_to_header(input_file, output_file, var_name, description=""):
+# IMA-ADPCM 编码表，与 src/audio/AdpcmCodec.h 保持一致
+ADPCM_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+]
+ADPCM_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+DEFAULT_BLOCK_ALIGN = 256
+
+
+def adpcm_decode_nibble(nibble, predictor, index):
+    """解码一个4bit码字，返回 (新预测值, 新索引)"""
+    step = ADPCM_STEP_TABLE[index]
+    diff = step >> 3
+    if nibble & 1:
+        diff += step >> 2
+    if nibble & 2:
+        diff += step >> 1
+    if nibble & 4:
+        diff += step
+    if nibble & 8:
+        predictor -= diff
+    else:
+        predictor += diff
+    predictor = max(-32768, min(32767, predictor))
+    index = max(0, min(88, index + ADPCM_INDEX_TABLE[nibble]))
+    return predictor, index
+
+
+def adpcm_encode(samples, block_align=DEFAULT_BLOCK_ALIGN):
+    """将16位单声道采样编码为 IMA-ADPCM 块序列"""
+    per_block = (block_align - 4) * 2 + 1
+    out = bytearray()
+    index = 0
+    for start in range(0, len(samples), per_block):
+        block = samples[start:start + per_block]
+        # 最后一块用静音补齐，解码时按 sample_count 截断
+        block = block + [0] * (per_block - len(block))
+        predictor = block[0]
+        out += struct.pack('<hBB', predictor, index, 0)
+        nibbles = []
+        for sample in block[1:]:
+            diff = sample - predictor
+            nibble = 0
+            if diff < 0:
+                nibble = 8
+                diff = -diff
+            step = ADPCM_STEP_TABLE[index]
+            if diff >= step:
+                nibble |= 4
+                diff -= step
+            step >>= 1
+            if diff >= step:
+                nibble |= 2
+                diff -= step
+            step >>= 1
+            if diff >= step:
+                nibble |= 1
+            # 编码器与解码器同步跟踪预测值
+            predictor, index = adpcm_decode_nibble(nibble, predictor, index)
+            nibbles.append(nibble)
+        for i in range(0, len(nibbles), 2):
+            out.append(nibbles[i] | (nibbles[i + 1] << 4))
+    return bytes(out)
+
+
+def adpcm_decode(data, sample_count, block_align=DEFAULT_BLOCK_ALIGN):
+    """解码 IMA-ADPCM 块序列（与固件解码器逐位一致），用于校验"""
+    samples = []
+    for start in range(0, len(data), block_align):
+        block = data[start:start + block_align]
+        predictor, index, _ = struct.unpack('<hBB', block[:4])
+        samples.append(predictor)
+        for byte in block[4:]:
+            for nibble in (byte & 0x0F, byte >> 4):
+                predictor, index = adpcm_decode_nibble(nibble, predictor, index)
+                samples.append(predictor)
+    return samples[:sample_count]
+
+
+def calculate_snr(reference, decoded):
+    """计算解码信噪比(dB)"""
+    signal = sum(s * s for s in reference)
+    noise = sum((a - b) * (a - b) for a, b in zip(reference, decoded))
+    if noise == 0:
+        return float('inf')
+    if signal == 0:
+        return 0.0
+    return 10 * math.log10(signal / noise)
+
+def wav_to_header(input_file, output_file, var_name, description="",
+                  audio_format="adpcm", block_align=DEFAULT_BLOCK_ALIGN):
     """
     将WAV文件转换为C头文件
     
@@ -26,6 +127,8 @@ def wav_to_header(input_file, output_file, var_name, description=""):
         output_file: 输出的C头文件路径
         var_name: C数组变量名
         description: 描述信息
+        audio_format: 输出格式 adpcm(默认) 或 pcm
+        block_align: ADPCM块大小（字节）
     """
     
     if not os.path.exists(input_file):
@@ -54,13 +157,34 @@ def wav_to_header(input_file, output_file, var_name, description=""):
                 print(f"警告: 声道数为 {channels}，建议使用单声道")
             if sample_width != 2:
                 print(f"警告: 位深度为 {sample_width * 8} bit，建议使用 16 bit")
-        
+
+            raw_frames = wav_file.readframes(frames)
+
         # 读取整个文件的二进制数据
         with open(input_file, 'rb') as f:
-            audio_data = f.read()
-        
-        file_size = len(audio_data)
+            file_data = f.read()
+
+        file_size = len(file_data)
         print(f"文件大小: {file_size} 字节")
+
+        if audio_format == "adpcm":
+            if channels != 1 or sample_width != 2:
+                print("错误: ADPCM 编码仅支持16位单声道WAV，请先转换格式或使用 --format=pcm")
+                return False
+            samples = list(struct.unpack(f"<{frames}h", raw_frames[:frames * 2]))
+            audio_data = adpcm_encode(samples, block_align)
+            decoded = adpcm_decode(audio_data, frames, block_align)
+            snr = calculate_snr(samples, decoded)
+            max_error = max((abs(a - b) for a, b in zip(samples, decoded)), default=0)
+            print(f"ADPCM编码: {len(audio_data)} 字节 (压缩比 {len(raw_frames) / max(len(audio_data), 1):.2f}:1)")
+            print(f"解码校验: SNR {snr:.1f} dB, 最大误差 {max_error}")
+            format_name = "VOICE_FORMAT_IMA_ADPCM"
+            format_desc = f"IMA-ADPCM, 块大小 {block_align} 字节"
+        else:
+            audio_data = file_data
+            format_name = "VOICE_FORMAT_WAV_PCM16"
+            format_desc = "WAV 16bit PCM"
+            block_align = 0
         
         # 生成C头文件
         header_guard = f"{var_name.upper()}_H"
@@ -68,7 +192,8 @@ def wav_to_header(input_file, output_file, var_name, description=""):
         header_content = f"""#ifndef {header_guard}
 #define {header_guard}
 
-#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
 
 /*
  * 语音文件: {os.path.basename(input_file)}
@@ -81,6 +206,8 @@ def wav_to_header(input_file, output_file, var_name, description=""):
  *   位深度: {sample_width * 8} bit
  *   时长: {frames / sample_rate:.2f} 秒
  *   文件大小: {file_size} 字节
+ *   存储格式: {format_desc}
+ *   数据大小: {len(audio_data)} 字节
  */
 
 const uint8_t {var_name}[] = {{
@@ -99,16 +226,8 @@ const uint8_t {var_name}[] = {{
 
 const size_t {var_name}_size = sizeof({var_name});
 
-// 语音文件信息结构
-struct VoiceInfo {{
-    const char* name;
-    const char* description;
-    const uint8_t* data;
-    size_t size;
-    uint32_t sample_rate;
-    uint8_t channels;
-    uint8_t bits_per_sample;
-}};
+// 前向声明，避免重复定义（VoiceInfo 定义于 VoiceInfo.h）
+struct VoiceInfo;
 
 // 语音信息常量
 const VoiceInfo {var_name.upper()}_INFO = {{
@@ -118,7 +237,10 @@ const VoiceInfo {var_name.upper()}_INFO = {{
     {var_name}_size,
     {sample_rate},
     {channels},
-    {sample_width * 8}
+    {sample_width * 8},
+    {format_name},
+    {block_align},
+    {frames}
 }};
 
 #endif // {header_guard}
@@ -134,15 +256,12 @@ const VoiceInfo {var_name.upper()}_INFO = {{
         
         # 生成使用示例
         example_code = f"""
-// 使用示例:
+// 使用示例（在 AudioManager.cpp 中包含，需在 AudioManager.h 之后）:
 #include "{os.path.basename(output_file)}"
 
 void playVoice() {{
-    // 播放语音数据
-    audioManager.playVoiceFromArray({var_name}, {var_name}_size);
-    
-    // 或者使用语音信息结构
-    audioManager.playVoiceFromArray({var_name.upper()}_INFO.data, {var_name.upper()}_INFO.size);
+    // 按语音信息结构播放，ADPCM/PCM 自动识别
+    audioManager.playVoice({var_name.upper()}_INFO);
 }}
 """
         print(example_code)
@@ -154,18 +273,39 @@ void playVoice() {{
         return False
 
 def main():
-    if len(sys.argv) < 4:
-        print("用法: python wav_to_header.py <输入WAV文件> <输出头文件> <变量名> [描述]")
+    options = [arg for arg in sys.argv[1:] if arg.startswith("--")]
+    args = [arg for arg in sys.argv[1:] if not arg.startswith("--")]
+
+    audio_format = "adpcm"
+    block_align = DEFAULT_BLOCK_ALIGN
+    for option in options:
+        if option.startswith("--format="):
+            audio_format = option.split("=", 1)[1].lower()
+        elif option.startswith("--block-align="):
+            block_align = int(option.split("=", 1)[1])
+        else:
+            print(f"错误: 未知选项 {option}")
+            sys.exit(1)
+
+    if audio_format not in ("adpcm", "pcm"):
+        print("错误: --format 只支持 adpcm 或 pcm")
+        sys.exit(1)
+    if block_align < 8 or block_align % 4 != 0:
+        print("错误: --block-align 必须是不小于8的4的倍数")
+        sys.exit(1)
+
+    if len(args) < 3:
+        print("用法: python wav_to_header.py <输入WAV文件> <输出头文件> <变量名> [描述] [--format=adpcm|pcm] [--block-align=256]")
         print("")
         print("示例:")
         print('  python wav_to_header.py welcome.wav welcome_audio.h welcome_voice_data "大菠萝车机,扎西德勒"')
         print('  python wav_to_header.py boot.wav boot_audio.h boot_sound_data "开机音效"')
         sys.exit(1)
     
-    input_file = sys.argv[1]
-    output_file = sys.argv[2]
-    var_name = sys.argv[3]
-    description = sys.argv[4] if len(sys.argv) > 4 else ""
+    input_file = args[0]
+    output_file = args[1]
+    var_name = args[2]
+    description = args[3] if len(args) > 3 else ""
     
     # 验证变量名
     if not var_name.replace('_', '').isalnum():
@@ -176,14 +316,15 @@ def main():
         print("错误: 变量名不能以数字开头")
         sys.exit(1)
     
-    success = wav_to_header(input_file, output_file, var_name, description)
+    success = wav_to_header(input_file, output_file, var_name, description,
+                            audio_format, block_align)
     
     if success:
         print("\n转换完成！")
         print("\n下一步:")
         print(f"1. 将 {output_file} 复制到 src/audio/ 目录")
         print("2. 在 AudioManager.cpp 中包含头文件")
-        print("3. 使用 playVoiceFromArray() 播放语音")
+        print("3. 使用 playVoice() 播放语音")
     else:
         print("\n转换失败！")
         sys.exit(1)